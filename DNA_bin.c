@@ -3,7 +3,20 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <limits.h>
+#include <math.h>
 #include "gene_bin.h"
+#include "arena.h"
+#include "gene_stream.h"
+#include "perf_counters.h"
+#include "similarity.h"
+#include "variants.h"
+#include "consensus.h"
+#include "phylo.h"
+#include "rank_select.h"
+#include "protein_search.h"
+#include "protein_score.h"
 
 
 /********** C-PYTHON INTERFACE DEFINTIONS **********/
@@ -14,6 +27,10 @@ static PyObject* DNAb_version(PyObject* self) {
 	return Py_BuildValue("s", "DNA version 2.0");
 }
 
+static PyObject* DNAb_cpu_dispatch_level(PyObject* self) {
+	return Py_BuildValue("s", cpu_dispatch_level());
+}
+
 
 /********** C-PYTHON INTERFACE RELATED FUNCTIONS **********/
 
@@ -34,6 +51,133 @@ long int DNAb_get_binary_size(Py_buffer view) {
 	return size;
 }
 
+// 64 bits integers in native or little-endian byte order: array('l'), array('q'), numpy.int64 or numpy.uint64
+static bool DNAb_is_int64(const Py_buffer* view) {
+	const char* format = view->format ? view->format : "B";
+	if (*format == '@' || *format == '=' || *format == '<')
+		format++;
+	return view->itemsize == sizeof(long) && *format && !format[1] && strchr("lqLQ", *format);
+}
+
+// Get a sequence in binary array format: a 1-dimensional array of 64 bits integers, and its number of bits
+static int DNAb_get_sequence(PyObject* obj, Py_buffer* view, long* nb_bits) {
+	if (PyObject_GetBuffer(obj, view, PyBUF_ANY_CONTIGUOUS | PyBUF_FORMAT) == -1)
+		return -1;
+
+	if (view->ndim != 1 || !DNAb_is_int64(view)) {
+		PyErr_SetString(PyExc_TypeError, "Expecting a 1-dimensional array of long int.");
+		PyBuffer_Release(view);
+		return -1;
+	}
+	//get_binary_value takes int positions
+	*nb_bits = view->shape[0] < INT_MAX / int_SIZE ? view->shape[0] * int_SIZE : INT_MAX;
+	return 0;
+}
+
+// Binary array of a DNA sequence given as a string or a bytes-like object (numpy.uint8), with its length
+static long int* DNAb_binary_array(PyObject* args, long int* array_size) {
+	Py_buffer seq_char;
+	int seq_size = 0;
+
+	//Get the parameters (1-dimensional array of char, and its length)
+	if (!PyArg_ParseTuple(args, "s*i", &seq_char, &seq_size))
+		return NULL;
+	if (seq_size < 0 || seq_size > seq_char.len) {
+		PyErr_SetString(PyExc_ValueError, "Expecting a length within the sequence.");
+		PyBuffer_Release(&seq_char);
+		return NULL;
+	}
+
+	long int* array = set_binary_array(seq_char.buf, seq_size);
+	PyBuffer_Release(&seq_char);
+	*array_size = 2 * seq_size / int_SIZE;
+	*array_size += (2 * seq_size % int_SIZE != 0);
+	if (!array)
+		PyErr_NoMemory();
+	return array;
+}
+
+
+/********** C-OWNED ARRAYS **********/
+
+// Memory allocated by the library, given to Python without copy (memoryview, numpy.asarray)
+typedef struct DNAb_array_s {
+	PyObject_HEAD
+	void* data;
+	const char* format;
+	int ndim;
+	Py_ssize_t shape[2];
+	Py_ssize_t strides[2];
+}DNAb_array_t;
+
+static void DNAb_array_dealloc(DNAb_array_t* self) {
+	free(self->data);
+	Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+static int DNAb_array_getbuffer(DNAb_array_t* self, Py_buffer* view, int flags) {
+	view->obj = (PyObject*)self;
+	Py_INCREF(self);
+	view->buf = self->data;
+	view->itemsize = self->strides[self->ndim - 1];
+	view->len = self->shape[0] * self->strides[0];
+	view->readonly = 0;
+	view->format = flags & PyBUF_FORMAT ? (char*)self->format : NULL;
+	view->ndim = self->ndim;
+	view->shape = self->shape;
+	view->strides = self->strides;
+	view->suboffsets = NULL;
+	view->internal = NULL;
+	return 0;
+}
+
+static PyBufferProcs DNAb_array_buffer = {
+	(getbufferproc)DNAb_array_getbuffer,
+	NULL
+};
+
+static PyTypeObject DNAb_array_type = {
+	PyVarObject_HEAD_INIT(NULL, 0)
+	.tp_name = "DNA_bin.Array",
+	.tp_doc = "Array allocated by the DNA library, exported with the buffer protocol",
+	.tp_basicsize = sizeof(DNAb_array_t),
+	.tp_dealloc = (destructor)DNAb_array_dealloc,
+	.tp_as_buffer = &DNAb_array_buffer,
+	.tp_flags = Py_TPFLAGS_DEFAULT,
+};
+
+/**
+ * Memory view of a malloc'ed row-major array, freed with its last view.
+ *
+ * in : data : array given to the view (freed on error)
+ * in : format : struct module or PEP 3118 format of the items (static string)
+ * in : itemsize : size of the items
+ * in : ndim : 1 or 2 dimensions
+ * in : rows, cols : shape of the array (cols unused in 1 dimension)
+ * out : PyObject* : memoryview, NULL on error
+ */
+static PyObject* DNAb_array_view(void* data, const char* format, const Py_ssize_t itemsize, const int ndim,
+                                 const Py_ssize_t rows, const Py_ssize_t cols) {
+	if (!data)
+		return PyErr_NoMemory();
+	DNAb_array_t* array = PyObject_New(DNAb_array_t, &DNAb_array_type);
+	if (!array) {
+		free(data);
+		return NULL;
+	}
+	array->data = data;
+	array->format = format;
+	array->ndim = ndim;
+	array->shape[0] = rows;
+	array->shape[1] = cols;
+	array->strides[0] = ndim == 2 ? cols * itemsize : itemsize;
+	array->strides[1] = itemsize;
+
+	PyObject* view = PyMemoryView_FromObject((PyObject*)array);
+	Py_DECREF(array);
+	return view;
+}
+
 
 /********** BINARIES FUNCTION **********/
 
@@ -56,13 +200,16 @@ static PyObject* DNAb_get_binary_value(PyObject* self, PyObject* args) {
 		return NULL;
 	}
 
-	if (strcmp(view_seq_bin.format, "l")) {
+	if (!DNAb_is_int64(&view_seq_bin)) {
 		PyErr_SetString(PyExc_TypeError, "Expecting a 1-dimensional array of long int.");
 		PyBuffer_Release(&view_seq_bin);
 		return NULL;
 	}
 
-	return Py_BuildValue("l", get_binary_value(view_seq_bin.buf, pos));
+	long int value = get_binary_value(view_seq_bin.buf, pos);
+	PyBuffer_Release(&view_seq_bin);
+
+	return Py_BuildValue("l", value);
 }
 
 static PyObject* DNAb_change_binary_value(PyObject* self, PyObject* args) {
@@ -85,7 +232,7 @@ static PyObject* DNAb_change_binary_value(PyObject* self, PyObject* args) {
 		return NULL;
 	}
 
-	if (strcmp(view_seq_bin.format, "l")) {
+	if (!DNAb_is_int64(&view_seq_bin)) {
 		PyErr_SetString(PyExc_TypeError, "Expecting a 1-dimensional array of long int.");
 		PyBuffer_Release(&view_seq_bin);
 		return NULL;
@@ -96,26 +243,22 @@ static PyObject* DNAb_change_binary_value(PyObject* self, PyObject* args) {
 	PyObject* pylist = PyList_New(view_seq_bin.shape[0]);
 	for (int i = 0; i < view_seq_bin.shape[0]; i++)
 		PyList_SetItem(pylist, i, PyLong_FromLong(array[i]));
+	PyBuffer_Release(&view_seq_bin);
 
 	return pylist;
 }
 
 static PyObject* DNAb_set_binary_array(PyObject* self, PyObject* args) {
-	char* seq_char;
-	long int seq_size = 0;
-
-	//Get the parameters (1-dimensional array of char, and its length)
-	if (!PyArg_ParseTuple(args, "si", &seq_char, &seq_size))
+	long int array_size;
+	long int* array = DNAb_binary_array(args, &array_size);
+	if (!array)
 		return NULL;
 
-	long int* array = set_binary_array(seq_char, seq_size);
-	long int array_size = 2 * seq_size / int_SIZE;
-	array_size += (2 * seq_size % int_SIZE != 0);
-
 	PyObject* pylist = PyList_New(array_size);
 
 	for (long int i = 0; i < array_size; i++)
 		PyList_SetItem(pylist, i, PyLong_FromLong(array[i]));
+	free(array);
 
 	return pylist;
 }
@@ -140,7 +283,7 @@ static PyObject* DNAb_xor_binary_array(PyObject* self, PyObject* args) {
 		return NULL;
 	}
 
-	if (strcmp(view_seq_bin1.format, "l")) {
+	if (!DNAb_is_int64(&view_seq_bin1)) {
 		PyErr_SetString(PyExc_TypeError, "Expecting a 1-dimensional array of long int.");
 		PyBuffer_Release(&view_seq_bin1);
 		return NULL;
@@ -156,7 +299,7 @@ static PyObject* DNAb_xor_binary_array(PyObject* self, PyObject* args) {
 		return NULL;
 	}
 
-	if (strcmp(view_seq_bin2.format, "l")) {
+	if (!DNAb_is_int64(&view_seq_bin2)) {
 		PyErr_SetString(PyExc_TypeError, "Expecting a 1-dimensional array of long int.");
 		PyBuffer_Release(&view_seq_bin2);
 		return NULL;
@@ -166,6 +309,10 @@ static PyObject* DNAb_xor_binary_array(PyObject* self, PyObject* args) {
 	long int array_size2 = DNAb_get_binary_size(view_seq_bin2);
 
 	long int* array = xor_binary_array(view_seq_bin1.buf, array_size1, view_seq_bin2.buf, array_size2);
+	PyBuffer_Release(&view_seq_bin1);
+	PyBuffer_Release(&view_seq_bin2);
+	if (!array)
+		return PyErr_NoMemory();
 
 	long int intsize = int_SIZE + 1;
 
@@ -177,6 +324,7 @@ static PyObject* DNAb_xor_binary_array(PyObject* self, PyObject* args) {
 
 	for (long int i = 0; i < array_size; i++)
 		PyList_SetItem(pylist, i, PyLong_FromLong(array[i]));
+	free(array);
 
 	return pylist;
 }
@@ -199,7 +347,7 @@ static PyObject* DNAb_popcount_binary_array(PyObject* self, PyObject* args) {
 		return NULL;
 	}
 
-	if (strcmp(view_seq.format, "l")) {
+	if (!DNAb_is_int64(&view_seq)) {
 		PyErr_SetString(PyExc_TypeError, "Expecting a 1-dimensional array of long int.");
 		PyBuffer_Release(&view_seq);
 		return NULL;
@@ -207,7 +355,10 @@ static PyObject* DNAb_popcount_binary_array(PyObject* self, PyObject* args) {
 
 	long int size = DNAb_get_binary_size(view_seq);
 
-	return Py_BuildValue("l", popcount_binary_array(view_seq.buf, size));
+	long int pop = popcount_binary_array(view_seq.buf, size);
+	PyBuffer_Release(&view_seq);
+
+	return Py_BuildValue("l", pop);
 }
 
 static PyObject* DNAb_get_piece_binary_array(PyObject* self, PyObject* args) {
@@ -230,13 +381,16 @@ static PyObject* DNAb_get_piece_binary_array(PyObject* self, PyObject* args) {
 		return NULL;
 	}
 
-	if (strcmp(view_seq_bin.format, "l")) {
+	if (!DNAb_is_int64(&view_seq_bin)) {
 		PyErr_SetString(PyExc_TypeError, "Expecting a 1-dimensional array of long int.");
 		PyBuffer_Release(&view_seq_bin);
 		return NULL;
 	}
 
 	long int* array = get_piece_binary_array(view_seq_bin.buf, pos_start, size);
+	PyBuffer_Release(&view_seq_bin);
+	if (!array)
+		return PyErr_NoMemory();
 
 	long int intsize = int_SIZE + 1;
 
@@ -245,6 +399,7 @@ static PyObject* DNAb_get_piece_binary_array(PyObject* self, PyObject* args) {
 
 	for (long int i = 0; i < array_size; i++)
 		PyList_SetItem(pylist, i, PyLong_FromLong(array[i]));
+	free(array);
 
 	return pylist;
 }
@@ -255,25 +410,31 @@ static PyObject* DNAb_get_piece_binary_array(PyObject* self, PyObject* args) {
 
 //////////////// Convert to binary
 static PyObject* DNAb_convert_to_binary(PyObject* self, PyObject* args) {
-	char* seq_char;
-	long int seq_size = 0;
-
-	//Get the parameters (1-dimensional array of char, and its length)
-	if (!PyArg_ParseTuple(args, "si", &seq_char, &seq_size))
+	long int array_size;
+	long int* array = DNAb_binary_array(args, &array_size);
+	if (!array)
 		return NULL;
 
-	long int* array = set_binary_array(seq_char, seq_size);
-	long int array_size = 2 * seq_size / int_SIZE;
-	array_size += (2 * seq_size % int_SIZE != 0);
-
 	PyObject* pylist = PyList_New(array_size);
 
 	for (long int i = 0; i < array_size; i++)
 		PyList_SetItem(pylist, i, PyLong_FromLong(array[i]));
+	free(array);
 
 	return pylist;
 }
 
+//////////////// Convert to binary, as an array of long int
+static PyObject* DNAb_convert_to_binary_array(PyObject* self, PyObject* args) {
+	long int array_size;
+	long int* array = DNAb_binary_array(args, &array_size);
+	if (!array)
+		return NULL;
+
+	//The binary array itself, without copy
+	return DNAb_array_view(array, "l", sizeof(*array), 1, array_size, 0);
+}
+
 //////////////// Binary to DNA
 static PyObject* DNAb_binary_to_dna(PyObject* self, PyObject* args) {
 	Py_buffer view_bin_dna_seq;
@@ -293,7 +454,7 @@ static PyObject* DNAb_binary_to_dna(PyObject* self, PyObject* args) {
 		return NULL;
 	}
 
-	if (strcmp(view_bin_dna_seq.format, "l")) {
+	if (!DNAb_is_int64(&view_bin_dna_seq)) {
 		PyErr_SetString(PyExc_TypeError, "Expecting a 1-dimensional array of long int.");
 		PyBuffer_Release(&view_bin_dna_seq);
 		return NULL;
@@ -301,8 +462,20 @@ static PyObject* DNAb_binary_to_dna(PyObject* self, PyObject* args) {
 
 	long int size = DNAb_get_binary_size(view_bin_dna_seq);
 
+	//The result is written in the thread arena, and given back once copied
+	arena_t* arena = arena_thread();
+	if (!arena) {
+		PyBuffer_Release(&view_bin_dna_seq);
+		return PyErr_NoMemory();
+	}
+	arena_mark_t mark = arena_mark(arena);
+	char* dna_seq = binary_to_dna_into(view_bin_dna_seq.buf, size, arena_alloc(arena, size / 2 + 1));
+	PyBuffer_Release(&view_bin_dna_seq);
+
 	//Return the char* value as a Python string object
-	return Py_BuildValue("y", binary_to_dna(view_bin_dna_seq.buf, size));
+	PyObject* res = Py_BuildValue("y", dna_seq);
+	arena_rewind(arena, mark);
+	return res;
 }
 
 //////////////// Generating mRNA
@@ -327,14 +500,28 @@ static PyObject* DNAb_generating_mRNA(PyObject* self, PyObject* args) {
 		return NULL;
 	}
 
-	if (strcmp(view_gene_seq.format, "l")) {
+	if (!DNAb_is_int64(&view_gene_seq)) {
 		PyErr_SetString(PyExc_TypeError, "Expecting a 1-dimensional array of long int.");
 		PyBuffer_Release(&view_gene_seq);
 		return NULL;
 	}
 
+	//The result is written in the thread arena, and given back once copied
+	arena_t* arena = arena_thread();
+	if (!arena) {
+		PyBuffer_Release(&view_gene_seq);
+		return PyErr_NoMemory();
+	}
+	arena_mark_t mark = arena_mark(arena);
+	char* rna_seq = NULL;
+	if (seq_size >= 0)
+		rna_seq = generating_mRNA_into(view_gene_seq.buf, start_pos, seq_size, arena_alloc(arena, seq_size / 2 + 2));
+	PyBuffer_Release(&view_gene_seq);
+
 	//Return the char* value as a Python string object
-	return Py_BuildValue("y", generating_mRNA(view_gene_seq.buf, start_pos, seq_size));
+	PyObject* res = Py_BuildValue("y", rna_seq);
+	arena_rewind(arena, mark);
+	return res;
 }
 
 //////////////// Detecting genes
@@ -356,7 +543,7 @@ static PyObject* DNAb_detecting_genes(PyObject* self, PyObject* args) {
 		return NULL;
 	}
 
-	if (strcmp(view_gene.format, "l")) {
+	if (!DNAb_is_int64(&view_gene)) {
 		PyErr_SetString(PyExc_TypeError, "Expecting a 1-dimensional array of long int");
 		PyBuffer_Release(&view_gene);
 		return NULL;
@@ -369,6 +556,7 @@ static PyObject* DNAb_detecting_genes(PyObject* self, PyObject* args) {
 	g.gene_end = malloc(sizeof(*g.gene_end) * gene_size);
 
 	detecting_genes(view_gene.buf, gene_size, &g);
+	PyBuffer_Release(&view_gene);
 
 
 	PyObject* List = PyList_New(0);
@@ -385,15 +573,49 @@ static PyObject* DNAb_detecting_genes(PyObject* self, PyObject* args) {
 	return List;
 }
 
+//////////////// Detecting genes, as a structured array of (start, end)
+static PyObject* DNAb_detecting_genes_array(PyObject* self, PyObject* args) {
+	Py_buffer view_gene;
+	PyObject* obj_gene = NULL;
+	long nb_bits;
+
+	//Get the parameter (1-dimensional arrays of 64 bits integers)
+	if (!PyArg_ParseTuple(args, "O", &obj_gene))
+		return NULL;
+	if (DNAb_get_sequence(obj_gene, &view_gene, &nb_bits))
+		return NULL;
+
+	gene_map_t g = { 0, malloc(sizeof(*g.gene_start) * nb_bits), malloc(sizeof(*g.gene_end) * nb_bits) };
+	uint64_t* genes = NULL;
+	if (g.gene_start && g.gene_end) {
+		Py_BEGIN_ALLOW_THREADS
+		detecting_genes(view_gene.buf, nb_bits, &g);
+		genes = malloc(2 * sizeof(*genes) * (g.genes_counter + 1));
+		for (unsigned long long i = 0; genes && i < g.genes_counter; i++) {
+			genes[2 * i] = g.gene_start[i];
+			genes[2 * i + 1] = g.gene_end[i];
+		}
+		Py_END_ALLOW_THREADS
+	}
+	PyBuffer_Release(&view_gene);
+	free(g.gene_start);
+	free(g.gene_end);
+
+	//numpy.asarray gives the fields 'start' and 'end'
+	return DNAb_array_view(genes, "T{Q:start:Q:end:}", 2 * sizeof(*genes), 1, g.genes_counter, 0);
+}
+
 //////////////// Generating an amino acid chain (protein)
 static PyObject* DNAb_generating_amino_acid_chain(PyObject* self, PyObject* args) {
 	Py_buffer view_gene_seq;
 	PyObject* obj_gene_seq = NULL;
 
 	int start_pos = 0, seq_size = 0;
+	// Standard code with 'O' stops by default, else a NCBI translation table identifier
+	int table_id = 0;
 
-	//Get the parameters (1-dimensional array of long int, the start position, and its length)
-	if (!PyArg_ParseTuple(args, "Oii", &obj_gene_seq, &start_pos, &seq_size))
+	//Get the parameters (1-dimensional array of long int, the start position, its length, and the genetic code)
+	if (!PyArg_ParseTuple(args, "Oii|i", &obj_gene_seq, &start_pos, &seq_size, &table_id))
 		return NULL;
 
 	//Get the array memory view
@@ -406,14 +628,29 @@ static PyObject* DNAb_generating_amino_acid_chain(PyObject* self, PyObject* args
 		return NULL;
 	}
 
-	if (strcmp(view_gene_seq.format, "l")) {
+	if (!DNAb_is_int64(&view_gene_seq)) {
 		PyErr_SetString(PyExc_TypeError, "Expecting a 1-dimensional array of long int.");
 		PyBuffer_Release(&view_gene_seq);
 		return NULL;
 	}
 
+	//The result is written in the thread arena, and given back once copied
+	arena_t* arena = arena_thread();
+	if (!arena) {
+		PyBuffer_Release(&view_gene_seq);
+		return PyErr_NoMemory();
+	}
+	arena_mark_t mark = arena_mark(arena);
+	char* aa_seq = NULL;
+	if (seq_size >= 0)
+		aa_seq = generating_amino_acid_chain_table_into(view_gene_seq.buf, start_pos, seq_size, table_id,
+		                                                arena_alloc(arena, seq_size / 6 + 1));
+	PyBuffer_Release(&view_gene_seq);
+
 	//Return the char* value as a Python string object
-	return Py_BuildValue("y", generating_amino_acid_chain(view_gene_seq.buf, start_pos, seq_size));
+	PyObject* res = Py_BuildValue("y", aa_seq);
+	arena_rewind(arena, mark);
+	return res;
 }
 
 //////////////// Detecting probable mutation zones
@@ -437,7 +674,7 @@ static PyObject* DNAb_detecting_mutations(PyObject* self, PyObject* args) {
 		return NULL;
 	}
 
-	if (strcmp(view_gene_seq.format, "l")) {
+	if (!DNAb_is_int64(&view_gene_seq)) {
 		PyErr_SetString(PyExc_TypeError, "Expecting a 1-dimensional array of long int.");
 		PyBuffer_Release(&view_gene_seq);
 		return NULL;
@@ -457,6 +694,7 @@ static PyObject* DNAb_detecting_mutations(PyObject* self, PyObject* args) {
 	}
 
 	detecting_mutations(view_gene_seq.buf, start_pos, size_sequence, m);
+	PyBuffer_Release(&view_gene_seq);
 
 	PyObject* List = PyList_New(0);
 	for (short int i = 0; i < 5; i++) {
@@ -476,6 +714,65 @@ static PyObject* DNAb_detecting_mutations(PyObject* self, PyObject* args) {
 	return List;
 }
 
+//////////////// Genes, mRNA, amino acid chains and mutation zones in one pass
+static PyObject* DNAb_analysing_genes(PyObject* self, PyObject* args) {
+	Py_buffer view_gene;
+	PyObject* obj_gene = NULL;
+
+	//Get the parameter (1-dimensional arrays of long int)
+	if (!PyArg_ParseTuple(args, "O", &obj_gene))
+		return NULL;
+
+	//Get the array memory view
+	if (PyObject_GetBuffer(obj_gene, &view_gene, PyBUF_ANY_CONTIGUOUS | PyBUF_FORMAT) == -1)
+		return NULL;
+
+	if (view_gene.ndim != 1) {
+		PyErr_SetString(PyExc_TypeError, "Expecting a 1-dimensional array.");
+		PyBuffer_Release(&view_gene);
+		return NULL;
+	}
+
+	if (!DNAb_is_int64(&view_gene)) {
+		PyErr_SetString(PyExc_TypeError, "Expecting a 1-dimensional array of long int");
+		PyBuffer_Release(&view_gene);
+		return NULL;
+	}
+
+	//Same number of bits as detecting_genes
+	gene_analysis_t analysis;
+	int res = analysing_genes(view_gene.buf, view_gene.shape[0] * int_SIZE, &analysis);
+	PyBuffer_Release(&view_gene);
+	if (res)
+		return PyErr_NoMemory();
+
+	//One [start, end, mRNA, amino acid chain, mutation zones] list per gene
+	PyObject* List = PyList_New(0);
+	for (unsigned long long i = 0; List && i < analysis.genes.genes_counter; i++) {
+		PyObject* zones = PyList_New(0);
+		for (int z = 0; zones && z < GENE_MUTATIONS; z++) {
+			unsigned long long zone = GENE_MUTATIONS * i + z;
+			if (analysis.mut_size[zone] == 0)
+				continue;
+			PyObject* l = Py_BuildValue("[kkk]", analysis.mut_size[zone], analysis.mut_start[zone], analysis.mut_end[zone]);
+			if (!l || PyList_Append(zones, l))
+				Py_CLEAR(zones);
+			Py_XDECREF(l);
+		}
+
+		PyObject* gene = NULL;
+		if (zones)
+			gene = Py_BuildValue("[KKyyN]", analysis.genes.gene_start[i], analysis.genes.gene_end[i],
+			                     analysis.rna + analysis.rna_offset[i], analysis.proteins + analysis.protein_offset[i], zones);
+		if (!gene || PyList_Append(List, gene))
+			Py_CLEAR(List);
+		Py_XDECREF(gene);
+	}
+	gene_analysis_free(&analysis);
+
+	return List;
+}
+
 //////////////// Calculating the matching score of two sequences
 static PyObject* DNAb_calculating_matching_score(PyObject* self, PyObject* args) {
 	Py_buffer view_seq_bin1;
@@ -494,8 +791,10 @@ static PyObject* DNAb_calculating_matching_score(PyObject* self, PyObject* args)
 		return NULL;
 
 	//Get the second array memory view
-	if (PyObject_GetBuffer(obj_seq_bin2, &view_seq_bin2, PyBUF_ANY_CONTIGUOUS | PyBUF_FORMAT) == -1)
+	if (PyObject_GetBuffer(obj_seq_bin2, &view_seq_bin2, PyBUF_ANY_CONTIGUOUS | PyBUF_FORMAT) == -1) {
+		PyBuffer_Release(&view_seq_bin1);
 		return NULL;
+	}
 
 	if (view_seq_bin1.ndim != 1 || view_seq_bin2.ndim != 1) {
 		PyErr_SetString(PyExc_TypeError, "Expecting 2 1-dimensional array.");
@@ -504,15 +803,991 @@ static PyObject* DNAb_calculating_matching_score(PyObject* self, PyObject* args)
 		return NULL;
 	}
 
-	if (strcmp(view_seq_bin1.format, "l") || strcmp(view_seq_bin2.format, "l")) {
+	if (!DNAb_is_int64(&view_seq_bin1) || !DNAb_is_int64(&view_seq_bin2)) {
 		PyErr_SetString(PyExc_TypeError, "Expecting 2 1-dimensional array of long int.");
 		PyBuffer_Release(&view_seq_bin1);
 		PyBuffer_Release(&view_seq_bin2);
 		return NULL;
 	}
 
+	float score = calculating_matching_score(view_seq_bin1.buf, start_pos1, seq_size1, view_seq_bin2.buf, start_pos2, seq_size2);
+	PyBuffer_Release(&view_seq_bin1);
+	PyBuffer_Release(&view_seq_bin2);
+
 	//Return the float value as a Python float object
-	return Py_BuildValue("f", calculating_matching_score(view_seq_bin1.buf, start_pos1, seq_size1, view_seq_bin2.buf, start_pos2, seq_size2));
+	return Py_BuildValue("f", score);
+}
+
+//////////////// Calculating the matching scores of the windows of two sequences
+static PyObject* DNAb_calculating_matching_profile(PyObject* self, PyObject* args) {
+	Py_buffer view_seq1, view_seq2;
+	PyObject* obj_seq1 = NULL;
+	PyObject* obj_seq2 = NULL;
+	long start_pos1 = 0, start_pos2 = 0;
+	int size = 0, window = 0, step = 0;
+	long nb_bits1, nb_bits2;
+
+	//Get the parameters (2 1-dimensional arrays with their start positions, the bits compared, the window and the step)
+	if (!PyArg_ParseTuple(args, "OlOliii", &obj_seq1, &start_pos1, &obj_seq2, &start_pos2, &size, &window, &step))
+		return NULL;
+	if (DNAb_get_sequence(obj_seq1, &view_seq1, &nb_bits1))
+		return NULL;
+	if (DNAb_get_sequence(obj_seq2, &view_seq2, &nb_bits2)) {
+		PyBuffer_Release(&view_seq1);
+		return NULL;
+	}
+
+	if (start_pos1 < 0 || start_pos2 < 0 || size < 0 || start_pos1 > nb_bits1 - size || start_pos2 > nb_bits2 - size
+	    || window <= 0 || step <= 0) {
+		PyErr_SetString(PyExc_ValueError, "Expecting windows in the sequences.");
+		PyBuffer_Release(&view_seq1);
+		PyBuffer_Release(&view_seq2);
+		return NULL;
+	}
+
+	long nb_windows = size < window ? 0 : (size - window) / step + 1;
+	float* profile = malloc((nb_windows + 1) * sizeof(*profile));
+	if (profile) {
+		Py_BEGIN_ALLOW_THREADS
+		nb_windows = calculating_matching_profile(view_seq1.buf, start_pos1, view_seq2.buf, start_pos2, size, window,
+		                                          step, profile);
+		Py_END_ALLOW_THREADS
+	}
+	PyBuffer_Release(&view_seq1);
+	PyBuffer_Release(&view_seq2);
+	if (profile && nb_windows < 0) {
+		free(profile);
+		return PyErr_NoMemory();
+	}
+	return DNAb_array_view(profile, "f", sizeof(*profile), 1, nb_windows, 0);
+}
+
+//////////////// Calculating the GC content of the windows of a sequence
+static PyObject* DNAb_gc_content_windows(PyObject* self, PyObject* args) {
+	Py_buffer view_seq;
+	PyObject* obj_seq = NULL;
+	long long window = 0, step = 0, nb_bases = -1;
+	long nb_bits;
+
+	//Get the parameters (1-dimensional array of 64 bits integers, the window, the step, and its bases, all by default)
+	if (!PyArg_ParseTuple(args, "OLL|L", &obj_seq, &window, &step, &nb_bases))
+		return NULL;
+	if (DNAb_get_sequence(obj_seq, &view_seq, &nb_bits))
+		return NULL;
+	if (nb_bases < 0)
+		nb_bases = nb_bits / 2;
+	if (nb_bases > nb_bits / 2 || window <= 0 || step <= 0) {
+		PyErr_SetString(PyExc_ValueError, "Expecting windows in the sequence.");
+		PyBuffer_Release(&view_seq);
+		return NULL;
+	}
+
+	rank_select_t index;
+	long nb_windows = -1;
+	float* gc = malloc(((nb_bases >= window ? (nb_bases - window) / step : 0) + 2) * sizeof(*gc));
+	Py_BEGIN_ALLOW_THREADS
+	if (gc && !rank_select_init(&index, view_seq.buf, nb_bases)) {
+		nb_windows = rank_select_gc_windows(&index, window, step, gc);
+		rank_select_free(&index);
+	}
+	Py_END_ALLOW_THREADS
+	PyBuffer_Release(&view_seq);
+	if (nb_windows < 0) {
+		free(gc);
+		return PyErr_NoMemory();
+	}
+	return DNAb_array_view(gc, "f", sizeof(*gc), 1, nb_windows, 0);
+}
+
+//////////////// Detecting the single base variants of a genome against a reference
+static PyObject* DNAb_detecting_variants(PyObject* self, PyObject* args) {
+	Py_buffer view_ref, view_seq;
+	PyObject* obj_ref = NULL;
+	PyObject* obj_seq = NULL;
+	long long nb_bases = -1;
+	long nb_bits_ref, nb_bits_seq;
+
+	//Get the parameters (2 1-dimensional arrays of 64 bits integers, and the bases compared, all by default)
+	if (!PyArg_ParseTuple(args, "OO|L", &obj_ref, &obj_seq, &nb_bases))
+		return NULL;
+	if (DNAb_get_sequence(obj_ref, &view_ref, &nb_bits_ref))
+		return NULL;
+	if (DNAb_get_sequence(obj_seq, &view_seq, &nb_bits_seq)) {
+		PyBuffer_Release(&view_ref);
+		return NULL;
+	}
+
+	long max_bases = (nb_bits_ref < nb_bits_seq ? nb_bits_ref : nb_bits_seq) / 2;
+	if (nb_bases < 0)
+		nb_bases = max_bases;
+	if (nb_bases > max_bases || nb_bases >= VARIANTS_MAX_BASES) {
+		if (nb_bases > max_bases)
+			PyErr_SetString(PyExc_ValueError, "More bases than in the sequences.");
+		else
+			PyErr_Format(PyExc_ValueError, "Expecting less than %d bases.", VARIANTS_MAX_BASES);
+		PyBuffer_Release(&view_ref);
+		PyBuffer_Release(&view_seq);
+		return NULL;
+	}
+
+	variants_t variants;
+	variants_init(&variants);
+	int res;
+	Py_BEGIN_ALLOW_THREADS
+	res = extracting_variants(view_ref.buf, view_seq.buf, nb_bases, &variants);
+	Py_END_ALLOW_THREADS
+	PyBuffer_Release(&view_ref);
+	PyBuffer_Release(&view_seq);
+	if (res) {
+		variants_free(&variants);
+		return PyErr_NoMemory();
+	}
+
+	//numpy.asarray gives the fields 'pos', 'ref' and 'alt'
+	variant_t* list = variants.list ? variants.list : malloc(sizeof(*list));
+	return DNAb_array_view(list, "T{I:pos:c:ref:c:alt:2x}", sizeof(*list), 1, variants.nb_variants, 0);
+}
+
+// Genomes of a collection call: a sequence of binary arrays
+typedef struct DNAb_genomes_s {
+	PyObject* seqs;
+	Py_ssize_t n;
+	Py_buffer* views;
+	const long int** seqs_bin;
+	//Bases of each array, and of the shortest
+	unsigned long long* nb_bases;
+	long min_bases;
+}DNAb_genomes_t;
+
+static void DNAb_release_genomes(DNAb_genomes_t* genomes, const Py_ssize_t nb_views) {
+	for (Py_ssize_t i = 0; i < nb_views; i++)
+		PyBuffer_Release(&genomes->views[i]);
+	PyMem_RawFree(genomes->views);
+	PyMem_RawFree(genomes->seqs_bin);
+	PyMem_RawFree(genomes->nb_bases);
+	Py_XDECREF(genomes->seqs);
+}
+
+// Get the genomes of a collection call (at least one), to release with DNAb_release_genomes
+static int DNAb_get_genomes(PyObject* obj, DNAb_genomes_t* genomes) {
+	memset(genomes, 0, sizeof(*genomes));
+	genomes->seqs = PySequence_Fast(obj, "Expecting a sequence of binary arrays.");
+	if (!genomes->seqs)
+		return -1;
+	genomes->n = PySequence_Fast_GET_SIZE(genomes->seqs);
+	if (!genomes->n) {
+		DNAb_release_genomes(genomes, 0);
+		PyErr_SetString(PyExc_ValueError, "Expecting at least one genome.");
+		return -1;
+	}
+
+	genomes->views = PyMem_RawCalloc(genomes->n, sizeof(*genomes->views));
+	genomes->seqs_bin = PyMem_RawMalloc(genomes->n * sizeof(*genomes->seqs_bin));
+	genomes->nb_bases = PyMem_RawMalloc(genomes->n * sizeof(*genomes->nb_bases));
+	if (!genomes->views || !genomes->seqs_bin || !genomes->nb_bases) {
+		DNAb_release_genomes(genomes, 0);
+		PyErr_NoMemory();
+		return -1;
+	}
+	genomes->min_bases = LONG_MAX;
+	for (Py_ssize_t i = 0; i < genomes->n; i++) {
+		long nb_bits;
+		if (DNAb_get_sequence(PySequence_Fast_GET_ITEM(genomes->seqs, i), &genomes->views[i], &nb_bits)) {
+			DNAb_release_genomes(genomes, i);
+			return -1;
+		}
+		genomes->seqs_bin[i] = genomes->views[i].buf;
+		genomes->nb_bases[i] = nb_bits / 2;
+		if (nb_bits / 2 < genomes->min_bases)
+			genomes->min_bases = nb_bits / 2;
+	}
+	return 0;
+}
+
+//////////////// Building the consensus of aligned genomes
+static PyObject* DNAb_building_consensus(PyObject* self, PyObject* args) {
+	PyObject* obj_seqs = NULL;
+	long long nb_bases = -1;
+	DNAb_genomes_t genomes;
+
+	//Get the parameters (a sequence of 1-dimensional arrays of 64 bits integers, and the bases of each, all by default)
+	if (!PyArg_ParseTuple(args, "O|L", &obj_seqs, &nb_bases))
+		return NULL;
+	if (DNAb_get_genomes(obj_seqs, &genomes))
+		return NULL;
+
+	if (nb_bases < 0)
+		nb_bases = genomes.min_bases;
+	char* consensus = NULL;
+	float* entropy = NULL;
+	PyObject* result = NULL;
+	if (nb_bases > genomes.min_bases)
+		PyErr_SetString(PyExc_ValueError, "More bases than in the sequences.");
+	else if (!(consensus = malloc(nb_bases + 1)) || !(entropy = malloc((nb_bases + 1) * sizeof(*entropy))))
+		PyErr_NoMemory();
+	else {
+		int res;
+		Py_BEGIN_ALLOW_THREADS
+		thread_pool_t* pool = thread_pool_create(thread_pool_default_size());
+		res = building_consensus(pool, genomes.seqs_bin, genomes.n, nb_bases, consensus, entropy, NULL);
+		thread_pool_destroy(pool);
+		Py_END_ALLOW_THREADS
+		if (res)
+			PyErr_SetString(PyExc_ValueError, "Cannot build the consensus of the genomes.");
+		else {
+			result = Py_BuildValue("(y#N)", consensus, (Py_ssize_t)nb_bases,
+			                       DNAb_array_view(entropy, "f", sizeof(*entropy), 1, nb_bases, 0));
+			entropy = NULL;
+		}
+	}
+	free(consensus);
+	free(entropy);
+	DNAb_release_genomes(&genomes, genomes.n);
+	return result;
+}
+
+//////////////// Building the neighbor joining tree of genomes
+static PyObject* DNAb_building_phylogeny(PyObject* self, PyObject* args) {
+	PyObject* obj_seqs = NULL;
+	PyObject* obj_names = Py_None;
+	int k = 0;
+	DNAb_genomes_t genomes;
+
+	//Get the parameters (a sequence of 1-dimensional arrays of 64 bits integers, their names, the k-mer length)
+	if (!PyArg_ParseTuple(args, "O|Oi", &obj_seqs, &obj_names, &k))
+		return NULL;
+	if (k < 0 || k > PHYLO_MAX_K) {
+		PyErr_Format(PyExc_ValueError, "Expecting a k-mer length from 0 (mismatch distance) to %d.", PHYLO_MAX_K);
+		return NULL;
+	}
+	if (DNAb_get_genomes(obj_seqs, &genomes))
+		return NULL;
+	Py_ssize_t n = genomes.n;
+
+	//Names of the genomes, their numbers by default. The UTF-8 of the names belongs to the strings: a tuple keeps
+	//them alive without the GIL, where a list could be changed by another thread
+	const char** names = NULL;
+	PyObject* names_tuple = NULL;
+	if (obj_names != Py_None) {
+		names_tuple = PySequence_Tuple(obj_names);
+		if (!names_tuple || PyTuple_GET_SIZE(names_tuple) != n || !(names = PyMem_RawMalloc(n * sizeof(*names)))) {
+			if (names_tuple && !PyErr_Occurred())
+				PyErr_SetString(PyExc_ValueError, "Expecting one name per genome.");
+			Py_XDECREF(names_tuple);
+			DNAb_release_genomes(&genomes, n);
+			return NULL;
+		}
+		for (Py_ssize_t i = 0; i < n && names; i++)
+			if (!(names[i] = PyUnicode_AsUTF8(PyTuple_GET_ITEM(names_tuple, i)))) {
+				PyMem_RawFree(names);
+				names = NULL;
+			}
+		if (!names) {
+			Py_DECREF(names_tuple);
+			DNAb_release_genomes(&genomes, n);
+			return NULL;
+		}
+	}
+
+	float* distances = malloc(n * n * sizeof(*distances));
+	float* joined = malloc(n * n * sizeof(*distances));
+	char* newick = NULL;
+	int res = -1;
+	if (distances && joined) {
+		Py_BEGIN_ALLOW_THREADS
+		thread_pool_t* pool = thread_pool_create(thread_pool_default_size());
+		phylo_tree_t tree;
+		res = computing_distances(pool, genomes.seqs_bin, genomes.nb_bases, n, k, distances);
+		if (!res) {
+			memcpy(joined, distances, n * n * sizeof(*distances));
+			res = joining_neighbors(pool, joined, n, &tree);
+		}
+		if (!res) {
+			newick = writing_newick(&tree, names);
+			phylo_tree_free(&tree);
+		}
+		thread_pool_destroy(pool);
+		Py_END_ALLOW_THREADS
+	}
+
+	PyObject* result = NULL;
+	if (!newick) {
+		if (distances && joined)
+			PyErr_SetString(PyExc_ValueError, "Cannot build the tree of the genomes.");
+		else
+			PyErr_NoMemory();
+		free(distances);
+	}
+	else
+		result = Py_BuildValue("(Ns)", DNAb_array_view(distances, "f", sizeof(*distances), 2, n, n), newick);
+	free(newick);
+	free(joined);
+	PyMem_RawFree(names);
+	Py_XDECREF(names_tuple);
+	DNAb_release_genomes(&genomes, n);
+	return result;
+}
+
+//////////////// Searching query proteins in the six frames of a genome
+static PyObject* DNAb_searching_proteins(PyObject* self, PyObject* args) {
+	Py_buffer view_seq;
+	PyObject* obj_seq = NULL;
+	PyObject* obj_queries = NULL;
+	int min_score = 40, x_drop = 20, k = 3, reduced = 0, table_id = 1;
+	long long nb_bases = -1;
+	long nb_bits;
+
+	//Get the parameters (1-dimensional array of 64 bits integers, the query proteins, the lowest score, the X-drop,
+	//the seed length, the reduced alphabet, the translation table, and the bases of the genome, all by default)
+	if (!PyArg_ParseTuple(args, "OO|iiipiL", &obj_seq, &obj_queries, &min_score, &x_drop, &k, &reduced, &table_id,
+	                      &nb_bases))
+		return NULL;
+	//The UTF-8 of the queries belongs to the strings: a tuple keeps them alive without the GIL, where a list could be
+	//changed by another thread
+	PyObject* queries_tuple = PySequence_Tuple(obj_queries);
+	if (!queries_tuple)
+		return NULL;
+	Py_ssize_t nb_queries = PyTuple_GET_SIZE(queries_tuple);
+	const char** queries = PyMem_RawMalloc((nb_queries + 1) * sizeof(*queries));
+	if (!queries) {
+		Py_DECREF(queries_tuple);
+		return PyErr_NoMemory();
+	}
+	for (Py_ssize_t i = 0; i < nb_queries; i++)
+		if (!(queries[i] = PyUnicode_AsUTF8(PyTuple_GET_ITEM(queries_tuple, i)))) {
+			PyMem_RawFree(queries);
+			Py_DECREF(queries_tuple);
+			return NULL;
+		}
+	if (DNAb_get_sequence(obj_seq, &view_seq, &nb_bits)) {
+		PyMem_RawFree(queries);
+		Py_DECREF(queries_tuple);
+		return NULL;
+	}
+	if (nb_bases < 0)
+		nb_bases = nb_bits / 2;
+	if (nb_bases > nb_bits / 2) {
+		PyErr_SetString(PyExc_ValueError, "More bases than in the sequence.");
+		PyBuffer_Release(&view_seq);
+		PyMem_RawFree(queries);
+		Py_DECREF(queries_tuple);
+		return NULL;
+	}
+
+	protein_db_t db;
+	protein_hit_t* hits = NULL;
+	long nb_hits = -1;
+	int res;
+	Py_BEGIN_ALLOW_THREADS
+	res = indexing_proteins(view_seq.buf, nb_bases, table_id, k, reduced, &db);
+	if (!res) {
+		thread_pool_t* pool = thread_pool_create(thread_pool_default_size());
+		nb_hits = searching_proteins(pool, &db, queries, nb_queries, min_score, x_drop, &hits);
+		thread_pool_destroy(pool);
+		protein_db_free(&db);
+	}
+	Py_END_ALLOW_THREADS
+	PyBuffer_Release(&view_seq);
+	PyMem_RawFree(queries);
+	Py_DECREF(queries_tuple);
+	if (res) {
+		PyErr_SetString(PyExc_ValueError, "Cannot index the frames of the genome (translation table or seed length).");
+		return NULL;
+	}
+	if (nb_hits < 0)
+		return PyErr_NoMemory();
+
+	//numpy.asarray gives the fields of protein_hit_t
+	return DNAb_array_view(hits, "T{I:query:i:frame:I:query_start:I:subject_start:I:length:i:score:Q:nt_start:}",
+	                       sizeof(*hits), 1, nb_hits, 0);
+}
+
+// Amino acid chains of a protein call: the (offsets, data) of a bulk translation, or a sequence of chains,
+// copied in a bulk buffer
+typedef struct DNAb_chains_s {
+	char* data;
+	int64_t* offsets;
+	protein_chains_t chains;
+}DNAb_chains_t;
+
+static void DNAb_release_chains(DNAb_chains_t* chains) {
+	free(chains->data);
+	free(chains->offsets);
+}
+
+static int DNAb_get_chains(PyObject* obj, DNAb_chains_t* chains) {
+	memset(chains, 0, sizeof(*chains));
+	if (PyTuple_Check(obj) && PyTuple_GET_SIZE(obj) == 2 && !PyUnicode_Check(PyTuple_GET_ITEM(obj, 0))
+	    && !PyBytes_Check(PyTuple_GET_ITEM(obj, 0))) {
+		Py_buffer view_offsets, view_data;
+		if (PyObject_GetBuffer(PyTuple_GET_ITEM(obj, 0), &view_offsets, PyBUF_ANY_CONTIGUOUS | PyBUF_FORMAT) == -1)
+			return -1;
+		if (PyObject_GetBuffer(PyTuple_GET_ITEM(obj, 1), &view_data, PyBUF_ANY_CONTIGUOUS) == -1) {
+			PyBuffer_Release(&view_offsets);
+			return -1;
+		}
+		//Increasing offsets within the data
+		const int64_t* offsets = view_offsets.buf;
+		Py_ssize_t n = view_offsets.ndim == 1 && DNAb_is_int64(&view_offsets) ? view_offsets.shape[0] : 0;
+		int valid = n > 0 && offsets[0] >= 0;
+		for (Py_ssize_t i = 1; i < n && valid; i++)
+			valid = offsets[i] >= offsets[i - 1] && offsets[i] <= view_data.len;
+		if (valid) {
+			chains->offsets = malloc(n * sizeof(*chains->offsets));
+			chains->data = malloc(view_data.len + 1);
+			if (chains->offsets && chains->data) {
+				memcpy(chains->offsets, offsets, n * sizeof(*chains->offsets));
+				memcpy(chains->data, view_data.buf, view_data.len);
+			}
+		}
+		else
+			PyErr_SetString(PyExc_ValueError, "Expecting the (offsets, data) of a bulk translation.");
+		PyBuffer_Release(&view_offsets);
+		PyBuffer_Release(&view_data);
+		chains->chains = (protein_chains_t){ chains->data, chains->offsets, n - 1 };
+	}
+	else {
+		PyObject* fast = PySequence_Fast(obj, "Expecting a sequence of amino acid chains.");
+		if (!fast)
+			return -1;
+		Py_ssize_t n = PySequence_Fast_GET_SIZE(fast);
+		const char** items = PyMem_RawMalloc((n + 1) * sizeof(*items));
+		chains->offsets = malloc((n + 1) * sizeof(*chains->offsets));
+		int valid = items && chains->offsets;
+		if (valid) {
+			chains->offsets[0] = 0;
+			for (Py_ssize_t i = 0; i < n && valid; i++) {
+				PyObject* item = PySequence_Fast_GET_ITEM(fast, i);
+				Py_ssize_t length = 0;
+				char* chain = NULL;
+				if (PyUnicode_Check(item))
+					valid = !!(items[i] = PyUnicode_AsUTF8AndSize(item, &length));
+				else
+					valid = !PyBytes_AsStringAndSize(item, &chain, &length) && (items[i] = chain);
+				chains->offsets[i + 1] = chains->offsets[i] + length;
+			}
+		}
+		if (valid && (chains->data = malloc(chains->offsets[n] + 1)))
+			for (Py_ssize_t i = 0; i < n; i++)
+				memcpy(chains->data + chains->offsets[i], items[i], chains->offsets[i + 1] - chains->offsets[i]);
+		PyMem_RawFree(items);
+		Py_DECREF(fast);
+		chains->chains = (protein_chains_t){ chains->data, chains->offsets, n };
+	}
+
+	if (!chains->data || !chains->offsets) {
+		DNAb_release_chains(chains);
+		if (!PyErr_Occurred())
+			PyErr_NoMemory();
+		return -1;
+	}
+	return 0;
+}
+
+// Scoring of a protein call: the matrix name, gapped or not, and the gap costs
+static int DNAb_get_scoring(const char* matrix, const int gapped, const int gap_open, const int gap_extend,
+                            protein_scoring_t* scoring) {
+	*scoring = (protein_scoring_t){ -1, gapped, gap_open, gap_extend };
+	for (int id = 0; substitution_matrix_name(id); id++)
+		if (!PyOS_stricmp(matrix, substitution_matrix_name(id)))
+			scoring->matrix_id = id;
+	if (scoring->matrix_id < 0) {
+		PyErr_Format(PyExc_ValueError, "Unknown substitution matrix %s.", matrix);
+		return -1;
+	}
+	if (gapped && (gap_open < 0 || gap_extend <= 0)) {
+		PyErr_SetString(PyExc_ValueError, "Expecting a gap opening of 0 or more, and an extension of 1 or more.");
+		return -1;
+	}
+	return 0;
+}
+
+//////////////// Scoring two amino acid chains
+static PyObject* DNAb_scoring_proteins(PyObject* self, PyObject* args) {
+	Py_buffer chain1, chain2;
+	const char* matrix = "BLOSUM62";
+	int gapped = 1, gap_open = 11, gap_extend = 1;
+	protein_scoring_t scoring;
+
+	//Get the parameters (2 amino acid chains, the substitution matrix, gapped or not, and the gap costs)
+	if (!PyArg_ParseTuple(args, "s*s*|spii", &chain1, &chain2, &matrix, &gapped, &gap_open, &gap_extend))
+		return NULL;
+	int64_t score = -1;
+	int res = -1;
+	if (!DNAb_get_scoring(matrix, gapped, gap_open, gap_extend, &scoring)) {
+		Py_BEGIN_ALLOW_THREADS
+		res = scoring_proteins(chain1.buf, chain1.len, chain2.buf, chain2.len, &scoring, &score);
+		Py_END_ALLOW_THREADS
+		if (res)
+			PyErr_NoMemory();
+	}
+	PyBuffer_Release(&chain1);
+	PyBuffer_Release(&chain2);
+	return res ? NULL : PyLong_FromLongLong(score);
+}
+
+//////////////// Scoring the chain i of a set against the chain i of another one
+static PyObject* DNAb_scoring_proteins_batch(PyObject* self, PyObject* args) {
+	PyObject* obj_chains1 = NULL;
+	PyObject* obj_chains2 = NULL;
+	const char* matrix = "BLOSUM62";
+	int gapped = 1, gap_open = 11, gap_extend = 1;
+	protein_scoring_t scoring;
+	DNAb_chains_t chains1, chains2;
+
+	//Get the parameters (2 sets of amino acid chains, the substitution matrix, gapped or not, and the gap costs)
+	if (!PyArg_ParseTuple(args, "OO|spii", &obj_chains1, &obj_chains2, &matrix, &gapped, &gap_open, &gap_extend))
+		return NULL;
+	if (DNAb_get_scoring(matrix, gapped, gap_open, gap_extend, &scoring) || DNAb_get_chains(obj_chains1, &chains1))
+		return NULL;
+	if (DNAb_get_chains(obj_chains2, &chains2)) {
+		DNAb_release_chains(&chains1);
+		return NULL;
+	}
+	unsigned long long n = chains1.chains.nb_chains;
+	if (n != chains2.chains.nb_chains) {
+		PyErr_SetString(PyExc_ValueError, "Expecting as many chains in both sets.");
+		DNAb_release_chains(&chains1);
+		DNAb_release_chains(&chains2);
+		return NULL;
+	}
+
+	int64_t* scores = malloc((n + 1) * sizeof(*scores));
+	int res = -1;
+	if (scores) {
+		Py_BEGIN_ALLOW_THREADS
+		thread_pool_t* pool = thread_pool_create(thread_pool_default_size());
+		res = scoring_proteins_batch(pool, &chains1.chains, &chains2.chains, &scoring, scores);
+		thread_pool_destroy(pool);
+		Py_END_ALLOW_THREADS
+	}
+	DNAb_release_chains(&chains1);
+	DNAb_release_chains(&chains2);
+	if (res) {
+		free(scores);
+		return PyErr_NoMemory();
+	}
+	return DNAb_array_view(scores, "q", sizeof(*scores), 1, n, 0);
+}
+
+//////////////// Scoring all the pairs of a set of amino acid chains
+static PyObject* DNAb_scoring_proteins_all_pairs(PyObject* self, PyObject* args) {
+	PyObject* obj_chains = NULL;
+	const char* matrix = "BLOSUM62";
+	int gapped = 1, gap_open = 11, gap_extend = 1;
+	protein_scoring_t scoring;
+	DNAb_chains_t chains;
+
+	//Get the parameters (amino acid chains, the substitution matrix, gapped or not, and the gap costs)
+	if (!PyArg_ParseTuple(args, "O|spii", &obj_chains, &matrix, &gapped, &gap_open, &gap_extend))
+		return NULL;
+	if (DNAb_get_scoring(matrix, gapped, gap_open, gap_extend, &scoring) || DNAb_get_chains(obj_chains, &chains))
+		return NULL;
+
+	unsigned long long n = chains.chains.nb_chains;
+	int64_t* scores = malloc((n * n + 1) * sizeof(*scores));
+	int res = -1;
+	if (scores) {
+		Py_BEGIN_ALLOW_THREADS
+		thread_pool_t* pool = thread_pool_create(thread_pool_default_size());
+		res = scoring_proteins_all_pairs(pool, &chains.chains, &scoring, scores);
+		thread_pool_destroy(pool);
+		Py_END_ALLOW_THREADS
+	}
+	DNAb_release_chains(&chains);
+	if (res) {
+		free(scores);
+		return PyErr_NoMemory();
+	}
+	return DNAb_array_view(scores, "q", sizeof(*scores), 2, n, n);
+}
+
+/********** BATCH FUNCTIONS **********/
+
+// Get the (start, length) pairs of a batch call: 64 bits integers, of shape (n, 2) or (2n,).
+// Every pair must be in the sequence, its length rounded up to a multiple of unit bits (the bits read).
+static const long* DNAb_get_pairs(PyObject* obj, Py_buffer* view, Py_ssize_t* nb_pairs, const long nb_bits,
+                                  const long unit) {
+	if (PyObject_GetBuffer(obj, view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) == -1)
+		return NULL;
+
+	if (!DNAb_is_int64(view) || view->ndim > 2 || (view->ndim == 2 && view->shape[1] != 2) || (view->len / view->itemsize) % 2) {
+		PyErr_SetString(PyExc_TypeError, "Expecting (start, length) pairs of 64 bits integers.");
+		PyBuffer_Release(view);
+		return NULL;
+	}
+
+	const long* pairs = view->buf;
+	*nb_pairs = view->len / view->itemsize / 2;
+	for (Py_ssize_t i = 0; i < *nb_pairs; i++) {
+		long start = pairs[2 * i], length = pairs[2 * i + 1];
+		if (start < 0 || length <= 0 || length > nb_bits || start > nb_bits - (length + unit - 1) / unit * unit) {
+			PyErr_Format(PyExc_ValueError, "Pair %zd (%ld, %ld) is out of the sequence.", i, start, length);
+			PyBuffer_Release(view);
+			return NULL;
+		}
+	}
+	return pairs;
+}
+
+//////////////// Generating the mRNA of many genes of a sequence
+static PyObject* DNAb_generating_mRNA_batch(PyObject* self, PyObject* args) {
+	Py_buffer view_seq, view_pairs;
+	PyObject* obj_seq = NULL;
+	PyObject* obj_pairs = NULL;
+	long nb_bits;
+	Py_ssize_t n;
+
+	//Get the parameters (1-dimensional array of long int, (start, length) pairs)
+	if (!PyArg_ParseTuple(args, "OO", &obj_seq, &obj_pairs))
+		return NULL;
+	if (DNAb_get_sequence(obj_seq, &view_seq, &nb_bits))
+		return NULL;
+	const long* pairs = DNAb_get_pairs(obj_pairs, &view_pairs, &n, nb_bits, 2);
+	if (!pairs) {
+		PyBuffer_Release(&view_seq);
+		return NULL;
+	}
+
+	//One char per nucleotide
+	int64_t* offsets = malloc(sizeof(*offsets) * (n + 1));
+	PyObject* obj_data = NULL;
+	if (offsets) {
+		offsets[0] = 0;
+		for (Py_ssize_t i = 0; i < n; i++)
+			offsets[i + 1] = offsets[i] + (pairs[2 * i + 1] + 1) / 2;
+		obj_data = PyBytes_FromStringAndSize(NULL, offsets[n]);
+	}
+	if (obj_data) {
+		//The null terminator of a string is overwritten by the next one, the last one is the one of the bytes object
+		char* data = PyBytes_AS_STRING(obj_data);
+		Py_BEGIN_ALLOW_THREADS
+		for (Py_ssize_t i = 0; i < n; i++)
+			generating_mRNA_into(view_seq.buf, pairs[2 * i], pairs[2 * i + 1], data + offsets[i]);
+		Py_END_ALLOW_THREADS
+	}
+	PyBuffer_Release(&view_seq);
+	PyBuffer_Release(&view_pairs);
+
+	if (!obj_data) {
+		free(offsets);
+		return PyErr_Occurred() ? NULL : PyErr_NoMemory();
+	}
+	return Py_BuildValue("(NN)", DNAb_array_view(offsets, "q", sizeof(*offsets), 1, n + 1, 0), obj_data);
+}
+
+//////////////// Generating the amino acid chains of many genes of a sequence
+static PyObject* DNAb_generating_amino_acid_chain_batch(PyObject* self, PyObject* args) {
+	Py_buffer view_seq, view_pairs;
+	PyObject* obj_seq = NULL;
+	PyObject* obj_pairs = NULL;
+	long nb_bits;
+	Py_ssize_t n;
+	int table_id = 0;
+
+	//Get the parameters (1-dimensional array of long int, (start, length) pairs, and the genetic code)
+	if (!PyArg_ParseTuple(args, "OO|i", &obj_seq, &obj_pairs, &table_id))
+		return NULL;
+	if (!codon_table_name(table_id)) {
+		PyErr_Format(PyExc_ValueError, "Unknown translation table %d.", table_id);
+		return NULL;
+	}
+	if (DNAb_get_sequence(obj_seq, &view_seq, &nb_bits))
+		return NULL;
+	const long* pairs = DNAb_get_pairs(obj_pairs, &view_pairs, &n, nb_bits, 6);
+	if (!pairs) {
+		PyBuffer_Release(&view_seq);
+		return NULL;
+	}
+
+	//One char per codon, an empty chain if the length is not a multiple of 3 bits (as None per gene)
+	int64_t* offsets = malloc(sizeof(*offsets) * (n + 1));
+	PyObject* obj_data = NULL;
+	if (offsets) {
+		offsets[0] = 0;
+		for (Py_ssize_t i = 0; i < n; i++)
+			offsets[i + 1] = offsets[i] + (pairs[2 * i + 1] % 3 ? 0 : (pairs[2 * i + 1] + 5) / 6);
+		obj_data = PyBytes_FromStringAndSize(NULL, offsets[n]);
+	}
+	if (obj_data) {
+		char* data = PyBytes_AS_STRING(obj_data);
+		Py_BEGIN_ALLOW_THREADS
+		for (Py_ssize_t i = 0; i < n; i++)
+			generating_amino_acid_chain_table_into(view_seq.buf, pairs[2 * i], pairs[2 * i + 1], table_id,
+			                                       data + offsets[i]);
+		Py_END_ALLOW_THREADS
+	}
+	PyBuffer_Release(&view_seq);
+	PyBuffer_Release(&view_pairs);
+
+	if (!obj_data) {
+		free(offsets);
+		return PyErr_Occurred() ? NULL : PyErr_NoMemory();
+	}
+	return Py_BuildValue("(NN)", DNAb_array_view(offsets, "q", sizeof(*offsets), 1, n + 1, 0), obj_data);
+}
+
+//////////////// Detecting the mutation zones of many genes of a sequence
+static PyObject* DNAb_detecting_mutations_batch(PyObject* self, PyObject* args) {
+	Py_buffer view_seq, view_pairs;
+	PyObject* obj_seq = NULL;
+	PyObject* obj_pairs = NULL;
+	long nb_bits;
+	Py_ssize_t n;
+
+	//Get the parameters (1-dimensional array of long int, (start, length) pairs)
+	if (!PyArg_ParseTuple(args, "OO", &obj_seq, &obj_pairs))
+		return NULL;
+	if (DNAb_get_sequence(obj_seq, &view_seq, &nb_bits))
+		return NULL;
+	const long* pairs = DNAb_get_pairs(obj_pairs, &view_pairs, &n, nb_bits, 2);
+	if (!pairs) {
+		PyBuffer_Release(&view_seq);
+		return NULL;
+	}
+
+	//GENE_MUTATIONS (size, start, end) zones per gene, the found ones are packed
+	int64_t* offsets = malloc(sizeof(*offsets) * (n + 1));
+	uint64_t* zones = malloc(sizeof(*zones) * 3 * GENE_MUTATIONS * (n + 1));
+	if (offsets && zones) {
+		offsets[0] = 0;
+		Py_BEGIN_ALLOW_THREADS
+		for (Py_ssize_t i = 0; i < n; i++) {
+			unsigned long size[GENE_MUTATIONS] = { 0 }, start[GENE_MUTATIONS] = { 0 }, end[GENE_MUTATIONS] = { 0 };
+			mutation_map m = { size, start, end };
+			detecting_mutations(view_seq.buf, pairs[2 * i], pairs[2 * i + 1], m);
+
+			uint64_t* zone = zones + 3 * offsets[i];
+			for (int z = 0; z < GENE_MUTATIONS; z++) {
+				if (!size[z])
+					continue;
+				*zone++ = size[z];
+				*zone++ = start[z];
+				*zone++ = end[z];
+			}
+			offsets[i + 1] = (zone - zones) / 3;
+		}
+		Py_END_ALLOW_THREADS
+	}
+	PyBuffer_Release(&view_seq);
+	PyBuffer_Release(&view_pairs);
+	if (!offsets || !zones) {
+		free(offsets);
+		free(zones);
+		return PyErr_NoMemory();
+	}
+
+	//Zones of shape (m, 3)
+	uint64_t* found = realloc(zones, sizeof(*zones) * (3 * offsets[n] + 1));
+	return Py_BuildValue("(NN)", DNAb_array_view(offsets, "q", sizeof(*offsets), 1, n + 1, 0),
+	                     DNAb_array_view(found ? found : zones, "Q", sizeof(*zones), 2, offsets[n], 3));
+}
+
+//////////////// Calculating the matching scores of the genes of two sequences
+static PyObject* DNAb_calculating_matching_score_batch(PyObject* self, PyObject* args) {
+	Py_buffer view_seq1, view_pairs1, view_seq2, view_pairs2;
+	PyObject* obj_seq1 = NULL;
+	PyObject* obj_pairs1 = NULL;
+	PyObject* obj_seq2 = NULL;
+	PyObject* obj_pairs2 = NULL;
+	long nb_bits1, nb_bits2;
+	Py_ssize_t n1, n2;
+
+	//Get the parameters (2 1-dimensional arrays of long int, with their (start, length) pairs)
+	if (!PyArg_ParseTuple(args, "OOOO", &obj_seq1, &obj_pairs1, &obj_seq2, &obj_pairs2))
+		return NULL;
+	if (DNAb_get_sequence(obj_seq1, &view_seq1, &nb_bits1))
+		return NULL;
+	const long* pairs1 = DNAb_get_pairs(obj_pairs1, &view_pairs1, &n1, nb_bits1, 1);
+	if (!pairs1) {
+		PyBuffer_Release(&view_seq1);
+		return NULL;
+	}
+	if (DNAb_get_sequence(obj_seq2, &view_seq2, &nb_bits2)) {
+		PyBuffer_Release(&view_seq1);
+		PyBuffer_Release(&view_pairs1);
+		return NULL;
+	}
+	const long* pairs2 = DNAb_get_pairs(obj_pairs2, &view_pairs2, &n2, nb_bits2, 1);
+	if (!pairs2) {
+		PyBuffer_Release(&view_seq1);
+		PyBuffer_Release(&view_pairs1);
+		PyBuffer_Release(&view_seq2);
+		return NULL;
+	}
+
+	//Genes of the pairs
+	unsigned long long* bounds = PyMem_RawMalloc(sizeof(*bounds) * 2 * (n1 + n2 + 1));
+	float* scores = malloc(sizeof(*scores) * (n1 * n2 + 1));
+	similarity_hit_t* hits = PyMem_RawMalloc(sizeof(*hits) * (n2 + 1));
+	int res = -1;
+	if (bounds && scores && hits) {
+		gene_map_t genes1 = { n1, bounds, bounds + n1 };
+		gene_map_t genes2 = { n2, bounds + 2 * n1, bounds + 2 * n1 + n2 };
+		for (Py_ssize_t i = 0; i < n1; i++) {
+			genes1.gene_start[i] = pairs1[2 * i];
+			genes1.gene_end[i] = pairs1[2 * i] + pairs1[2 * i + 1] - 1;
+		}
+		for (Py_ssize_t i = 0; i < n2; i++) {
+			genes2.gene_start[i] = pairs2[2 * i];
+			genes2.gene_end[i] = pairs2[2 * i] + pairs2[2 * i + 1] - 1;
+		}
+
+		//The pieces are extracted once per gene, every pair is scored (no threshold)
+		Py_BEGIN_ALLOW_THREADS
+		similarity_genes_t set1 = { 0 }, set2 = { 0 };
+		similarity_stats_t stats = { 0 };
+		if (!similarity_prepare(view_seq1.buf, &genes1, &set1) && !similarity_prepare(view_seq2.buf, &genes2, &set2)) {
+			for (Py_ssize_t j = 0; j < n1; j++) {
+				similarity_above(&set1, j, &set2, -INFINITY, hits, &stats);
+				for (Py_ssize_t k = 0; k < n2; k++)
+					scores[j * n2 + k] = hits[k].score;
+			}
+			res = 0;
+		}
+		similarity_free(&set1);
+		similarity_free(&set2);
+		Py_END_ALLOW_THREADS
+	}
+	PyBuffer_Release(&view_seq1);
+	PyBuffer_Release(&view_pairs1);
+	PyBuffer_Release(&view_seq2);
+	PyBuffer_Release(&view_pairs2);
+
+	PyMem_RawFree(bounds);
+	PyMem_RawFree(hits);
+	if (res) {
+		free(scores);
+		return PyErr_NoMemory();
+	}
+
+	//Scores of shape (n1, n2), row-major
+	return DNAb_array_view(scores, "f", sizeof(*scores), 2, n1, n2);
+}
+
+
+/********** STREAMING ANALYSIS **********/
+
+// Give one stream event to the Python callback, stop the stream if it raises an exception
+static int DNAb_stream_event(const gene_stream_event_t* event, void* arg) {
+	PyObject* callback = arg;
+	PyObject* item = NULL;
+
+	switch (event->type) {
+	case GENE_STREAM_RECORD:
+		item = Py_BuildValue("(skN)", "record", event->record,
+		                     PyUnicode_DecodeUTF8(event->name, strlen(event->name), "replace"));
+		break;
+	case GENE_STREAM_GENE:
+		item = Py_BuildValue("(skKK)", "gene", event->record, event->gene_start, event->gene_end);
+		break;
+	case GENE_STREAM_MUTATION:
+		item = Py_BuildValue("(skKKKKK)", "mutation", event->record, event->gene_start, event->gene_end,
+		                     event->mut_start, event->mut_end, event->mut_size);
+		break;
+	}
+	if (!item)
+		return 1;
+
+	PyObject* res = PyObject_CallFunctionObjArgs(callback, item, NULL);
+	Py_DECREF(item);
+	if (!res)
+		return 1;
+	Py_DECREF(res);
+	return 0;
+}
+
+//////////////// Streaming analysis of a FASTA file
+static PyObject* DNAb_streaming_analysis(PyObject* self, PyObject* args) {
+	char* filename = NULL;
+	PyObject* callback = NULL;
+	Py_ssize_t chunk_size = 0;
+
+	//Get the parameters (FASTA file name, function called for each event, optional chunk size)
+	if (!PyArg_ParseTuple(args, "sO|n", &filename, &callback, &chunk_size))
+		return NULL;
+
+	if (!PyCallable_Check(callback)) {
+		PyErr_SetString(PyExc_TypeError, "Expecting a callable.");
+		return NULL;
+	}
+	if (chunk_size < 0) {
+		PyErr_SetString(PyExc_ValueError, "Expecting a positive chunk size.");
+		return NULL;
+	}
+
+	FILE* in = fopen(filename, "rb");
+	if (!in)
+		return PyErr_SetFromErrnoWithFilename(PyExc_OSError, filename);
+
+	int res = gene_stream_file(in, chunk_size, DNAb_stream_event, callback);
+	fclose(in);
+
+	//The callback exception, or a read error
+	if (PyErr_Occurred())
+		return NULL;
+	if (res) {
+		PyErr_SetString(PyExc_OSError, "Cannot read the FASTA file.");
+		return NULL;
+	}
+	Py_RETURN_NONE;
+}
+
+
+/********** PERFORMANCE COUNTERS **********/
+
+//////////////// Hardware counters totals per call site
+static PyObject* DNAb_perf_counters(PyObject* self) {
+	PyObject* dict = PyDict_New();
+
+	// The library functions are only instrumented when built with -DGENE_PERF
+#ifdef GENE_PERF
+	for (int s = 0; s < PERF_SITES; s++) {
+		perf_counters_t c;
+		perf_counters_get(s, &c);
+		if (!c.calls)
+			continue;
+
+		PyObject* site = PyDict_New();
+		PyObject* item = PyLong_FromUnsignedLongLong(c.calls);
+		PyDict_SetItemString(site, "calls", item);
+		Py_DECREF(item);
+		item = PyLong_FromUnsignedLongLong(c.time_ns);
+		PyDict_SetItemString(site, "time_ns", item);
+		Py_DECREF(item);
+
+		//Unavailable events (virtual machines, restricted perf_event_paranoid) are None
+		for (int e = 0; e < PERF_EVENTS; e++) {
+			if (perf_event_available(e))
+				item = PyLong_FromUnsignedLongLong(c.values[e]);
+			else {
+				item = Py_None;
+				Py_INCREF(item);
+			}
+			PyDict_SetItemString(site, perf_event_name(e), item);
+			Py_DECREF(item);
+		}
+		if (perf_event_available(PERF_CYCLES) && c.values[PERF_CYCLES])
+			item = PyFloat_FromDouble((double)c.values[PERF_INSTRUCTIONS] / c.values[PERF_CYCLES]);
+		else {
+			item = Py_None;
+			Py_INCREF(item);
+		}
+		PyDict_SetItemString(site, "ipc", item);
+		Py_DECREF(item);
+
+		PyDict_SetItemString(dict, perf_site_name(s), site);
+		Py_DECREF(site);
+	}
+#endif
+
+	return dict;
+}
+
+//////////////// Reset the hardware counters totals
+static PyObject* DNAb_perf_counters_reset(PyObject* self) {
+	perf_counters_reset();
+	Py_RETURN_NONE;
 }
 
 
@@ -527,12 +1802,32 @@ static PyMethodDef DNAb_methods [] = {
 	{ "popcount_binary_array", DNAb_popcount_binary_array, METH_VARARGS, "Popcount the binary array sequence"},
 	{ "get_piece_binary_array", DNAb_get_piece_binary_array, METH_VARARGS, "Retrieve piece of the binary array sequence"},
 	{ "convert_to_binary", DNAb_convert_to_binary, METH_VARARGS, "Convert a DNA base sequence to its binary array format"},
+	{ "convert_to_binary_array", DNAb_convert_to_binary_array, METH_VARARGS, "Convert a DNA base sequence to its binary array format, as an array of long int"},
 	{ "binary_to_dna", DNAb_binary_to_dna, METH_VARARGS, "Convert a DNA sequence in binary array format to its DNA bases"},
 	{ "generating_mRNA", DNAb_generating_mRNA, METH_VARARGS, "Convert a DNA sequence in binary array format to its mRNA sequence"},
 	{ "detecting_genes", DNAb_detecting_genes, METH_VARARGS, "Detects genes in the mRNA sequence in binary array format and maps them"},
-	{ "generating_amino_acid_chain", DNAb_generating_amino_acid_chain, METH_VARARGS, "Generate an amino acid chain (protein) from a binary arary sequence"},
+	{ "detecting_genes_array", DNAb_detecting_genes_array, METH_VARARGS, "Detects genes in the mRNA sequence in binary array format, as a structured array of (start, end)"},
+	{ "generating_amino_acid_chain", DNAb_generating_amino_acid_chain, METH_VARARGS, "Generate an amino acid chain (protein) from a binary arary sequence, with an optional NCBI translation table"},
 	{ "detecting_mutations", DNAb_detecting_mutations, METH_VARARGS, "Detects probable mutation areas"},
+	{ "analysing_genes", DNAb_analysing_genes, METH_VARARGS, "Detects genes, and generates their mRNA, amino acid chains and mutation zones in one pass"},
 	{ "calculating_matching_score", DNAb_calculating_matching_score, METH_VARARGS, "Calculates the matching score of two binary array sequences"},
+	{ "calculating_matching_profile", DNAb_calculating_matching_profile, METH_VARARGS, "Calculates the matching score of every window of two binary array sequences"},
+	{ "gc_content_windows", DNAb_gc_content_windows, METH_VARARGS, "Calculates the GC percentage of every window of a binary array sequence"},
+	{ "detecting_variants", DNAb_detecting_variants, METH_VARARGS, "Detects the single base variants of a binary array sequence against a reference, as a structured array of (pos, ref, alt) with 32 bits positions, for genomes below 1.07 Gb"},
+	{ "building_consensus", DNAb_building_consensus, METH_VARARGS, "Builds the consensus of aligned binary array genomes, as (consensus, entropy of each position)"},
+	{ "building_phylogeny", DNAb_building_phylogeny, METH_VARARGS, "Builds the neighbor joining tree of binary array genomes, as (distance matrix, Newick text)"},
+	{ "searching_proteins", DNAb_searching_proteins, METH_VARARGS, "Searches query proteins in the six frames of a binary array genome, as a structured array of ungapped hits"},
+	{ "scoring_proteins", DNAb_scoring_proteins, METH_VARARGS, "Scores two amino acid chains with a substitution matrix (BLOSUM62, PAM250), gapped or not"},
+	{ "scoring_proteins_batch", DNAb_scoring_proteins_batch, METH_VARARGS, "Scores the chain i of a set of amino acid chains against the chain i of another one"},
+	{ "scoring_proteins_all_pairs", DNAb_scoring_proteins_all_pairs, METH_VARARGS, "Scores all the pairs of a set of amino acid chains, as a matrix"},
+	{ "generating_mRNA_batch", DNAb_generating_mRNA_batch, METH_VARARGS, "Generates the mRNA of (start, length) pairs of a sequence, as (offsets, data)"},
+	{ "generating_amino_acid_chain_batch", DNAb_generating_amino_acid_chain_batch, METH_VARARGS, "Generates the amino acid chains of (start, length) pairs of a sequence, as (offsets, data)"},
+	{ "detecting_mutations_batch", DNAb_detecting_mutations_batch, METH_VARARGS, "Detects the mutation zones of (start, length) pairs of a sequence, as (offsets, zones)"},
+	{ "calculating_matching_score_batch", DNAb_calculating_matching_score_batch, METH_VARARGS, "Calculates the matching scores of the (start, length) pairs of two sequences, as a matrix"},
+	{ "perf_counters", (PyCFunction)DNAb_perf_counters, METH_NOARGS, "Return the hardware counters totals of each instrumented function"},
+	{ "perf_counters_reset", (PyCFunction)DNAb_perf_counters_reset, METH_NOARGS, "Reset the hardware counters totals"},
+	{ "streaming_analysis", DNAb_streaming_analysis, METH_VARARGS, "Analyse a FASTA file chunk by chunk, calling a function for each record, gene and mutation zone"},
+	{ "cpu_dispatch_level", (PyCFunction)DNAb_cpu_dispatch_level, METH_NOARGS, "Return the instruction set selected for the hot kernels"},
 	{ "version", (PyCFunction)DNAb_version, METH_VARARGS, "Return the version of the DNA library"},
 	{NULL, NULL, 0, NULL}
 };
@@ -547,11 +1842,21 @@ static PyModuleDef DNAb_module = {
 };
 
 PyMODINIT_FUNC PyInit_DNA_bin() {
+	if (PyType_Ready(&DNAb_array_type) < 0)
+		return NULL;
+
 	PyObject* obj = PyModule_Create(&DNAb_module);
 
 	if (!obj)
 		return NULL;
 
+	Py_INCREF(&DNAb_array_type);
+	if (PyModule_AddObject(obj, "Array", (PyObject*)&DNAb_array_type) < 0) {
+		Py_DECREF(&DNAb_array_type);
+		Py_DECREF(obj);
+		return NULL;
+	}
+
 	DNAb_error = PyErr_NewException("DNAb.error", NULL, NULL);
 	Py_XINCREF(DNAb_error);
 
@@ -0,0 +1,459 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "analysis_cache.h"
+
+// Longest path of a cache file
+#define ANALYSIS_CACHE_PATH_SIZE 4096
+
+
+/***************************************/
+/************** ANALYSIS ***************/
+/***************************************/
+
+static inline uint64_t analysis_mix(uint64_t h){
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+/**
+ * Hash of a packed sequence.
+ *
+ * in : seq_bin : sequence in binary array format
+ * in : nb_bits : number of bits of the sequence
+ * out : uint64_t : 64 bits hash of the integers of the sequence and of its size
+ *
+ * A few multiplications per integer: hashing costs much less than reading the FASTA file.
+ */
+uint64_t analysis_hash(const long int* seq_bin, const long int nb_bits){
+    long int nb_words = binary_array_size(nb_bits);
+    uint64_t h = analysis_mix(0x9e3779b97f4a7c15ULL ^ (uint64_t)nb_bits);
+    for (long int i = 0; i < nb_words; i++) {
+        h ^= analysis_mix((uint64_t)seq_bin[i] + i);
+        h = ((h << 29) | (h >> 35)) * 0x9e3779b97f4a7c15ULL;
+    }
+    return analysis_mix(h);
+}
+
+/**
+ * Number of gene pairs compared inside a genome, as main_bin.py: the genes of the first half
+ * (and the middle one) with those of the first half, when the genome has more than 3 genes.
+ */
+unsigned long long analysis_intra_pairs(const unsigned long long nb_genes){
+    if (nb_genes <= 3)
+        return 0;
+    return (nb_genes / 2 + 1) * (nb_genes / 2);
+}
+
+/**
+ * Genes of the pair index of a genome: j from the middle gene down to the first one, then k from the first gene.
+ */
+void analysis_intra_pair(const unsigned long long nb_genes, const unsigned long long index,
+                         unsigned long long* j, unsigned long long* k){
+    unsigned long long half = nb_genes / 2;
+    *j = half - index / half;
+    *k = index % half;
+}
+
+/**
+ * Free the results of a genome.
+ */
+void analysis_genome_free(analysis_genome_t* genome){
+    free(genome->genes.gene_start);
+    free(genome->genes.gene_end);
+    free(genome->rna);
+    free(genome->rna_offset);
+    free(genome->proteins);
+    free(genome->protein_offset);
+    free(genome->mut_size);
+    free(genome->mut_start);
+    free(genome->mut_end);
+    free(genome->scores);
+    memset(genome, 0, sizeof(*genome));
+}
+
+/**
+ * Allocate the per gene arrays of a genome.
+ */
+static int analysis_genome_alloc(analysis_genome_t* genome, const unsigned long long nb_genes,
+                                 const size_t rna_size, const size_t protein_size, const unsigned long long nb_scores){
+    // One more element: malloc(0) may return NULL
+    genome->genes.gene_start = malloc(sizeof(*genome->genes.gene_start) * (nb_genes + 1));
+    genome->genes.gene_end = malloc(sizeof(*genome->genes.gene_end) * (nb_genes + 1));
+    genome->rna = malloc(rna_size + 1);
+    genome->rna_offset = malloc(sizeof(*genome->rna_offset) * (nb_genes + 1));
+    genome->proteins = malloc(protein_size + 1);
+    genome->protein_offset = malloc(sizeof(*genome->protein_offset) * (nb_genes + 1));
+    genome->mut_size = calloc(ANALYSIS_MUTATIONS * nb_genes + 1, sizeof(*genome->mut_size));
+    genome->mut_start = calloc(ANALYSIS_MUTATIONS * nb_genes + 1, sizeof(*genome->mut_start));
+    genome->mut_end = calloc(ANALYSIS_MUTATIONS * nb_genes + 1, sizeof(*genome->mut_end));
+    genome->scores = malloc(sizeof(*genome->scores) * (nb_scores + 1));
+    genome->genes.genes_counter = nb_genes;
+    genome->nb_scores = nb_scores;
+
+    if (!genome->genes.gene_start || !genome->genes.gene_end || !genome->rna || !genome->rna_offset
+        || !genome->proteins || !genome->protein_offset
+        || !genome->mut_size || !genome->mut_start || !genome->mut_end || !genome->scores) {
+        analysis_genome_free(genome);
+        return printf("ERROR: analysis_genome_alloc: cannot allocate memory\n"), -1;
+    }
+    return 0;
+}
+
+/**
+ * Analyse a genome: genes, mRNA, amino acid chains, mutation zones, and matching scores of its genes.
+ *
+ * in : seq_bin : sequence in binary array format
+ * in : nb_bits : number of bits of the sequence
+ * out : genome : results, to free with analysis_genome_free
+ * out : int : 0, -1 on error
+ *
+ * The genes and their results come from one pass of analysing_genes, whose arrays are kept.
+ */
+int analysing_genome(const long int* seq_bin, const long int nb_bits, analysis_genome_t* genome){
+    memset(genome, 0, sizeof(*genome));
+
+    gene_analysis_t analysis;
+    if (analysing_genes(seq_bin, nb_bits, &analysis))
+        return -1;
+
+    unsigned long long nb_genes = analysis.genes.genes_counter;
+    genome->hash = analysis_hash(seq_bin, nb_bits);
+    genome->nb_bits = nb_bits;
+    genome->genes = analysis.genes;
+    genome->rna = analysis.rna;
+    genome->rna_offset = analysis.rna_offset;
+    genome->proteins = analysis.proteins;
+    genome->protein_offset = analysis.protein_offset;
+    genome->mut_size = analysis.mut_size;
+    genome->mut_start = analysis.mut_start;
+    genome->mut_end = analysis.mut_end;
+    genome->nb_scores = analysis_intra_pairs(nb_genes);
+    genome->scores = malloc(sizeof(*genome->scores) * (genome->nb_scores + 1));
+    if (!genome->scores) {
+        analysis_genome_free(genome);
+        return printf("ERROR: analysing_genome: cannot allocate memory\n"), -1;
+    }
+
+    for (unsigned long long p = 0; p < genome->nb_scores; p++) {
+        unsigned long long j, k;
+        analysis_intra_pair(nb_genes, p, &j, &k);
+        genome->scores[p] = calculating_matching_score(
+            seq_bin, genome->genes.gene_start[j], genome->genes.gene_end[j] - genome->genes.gene_start[j] + 1,
+            seq_bin, genome->genes.gene_start[k], genome->genes.gene_end[k] - genome->genes.gene_start[k] + 1);
+    }
+    return 0;
+}
+
+/**
+ * Matching scores of all the genes of a genome with all the genes of another one.
+ *
+ * in : seq1, genome1 : first genome and its results
+ * in : seq2, genome2 : second genome and its results
+ * out : scores : score of the genes j and k at scores[j * genes of genome2 + k]
+ */
+void comparing_genomes(const long int* seq1, const analysis_genome_t* genome1,
+                       const long int* seq2, const analysis_genome_t* genome2, float* scores){
+    const gene_map_t* g1 = &genome1->genes;
+    const gene_map_t* g2 = &genome2->genes;
+    for (unsigned long long j = 0; j < g1->genes_counter; j++)
+        for (unsigned long long k = 0; k < g2->genes_counter; k++)
+            scores[j * g2->genes_counter + k] = calculating_matching_score(
+                seq1, g1->gene_start[j], g1->gene_end[j] - g1->gene_start[j] + 1,
+                seq2, g2->gene_start[k], g2->gene_end[k] - g2->gene_start[k] + 1);
+}
+
+
+
+/***************************************/
+/**************** CACHE ****************/
+/***************************************/
+
+/**
+ * Open a cache directory (created if needed).
+ *
+ * in : dir : cache directory
+ * out : analysis_cache_t* : cache, NULL on error
+ *
+ * The cache files are written in the format of the machine: a cache is not meant to be shared between architectures.
+ */
+analysis_cache_t* analysis_cache_open(const char* dir){
+    if (mkdir(dir, 0777) && errno != EEXIST)
+        return printf("ERROR: analysis_cache_open: cannot create directory %s\n", dir), NULL;
+
+    analysis_cache_t* cache = calloc(1, sizeof(*cache));
+    if (!cache || !(cache->dir = strdup(dir))) {
+        free(cache);
+        return printf("ERROR: analysis_cache_open: cannot allocate memory\n"), NULL;
+    }
+    pthread_mutex_init(&cache->lock, NULL);
+    return cache;
+}
+
+/**
+ * Free a cache (the files stay).
+ */
+void analysis_cache_close(analysis_cache_t* cache){
+    pthread_mutex_destroy(&cache->lock);
+    free(cache->dir);
+    free(cache);
+}
+
+static void analysis_cache_path(const analysis_cache_t* cache, char* path, const uint64_t hash, const char* ext){
+    snprintf(path, ANALYSIS_CACHE_PATH_SIZE, "%s/%016llx.%s", cache->dir, (unsigned long long)hash, ext);
+}
+
+// Read or write an array, 0 on success
+#define CACHE_READ(ptr, nb, f) (fread((ptr), sizeof(*(ptr)), (nb), (f)) != (size_t)(nb))
+#define CACHE_WRITE(ptr, nb, f) (fwrite((ptr), sizeof(*(ptr)), (nb), (f)) != (size_t)(nb))
+
+/**
+ * Load the results of a genome.
+ *
+ * in : cache : cache
+ * in : hash, nb_bits : hash and size of the packed sequence
+ * out : genome : results, to free with analysis_genome_free
+ * out : int : 0 if found, 1 if the genome is not in the cache, -1 on error
+ */
+int analysis_cache_load_genome(analysis_cache_t* cache, const uint64_t hash, const long int nb_bits,
+                               analysis_genome_t* genome){
+    char path[ANALYSIS_CACHE_PATH_SIZE];
+    analysis_cache_path(cache, path, hash, "genome");
+    memset(genome, 0, sizeof(*genome));
+
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        __atomic_fetch_add(&cache->genome_misses, 1, __ATOMIC_RELAXED);
+        return 1;
+    }
+
+    char magic[sizeof(ANALYSIS_CACHE_MAGIC)];
+    uint64_t header[6];
+    int res = 1;
+    if (CACHE_READ(magic, sizeof(magic), f) || memcmp(magic, ANALYSIS_CACHE_MAGIC, sizeof(magic))
+        || CACHE_READ(header, 6, f) || header[0] != hash || header[1] != (uint64_t)nb_bits)
+        goto end;
+
+    // header: hash, nb_bits, genes, mRNA bytes, protein bytes, scores
+    unsigned long long nb_genes = header[2];
+    if (analysis_genome_alloc(genome, nb_genes, header[3], header[4], header[5])) {
+        res = -1;
+        goto end;
+    }
+    genome->hash = hash;
+    genome->nb_bits = nb_bits;
+    if (CACHE_READ(genome->genes.gene_start, nb_genes, f) || CACHE_READ(genome->genes.gene_end, nb_genes, f)
+        || CACHE_READ(genome->rna_offset, nb_genes, f) || CACHE_READ(genome->rna, header[3], f)
+        || CACHE_READ(genome->protein_offset, nb_genes, f) || CACHE_READ(genome->proteins, header[4], f)
+        || CACHE_READ(genome->mut_size, ANALYSIS_MUTATIONS * nb_genes, f)
+        || CACHE_READ(genome->mut_start, ANALYSIS_MUTATIONS * nb_genes, f)
+        || CACHE_READ(genome->mut_end, ANALYSIS_MUTATIONS * nb_genes, f)
+        || CACHE_READ(genome->scores, header[5], f)) {
+        analysis_genome_free(genome);
+        goto end;
+    }
+    res = 0;
+
+end:
+    fclose(f);
+    __atomic_fetch_add(res ? &cache->genome_misses : &cache->genome_hits, 1, __ATOMIC_RELAXED);
+    return res;
+}
+
+/**
+ * Store the results of a genome.
+ *
+ * out : int : 0, -1 on error
+ *
+ * The file is written under a temporary name, then renamed: a reader never sees a partial file.
+ */
+int analysis_cache_store_genome(analysis_cache_t* cache, const analysis_genome_t* genome){
+    char path[ANALYSIS_CACHE_PATH_SIZE], tmp[ANALYSIS_CACHE_PATH_SIZE + 32];
+    analysis_cache_path(cache, path, genome->hash, "genome");
+    snprintf(tmp, sizeof(tmp), "%s.%ld.%p", path, (long)getpid(), (void*)genome);
+
+    FILE* f = fopen(tmp, "wb");
+    if (!f)
+        return printf("ERROR: analysis_cache_store_genome: cannot open file %s\n", tmp), -1;
+
+    unsigned long long nb_genes = genome->genes.genes_counter;
+    size_t rna_size = 0, protein_size = 0;
+    if (nb_genes) {
+        rna_size = genome->rna_offset[nb_genes - 1] + strlen(genome->rna + genome->rna_offset[nb_genes - 1]) + 1;
+        protein_size = genome->protein_offset[nb_genes - 1]
+                     + strlen(genome->proteins + genome->protein_offset[nb_genes - 1]) + 1;
+    }
+    uint64_t header[6] = { genome->hash, genome->nb_bits, nb_genes, rna_size, protein_size, genome->nb_scores };
+
+    int res = CACHE_WRITE(ANALYSIS_CACHE_MAGIC, sizeof(ANALYSIS_CACHE_MAGIC), f) || CACHE_WRITE(header, 6, f)
+        || CACHE_WRITE(genome->genes.gene_start, nb_genes, f) || CACHE_WRITE(genome->genes.gene_end, nb_genes, f)
+        || CACHE_WRITE(genome->rna_offset, nb_genes, f) || CACHE_WRITE(genome->rna, rna_size, f)
+        || CACHE_WRITE(genome->protein_offset, nb_genes, f) || CACHE_WRITE(genome->proteins, protein_size, f)
+        || CACHE_WRITE(genome->mut_size, ANALYSIS_MUTATIONS * nb_genes, f)
+        || CACHE_WRITE(genome->mut_start, ANALYSIS_MUTATIONS * nb_genes, f)
+        || CACHE_WRITE(genome->mut_end, ANALYSIS_MUTATIONS * nb_genes, f)
+        || CACHE_WRITE(genome->scores, genome->nb_scores, f);
+    res |= fclose(f) != 0;
+
+    if (res || rename(tmp, path)) {
+        remove(tmp);
+        return printf("ERROR: analysis_cache_store_genome: cannot write file %s\n", path), -1;
+    }
+    return 0;
+}
+
+/**
+ * Load the index of the pair score blocks of a first genome.
+ *
+ * in : cache : cache
+ * in : hash : hash of the first genome
+ * out : row : index of the blocks, to close with analysis_cache_close_row
+ * out : int : 0, -1 on error
+ *
+ * A block cut by an interrupted run is removed from the file.
+ */
+int analysis_cache_load_row(analysis_cache_t* cache, const uint64_t hash, analysis_cache_row_t* row){
+    char path[ANALYSIS_CACHE_PATH_SIZE];
+    analysis_cache_path(cache, path, hash, "pairs");
+    memset(row, 0, sizeof(*row));
+    row->hash = hash;
+
+    row->file = fopen(path, "rb");
+    if (!row->file)
+        return 0;
+
+    // No block is appended (identical genomes share their pair file) while the file is scanned
+    pthread_mutex_lock(&cache->lock);
+    int res = 0;
+    char magic[sizeof(ANALYSIS_CACHE_MAGIC)];
+    long size = fseek(row->file, 0, SEEK_END) ? 0 : ftell(row->file);
+    rewind(row->file);
+    if (CACHE_READ(magic, sizeof(magic), row->file) || memcmp(magic, ANALYSIS_CACHE_MAGIC, sizeof(magic))) {
+        // Other format: start again
+        fclose(row->file);
+        row->file = NULL;
+        res = remove(path);
+        pthread_mutex_unlock(&cache->lock);
+        return res ? -1 : 0;
+    }
+
+    unsigned long capacity = 0;
+    long end = sizeof(magic);
+    uint64_t header[3];
+    while (!res && !CACHE_READ(header, 3, row->file)) {
+        // header: second genome, genes of both genomes, then the scores
+        long offset = end + sizeof(header);
+        long next = offset + (long)(header[1] * header[2] * sizeof(float));
+        if (next > size || fseek(row->file, next, SEEK_SET))
+            break;
+        if (row->nb_blocks == capacity) {
+            capacity = capacity ? 2 * capacity : 64;
+            uint64_t* hash2 = realloc(row->hash2, capacity * sizeof(*hash2));
+            if (hash2)
+                row->hash2 = hash2;
+            uint64_t* nb1 = realloc(row->nb_genes1, capacity * sizeof(*nb1));
+            if (nb1)
+                row->nb_genes1 = nb1;
+            uint64_t* nb2 = realloc(row->nb_genes2, capacity * sizeof(*nb2));
+            if (nb2)
+                row->nb_genes2 = nb2;
+            long* offsets = realloc(row->offset, capacity * sizeof(*offsets));
+            if (offsets)
+                row->offset = offsets;
+            if (!hash2 || !nb1 || !nb2 || !offsets) {
+                printf("ERROR: analysis_cache_load_row: cannot allocate memory\n");
+                res = -1;
+                break;
+            }
+        }
+        row->hash2[row->nb_blocks] = header[0];
+        row->nb_genes1[row->nb_blocks] = header[1];
+        row->nb_genes2[row->nb_blocks] = header[2];
+        row->offset[row->nb_blocks] = offset;
+        row->nb_blocks++;
+        end = next;
+    }
+
+    // Block cut by an interrupted run
+    if (!res && size > end)
+        res = truncate(path, end);
+    pthread_mutex_unlock(&cache->lock);
+
+    if (res)
+        analysis_cache_close_row(row);
+    return res ? -1 : 0;
+}
+
+/**
+ * Close the index of the pair score blocks of a genome.
+ */
+void analysis_cache_close_row(analysis_cache_row_t* row){
+    if (row->file)
+        fclose(row->file);
+    free(row->hash2);
+    free(row->nb_genes1);
+    free(row->nb_genes2);
+    free(row->offset);
+    memset(row, 0, sizeof(*row));
+}
+
+/**
+ * Load the pair scores of two genomes.
+ *
+ * in : cache : cache
+ * in : row : index of the first genome
+ * in : hash2 : hash of the second genome
+ * in : nb_genes1, nb_genes2 : number of genes of the genomes
+ * out : scores : scores, as comparing_genomes
+ * out : int : 0 if found, 1 if the block is not in the cache
+ */
+int analysis_cache_load_scores(analysis_cache_t* cache, const analysis_cache_row_t* row, const uint64_t hash2,
+                               const uint64_t nb_genes1, const uint64_t nb_genes2, float* scores){
+    for (unsigned long b = 0; b < row->nb_blocks; b++) {
+        if (row->hash2[b] != hash2 || row->nb_genes1[b] != nb_genes1 || row->nb_genes2[b] != nb_genes2)
+            continue;
+        if (fseek(row->file, row->offset[b], SEEK_SET) || CACHE_READ(scores, nb_genes1 * nb_genes2, row->file))
+            break;
+        __atomic_fetch_add(&cache->pair_hits, 1, __ATOMIC_RELAXED);
+        return 0;
+    }
+    __atomic_fetch_add(&cache->pair_misses, 1, __ATOMIC_RELAXED);
+    return 1;
+}
+
+/**
+ * Store the pair scores of two genomes, at the end of the pair file of the first one.
+ *
+ * out : int : 0, -1 on error
+ */
+int analysis_cache_store_scores(analysis_cache_t* cache, const uint64_t hash1, const uint64_t hash2,
+                                const uint64_t nb_genes1, const uint64_t nb_genes2, const float* scores){
+    char path[ANALYSIS_CACHE_PATH_SIZE];
+    analysis_cache_path(cache, path, hash1, "pairs");
+    uint64_t header[3] = { hash2, nb_genes1, nb_genes2 };
+
+    // Identical genomes share their pair file
+    pthread_mutex_lock(&cache->lock);
+    FILE* f = fopen(path, "ab");
+    int res = !f;
+    if (f) {
+        if (!fseek(f, 0, SEEK_END) && ftell(f) == 0)
+            res |= CACHE_WRITE(ANALYSIS_CACHE_MAGIC, sizeof(ANALYSIS_CACHE_MAGIC), f);
+        res |= CACHE_WRITE(header, 3, f) || CACHE_WRITE(scores, nb_genes1 * nb_genes2, f);
+        res |= fclose(f) != 0;
+    }
+    pthread_mutex_unlock(&cache->lock);
+
+    if (res)
+        return printf("ERROR: analysis_cache_store_scores: cannot write file %s\n", path), -1;
+    return 0;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "gene_bin.h"
+
+// Header of the cache files, to change when the cached results or their format change
+#define ANALYSIS_CACHE_MAGIC "DNACAC2"
+// Mutation zones kept per gene (as analysing_genes)
+#define ANALYSIS_MUTATIONS GENE_MUTATIONS
+
+typedef struct analysis_genome_s {
+
+    //Hash of the packed sequence (analysis_hash), and its number of bits
+    uint64_t hash;
+    long int nb_bits;
+
+    gene_map_t genes;
+
+    //mRNA of each gene: null terminated, at rna + rna_offset[gene]
+    char* rna;
+    size_t* rna_offset;
+
+    //Amino acid chain of each gene: null terminated, at proteins + protein_offset[gene]
+    char* proteins;
+    size_t* protein_offset;
+
+    //Mutation zones of each gene: ANALYSIS_MUTATIONS per gene, as mutation_map (size 0: no zone)
+    unsigned long* mut_size;
+    unsigned long* mut_start;
+    unsigned long* mut_end;
+
+    //Matching scores of the genes of the genome, in the order of analysis_intra_pair
+    unsigned long long nb_scores;
+    float* scores;
+
+}analysis_genome_t;
+
+typedef struct analysis_cache_s {
+
+    //Cache directory: <hash>.genome per genome, <hash>.pairs for the pair scores of a genome
+    char* dir;
+
+    //Appends to the pair files
+    pthread_mutex_t lock;
+
+    //Reuse statistics
+    unsigned long long genome_hits;
+    unsigned long long genome_misses;
+    unsigned long long pair_hits;
+    unsigned long long pair_misses;
+
+}analysis_cache_t;
+
+typedef struct analysis_cache_row_s {
+
+    //Pair score blocks stored for a first genome
+    uint64_t hash;
+    FILE* file;
+    unsigned long nb_blocks;
+    uint64_t* hash2;
+    uint64_t* nb_genes1;
+    uint64_t* nb_genes2;
+    long* offset;
+
+}analysis_cache_row_t;
+
+
+/******** ANALYSIS FUNCTION *********/
+
+uint64_t analysis_hash(const long int* seq_bin, const long int nb_bits);
+unsigned long long analysis_intra_pairs(const unsigned long long nb_genes);
+void analysis_intra_pair(const unsigned long long nb_genes, const unsigned long long index,
+                         unsigned long long* j, unsigned long long* k);
+int analysing_genome(const long int* seq_bin, const long int nb_bits, analysis_genome_t* genome);
+void comparing_genomes(const long int* seq1, const analysis_genome_t* genome1,
+                       const long int* seq2, const analysis_genome_t* genome2, float* scores);
+void analysis_genome_free(analysis_genome_t* genome);
+
+
+/******** CACHE FUNCTION *********/
+
+analysis_cache_t* analysis_cache_open(const char* dir);
+void analysis_cache_close(analysis_cache_t* cache);
+int analysis_cache_load_genome(analysis_cache_t* cache, const uint64_t hash, const long int nb_bits,
+                               analysis_genome_t* genome);
+int analysis_cache_store_genome(analysis_cache_t* cache, const analysis_genome_t* genome);
+int analysis_cache_load_row(analysis_cache_t* cache, const uint64_t hash, analysis_cache_row_t* row);
+void analysis_cache_close_row(analysis_cache_row_t* row);
+int analysis_cache_load_scores(analysis_cache_t* cache, const analysis_cache_row_t* row, const uint64_t hash2,
+                               const uint64_t nb_genes1, const uint64_t nb_genes2, float* scores);
+int analysis_cache_store_scores(analysis_cache_t* cache, const uint64_t hash1, const uint64_t hash2,
+                                const uint64_t nb_genes1, const uint64_t nb_genes2, const float* scores);
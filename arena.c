@@ -0,0 +1,316 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include "arena.h"
+
+
+/***************************************/
+/************ PAGE POLICIES ************/
+/***************************************/
+
+// Size of a mapping of size bytes with a page policy
+static size_t arena_pages_size(const size_t size, const int flags){
+    size_t page = flags & (ARENA_HUGE | ARENA_HUGETLB) ? ARENA_HUGE_PAGE_SIZE : (size_t)sysconf(_SC_PAGESIZE);
+    return (size + page - 1) / page * page;
+}
+
+// Interleave the pages of a mapping over the online NUMA nodes, nothing on a single node machine
+static void arena_interleave(void* ptr, const size_t size){
+#ifdef SYS_mbind
+    unsigned long nodes = 0;
+    FILE* f = fopen("/sys/devices/system/node/online", "r");
+    if (!f)
+        return;
+    // List of ranges: "0-3,6"
+    unsigned first, last;
+    int n;
+    while ((n = fscanf(f, "%u-%u", &first, &last)) >= 1) {
+        if (n == 1)
+            last = first;
+        for (unsigned node = first; node <= last && node < 64; node++)
+            nodes |= 1UL << node;
+        if (fgetc(f) != ',')
+            break;
+    }
+    fclose(f);
+
+    // MPOL_INTERLEAVE, without libnuma
+    if (nodes & (nodes - 1))
+        syscall(SYS_mbind, ptr, size, 3, &nodes, 64, 0);
+#endif
+}
+
+/**
+ * Allocate memory with its own pages.
+ *
+ * in : size : number of bytes
+ * in : flags : ARENA_HUGE, ARENA_HUGETLB and ARENA_INTERLEAVE combined (ARENA_PAGES alone: regular pages)
+ * out : void* : page aligned memory (ARENA_HUGE_PAGE_SIZE aligned with huge pages), filled with 0 when touched,
+ *               to free with arena_pages_free. NULL on error.
+ *
+ * The pages are only given when touched: unless they are interleaved, each page is placed on the NUMA
+ * node of the thread that writes it first (thread_pool_first_touch). Explicit huge pages fall back to
+ * transparent ones, which fall back to regular pages.
+ */
+void* arena_pages_alloc(const size_t size, const int flags){
+    size_t length = arena_pages_size(size ? size : 1, flags);
+    void* ptr = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+    if (flags & ARENA_HUGETLB)
+        ptr = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+    if (ptr == MAP_FAILED && flags & (ARENA_HUGE | ARENA_HUGETLB)) {
+        // Aligned on a huge page: map one more and unmap the edges
+        char* raw = mmap(NULL, length + ARENA_HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED)
+            return printf("ERROR: arena_pages_alloc: cannot allocate %zu bytes\n", size), NULL;
+        char* aligned = (char*)(((uintptr_t)raw + ARENA_HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(ARENA_HUGE_PAGE_SIZE - 1));
+        if (aligned > raw)
+            munmap(raw, aligned - raw);
+        munmap(aligned + length, raw + ARENA_HUGE_PAGE_SIZE - aligned);
+        ptr = aligned;
+#ifdef MADV_HUGEPAGE
+        madvise(ptr, length, MADV_HUGEPAGE);
+#endif
+    }
+    else if (ptr == MAP_FAILED) {
+        ptr = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (ptr == MAP_FAILED)
+            return printf("ERROR: arena_pages_alloc: cannot allocate %zu bytes\n", size), NULL;
+    }
+
+    if (flags & ARENA_INTERLEAVE)
+        arena_interleave(ptr, length);
+    return ptr;
+}
+
+/**
+ * Free the memory of arena_pages_alloc.
+ *
+ * in : ptr : memory to free (NULL: nothing)
+ * in : size, flags : as given to arena_pages_alloc
+ */
+void arena_pages_free(void* ptr, const size_t size, const int flags){
+    if (ptr)
+        munmap(ptr, arena_pages_size(size ? size : 1, flags));
+}
+
+
+
+/***************************************/
+/*************** ARENAS ****************/
+/***************************************/
+
+
+/**
+ * Allocate a new block and chain it in front of the current one.
+ */
+static arena_block_t* arena_new_block(arena_t* arena, size_t size){
+    arena_block_t* block = NULL;
+    size_t mapped = 0;
+
+    if (arena->flags) {
+        // The whole mapping is usable
+        mapped = arena_pages_size(sizeof(*block) + size, arena->flags);
+        size = mapped - sizeof(*block);
+        block = arena_pages_alloc(mapped, arena->flags);
+    }
+    else
+        block = malloc(sizeof(*block) + size);
+    if (!block)
+        return printf("ERROR: arena_new_block: cannot allocate memory\n"), NULL;
+
+    block->prev = arena->block;
+    block->size = size;
+    block->used = 0;
+    block->mapped = mapped;
+    arena->block = block;
+    return block;
+}
+
+static void arena_free_block(const arena_t* arena, arena_block_t* block){
+    if (block->mapped)
+        arena_pages_free(block, block->mapped, arena->flags);
+    else
+        free(block);
+}
+
+/**
+ * Initialize an arena.
+ *
+ * in : arena : arena to initialize
+ * in : size : size of the first block (0 = ARENA_BLOCK_SIZE)
+ * out : int : 0 on success, -1 on error
+ */
+int arena_init(arena_t* arena, const size_t size){
+    return arena_init_pages(arena, size, 0);
+}
+
+/**
+ * Initialize an arena whose blocks are mapped with a page policy.
+ *
+ * in : arena : arena to initialize
+ * in : size : size of the first block (0 = ARENA_BLOCK_SIZE), rounded up to whole pages
+ * in : flags : ARENA_PAGES, ARENA_HUGE, ARENA_HUGETLB and ARENA_INTERLEAVE combined, 0 for malloc
+ * out : int : 0 on success, -1 on error
+ *
+ * For the large packed genomes: huge pages cut the TLB misses of the scans, and the pages of
+ * a block are placed by the first thread writing them, or interleaved over the NUMA nodes.
+ */
+int arena_init_pages(arena_t* arena, const size_t size, const int flags){
+    arena->block = NULL;
+    arena->block_size = size ? size : ARENA_BLOCK_SIZE;
+    arena->flags = flags;
+    return arena_new_block(arena, arena->block_size) ? 0 : -1;
+}
+
+/**
+ * Allocate memory in an arena.
+ *
+ * in : arena : arena
+ * in : size : number of bytes
+ * out : void* : ARENA_ALIGN aligned memory, valid until the arena is rewound, reset or released. NULL on error.
+ *
+ * Bumps a pointer in the current block. When the block is full, a new block at least twice larger is chained:
+ * the memory already allocated never moves.
+ */
+void* arena_alloc(arena_t* arena, const size_t size){
+    if (size > SIZE_MAX / 4)
+        return printf("ERROR: arena_alloc: cannot allocate %zu bytes\n", size), NULL;
+
+    size_t aligned = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    arena_block_t* block = arena->block;
+
+    if (!block || block->size - block->used < aligned) {
+        if (block)
+            arena->block_size *= 2;
+        while (arena->block_size < aligned)
+            arena->block_size *= 2;
+        if (!(block = arena_new_block(arena, arena->block_size)))
+            return NULL;
+    }
+
+    void* ptr = block->data + block->used;
+    block->used += aligned;
+    return ptr;
+}
+
+/**
+ * Current position of an arena.
+ */
+arena_mark_t arena_mark(const arena_t* arena){
+    arena_mark_t mark = { arena->block, arena->block ? arena->block->used : 0, arena->block_size };
+    return mark;
+}
+
+/**
+ * Free everything allocated since a mark.
+ *
+ * in : arena : arena
+ * in : mark : position returned by arena_mark
+ *
+ * The size of the next block goes back to its value at the mark, so that repeated
+ * mark / large allocation / rewind cycles do not double it each time.
+ */
+void arena_rewind(arena_t* arena, const arena_mark_t mark){
+    while (arena->block && arena->block != mark.block) {
+        arena_block_t* prev = arena->block->prev;
+        arena_free_block(arena, arena->block);
+        arena->block = prev;
+    }
+    if (arena->block)
+        arena->block->used = mark.used;
+    if (mark.block_size)
+        arena->block_size = mark.block_size;
+}
+
+/**
+ * Free everything allocated in an arena, and keep its memory for the next allocations.
+ *
+ * in : arena : arena
+ *
+ * If several blocks were needed, they are replaced by one block of their total size,
+ * so that an arena reset between genomes of similar sizes stops allocating after the first one.
+ */
+void arena_reset(arena_t* arena){
+    arena_block_t* block = arena->block;
+    if (!block)
+        return;
+
+    if (block->prev) {
+        size_t total = arena_capacity(arena);
+        arena_release(arena);
+        arena->block_size = total;
+        arena_new_block(arena, total);
+        return;
+    }
+    block->used = 0;
+}
+
+/**
+ * Free the memory of an arena.
+ */
+void arena_release(arena_t* arena){
+    while (arena->block) {
+        arena_block_t* prev = arena->block->prev;
+        arena_free_block(arena, arena->block);
+        arena->block = prev;
+    }
+}
+
+/**
+ * Total size of the blocks of an arena.
+ */
+size_t arena_capacity(const arena_t* arena){
+    size_t total = 0;
+    for (const arena_block_t* block = arena->block; block; block = block->prev)
+        total += block->size;
+    return total;
+}
+
+
+
+/***************************************/
+/********* PER-THREAD ARENAS ***********/
+/***************************************/
+
+static pthread_key_t arena_key;
+static pthread_once_t arena_key_once = PTHREAD_ONCE_INIT;
+
+static void arena_thread_free(void* ptr){
+    arena_release(ptr);
+    free(ptr);
+}
+
+static void arena_key_create(void){
+    pthread_key_create(&arena_key, arena_thread_free);
+}
+
+/**
+ * Arena of the calling thread.
+ *
+ * out : arena : arena of the calling thread, created at the first call and released at the thread exit. NULL on error.
+ *
+ * The library functions only use it between an arena_mark and an arena_rewind,
+ * the caller is free to reset it between two genomes.
+ */
+arena_t* arena_thread(void){
+    pthread_once(&arena_key_once, arena_key_create);
+
+    arena_t* arena = pthread_getspecific(arena_key);
+    if (!arena) {
+        arena = malloc(sizeof(*arena));
+        if (!arena || arena_init(arena, 0))
+            return printf("ERROR: arena_thread: cannot allocate memory\n"), free(arena), NULL;
+        pthread_setspecific(arena_key, arena);
+    }
+    return arena;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stddef.h>
+
+// Default size of the first block of an arena
+#define ARENA_BLOCK_SIZE (1 << 20)
+// Alignment of the allocations
+#define ARENA_ALIGN 16
+
+// Page policies of the blocks of an arena (arena_init_pages) and of arena_pages_alloc
+// Blocks mapped with their own pages, placed on the NUMA node of the thread that touches them first
+#define ARENA_PAGES 1
+// Transparent huge pages (madvise), the mappings are aligned on ARENA_HUGE_PAGE_SIZE
+#define ARENA_HUGE 2
+// Explicit huge pages (MAP_HUGETLB), transparent ones if none is reserved
+#define ARENA_HUGETLB 4
+// Pages interleaved over the NUMA nodes
+#define ARENA_INTERLEAVE 8
+// Size of the huge pages
+#define ARENA_HUGE_PAGE_SIZE (2UL << 20)
+
+typedef struct arena_block_s {
+
+    //Previous (older) block
+    struct arena_block_s* prev;
+
+    //Usable size and used size of the block
+    size_t size;
+    size_t used;
+    //Size of the mapping of the block (page policies), 0 if it is allocated by malloc
+    size_t mapped;
+
+    char data[];
+
+}arena_block_t;
+
+typedef struct arena_s {
+
+    //Current block, the older ones are chained behind it
+    arena_block_t* block;
+
+    //Size of the next block
+    size_t block_size;
+
+    //Page policy of the blocks (ARENA_PAGES...), 0 for malloc
+    int flags;
+
+}arena_t;
+
+// Position in an arena, to free everything allocated after it, and size of its next block then
+typedef struct arena_mark_s {
+    arena_block_t* block;
+    size_t used;
+    size_t block_size;
+}arena_mark_t;
+
+
+/******** ARENA FUNCTION *********/
+
+int arena_init(arena_t* arena, const size_t size);
+int arena_init_pages(arena_t* arena, const size_t size, const int flags);
+void* arena_alloc(arena_t* arena, const size_t size);
+arena_mark_t arena_mark(const arena_t* arena);
+void arena_rewind(arena_t* arena, const arena_mark_t mark);
+void arena_reset(arena_t* arena);
+void arena_release(arena_t* arena);
+size_t arena_capacity(const arena_t* arena);
+arena_t* arena_thread(void);
+void* arena_pages_alloc(const size_t size, const int flags);
+void arena_pages_free(void* ptr, const size_t size, const int flags);
@@ -0,0 +1,166 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+
+#include "consensus.h"
+
+// Planes of the counters: enough for UINT32_MAX genomes
+#define CONSENSUS_PLANES 33
+
+
+/***************************************/
+/************** PACKING ****************/
+/***************************************/
+
+/**
+ * Bases of a block, as one bit per base for each of A, G, C and T.
+ *
+ * in : seq_bin, nb_words : binary array and its number of words
+ * in : base : first base of the block
+ * in : valid : bases of the block in the sequence
+ * out : planes : bit j of planes[code] is set if the base + j is the base of this code (A = 0, G = 1, C = 2, T = 3)
+ */
+static inline void consensus_planes(const long int* seq_bin, const long int nb_words, const uint64_t base,
+                                    const uint64_t valid, uint64_t planes[4]){
+    unsigned long long bits[2];
+    get_bases_binary_array(seq_bin, nb_words, base, bits);
+    uint64_t first = bits[0], second = bits[1];
+    planes[0] = ~first & ~second & valid;
+    planes[1] = ~first & second & valid;
+    planes[2] = first & ~second & valid;
+    planes[3] = first & second & valid;
+}
+
+
+
+/***************************************/
+/************** COUNTING ***************/
+/***************************************/
+
+// Add a plane of bits at a weight of the vertical counters
+static inline void consensus_add(uint64_t* counter, int plane, uint64_t carry){
+    while (carry) {
+        uint64_t next = counter[plane] & carry;
+        counter[plane++] ^= carry;
+        carry = next;
+    }
+}
+
+typedef struct consensus_job_s {
+    const long int* const* seqs_bin;
+    unsigned long long nb_genomes;
+    unsigned long long nb_bases;
+    char* consensus;
+    float* entropy;
+    uint32_t* counts;
+}consensus_job_t;
+
+/**
+ * Consensus of blocks of bases (thread pool task).
+ *
+ * The bases of a block are counted for all the genomes at once: counter[code][k] holds the bit k of the
+ * count of the code at each of the 64 bases. The genomes are added two by two with a carry-save adder,
+ * whose carries go to the counters from their bit 1, so that most additions stop at the first bits.
+ */
+GENE_KERNEL
+static void consensus_task(void* arg, const unsigned long long begin, const unsigned long long end,
+                           const unsigned thread_id){
+    const consensus_job_t* job = arg;
+    const long int nb_words = binary_array_size(2 * job->nb_bases);
+    const int nb_planes = 64 - __builtin_clzll(job->nb_genomes | 1);
+    // Codes of A, C, G and T
+    static const int order[4] = { 0, 2, 1, 3 };
+
+    for (unsigned long long block = begin; block < end; block++) {
+        uint64_t base = block * CONSENSUS_BLOCK;
+        uint64_t n = job->nb_bases - base < CONSENSUS_BLOCK ? job->nb_bases - base : CONSENSUS_BLOCK;
+        uint64_t valid = n < 64 ? (1ULL << n) - 1 : UINT64_MAX;
+
+        uint64_t counter[4][CONSENSUS_PLANES] = { { 0 } };
+        uint64_t planes1[4], planes2[4];
+        unsigned long long g = 0;
+        for (; g + 1 < job->nb_genomes; g += 2) {
+            consensus_planes(job->seqs_bin[g], nb_words, base, valid, planes1);
+            consensus_planes(job->seqs_bin[g + 1], nb_words, base, valid, planes2);
+            for (int c = 0; c < 4; c++) {
+                uint64_t u = counter[c][0] ^ planes1[c];
+                uint64_t carry = (counter[c][0] & planes1[c]) | (u & planes2[c]);
+                counter[c][0] = u ^ planes2[c];
+                consensus_add(counter[c], 1, carry);
+            }
+        }
+        if (g < job->nb_genomes) {
+            consensus_planes(job->seqs_bin[g], nb_words, base, valid, planes1);
+            for (int c = 0; c < 4; c++)
+                consensus_add(counter[c], 0, planes1[c]);
+        }
+
+        // Counts of A, C, G and T, then the most frequent (the first on ties) and the entropy
+        for (uint64_t j = 0; j < n; j++) {
+            uint32_t count[4];
+            for (int c = 0; c < 4; c++) {
+                count[c] = 0;
+                for (int k = 0; k < nb_planes; k++)
+                    count[c] |= (uint32_t)(counter[order[c]][k] >> j & 1) << k;
+            }
+
+            if (job->counts)
+                memcpy(job->counts + 4 * (base + j), count, sizeof(count));
+            if (job->consensus) {
+                int best = 0;
+                for (int c = 1; c < 4; c++)
+                    if (count[c] > count[best])
+                        best = c;
+                job->consensus[base + j] = "ACGT"[best];
+            }
+            if (job->entropy) {
+                double h = 0;
+                for (int c = 0; c < 4; c++)
+                    if (count[c]) {
+                        double f = (double)count[c] / job->nb_genomes;
+                        h -= f * log2(f);
+                    }
+                job->entropy[base + j] = h;
+            }
+        }
+    }
+}
+
+/**
+ * Consensus of aligned genomes, with the entropy of each position.
+ *
+ * in : pool : threads sharing the blocks of bases, NULL for the calling thread only
+ * in : seqs_bin, nb_genomes : genomes in binary array format, aligned (same positions)
+ * in : nb_bases : bases of each genome
+ * out : consensus : most frequent base at each position (nb_bases + 1 chars, null terminated), NULL for none
+ * out : entropy : Shannon entropy of the bases at each position, in bits (nb_bases floats), NULL for none
+ * out : counts : number of A, C, G and T at each position (4 * nb_bases, in this order), NULL for none
+ * out : int : 0, -1 on error
+ *
+ * The bases are counted 64 positions at a time without decoding them: each genome gives one bit
+ * per position for each base, added to bit-sliced counters (consensus_task).
+ */
+int building_consensus(thread_pool_t* pool, const long int* const* seqs_bin, const unsigned long long nb_genomes,
+                       const unsigned long long nb_bases, char* consensus, float* entropy, uint32_t* counts){
+    if (!seqs_bin || !nb_genomes)
+        return printf("ERROR: building_consensus: undefined genomes\n"), -1;
+    if (nb_genomes > UINT32_MAX)
+        return printf("ERROR: building_consensus: too many genomes\n"), -1;
+    if (nb_bases >= INT_MAX / 2)
+        return printf("ERROR: building_consensus: sequence too long\n"), -1;
+    for (unsigned long long g = 0; g < nb_genomes; g++)
+        if (!seqs_bin[g])
+            return printf("ERROR: building_consensus: undefined genome\n"), -1;
+
+    consensus_job_t job = { seqs_bin, nb_genomes, nb_bases, consensus, entropy, counts };
+    unsigned long long nb_blocks = (nb_bases + CONSENSUS_BLOCK - 1) / CONSENSUS_BLOCK;
+    if (pool)
+        thread_pool_run_dynamic(pool, nb_blocks, CONSENSUS_CHUNK, consensus_task, &job);
+    else
+        consensus_task(&job, 0, nb_blocks, 0);
+    if (consensus)
+        consensus[nb_bases] = '\0';
+    return 0;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "gene_bin.h"
+#include "thread_pool.h"
+
+// Bases counted together by the bit-sliced counters, one per bit of a word
+#define CONSENSUS_BLOCK 64
+// Blocks of bases claimed at once by a thread
+#define CONSENSUS_CHUNK 16
+
+
+/******** CONSENSUS FUNCTION *********/
+
+int building_consensus(thread_pool_t* pool, const long int* const* seqs_bin, const unsigned long long nb_genomes,
+                       const unsigned long long nb_bases, char* consensus, float* entropy, uint32_t* counts);
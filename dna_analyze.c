@@ -0,0 +1,738 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <ctype.h>
+#include <math.h>
+#include <errno.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "gene_bin.h"
+#include "arena.h"
+#include "thread_pool.h"
+#include "result_writer.h"
+#include "analysis_cache.h"
+#include "similarity.h"
+
+// Longest path of an input or output file
+#define ANALYZE_PATH_SIZE 4096
+
+// Head of every HTML page, as written by main_bin.py
+static const char* html_start =
+    "<html>\n"
+    "  <head><style> \n"
+    "  th, td {\n"
+    "    font-size: 10px; \n"
+    "  }\n"
+    "  .title {\n"
+    "    font-size: 15px; \n"
+    "  }\n"
+    "  /*Style du tableau*/\n"
+    "  table, th, td {\n"
+    "    border: 1px solid black;\n"
+    "    border-collapse: collapse;\n"
+    "    border-style: dashed;\n"
+    "  }\n"
+    "  .title {\n"
+    "    border-style : dashed dashed dashed solid;\n"
+    "    padding-left: 1%;\n"
+    "  }\n"
+    "  table {\n"
+    "    width:90%;\n"
+    "    margin-left : 5%;\n"
+    "  }\n"
+    "\n"
+    "  details > summary {\n"
+    "    padding: 4px;\n"
+    "    width: 200px;\n"
+    "    background-color: #eeeeee;\n"
+    "    border: none;\n"
+    "    box-shadow: 1px 1px 2px #bbbbbb;\n"
+    "    cursor: help;\n"
+    "  }\n"
+    "  </style>\n"
+    "  </head>\n"
+    "\n"
+    "  ";
+
+static const char* html_genes_header =
+    "<table>\n<tbody>\n<tr>\n<td class = \"title\">Sequence</td>\n<td class = \"title\">MRNA</td>\n"
+    "<td class = \"title\">Chain</td>\n<td class = \"title\">Mutation</td>\n</tr>\n";
+
+static const char* html_scores_header =
+    "<table>\n<tr>\n<th class = \"title\">Sequence</th>\n<th class = \"title\">Matching</th>\n</tr>\n<tbody>";
+
+typedef struct analyze_file_s {
+
+    //File name in the input directory, and the same name without ".fasta"
+    char* name;
+    char* title;
+
+    //Sequence in binary array format, and its number of bits (whole integers, as DNA_bin.detecting_genes)
+    long int* seq_bin;
+    long int nb_bits;
+
+    //Genes, amino acid chains, mutation zones and scores of the genes of the file
+    analysis_genome_t genome;
+    //Pieces of the genes, for the similarity queries
+    similarity_genes_t set;
+
+    int error;
+    //Error of the comparisons of the file with the previous ones
+    int compare_error;
+
+}analyze_file_t;
+
+typedef struct analyze_s {
+
+    const char* input;
+    const char* output;
+
+    analyze_file_t* files;
+    unsigned long nb_files;
+
+    //Machine-readable results instead of the HTML pages, NULL for HTML
+    result_writer_t* writer;
+    //Results of the previous runs, NULL without cache
+    analysis_cache_t* cache;
+
+    //Gene pairs of two files kept: the top_k best of each gene (0: all) with a score of at least min_score
+    int query;
+    unsigned long long top_k;
+    float min_score;
+    //Pruning counters of each thread
+    similarity_stats_t* stats;
+
+}analyze_t;
+
+
+/**
+ * Write a score as Python str(float) does: shortest representation that reads back the same value.
+ */
+static void writing_score(FILE* out, const double value){
+    if (isnan(value)) {
+        fputs("nan", out);
+        return;
+    }
+    if (isinf(value)) {
+        fputs(value < 0 ? "-inf" : "inf", out);
+        return;
+    }
+
+    // Shortest number of significant digits
+    char buf[32];
+    int precision;
+    for (precision = 1; precision < 17; precision++) {
+        snprintf(buf, sizeof(buf), "%.*e", precision - 1, value);
+        if (strtod(buf, NULL) == value)
+            break;
+    }
+    snprintf(buf, sizeof(buf), "%.*e", precision - 1, value);
+
+    // buf = [-]d[.ddd]e[+-]xx
+    char digits[32];
+    int nb_digits = 0, i = 0;
+    if (buf[0] == '-') {
+        fputc('-', out);
+        i++;
+    }
+    for (; buf[i] != 'e'; i++)
+        if (buf[i] != '.')
+            digits[nb_digits++] = buf[i];
+    int exponent = atoi(buf + i + 1);
+
+    // Scientific notation out of [1e-4, 1e16)
+    if (exponent < -4 || exponent >= 16) {
+        fputc(digits[0], out);
+        if (nb_digits > 1)
+            fprintf(out, ".%.*s", nb_digits - 1, digits + 1);
+        fprintf(out, "e%c%02d", exponent < 0 ? '-' : '+', abs(exponent));
+        return;
+    }
+    if (exponent < 0) {
+        fputs("0.", out);
+        for (int d = -1; d > exponent; d--)
+            fputc('0', out);
+        fprintf(out, "%.*s", nb_digits, digits);
+        return;
+    }
+    for (int d = 0; d <= exponent; d++)
+        fputc(d < nb_digits ? digits[d] : '0', out);
+    if (nb_digits > exponent + 1)
+        fprintf(out, ".%.*s", nb_digits - exponent - 1, digits + exponent + 1);
+    else
+        fputs(".0", out);
+}
+
+/**
+ * Read the sequence of a FASTA file as moduleDNA.read_file: the first line is skipped,
+ * the other lines are stripped and concatenated.
+ */
+static char* reading_sequence(const char* filename, long int* length){
+    FILE* in = fopen(filename, "r");
+    if (!in)
+        return printf("ERROR: reading_sequence: cannot open file %s\n", filename), NULL;
+
+    size_t size = 0, capacity = 4096;
+    char* seq = malloc(capacity);
+    char* line = NULL;
+    size_t line_capacity = 0;
+    ssize_t nb;
+    int first = 1;
+    while (seq && (nb = getline(&line, &line_capacity, in)) != -1) {
+        if (first) {
+            first = 0;
+            continue;
+        }
+        char* begin = line;
+        while (nb > 0 && isspace((unsigned char)begin[nb - 1]))
+            nb--;
+        while (nb > 0 && isspace((unsigned char)*begin))
+            begin++, nb--;
+
+        if (size + nb + 1 > capacity) {
+            while (size + nb + 1 > capacity)
+                capacity *= 2;
+            char* tmp = realloc(seq, capacity);
+            if (!tmp)
+                free(seq);
+            seq = tmp;
+            if (!seq)
+                break;
+        }
+        memcpy(seq + size, begin, nb);
+        size += nb;
+    }
+    free(line);
+    fclose(in);
+
+    if (!seq)
+        return printf("ERROR: reading_sequence: cannot allocate memory\n"), NULL;
+    seq[size] = '\0';
+    *length = size;
+    return seq;
+}
+
+/**
+ * Open an output file, in the output directory.
+ */
+static FILE* opening_output(const analyze_t* a, const char* format, ...){
+    char path[ANALYZE_PATH_SIZE];
+    int len = snprintf(path, sizeof(path), "%s/", a->output);
+    va_list args;
+    va_start(args, format);
+    if (len > 0 && len < ANALYZE_PATH_SIZE)
+        vsnprintf(path + len, sizeof(path) - len, format, args);
+    va_end(args);
+
+    FILE* out = fopen(path, "w");
+    if (!out)
+        printf("ERROR: opening_output: cannot open file %s\n", path);
+    return out;
+}
+
+/**
+ * Write the mutation zones of a gene as the Python list of DNA_bin.detecting_mutations.
+ */
+static void writing_mutations(FILE* out, const analysis_genome_t* genome, const unsigned long long gene){
+    const unsigned long* sizes = genome->mut_size + ANALYSIS_MUTATIONS * gene;
+    const unsigned long* starts = genome->mut_start + ANALYSIS_MUTATIONS * gene;
+    const unsigned long* ends = genome->mut_end + ANALYSIS_MUTATIONS * gene;
+
+    int nb = 0;
+    for (int z = 0; z < ANALYSIS_MUTATIONS; z++) {
+        if (!sizes[z])
+            continue;
+        fprintf(out, "%s[%lu, %lu, %lu]", nb ? ", " : "<td>[", sizes[z], starts[z], ends[z]);
+        nb++;
+    }
+    fputs(nb ? "]</td>\n</tr>\n" : "<td>none</td>\n</tr>\n", out);
+}
+
+/**
+ * Write the page of the genes of a file.
+ *
+ * Each gene but the last one gets its mRNA, amino acid chain and mutation zones,
+ * then the genes of the first half are compared with each other, as in main_bin.py.
+ */
+static int writing_gene_page(const analyze_t* a, const analyze_file_t* file){
+    const analysis_genome_t* genome = &file->genome;
+    const gene_map_t* g = &genome->genes;
+    FILE* out = opening_output(a, "sequences/%s_bin.html", file->name);
+    if (!out)
+        return -1;
+    fprintf(out, "%s<h1>%s</h1><a href=\"../rapport_bin.html\" target=\"_blank\">"
+            "<input type=\"button\" value=\"Retour\"></a>", html_start, file->title);
+    fputs(html_genes_header, out);
+
+    for (unsigned long long j = 0; j + 1 < g->genes_counter; j++) {
+        unsigned long long start = g->gene_start[j], stop = g->gene_end[j];
+
+        const char* rna = genome->rna + genome->rna_offset[j];
+        if (*rna) {
+            fputs("<tr><td>", out);
+            for (const char* c = rna; *c; c++)
+                fputc(*c == 'U' ? 'T' : *c, out);
+            fprintf(out, "</td>\n<td>%s</td>\n", rna);
+        }
+        else
+            fprintf(out, "<tr><td>[%llu:%llu]=</td>\n<td> none </td>\n", start, stop);
+
+        const char* aa = genome->proteins + genome->protein_offset[j];
+        if (*aa)
+            fprintf(out, "<td>%s</td>\n", aa);
+        else
+            fputs("<td> none </td>\n", out);
+
+        writing_mutations(out, genome, j);
+    }
+    fputs("</tbody>\n</table>\n", out);
+
+    // Genes of the same file
+    fprintf(out, "%s\n", html_scores_header);
+    for (unsigned long long p = 0; p < genome->nb_scores; p++) {
+        unsigned long long j, k;
+        analysis_intra_pair(g->genes_counter, p, &j, &k);
+        fprintf(out, "<tr><td>Sequence [%llu:%llu] - [%llu:%llu]</td>\n<td>",
+                g->gene_start[j], g->gene_end[j], g->gene_start[k], g->gene_end[k]);
+        writing_score(out, genome->scores[p]);
+        fputs("</td> \n</tr>\n", out);
+    }
+    fputs("</tbody>\n</table>\n</details>\n </html>", out);
+
+    return fclose(out) ? -1 : 0;
+}
+
+/**
+ * Give the results of the genes of a file to the result writer.
+ *
+ * Every gene gets its amino acid chain and mutation zones,
+ * the genes of the same file are compared as in writing_gene_page.
+ */
+static int writing_gene_results(const analyze_t* a, const unsigned long f, const unsigned thread_id){
+    const analysis_genome_t* genome = &a->files[f].genome;
+    const gene_map_t* g = &genome->genes;
+    int res = 0;
+
+    for (unsigned long long j = 0; j < g->genes_counter && !res; j++) {
+        result_t r = { .type = RESULT_GENE, .record = f, .gene_start = g->gene_start[j], .gene_end = g->gene_end[j] };
+        res |= result_writer_write(a->writer, thread_id, &r);
+
+        r.type = RESULT_PROTEIN;
+        r.protein = genome->proteins + genome->protein_offset[j];
+        res |= result_writer_write(a->writer, thread_id, &r);
+
+        r.type = RESULT_MUTATION;
+        r.protein = NULL;
+        for (int z = 0; z < ANALYSIS_MUTATIONS; z++) {
+            unsigned long long zone = ANALYSIS_MUTATIONS * j + z;
+            if (!genome->mut_size[zone])
+                continue;
+            r.mut_start = genome->mut_start[zone];
+            r.mut_end = genome->mut_end[zone];
+            r.mut_size = genome->mut_size[zone];
+            res |= result_writer_write(a->writer, thread_id, &r);
+        }
+    }
+
+    for (unsigned long long p = 0; p < genome->nb_scores && !res; p++) {
+        unsigned long long j, k;
+        analysis_intra_pair(g->genes_counter, p, &j, &k);
+        result_t r = { .type = RESULT_SCORE, .record = f, .record2 = f,
+                       .gene_start = g->gene_start[j], .gene_end = g->gene_end[j],
+                       .gene2_start = g->gene_start[k], .gene2_end = g->gene_end[k], .score = genome->scores[p] };
+        res |= result_writer_write(a->writer, thread_id, &r);
+    }
+    return res ? -1 : 0;
+}
+
+/**
+ * Analyse one file (thread pool task): encoding, genes, and their page or results.
+ */
+static void analyzing_files(void* arg, const unsigned long long begin, const unsigned long long end,
+                            const unsigned thread_id){
+    analyze_t* a = arg;
+    char path[ANALYZE_PATH_SIZE];
+    arena_t* arena = arena_thread();
+
+    for (unsigned long long f = begin; f < end; f++) {
+        analyze_file_t* file = &a->files[f];
+        file->error = 1;
+
+        // Reading and encoding
+        long int length = 0;
+        snprintf(path, sizeof(path), "%s/%s", a->input, file->name);
+        char* seq = reading_sequence(path, &length);
+        if (!seq)
+            continue;
+        file->nb_bits = binary_array_size(2 * length) * int_SIZE;
+        file->seq_bin = length ? convert_to_binary(seq, length) : calloc(1, sizeof(long int));
+        free(seq);
+        if (!file->seq_bin || !arena)
+            continue;
+
+        // Genes and their results, from the cache when the same sequence has already been analysed
+        int cached = 1;
+        if (a->cache)
+            cached = analysis_cache_load_genome(a->cache, analysis_hash(file->seq_bin, file->nb_bits),
+                                                file->nb_bits, &file->genome);
+        if (cached) {
+            if (analysing_genome(file->seq_bin, file->nb_bits, &file->genome))
+                continue;
+            if (a->cache && analysis_cache_store_genome(a->cache, &file->genome))
+                continue;
+        }
+        if (a->query && similarity_prepare(file->seq_bin, &file->genome.genes, &file->set))
+            continue;
+
+        if (a->writer)
+            file->error = writing_gene_results(a, f, thread_id) != 0;
+        else
+            file->error = writing_gene_page(a, file) != 0;
+        // The sequences of the next genomes are about the same size: keep the arena memory
+        arena_reset(arena);
+    }
+}
+
+/**
+ * Scores of the genes of two files, from the cache when both sequences have already been compared.
+ */
+static int comparing_pair(const analyze_t* a, const analyze_file_t* f1, const analyze_file_t* f2,
+                          const analysis_cache_row_t* row, float* scores){
+    const analysis_genome_t* g1 = &f1->genome;
+    const analysis_genome_t* g2 = &f2->genome;
+    if (a->cache && !analysis_cache_load_scores(a->cache, row, g2->hash, g1->genes.genes_counter,
+                                                g2->genes.genes_counter, scores))
+        return 0;
+
+    comparing_genomes(f1->seq_bin, g1, f2->seq_bin, g2, scores);
+    if (a->cache)
+        return analysis_cache_store_scores(a->cache, g1->hash, g2->hash, g1->genes.genes_counter,
+                                           g2->genes.genes_counter, scores);
+    return 0;
+}
+
+/**
+ * Pairs of a gene of a file kept in the comparison with another file.
+ *
+ * All the pairs, from the scores of comparing_pair, or those of the similarity query.
+ */
+static unsigned long long selecting_pairs(analyze_t* a, const analyze_file_t* f1, const analyze_file_t* f2,
+                                          const unsigned long long j, const float* scores, similarity_hit_t* hits,
+                                          const unsigned thread_id){
+    unsigned long long n2 = f2->genome.genes.genes_counter;
+    if (!a->query) {
+        for (unsigned long long k = 0; k < n2; k++)
+            hits[k] = (similarity_hit_t){ j, k, scores[j * n2 + k] };
+        return n2;
+    }
+    if (a->top_k)
+        return similarity_top_k(&f1->set, j, &f2->set, a->top_k, a->min_score, hits, &a->stats[thread_id]);
+    return similarity_above(&f1->set, j, &f2->set, a->min_score, hits, &a->stats[thread_id]);
+}
+
+/**
+ * Compare all the genes of a file with those of the previous files (thread pool task),
+ * in their own pages or in the results.
+ *
+ * The last files have the most comparisons: they are given first to the threads.
+ * With a similarity query, only the pairs it selects are written, and the pair cache is not used.
+ */
+static void comparing_files(void* arg, const unsigned long long begin, const unsigned long long end,
+                            const unsigned thread_id){
+    analyze_t* a = arg;
+    float* scores = NULL;
+    unsigned long long scores_size = 0;
+    similarity_hit_t* hits = NULL;
+    unsigned long long hits_size = 0;
+
+    for (unsigned long long r = begin; r < end; r++) {
+        unsigned long i = a->nb_files - 1 - r;
+        analyze_file_t* f1 = &a->files[i];
+        f1->compare_error = 1;
+
+        analysis_cache_row_t row;
+        memset(&row, 0, sizeof(row));
+        if (a->cache && !a->query && analysis_cache_load_row(a->cache, f1->genome.hash, &row))
+            continue;
+
+        int res = 0;
+        for (long c = i - 1; c >= 0 && !res; c--) {
+            const analyze_file_t* f2 = &a->files[c];
+            const gene_map_t* g1 = &f1->genome.genes;
+            const gene_map_t* g2 = &f2->genome.genes;
+
+            unsigned long long size = a->query ? 0 : g1->genes_counter * g2->genes_counter;
+            if (size > scores_size) {
+                float* tmp = realloc(scores, sizeof(*scores) * size);
+                if (!tmp) {
+                    printf("ERROR: comparing_files: cannot allocate memory\n");
+                    res = 1;
+                    break;
+                }
+                scores = tmp;
+                scores_size = size;
+            }
+            if (g2->genes_counter > hits_size) {
+                similarity_hit_t* tmp = realloc(hits, sizeof(*hits) * g2->genes_counter);
+                if (!tmp) {
+                    printf("ERROR: comparing_files: cannot allocate memory\n");
+                    res = 1;
+                    break;
+                }
+                hits = tmp;
+                hits_size = g2->genes_counter;
+            }
+            if (!a->query && (res = comparing_pair(a, f1, f2, &row, scores)))
+                break;
+
+            FILE* out = NULL;
+            if (!a->writer) {
+                if (!(out = opening_output(a, "sequences/cmp%lu-%ld_bin.html", i, c))) {
+                    res = 1;
+                    break;
+                }
+                fputs(html_scores_header, out);
+            }
+            for (unsigned long long j = 0; j < g1->genes_counter; j++) {
+                unsigned long long nb_hits = selecting_pairs(a, f1, f2, j, scores, hits, thread_id);
+                for (unsigned long long h = 0; h < nb_hits; h++) {
+                    unsigned long long k = hits[h].gene2;
+                    if (a->writer) {
+                        result_t result = { .type = RESULT_SCORE, .record = i, .record2 = c,
+                                            .gene_start = g1->gene_start[j], .gene_end = g1->gene_end[j],
+                                            .gene2_start = g2->gene_start[k], .gene2_end = g2->gene_end[k],
+                                            .score = hits[h].score };
+                        res |= result_writer_write(a->writer, thread_id, &result);
+                        continue;
+                    }
+                    fprintf(out, "<tr><td>Sequence [%llu:%llu] - [%llu:%llu]</td>\n<td>",
+                            g1->gene_start[j], g1->gene_end[j], g2->gene_start[k], g2->gene_end[k]);
+                    writing_score(out, hits[h].score);
+                    fputs("</td> \n</tr>\n", out);
+                }
+            }
+            if (out)
+                res |= fclose(out);
+        }
+        analysis_cache_close_row(&row);
+        f1->compare_error = res != 0;
+    }
+    free(scores);
+    free(hits);
+}
+
+/**
+ * List the FASTA files of the input directory, in the directory order (as glob.glob).
+ */
+static int listing_files(analyze_t* a, const unsigned long max_files){
+    DIR* dir = opendir(a->input);
+    if (!dir)
+        return printf("ERROR: listing_files: cannot open directory %s\n", a->input), -1;
+
+    unsigned long capacity = 16;
+    a->files = calloc(capacity, sizeof(*a->files));
+    a->nb_files = 0;
+
+    struct dirent* entry;
+    while (a->files && a->nb_files < max_files && (entry = readdir(dir))) {
+        size_t len = strlen(entry->d_name);
+        if (entry->d_name[0] == '.' || len < 6 || strcmp(entry->d_name + len - 6, ".fasta"))
+            continue;
+
+        if (a->nb_files == capacity) {
+            analyze_file_t* tmp = realloc(a->files, 2 * capacity * sizeof(*a->files));
+            if (!tmp)
+                break;
+            memset(tmp + capacity, 0, capacity * sizeof(*a->files));
+            a->files = tmp;
+            capacity *= 2;
+        }
+        analyze_file_t* file = &a->files[a->nb_files++];
+        file->name = strdup(entry->d_name);
+        file->title = strndup(entry->d_name, len - 6);
+        if (!file->name || !file->title)
+            break;
+    }
+    closedir(dir);
+
+    if (!a->files || (a->nb_files && (!a->files[a->nb_files - 1].name || !a->files[a->nb_files - 1].title)))
+        return printf("ERROR: listing_files: cannot allocate memory\n"), -1;
+    return 0;
+}
+
+/**
+ * Write the summary page and the comparison index.
+ */
+static int writing_index(const analyze_t* a){
+    FILE* report = opening_output(a, "rapport_bin.html");
+    FILE* comp = opening_output(a, "comp_bin.html");
+    if (!report || !comp) {
+        if (report)
+            fclose(report);
+        if (comp)
+            fclose(comp);
+        return -1;
+    }
+
+    fputs(html_start, report);
+    fprintf(comp, "%s<h1>Comparaison entre séquences</h1><a href=\"rapport_bin.html\" target=\"_blank\">"
+            "<input type=\"button\" value=\"Retour\"></a>", html_start);
+    for (unsigned long i = 0; i < a->nb_files; i++) {
+        const analyze_file_t* file = &a->files[i];
+        fprintf(report, "<details><summary>%s</summary>%s<a href=\"sequences/%s_bin.html\">%s</a></details>",
+                file->title, html_genes_header, file->name, file->title);
+        for (long c = i - 1; c >= 0; c--)
+            fprintf(comp, "<details><summary>Sequence %lu - %ld</summary><a href=\"sequences/cmp%lu-%ld_bin.html\">"
+                    "Comparaison %lu-%ld</a></details>\n", i, c, i, c, i, c);
+    }
+    fputs(" <a href=\"comp_bin.html\">Comparaison séquences</a></details></html>", report);
+    fputs("</tbody>\n</table>\n\n </html>", comp);
+
+    int res = fclose(report);
+    res |= fclose(comp);
+    return res ? -1 : 0;
+}
+
+static void usage(const char* name){
+    printf("Usage: %s [options]\n"
+           "  -i dir       directory of the FASTA files (default fastas)\n"
+           "  -o dir       output directory (default output)\n"
+           "  -n count     maximum number of files (default all)\n"
+           "  -t threads   number of threads (default: number of cores)\n"
+           "  -f format    html, tsv, jsonl or binary (default html, else results.<format> in the output directory)\n"
+           "  -c dir       cache of the results, only new or changed sequences are analysed and compared\n"
+           "  -k count     only the count best matching genes of the other file for each gene\n"
+           "  -s score     only the gene pairs of two files with a matching score of at least score\n",
+           name);
+}
+
+int main(int argc, char* argv[]){
+    analyze_t a;
+    memset(&a, 0, sizeof(a));
+    a.input = "fastas";
+    a.output = "output";
+    unsigned long max_files = (unsigned long)-1;
+    unsigned nb_threads = thread_pool_default_size();
+    const char* format_name = "html";
+    const char* cache_dir = NULL;
+    result_writer_format_t format = RESULT_WRITER_TSV;
+    a.min_score = -INFINITY;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "i:o:n:t:f:c:k:s:h")) != -1) {
+        switch (opt) {
+        case 'i': a.input = optarg; break;
+        case 'o': a.output = optarg; break;
+        case 'n': max_files = strtoul(optarg, NULL, 10); break;
+        case 't': nb_threads = strtoul(optarg, NULL, 10); break;
+        case 'c': cache_dir = optarg; break;
+        case 'k': a.top_k = strtoull(optarg, NULL, 10); a.query = 1; break;
+        case 's': a.min_score = strtof(optarg, NULL); a.query = 1; break;
+        case 'f':
+            format_name = optarg;
+            if (strcmp(format_name, "html") && result_writer_parse_format(format_name, &format))
+                return printf("ERROR: dna_analyze: unknown format %s\n", optarg), usage(argv[0]), 1;
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    int html = !strcmp(format_name, "html");
+    if (!nb_threads)
+        nb_threads = 1;
+
+    // Output directories
+    char path[ANALYZE_PATH_SIZE];
+    snprintf(path, sizeof(path), "%s/sequences", a.output);
+    if (mkdir(a.output, 0777) && errno != EEXIST)
+        return printf("ERROR: dna_analyze: cannot create directory %s\n", a.output), 1;
+    if (html) {
+        if (!mkdir(path, 0777))
+            printf("Output directory created \n");
+        else if (errno == EEXIST)
+            printf("Output directory already exists\n");
+        else
+            return printf("ERROR: dna_analyze: cannot create directory %s\n", path), 1;
+    }
+
+    if (listing_files(&a, max_files))
+        return 1;
+    if (cache_dir && !(a.cache = analysis_cache_open(cache_dir)))
+        return 1;
+
+    // Results, written by their own thread while the files are analysed
+    FILE* results = NULL;
+    if (!html) {
+        results = opening_output(&a, "results.%s", format_name);
+        if (!results || !(a.writer = result_writer_open(results, format, nb_threads))) {
+            if (results)
+                fclose(results);
+            return 1;
+        }
+    }
+
+    thread_pool_t* pool = thread_pool_create(nb_threads);
+    int res = 1;
+    if (!pool)
+        goto end;
+    if (a.query && !(a.stats = calloc(nb_threads, sizeof(*a.stats)))) {
+        printf("ERROR: dna_analyze: cannot allocate memory\n");
+        goto end;
+    }
+
+    // One file at a time per thread: the files are not the same size
+    thread_pool_run_dynamic(pool, a.nb_files, 1, analyzing_files, &a);
+    res = 0;
+    for (unsigned long i = 0; i < a.nb_files; i++)
+        if (a.files[i].error) {
+            printf("ERROR: dna_analyze: cannot analyse %s\n", a.files[i].name);
+            res = 1;
+        }
+    if (res)
+        goto end;
+
+    thread_pool_run_dynamic(pool, a.nb_files, 1, comparing_files, &a);
+    for (unsigned long i = 0; i < a.nb_files; i++)
+        res |= a.files[i].compare_error;
+    if (html)
+        res |= writing_index(&a) != 0;
+
+    if (a.cache)
+        printf("Cache: %llu/%llu genomes and %llu/%llu comparisons reused\n",
+               a.cache->genome_hits, a.cache->genome_hits + a.cache->genome_misses,
+               a.cache->pair_hits, a.cache->pair_hits + a.cache->pair_misses);
+    if (a.query) {
+        similarity_stats_t total = { 0 };
+        for (unsigned t = 0; t < nb_threads; t++) {
+            total.pairs += a.stats[t].pairs;
+            total.scored += a.stats[t].scored;
+        }
+        printf("Similarity: %llu/%llu gene pairs scored in full\n", total.scored, total.pairs);
+    }
+
+end:
+    if (pool)
+        thread_pool_destroy(pool);
+    if (a.writer) {
+        res |= result_writer_close(a.writer) != 0;
+        res |= fclose(results) != 0;
+    }
+    if (a.cache)
+        analysis_cache_close(a.cache);
+    for (unsigned long i = 0; i < a.nb_files; i++) {
+        free(a.files[i].name);
+        free(a.files[i].title);
+        free(a.files[i].seq_bin);
+        analysis_genome_free(&a.files[i].genome);
+        similarity_free(&a.files[i].set);
+    }
+    free(a.files);
+    free(a.stats);
+    return res;
+}
@@ -0,0 +1,143 @@
+"""
+Generates codon_tables.h, the translation lookup tables of the NCBI genetic codes.
+
+Usage: python3 gen_codon_tables.py [output]   (default: codon_tables.h)
+
+Each table holds the 64 amino acids indexed by the 6 bits of a codon in the binary
+array format of gene_bin.c (A = 00, G = 01, C = 10, T = 11, first nucleotide first),
+so that the translation of every genetic code is a single table lookup per codon.
+"""
+from sys import argv
+
+OUTPUT_FILENAME = "codon_tables.h"
+
+# NCBI order of the codons: TTT, TTC, TTA, TTG, TCT, ... GGG
+NCBI_BASES = "TCAG"
+# Value of the nucleotides in the binary array format
+BINARY_VALUE = {"A": 0, "G": 1, "C": 2, "T": 3}
+
+# NCBI translation tables (https://www.ncbi.nlm.nih.gov/Taxonomy/Utils/wprintgc.cgi), '*' = stop
+NCBI_TABLES = [
+    (1, "Standard",
+     "FFLLSSSSYY**CC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG"),
+    (2, "Vertebrate Mitochondrial",
+     "FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIMMTTTTNNKKSS**VVVVAAAADDEEGGGG"),
+    (3, "Yeast Mitochondrial",
+     "FFLLSSSSYY**CCWWTTTTPPPPHHQQRRRRIIMMTTTTNNKKSSRRVVVVAAAADDEEGGGG"),
+    (4, "Mold, Protozoan, and Coelenterate Mitochondrial and Mycoplasma/Spiroplasma",
+     "FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG"),
+    (5, "Invertebrate Mitochondrial",
+     "FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIMMTTTTNNKKSSSSVVVVAAAADDEEGGGG"),
+    (6, "Ciliate, Dasycladacean and Hexamita Nuclear",
+     "FFLLSSSSYYQQCC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG"),
+    (9, "Echinoderm and Flatworm Mitochondrial",
+     "FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIIMTTTTNNNKSSSSVVVVAAAADDEEGGGG"),
+    (10, "Euplotid Nuclear",
+     "FFLLSSSSYY**CCCWLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG"),
+    (11, "Bacterial, Archaeal and Plant Plastid",
+     "FFLLSSSSYY**CC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG"),
+    (12, "Alternative Yeast Nuclear",
+     "FFLLSSSSYY**CC*WLLLSPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG"),
+    (13, "Ascidian Mitochondrial",
+     "FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIMMTTTTNNKKSSGGVVVVAAAADDEEGGGG"),
+    (14, "Alternative Flatworm Mitochondrial",
+     "FFLLSSSSYYY*CCWWLLLLPPPPHHQQRRRRIIIMTTTTNNNKSSSSVVVVAAAADDEEGGGG"),
+    (15, "Blepharisma Nuclear",
+     "FFLLSSSSYY*QCC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG"),
+    (16, "Chlorophycean Mitochondrial",
+     "FFLLSSSSYY*LCC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG"),
+    (21, "Trematode Mitochondrial",
+     "FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIMMTTTTNNNKSSSSVVVVAAAADDEEGGGG"),
+    (22, "Scenedesmus obliquus Mitochondrial",
+     "FFLLSS*SYY*LCC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG"),
+    (23, "Thraustochytrium Mitochondrial",
+     "FF*LSSSSYY**CC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG"),
+    (24, "Rhabdopleuridae Mitochondrial",
+     "FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSSKVVVVAAAADDEEGGGG"),
+    (25, "Candidate Division SR1 and Gracilibacteria",
+     "FFLLSSSSYY**CCGWLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG"),
+    (26, "Pachysolen tannophilus Nuclear",
+     "FFLLSSSSYY**CC*WLLLAPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG"),
+    (27, "Karyorelict Nuclear",
+     "FFLLSSSSYYQQCCWWLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG"),
+    (28, "Condylostoma Nuclear",
+     "FFLLSSSSYYQQCCWWLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG"),
+    (29, "Mesodinium Nuclear",
+     "FFLLSSSSYYYYCC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG"),
+    (30, "Peritrich Nuclear",
+     "FFLLSSSSYYEECC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG"),
+    (31, "Blastocrithidia Nuclear",
+     "FFLLSSSSYYEECCWWLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG"),
+    (32, "Balanophoraceae Plastid",
+     "FFLLSSSSYY*WCC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG"),
+    (33, "Cephalodiscidae Mitochondrial",
+     "FFLLSSSSYYY*CCWWLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSSKVVVVAAAADDEEGGGG"),
+]
+
+# Table 0: the standard code with the stop codons written 'O',
+# as generating_amino_acid_chain has always returned it
+LEGACY_TABLE = (0, "Standard (stops as 'O')", NCBI_TABLES[0][2].replace("*", "O"))
+
+
+def binary_order(amino_acids):
+    """Reorder a 64 amino acids string from the NCBI order to the binary array order."""
+    table = [None] * 64
+    for i, aa in enumerate(amino_acids):
+        codon = (NCBI_BASES[i // 16], NCBI_BASES[i // 4 % 4], NCBI_BASES[i % 4])
+        table[BINARY_VALUE[codon[0]] << 4 | BINARY_VALUE[codon[1]] << 2 | BINARY_VALUE[codon[2]]] = aa
+    return "".join(table)
+
+
+def generating_header():
+    tables = [LEGACY_TABLE] + NCBI_TABLES
+    for table_id, name, amino_acids in tables:
+        if len(amino_acids) != 64:
+            raise ValueError(f"table {table_id} ({name}): {len(amino_acids)} codons instead of 64")
+    max_id = max(table_id for table_id, _, _ in tables)
+
+    index = [-1] * (max_id + 1)
+    for i, (table_id, _, _) in enumerate(tables):
+        index[table_id] = i
+
+    lines = ["// Generated by gen_codon_tables.py, do not edit.",
+             "#pragma once",
+             "",
+             f"#define CODON_TABLES_COUNT {len(tables)}",
+             f"#define CODON_TABLE_MAX_ID {max_id}",
+             "",
+             "// NCBI identifier of each table",
+             "static const int codon_table_ids[CODON_TABLES_COUNT] = {",
+             "    " + ", ".join(str(table_id) for table_id, _, _ in tables),
+             "};",
+             "",
+             "// Table of each NCBI identifier, -1 if there is none",
+             "static const signed char codon_table_index[CODON_TABLE_MAX_ID + 1] = {",
+             "    " + ", ".join(str(i) for i in index),
+             "};",
+             "",
+             "static const char* const codon_table_names[CODON_TABLES_COUNT] = {"]
+    lines += [f'    "{name}",' for _, name, _ in tables]
+    lines += ["};",
+              "",
+              "// Amino acid of each codon (6 bits of the binary array format), '*' = stop",
+              "static const char codon_tables[CODON_TABLES_COUNT][64 + 1] = {"]
+    lines += [f'    /* {table_id:2} */ "{binary_order(amino_acids)}",' for table_id, _, amino_acids in tables]
+    lines += ["};", ""]
+    return "\n".join(lines)
+
+
+def writing_header(filename = OUTPUT_FILENAME):
+    header = generating_header()
+    # Do not touch an up to date header, so that make does not rebuild everything
+    try:
+        with open(filename) as f:
+            if f.read() == header:
+                return
+    except FileNotFoundError:
+        pass
+    with open(filename, "w") as f:
+        f.write(header)
+
+
+if __name__ == "__main__":
+    writing_header(argv[1] if len(argv) > 1 else OUTPUT_FILENAME)
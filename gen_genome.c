@@ -0,0 +1,83 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "genome_gen.h"
+
+/**
+ * Parse a number of nucleotides, with an optional k, M or G suffix (powers of 1000).
+ */
+static unsigned long long parse_length(const char* arg){
+    char* end = NULL;
+    double value = strtod(arg, &end);
+    switch (*end) {
+    case 'k': case 'K': value *= 1e3; break;
+    case 'm': case 'M': value *= 1e6; break;
+    case 'g': case 'G': value *= 1e9; break;
+    }
+    return (unsigned long long)value;
+}
+
+static void usage(const char* name){
+    printf("Usage: %s [options]\n"
+           "  -s seed      random seed (default 42)\n"
+           "  -l length    nucleotides per genome, k/M/G suffix allowed (default 30k)\n"
+           "  -g gc        GC content between 0 and 1 (default 0.38)\n"
+           "  -n rate      N rate (default 0)\n"
+           "  -i rate      other IUPAC codes rate (default 0)\n"
+           "  -r count     number of planted ORFs (default 0)\n"
+           "  -L codons    codons per planted ORF (default 300)\n"
+           "  -c copies    genomes in the family, the first is the ancestor (default 1)\n"
+           "  -m rate      substitution rate of the copies (default 0.001)\n"
+           "  -f format    fasta or packed (default fasta)\n"
+           "  -o file      output file (default stdout)\n", name);
+}
+
+int main(int argc, char* argv[]){
+    genome_gen_params_t params;
+    genome_gen_default_params(&params);
+    genome_gen_format_t format = GENOME_GEN_FASTA;
+    const char* filename = NULL;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "s:l:g:n:i:r:L:c:m:f:o:h")) != -1) {
+        switch (opt) {
+        case 's': params.seed = strtoull(optarg, NULL, 10); break;
+        case 'l': params.length = parse_length(optarg); break;
+        case 'g': params.gc_content = atof(optarg); break;
+        case 'n': params.n_rate = atof(optarg); break;
+        case 'i': params.iupac_rate = atof(optarg); break;
+        case 'r': params.orf_count = strtoul(optarg, NULL, 10); break;
+        case 'L': params.orf_codons = strtoul(optarg, NULL, 10); break;
+        case 'c': params.copies = strtoul(optarg, NULL, 10); break;
+        case 'm': params.mutation_rate = atof(optarg); break;
+        case 'f':
+            if (!strcmp(optarg, "fasta"))
+                format = GENOME_GEN_FASTA;
+            else if (!strcmp(optarg, "packed"))
+                format = GENOME_GEN_PACKED;
+            else
+                return printf("ERROR: gen_genome: unknown format %s\n", optarg), usage(argv[0]), 1;
+            break;
+        case 'o': filename = optarg; break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    FILE* out = stdout;
+    if (filename) {
+        out = fopen(filename, format == GENOME_GEN_PACKED ? "wb" : "w");
+        if (!out)
+            return printf("ERROR: gen_genome: cannot open file %s\n", filename), 1;
+    }
+
+    int res = writing_genomes(out, &params, format);
+
+    if (out != stdout)
+        fclose(out);
+    return res ? 1 : 0;
+}
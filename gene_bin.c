@@ -1,8 +1,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
 
 #include "gene_bin.h"
+#include "arena.h"
+#include "codon_tables.h"
+#include "perf_counters.h"
 
 
 /***************************************/
@@ -10,6 +14,26 @@
 /***************************************/
 
 
+/**
+ * Instruction set used by the hot kernels.
+ * 
+ * out : char* : "avx512", "avx2", "sse4.2" or "scalar"
+ * 
+ * Same test as the ifunc resolvers of the GENE_KERNEL functions (x86-64-v4, v3, v2 levels).
+ */
+const char* cpu_dispatch_level(void){
+#if GENE_DISPATCH
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("x86-64-v4"))
+        return "avx512";
+    if (__builtin_cpu_supports("x86-64-v3"))
+        return "avx2";
+    if (__builtin_cpu_supports("x86-64-v2"))
+        return "sse4.2";
+#endif
+    return "scalar";
+}
+
 /**
  * Retrieve one bit from the binary array sequence.
  * 
@@ -17,11 +41,12 @@
  * in : pos : position of the requested bit (0 <= pos < size_seq * 2)
  * out : int : the requested bit
  * 
- * Shifts the seq_bin by pos.
+ * Shifts the seq_bin by pos. The bit of position pos of the value w is at (pos - w) % 64: the
+ * shift is masked explicitly, a shift of 64 or more is undefined (and 0 in the vector shifts).
  */
 int get_binary_value(const long int *seq_bin, const int pos){
     int new_pos = pos > int_SIZE ? pos / int_SIZE : 0;
-    return seq_bin[new_pos] & ((long)1 << (pos - new_pos)) ? 1 : 0;
+    return seq_bin[new_pos] & ((long)1 << ((pos - new_pos) & int_SIZE)) ? 1 : 0;
 }
 
 /**
@@ -32,18 +57,31 @@ int get_binary_value(const long int *seq_bin, const int pos){
  * in : value : new bit value
  * out : seq_bin : sequence in binary array format with the one bit changed
  * 
- * Set the bit value of seq_bin at pos position to value
+ * Set the bit value of seq_bin at pos position to value, placed as get_binary_value
  */
 long int* change_binary_value(long int *seq_bin, const int pos, const int value){
     int new_pos = pos > int_SIZE ? pos / int_SIZE : 0;
 
     if (value)
-        seq_bin[new_pos] |= ((long)1 << (pos - new_pos));
+        seq_bin[new_pos] |= ((long)1 << ((pos - new_pos) & int_SIZE));
     else
-        seq_bin[new_pos] &= ~((long)1 << (pos - new_pos));
+        seq_bin[new_pos] &= ~((long)1 << ((pos - new_pos) & int_SIZE));
     return seq_bin;
 }
 
+/**
+ * Number of values of a binary array.
+ * 
+ * in : nb_bits : number total of used bits
+ * out : long int : number of long int values needed to store nb_bits bits (at least 1)
+ * 
+ * Same size as the arrays allocated by set_binary_array and get_piece_binary_array.
+ */
+long int binary_array_size(const long int nb_bits){
+    long int array_size = nb_bits / int_SIZE + (nb_bits % int_SIZE != 0);
+    return array_size ? array_size : 1;
+}
+
 /**
  * Convert a char formated DNA sequence to its binary array format.
  * 
@@ -55,20 +93,32 @@ long int* change_binary_value(long int *seq_bin, const int pos, const int value)
  * The non-ACGT nucleotides corresponding to several possible nucleotides are arbitrarily defined.
  */
 long int* set_binary_array(const char *seq_char, const unsigned seq_size){
-    // Number of bits needed to transform seq_char into a binary array.
-    int seq_bin_size = 2 * seq_size;
-
-    // Binary array new size
-    int nb = seq_bin_size / int_SIZE;
-    if(seq_bin_size % int_SIZE != 0)
-        nb++;
-
     // Allocate memory and verify it has been allocated
     long int* seq_bin = NULL;
-    seq_bin = calloc(nb, sizeof(long int));
+    seq_bin = malloc(binary_array_size(2 * (long int)seq_size) * sizeof(long int));
     if(!seq_bin)
         return printf("ERROR: set_binary_array: cannot allocate memory.\n"), NULL;
 
+    return set_binary_array_into(seq_char, seq_size, seq_bin);
+}
+
+/**
+ * Convert a char formated DNA sequence to its binary array format, into a caller provided array.
+ * 
+ * in : seq_char, seq_size : see set_binary_array
+ * in : seq_bin : output array of binary_array_size(2 * seq_size) values
+ * out : seq_bin : sequence in binary array format, NULL if seq_bin is NULL
+ * 
+ * The array is written by the calling thread only: memory not touched yet (arena_pages_alloc)
+ * gets its pages on the NUMA node of this thread.
+ */
+GENE_KERNEL
+long int* set_binary_array_into(const char *seq_char, const unsigned seq_size, long int* seq_bin){
+    PERF_BEGIN(PERF_SET_BINARY_ARRAY);
+    if (!seq_bin)
+        return NULL;
+    memset(seq_bin, 0, binary_array_size(2 * (long int)seq_size) * sizeof(long int));
+
     int pos = 0;
     // Parse the DNA sequence, per nucleotides
     for (long int i = 0; i < seq_size; ++i){
@@ -116,6 +166,7 @@ long int* set_binary_array(const char *seq_char, const unsigned seq_size){
         }
         pos += 2;
     }
+    PERF_END(PERF_SET_BINARY_ARRAY);
     return seq_bin;
 }
 
@@ -135,11 +186,33 @@ long int* set_binary_array(const char *seq_char, const unsigned seq_size){
  */
 long int* xor_binary_array(long int* const seq_bin1, const unsigned seq_size1,
                            long int * const seq_bin2, const unsigned seq_size2){
+    // Allocate memory and verify it has been allocated
+    long int* xor = NULL;
+    xor = malloc(binary_array_size(seq_size1 >= seq_size2 ? seq_size1 : seq_size2) * sizeof(*xor));
+    if (!xor)
+        return printf("ERROR: xor_binary_array: cannot allocate memory.\n"), NULL;
+
+    return xor_binary_array_into(seq_bin1, seq_size1, seq_bin2, seq_size2, xor);
+}
+
+/**
+ * Xor two binary array sequences into a caller provided array.
+ * 
+ * in : seq_bin1, seq_size1, seq_bin2, seq_size2 : see xor_binary_array
+ * in : xor : output array of binary_array_size(max(seq_size1, seq_size2)) values
+ * out : xor : binary array sequence resulting from the xor operation between seq1 and seq2, NULL if xor is NULL
+ */
+GENE_KERNEL
+long int* xor_binary_array_into(const long int* seq_bin1, const unsigned seq_size1,
+                                const long int* seq_bin2, const unsigned seq_size2, long int* xor){
+    PERF_BEGIN(PERF_XOR_BINARY_ARRAY);
+    if (!xor)
+        return NULL;
 
     // size of the binary array type used
     long int intsize = int_SIZE + 1;
 
-    long int* s1, * s2;
+    const long int* s1, * s2;
     long int ss1, ss2;
     long int sbs1, sbs2;
 
@@ -166,11 +239,8 @@ long int* xor_binary_array(long int* const seq_bin1, const unsigned seq_size1,
 
     long int it = 0;
 
-    // Allocate memory and verify it has been allocated
-    long int* xor = NULL;
-    xor = calloc(ss1, sizeof(*xor));
-    if (!xor)
-        return printf("ERROR: xor_binary_array: cannot allocate memory.\n"), NULL;
+    // Values after the ss1 first ones are 0
+    memset(xor, 0, binary_array_size(sbs1) * sizeof(*xor));
 
     // Xor the two sequences values since its value is the same length.
     for (it = 0; it < ss2 - 1; it++)
@@ -184,6 +254,7 @@ long int* xor_binary_array(long int* const seq_bin1, const unsigned seq_size1,
     for (it = ss2; it < ss1; it++)
         xor[it] = s1[it];
 
+    PERF_END(PERF_XOR_BINARY_ARRAY);
     return xor;
 }
 
@@ -196,7 +267,9 @@ long int* xor_binary_array(long int* const seq_bin1, const unsigned seq_size1,
  * 
  * Iterates on seq_bin and for each value, adds its popcount to bin_popcount.
  */
+GENE_KERNEL
 int popcount_binary_array(const long int *seq_bin, const long int seq_size){
+    PERF_BEGIN(PERF_POPCOUNT_BINARY_ARRAY);
     int bin_popcount = 0;
 
     // Find the size of the binary array
@@ -205,8 +278,9 @@ int popcount_binary_array(const long int *seq_bin, const long int seq_size){
 
     // Parse the binary array
     for (long int i = 0; i < array_size; ++i)
-        bin_popcount += __builtin_popcount(seq_bin[i]);
+        bin_popcount += __builtin_popcountl(seq_bin[i]);
 
+    PERF_END(PERF_POPCOUNT_BINARY_ARRAY);
     return bin_popcount;
 }
 
@@ -220,15 +294,30 @@ int popcount_binary_array(const long int *seq_bin, const long int seq_size){
  * Iterates on seq_bin from pos_start, size times and gets for each iteration its binary value.
  */
 long int* get_piece_binary_array(const long int* seq_bin, const long int pos_start, const long int size){
-    //Find the size of the output
-    long int array_size = (size) / int_SIZE + (size % int_SIZE != 0);
-    
     // Allocate memory and verify it has been allocated
     long int *piece_seq_bin = NULL;
-    piece_seq_bin = calloc(array_size, sizeof(*seq_bin));
+    piece_seq_bin = malloc(binary_array_size(size) * sizeof(*seq_bin));
     if(!piece_seq_bin) 
         return printf("ERROR: get_piece_binary_array: cannot allocate memory.\n"), NULL;
 
+    return get_piece_binary_array_into(seq_bin, pos_start, size, piece_seq_bin);
+}
+
+/**
+ * Retrieve a piece of the binary array sequence into a caller provided array.
+ * 
+ * in : seq_bin, pos_start, size : see get_piece_binary_array
+ * in : piece_seq_bin : output array of binary_array_size(size) values
+ * out : piece_seq_bin : the requested part of seq_bin, NULL if piece_seq_bin is NULL
+ */
+GENE_KERNEL
+long int* get_piece_binary_array_into(const long int* seq_bin, const long int pos_start, const long int size,
+                                      long int* piece_seq_bin){
+    PERF_BEGIN(PERF_GET_PIECE_BINARY_ARRAY);
+    if (!piece_seq_bin)
+        return NULL;
+    memset(piece_seq_bin, 0, binary_array_size(size) * sizeof(*piece_seq_bin));
+
     // stop position.
     long int stop_pos = pos_start + size;
 
@@ -241,9 +330,76 @@ long int* get_piece_binary_array(const long int* seq_bin, const long int pos_sta
         j++;
     }
 
+    PERF_END(PERF_GET_PIECE_BINARY_ARRAY);
     return piece_seq_bin;
 }
 
+/**
+ * 64 bits of a binary array, in the order of their positions.
+ *
+ * in : seq_bin, nb_words : binary array and its number of words
+ * in : p : first position
+ * out : unsigned long long : bit j is the bit of position p + j (0 past the array)
+ *
+ * The words hold the positions 0 to 63, 64 to 125, then 63 positions each (get_binary_value):
+ * each word read is put in position order by a rotation, and its positions in the range are shifted in place.
+ */
+static inline unsigned long long binary_bits(const long int* seq_bin, const long int nb_words,
+                                             const unsigned long long p){
+    unsigned long long bits = 0;
+    for (unsigned long long q = p; q < p + 64;) {
+        unsigned long long w = q > 63 ? q / 63 : 0;
+        if ((long)w >= nb_words)
+            break;
+        unsigned long long start = w < 2 ? 64 * w : 63 * w;
+        unsigned long long end = w ? (w == 1 ? 126 : start + 63) : 64;
+        if (end > p + 64)
+            end = p + 64;
+
+        unsigned long long x = (unsigned long long)seq_bin[w];
+        int rot = (start - w) & 63;
+        if (rot)
+            x = x >> rot | x << (64 - rot);
+        unsigned long long n = end - q;
+        x >>= q - start;
+        if (n < 64)
+            x &= (1ULL << n) - 1;
+        bits |= x << (q - p);
+        q = end;
+    }
+    return bits;
+}
+
+// Even bits of a word, packed in its low half
+static inline unsigned long long binary_even(unsigned long long x){
+    x &= 0x5555555555555555ULL;
+    x = (x | x >> 1) & 0x3333333333333333ULL;
+    x = (x | x >> 2) & 0x0F0F0F0F0F0F0F0FULL;
+    x = (x | x >> 4) & 0x00FF00FF00FF00FFULL;
+    x = (x | x >> 8) & 0x0000FFFF0000FFFFULL;
+    return (x | x >> 16) & 0x00000000FFFFFFFFULL;
+}
+
+/**
+ * Bases of a binary array, as their first bits and their second bits.
+ *
+ * in : seq_bin, nb_words : binary array and its number of words
+ * in : base : first of 64 bases
+ * out : bits : bit j of bits[0] and of bits[1] are the first and the second bit of the base + j (0 past the array)
+ *
+ * A base is A, G, C or T when its bits are 00, 01, 10 or 11: bit j of ~bits[0] & bits[1] is set
+ * for a G at base + j, and so on, which counts or compares 64 bases at once.
+ */
+GENE_KERNEL
+void get_bases_binary_array(const long int* seq_bin, const long int nb_words, const unsigned long long base,
+                            unsigned long long bits[2]){
+    unsigned long long low = binary_bits(seq_bin, nb_words, 2 * base);
+    unsigned long long high = binary_bits(seq_bin, nb_words, 2 * base + 64);
+    // First bit of a base at its even position, second bit at the odd one
+    bits[0] = binary_even(low) | binary_even(high) << 32;
+    bits[1] = binary_even(low >> 1) | binary_even(high >> 1) << 32;
+}
+
 
 
 /***************************************/
@@ -261,7 +417,10 @@ long int* get_piece_binary_array(const long int* seq_bin, const long int pos_sta
  * Calls set_binary_array.
  */
 long int* convert_to_binary(const char* dna_seq, const unsigned size){
-    return set_binary_array(dna_seq, size);
+    PERF_BEGIN(PERF_CONVERT_TO_BINARY);
+    long int* seq_bin = set_binary_array(dna_seq, size);
+    PERF_END(PERF_CONVERT_TO_BINARY);
+    return seq_bin;
 }
 
 //////////////// Convert binary aa to codon
@@ -275,15 +434,32 @@ long int* convert_to_binary(const char* dna_seq, const unsigned size){
  * For each pair of bits in bin_dna_seq, append to dna_seq its corresponding nucleotide.
  */
 char* binary_to_dna(long int* bin_dna_seq, const unsigned size){
+    //Allocate memory and verify it has been allocated
+    char* dna_seq = malloc((size / 2) + 1);
+    if(!dna_seq)
+        return printf("ERROR: binary_to_dna: cannot allocate memory.\n"), NULL;
+
+    if (!binary_to_dna_into(bin_dna_seq, size, dna_seq))
+        return free(dna_seq), NULL;
+    return dna_seq;
+}
+
+/**
+ * Convert a DNA sequence in binary array format to its DNA bases, into a caller provided array.
+ * 
+ * in : bin_dna_seq, size : see binary_to_dna
+ * in : dna_seq : output char array of size / 2 + 1 chars
+ * out : dna_seq : null terminated DNA sequence, NULL on error
+ */
+GENE_KERNEL
+char* binary_to_dna_into(const long int* bin_dna_seq, const unsigned size, char* dna_seq){
+    PERF_BEGIN(PERF_BINARY_TO_DNA);
     if (size % 2 != 0) {
         printf("Error: binary_to_aa : wrong binary size (%d). Must be odd.\nExit.\n",size);
         return NULL;
     }
-
-    //Allocate memory and verify it has been allocated
-    char* dna_seq = calloc((size / 2) + 1, sizeof(*dna_seq));
-    if(!dna_seq)
-        return printf("ERROR: binary_to_dna: cannot allocate memory.\n"), NULL;
+    if (!dna_seq)
+        return NULL;
 
     int j = 0;
     //Parse the binary array, two bits per iteration
@@ -306,6 +482,8 @@ char* binary_to_dna(long int* bin_dna_seq, const unsigned size){
             dna_seq[j] = 'G';
         j++;
     }
+    dna_seq[j] = '\0';
+    PERF_END(PERF_BINARY_TO_DNA);
     return dna_seq;
 }
 
@@ -331,6 +509,27 @@ char* generating_mRNA(const long int* gene_seq, const long start_pos, const long
     if (!rna_seq)
         return printf("ERROR: generating_mRNA: cannot allocate memory\n"), NULL;
 
+    if (!generating_mRNA_into(gene_seq, start_pos, seq_size, rna_seq))
+        return free(rna_seq), NULL;
+    return rna_seq;
+}
+
+/**
+ * Convert a DNA sequence in binary array format to its mRNA sequence, into a caller provided array.
+ * 
+ * in : gene_seq, start_pos, seq_size : see generating_mRNA
+ * in : rna_seq : output char array of seq_size / 2 + 2 chars
+ * out : rna_seq : null terminated mRNA sequence, NULL on error
+ */
+GENE_KERNEL
+char* generating_mRNA_into(const long int* gene_seq, const long start_pos, const long int seq_size, char* rna_seq) {
+    PERF_BEGIN(PERF_GENERATING_MRNA);
+    // Check the input arguments
+    if (!gene_seq)
+        return printf("ERROR: generating_mRNA: undefined sequence\n"), NULL;
+    if (!rna_seq)
+        return NULL;
+
     int j = 0;
 
     long stop = seq_size+start_pos;
@@ -357,6 +556,7 @@ char* generating_mRNA(const long int* gene_seq, const long start_pos, const long
             return printf("ERROR: generating_mRNA: invalid value in DNA sequence\n"), NULL;
         j++;
     }
+    PERF_END(PERF_GENERATING_MRNA);
     rna_seq[j] = '\0';
     return rna_seq;
 }
@@ -376,7 +576,9 @@ char* generating_mRNA(const long int* gene_seq, const long start_pos, const long
  * 
  * NB : The gene in binary array form can correspond to an mRNA or DNA sequence, since it is stored in the same way.
  */
+GENE_KERNEL
 void detecting_genes(const long int *gene, const long int gene_size, gene_map_t* gene_map) {
+    PERF_BEGIN(PERF_DETECTING_GENES);
     gene_map->genes_counter = 0;
 
     // Check if memory ever have been allocated and allocate it if not
@@ -436,7 +638,7 @@ void detecting_genes(const long int *gene, const long int gene_size, gene_map_t*
                 i += 2;
         }
     }
-
+    PERF_END(PERF_DETECTING_GENES);
 }
 
 /**
@@ -452,6 +654,45 @@ void detecting_genes(const long int *gene, const long int gene_size, gene_map_t*
  * NB : The gene in binary array form can correspond to an mRNA or DNA sequence, since it is stored in the same way.
 */
 char* generating_amino_acid_chain(const long int *gene_seq, const long int start_pos, const long int seq_size) {
+    return generating_amino_acid_chain_table(gene_seq, start_pos, seq_size, 0);
+}
+
+/**
+ * Retrives amino acid chains in a mRNA sequence in binary array format, into a caller provided array.
+ * 
+ * in : gene_seq, start_pos, seq_size : see generating_amino_acid_chain
+ * in : aa_seq : output char array of seq_size / 6 + 1 chars
+ * out : aa_seq : null terminated char array of proteins symbols, NULL on error
+ */
+char* generating_amino_acid_chain_into(const long int *gene_seq, const long int start_pos, const long int seq_size,
+                                       char* aa_seq) {
+    return generating_amino_acid_chain_table_into(gene_seq, start_pos, seq_size, 0, aa_seq);
+}
+
+/**
+ * Name of a genetic code.
+ * 
+ * in : table_id : NCBI translation table identifier (0 = standard code with 'O' stops)
+ * out : char* : name of the table, NULL if there is no such table
+ */
+const char* codon_table_name(const int table_id) {
+    if (table_id < 0 || table_id > CODON_TABLE_MAX_ID || codon_table_index[table_id] < 0)
+        return NULL;
+    return codon_table_names[(int)codon_table_index[table_id]];
+}
+
+/**
+ * Retrives amino acid chains in a mRNA sequence in binary array format, with a given genetic code.
+ * 
+ * in : gene_seq : DNA sequence in binary array format
+ * in : start_pos : position of the first bit of the gene
+ * in : seq_size : gene_seq length (number total of used bits)
+ * in : table_id : NCBI translation table identifier (1 = standard, 2 = vertebrate mitochondrial, 11 = bacterial...),
+ *                 0 for the standard code with the stop codons written 'O'
+ * out : aa_seq : char array of proteins symbols, stop codons written '*'. NULL on error
+ */
+char* generating_amino_acid_chain_table(const long int *gene_seq, const long int start_pos, const long int seq_size,
+                                        const int table_id) {
     long int codon_size = 6;
     // Check the input argument
     if (!gene_seq)
@@ -461,230 +702,58 @@ char* generating_amino_acid_chain(const long int *gene_seq, const long int start
 
     // Allocate memory and verify it has been allocated
     char* aa_seq = NULL;
-     aa_seq = malloc(sizeof(*aa_seq) * (seq_size / codon_size) + 1);
+    aa_seq = malloc(sizeof(*aa_seq) * (seq_size / codon_size) + 1);
     if (!aa_seq)
         return printf("ERROR: generating_amino_acid_chain: cannot allocate memory\n"), NULL;
 
+    if (!generating_amino_acid_chain_table_into(gene_seq, start_pos, seq_size, table_id, aa_seq))
+        return free(aa_seq), NULL;
+    return aa_seq;
+}
+
+/**
+ * Retrives amino acid chains with a given genetic code, into a caller provided array.
+ * 
+ * in : gene_seq, start_pos, seq_size, table_id : see generating_amino_acid_chain_table
+ * in : aa_seq : output char array of seq_size / 6 + 1 chars
+ * out : aa_seq : null terminated char array of proteins symbols, NULL on error
+ * 
+ * Every genetic code is a lookup table generated from the NCBI tables by gen_codon_tables.py,
+ * indexed by the 6 bits of the codon.
+ */
+GENE_KERNEL
+char* generating_amino_acid_chain_table_into(const long int *gene_seq, const long int start_pos, const long int seq_size,
+                                             const int table_id, char* aa_seq) {
+    PERF_BEGIN(PERF_GENERATING_AMINO_ACID_CHAIN);
+    long int codon_size = 6;
+    // Check the input arguments
+    if (!gene_seq)
+        return printf("ERROR: generating_amino_acid_chain: undefined sequence\n"), NULL;
+    if (table_id < 0 || table_id > CODON_TABLE_MAX_ID || codon_table_index[table_id] < 0)
+        return printf("ERROR: generating_amino_acid_chain: unknown translation table %d\n", table_id), NULL;
+    if(seq_size % 3 != 0 || !aa_seq)
+        return NULL;
+
+    const char* table = codon_tables[(int)codon_table_index[table_id]];
     unsigned temp = 0;
 
     long size = start_pos+seq_size;
 
     //Parse the binary array, six bits by six (to parse three nucleotides per three)
     for (long int i = start_pos; i < size; i += codon_size) {
-        // The hash functions, takes the 6 bits, and transform the array into an integer.
-        // The integer first char is a 2, for hash generation purposes.
-        int hash = 2;
-        for(long int k = i; k < i + codon_size; k++){
-            hash = 10 * hash + get_binary_value(gene_seq, k);
-        }
+        // The 6 bits of the codon, first bit first, are the index of its amino acid
+        unsigned codon = 0;
+        for(long int k = i; k < i + codon_size; k++)
+            codon = (codon << 1) | get_binary_value(gene_seq, k);
 
-        // Switch over the hash.
-        switch(hash){
-        case 2000000 :
-            aa_seq[temp] = 'K';
-            break;
-        case 2000001 :
-            aa_seq[temp] = 'K';
-            break;
-        case 2000010 :
-            aa_seq[temp] = 'N';
-            break;
-        case 2000011 :
-            aa_seq[temp] = 'N';
-            break;
-        case 2000100 :
-            aa_seq[temp] = 'R';
-            break;
-        case 2000101 :
-            aa_seq[temp] = 'R';
-            break;
-        case 2000110 :
-            aa_seq[temp] = 'S';
-            break;
-        case 2000111 :
-            aa_seq[temp] = 'S';
-            break;
-        case 2001000 :
-            aa_seq[temp] = 'T';
-            break;
-        case 2001001 :
-            aa_seq[temp] = 'T';
-            break;
-        case 2001010 :
-            aa_seq[temp] = 'T';
-            break;
-        case 2001011 :
-            aa_seq[temp] = 'T';
-            break;
-        case 2001100 :
-            aa_seq[temp] = 'I';
-            break;
-        case 2001101 :
-            aa_seq[temp] = 'M';
-            break;
-        case 2001110 :
-            aa_seq[temp] = 'I';
-            break;
-        case 2001111 :
-            aa_seq[temp] = 'I';
-            break;
-        case 2010000 :
-            aa_seq[temp] = 'E';
-            break;
-        case 2010001 :
-            aa_seq[temp] = 'E';
-            break;
-        case 2010010 :
-            aa_seq[temp] = 'D';
-            break;
-        case 2010011 :
-            aa_seq[temp] = 'D';
-            break;
-        case 2010100 :
-            aa_seq[temp] = 'G';
-            break;
-        case 2010101 :
-            aa_seq[temp] = 'G';
-            break;
-        case 2010110 :
-            aa_seq[temp] = 'G';
-            break;
-        case 2010111 :
-            aa_seq[temp] = 'G';
-            break;
-        case 2011000 :
-            aa_seq[temp] = 'A';
-            break;
-        case 2011001 :
-            aa_seq[temp] = 'A';
-            break;
-        case 2011010 :
-            aa_seq[temp] = 'A';
-            break;
-        case 2011011 :
-            aa_seq[temp] = 'A';
-            break;
-        case 2011100 :
-            aa_seq[temp] = 'V';
-            break;
-        case 2011101 :
-            aa_seq[temp] = 'V';
-            break;
-        case 2011110 :
-            aa_seq[temp] = 'V';
-            break;
-        case 2011111 :
-            aa_seq[temp] = 'V';
-            break;
-        case 2100000 :
-            aa_seq[temp] = 'Q';
-            break;
-        case 2100001 :
-            aa_seq[temp] = 'Q';
-            break;
-        case 2100010 :
-            aa_seq[temp] = 'H';
-            break;
-        case 2100011 :
-            aa_seq[temp] = 'H';
-            break;
-        case 2100100 :
-            aa_seq[temp] = 'R';
-            break;
-        case 2100101 :
-            aa_seq[temp] = 'R';
-            break;
-        case 2100110 :
-            aa_seq[temp] = 'R';
-            break;
-        case 2100111 :
-            aa_seq[temp] = 'R';
-            break;
-        case 2101000 :
-            aa_seq[temp] = 'P';
-            break;
-        case 2101001 :
-            aa_seq[temp] = 'P';
-            break;
-        case 2101010 :
-            aa_seq[temp] = 'P';
-            break;
-        case 2101011 :
-            aa_seq[temp] = 'P';
-            break;
-        case 2101100 :
-            aa_seq[temp] = 'L';
-            break;
-        case 2101101 :
-            aa_seq[temp] = 'L';
-            break;
-        case 2101110 :
-            aa_seq[temp] = 'L';
-            break;
-        case 2101111 :
-            aa_seq[temp] = 'L';
-            break;
-        case 2110000 :
-            aa_seq[temp] = 'O';
-            break;
-        case 2110001 :
-            aa_seq[temp] = 'O';
-            break;
-        case 2110010 :
-            aa_seq[temp] = 'Y';
-            break;
-        case 2110011 :
-            aa_seq[temp] = 'Y';
-            break;
-        case 2110100 :
-            aa_seq[temp] = 'O';
-            break;
-        case 2110101 :
-            aa_seq[temp] = 'W';
-            break;
-        case 2110110 :
-            aa_seq[temp] = 'C';
-            break;
-        case 2110111 :
-            aa_seq[temp] = 'C';
-            break;
-        case 2111000 :
-            aa_seq[temp] = 'S';
-            break;
-        case 2111001 :
-            aa_seq[temp] = 'S';
-            break;
-        case 2111010 :
-            aa_seq[temp] = 'S';
-            break;
-        case 2111011 :
-            aa_seq[temp] = 'S';
-            break;
-        case 2111100 :
-            aa_seq[temp] = 'L';
-            break;
-        case 2111101 :
-            aa_seq[temp] = 'L';
-            break;
-        case 2111110 :
-            aa_seq[temp] = 'F';
-            break;
-        case 2111111 :
-            aa_seq[temp] = 'F';
-            break;
-
-        default:
-            return NULL;
-        }
-    
-        temp++;
+        aa_seq[temp++] = table[codon];
     }
 
+    PERF_END(PERF_GENERATING_AMINO_ACID_CHAIN);
     aa_seq[temp] = '\0';
     return aa_seq;
 }
 
-
 /**
  * Detects probable mutation areas.
  * 
@@ -699,8 +768,10 @@ char* generating_amino_acid_chain(const long int *gene_seq, const long int start
  * 
  * NB : The gene in binary array form can correspond to an mRNA or DNA sequence, since it is stored in the same way.
  */
+GENE_KERNEL
 void detecting_mutations(const long int *gene_seq, const long int start_pos, const long int size_sequence,
                          mutation_map mut_m) {
+    PERF_BEGIN(PERF_DETECTING_MUTATIONS);
     long int detect_mut = 0;  //Counting size of GC sequence
     unsigned short tmp_start_mut = 0;   //stock start mutation
     unsigned cmp = 0;   //counter of all mutation zones
@@ -737,6 +808,261 @@ void detecting_mutations(const long int *gene_seq, const long int start_pos, con
         mut_m.end_mut[cmp] = size_sequence;
         mut_m.size[cmp] = detect_mut-1;
     }
+    PERF_END(PERF_DETECTING_MUTATIONS);
+}
+
+//////////////// Analysing genes
+// Codons, 2 bits per nucleotide, the first nucleotide in the high bits
+#define CODON_AUG 0x0d
+#define CODON_UAA 0x30
+#define CODON_UAG 0x31
+#define CODON_UGA 0x34
+// Finished GC runs followed in the open gene (at most 5 can reach 1/5th of its length)
+#define GENE_ANALYSIS_ZONES 8
+
+// Gene being read by analysing_genes, from its start codon
+typedef struct gene_analysis_open_s {
+
+    //First bit of the gene, -1 if no gene is open
+    long int start;
+
+    //Nucleotides read, amino acids written, and the nucleotides of the current codon
+    size_t nb_rna;
+    size_t nb_aa;
+    unsigned codon;
+
+    //GC run in progress (bits), and its start from the gene start
+    unsigned long run_size;
+    unsigned long run_start;
+
+    //Finished GC runs that can still reach 1/5th of the gene length
+    unsigned nb_zones;
+    unsigned long zone_start[GENE_ANALYSIS_ZONES];
+    unsigned long zone_end[GENE_ANALYSIS_ZONES];
+    unsigned long zone_size[GENE_ANALYSIS_ZONES];
+
+}gene_analysis_open_t;
+
+/**
+ * Free the results of analysing_genes.
+ */
+void gene_analysis_free(gene_analysis_t* analysis){
+    free(analysis->genes.gene_start);
+    free(analysis->genes.gene_end);
+    free(analysis->rna);
+    free(analysis->rna_offset);
+    free(analysis->proteins);
+    free(analysis->protein_offset);
+    free(analysis->mut_size);
+    free(analysis->mut_start);
+    free(analysis->mut_end);
+    memset(analysis, 0, sizeof(*analysis));
+}
+
+// Room for size chars in a buffer, doubled when needed
+static int gene_analysis_reserve(char** buffer, size_t* capacity, const size_t size){
+    if (size <= *capacity)
+        return 0;
+    size_t new_capacity = *capacity ? *capacity : 4096;
+    while (new_capacity < size)
+        new_capacity *= 2;
+    char* tmp = realloc(*buffer, new_capacity);
+    if (!tmp)
+        return -1;
+    *buffer = tmp;
+    *capacity = new_capacity;
+    return 0;
+}
+
+// Room for one more gene, the per gene arrays are doubled when needed
+static int gene_analysis_grow(gene_analysis_t* analysis, unsigned long long* capacity){
+    if (analysis->genes.genes_counter < *capacity)
+        return 0;
+    unsigned long long n = *capacity ? 2 * *capacity : MAX_GENES;
+
+#define GENE_ANALYSIS_REALLOC(array, count) do { \
+        void* tmp = realloc(array, sizeof(*array) * (count)); \
+        if (!tmp) \
+            return -1; \
+        array = tmp; \
+    } while (0)
+    GENE_ANALYSIS_REALLOC(analysis->genes.gene_start, n);
+    GENE_ANALYSIS_REALLOC(analysis->genes.gene_end, n);
+    GENE_ANALYSIS_REALLOC(analysis->rna_offset, n);
+    GENE_ANALYSIS_REALLOC(analysis->protein_offset, n);
+    GENE_ANALYSIS_REALLOC(analysis->mut_size, GENE_MUTATIONS * n);
+    GENE_ANALYSIS_REALLOC(analysis->mut_start, GENE_MUTATIONS * n);
+    GENE_ANALYSIS_REALLOC(analysis->mut_end, GENE_MUTATIONS * n);
+#undef GENE_ANALYSIS_REALLOC
+
+    *capacity = n;
+    return 0;
+}
+
+/**
+ * Add one nucleotide to the open gene: its mRNA, its amino acid chain, and its GC runs as detecting_mutations.
+ */
+static inline void gene_analysis_nucleotide(gene_analysis_open_t* gene, char* rna, char* aa, const char* table,
+                                            const unsigned long offset, const unsigned code){
+    rna[gene->nb_rna++] = "AGCU"[code];
+    gene->codon = ((gene->codon << 2) | code) & 0x3f;
+    if (gene->nb_rna % 3 == 0)
+        aa[gene->nb_aa++] = table[gene->codon];
+
+    // G or C: the run goes on (detecting_mutations keeps its start in an unsigned short)
+    if (code == 1 || code == 2) {
+        if (!gene->run_size)
+            gene->run_start = (unsigned short)offset;
+        gene->run_size += 2;
+        return;
+    }
+    if (!gene->run_size)
+        return;
+
+    // A or T: the run is finished, the gene is longer than offset, so runs under (offset + 1) / 5 are never zones
+    unsigned long threshold = (offset + 1) / 5;
+    unsigned kept = 0;
+    for (unsigned z = 0; z < gene->nb_zones; z++) {
+        if (gene->zone_size[z] < threshold)
+            continue;
+        gene->zone_start[kept] = gene->zone_start[z];
+        gene->zone_end[kept] = gene->zone_end[z];
+        gene->zone_size[kept] = gene->zone_size[z];
+        kept++;
+    }
+    gene->nb_zones = kept;
+    if (gene->run_size >= threshold && gene->nb_zones < GENE_ANALYSIS_ZONES) {
+        gene->zone_start[gene->nb_zones] = gene->run_start;
+        gene->zone_end[gene->nb_zones] = offset;
+        gene->zone_size[gene->nb_zones] = gene->run_size;
+        gene->nb_zones++;
+    }
+    gene->run_size = 0;
+}
+
+/**
+ * Detects the genes of a sequence, and generates their mRNA, amino acid chains and mutation zones, in one pass.
+ * 
+ * in : seq_bin : sequence in binary array format
+ * in : nb_bits : number total of used bits in the sequence
+ * out : analysis : results, to free with gene_analysis_free
+ * out : int : 0, -1 on error
+ * 
+ * Same results as detecting_genes, then generating_mRNA, generating_amino_acid_chain and detecting_mutations
+ * on each gene, but every nucleotide is read once: the codons are checked at the same positions as
+ * detecting_genes, and the nucleotides of the open gene are translated as they are read.
+ * A new start codon restarts the open gene, as in detecting_genes.
+ */
+GENE_KERNEL
+int analysing_genes(const long int* seq_bin, const long int nb_bits, gene_analysis_t* analysis){
+    PERF_BEGIN(PERF_ANALYSING_GENES);
+    memset(analysis, 0, sizeof(*analysis));
+    if (!seq_bin)
+        return printf("ERROR: analysing_genes: undefined sequence\n"), -1;
+
+    const char* table = codon_tables[(int)codon_table_index[0]];
+    unsigned long long capacity = 0;
+    size_t rna_size = 0, rna_capacity = 0, protein_size = 0, protein_capacity = 0;
+    int res = gene_analysis_grow(analysis, &capacity)
+        || gene_analysis_reserve(&analysis->rna, &rna_capacity, 1)
+        || gene_analysis_reserve(&analysis->proteins, &protein_capacity, 1);
+
+    gene_analysis_open_t gene;
+    memset(&gene, 0, sizeof(gene));
+    gene.start = -1;
+    // Three last nucleotides, and the position of the next codon to check
+    unsigned codon = 0;
+    long int next = 0;
+
+    for (long int pos = 0; pos + 2 <= nb_bits && !res; pos += 2) {
+        unsigned code = (get_binary_value(seq_bin, pos) << 1) | get_binary_value(seq_bin, pos + 1);
+        codon = ((codon << 2) | code) & 0x3f;
+
+        // Room for the three nucleotides of a start codon and the null characters
+        if (gene_analysis_reserve(&analysis->rna, &rna_capacity, rna_size + (gene.start >= 0 ? gene.nb_rna : 0) + 4)
+            || gene_analysis_reserve(&analysis->proteins, &protein_capacity,
+                                     protein_size + (gene.start >= 0 ? gene.nb_aa : 0) + 2)) {
+            res = -1;
+            break;
+        }
+        if (gene.start >= 0)
+            gene_analysis_nucleotide(&gene, analysis->rna + rna_size, analysis->proteins + protein_size, table,
+                                     pos - gene.start, code);
+
+        // The codon to check is not complete yet
+        if (pos < next + 4)
+            continue;
+
+        if (codon == CODON_AUG) {
+            // (Re)start a gene with its start codon
+            gene.start = next;
+            gene.nb_rna = gene.nb_aa = 0;
+            gene.codon = 0;
+            gene.run_size = 0;
+            gene.nb_zones = 0;
+            for (int n = 0; n < 3; n++)
+                gene_analysis_nucleotide(&gene, analysis->rna + rna_size, analysis->proteins + protein_size, table,
+                                         2 * n, (codon >> (4 - 2 * n)) & 3);
+            next += 6;
+        }
+        else if (gene.start >= 0 && (codon == CODON_UAA || codon == CODON_UAG || codon == CODON_UGA)) {
+            if (gene_analysis_grow(analysis, &capacity)) {
+                res = -1;
+                break;
+            }
+            unsigned long long g = analysis->genes.genes_counter++;
+            long int end = next + 5;
+            analysis->genes.gene_start[g] = gene.start;
+            analysis->genes.gene_end[g] = end;
+
+            analysis->rna_offset[g] = rna_size;
+            analysis->rna[rna_size + gene.nb_rna] = '\0';
+            rna_size += gene.nb_rna + 1;
+
+            // No amino acid chain if the gene has no whole codons
+            if (gene.nb_rna % 3)
+                gene.nb_aa = 0;
+            analysis->protein_offset[g] = protein_size;
+            analysis->proteins[protein_size + gene.nb_aa] = '\0';
+            protein_size += gene.nb_aa + 1;
+
+            // Zones of 1/5th of the gene length, then the GC run up to the end of the gene
+            unsigned long size_sequence = end - gene.start;
+            unsigned long threshold = size_sequence / 5;
+            unsigned long* sizes = analysis->mut_size + GENE_MUTATIONS * g;
+            unsigned long* starts = analysis->mut_start + GENE_MUTATIONS * g;
+            unsigned long* ends = analysis->mut_end + GENE_MUTATIONS * g;
+            unsigned nb = 0;
+            for (unsigned z = 0; z < gene.nb_zones && nb < GENE_MUTATIONS; z++) {
+                if (gene.zone_size[z] < threshold)
+                    continue;
+                sizes[nb] = gene.zone_size[z] - 1;
+                starts[nb] = gene.zone_start[z];
+                ends[nb] = gene.zone_end[z];
+                nb++;
+            }
+            if (gene.run_size && gene.run_size >= threshold && nb < GENE_MUTATIONS) {
+                sizes[nb] = gene.run_size - 1;
+                starts[nb] = gene.run_start;
+                ends[nb] = size_sequence;
+                nb++;
+            }
+            for (; nb < GENE_MUTATIONS; nb++)
+                sizes[nb] = starts[nb] = ends[nb] = 0;
+
+            gene.start = -1;
+            next += 6;
+        }
+        else
+            next += 2;
+    }
+
+    PERF_END(PERF_ANALYSING_GENES);
+    if (res) {
+        gene_analysis_free(analysis);
+        return printf("ERROR: analysing_genes: cannot allocate memory\n"), -1;
+    }
+    return 0;
 }
 
 /**
@@ -752,26 +1078,146 @@ void detecting_mutations(const long int *gene_seq, const long int start_pos, con
 */
 float calculating_matching_score(const long int *seq1, long int start_pos1,const int seq_size1,
                                  const long int *seq2, long int start_pos2,const int seq_size2) {
+    PERF_BEGIN(PERF_CALCULATING_MATCHING_SCORE);
     // Check the input argument
     if (!seq1 || !seq2)
         return printf("ERROR: calculating_matching_score: undefined sequence\n"), -1.0;
 
+    // xor_size = max size between 'seq_size1' and 'seq_size2'
+    int xor_size = seq_size1 >= seq_size2 ? seq_size1 : seq_size2;
+
+    // The temporary arrays are taken from the thread arena, and given back at the end
+    arena_t* arena = arena_thread();
+    if (!arena)
+        return -1.0;
+    arena_mark_t mark = arena_mark(arena);
+
     // First step: apply the xor operation between both arrays 
     long int *seq1tmp;
-    seq1tmp = get_piece_binary_array(seq1, start_pos1, seq_size1);
+    seq1tmp = get_piece_binary_array_into(seq1, start_pos1, seq_size1,
+                                          arena_alloc(arena, binary_array_size(seq_size1) * sizeof(long int)));
 
     long int *seq2tmp;
-    seq2tmp = get_piece_binary_array(seq2, start_pos2, seq_size2);    
+    seq2tmp = get_piece_binary_array_into(seq2, start_pos2, seq_size2,
+                                          arena_alloc(arena, binary_array_size(seq_size2) * sizeof(long int)));
 
     long int *xor = NULL;
-    xor = xor_binary_array(seq1tmp, seq_size1, seq2tmp, seq_size2);
-    // xor_size = max size between 'seq_size1' and 'seq_size2'
-    int xor_size = seq_size1 >= seq_size2 ? seq_size1 : seq_size2;
+    if (seq1tmp && seq2tmp)
+        xor = xor_binary_array_into(seq1tmp, seq_size1, seq2tmp, seq_size2,
+                                    arena_alloc(arena, binary_array_size(xor_size) * sizeof(long int)));
+    if (!xor)
+        return arena_rewind(arena, mark), -1.0;
 
     //Second step: count the number of bits whose value is 1 on the result
     int pop = popcount_binary_array(xor, xor_size);
+    arena_rewind(arena, mark);
 
     //Last step: compute the percentage
     float y = ((float)pop * 100.0) / (float)xor_size;
+    PERF_END(PERF_CALCULATING_MATCHING_SCORE);
     return 100.0 - y;
-}
\ No newline at end of file
+}
+
+typedef struct matching_cursor_s {
+    //Word read, its first position and the one after its last, and the different bits before it
+    long int w;
+    long int start;
+    long int end;
+    long int mismatches;
+}matching_cursor_t;
+
+static inline void matching_cursor_init(matching_cursor_t* cursor, const long int pos){
+    cursor->w = pos > 63 ? pos / 63 : 0;
+    cursor->start = cursor->w < 2 ? 64 * cursor->w : 63 * cursor->w;
+    cursor->end = cursor->w ? (cursor->w == 1 ? 126 : cursor->start + 63) : 64;
+    cursor->mismatches = 0;
+}
+
+/**
+ * Different bits of two binary arrays, from the first word of a cursor to a position.
+ *
+ * in : seq1, seq2 : sequences in binary array format
+ * in : cursor : words counted, moved forward to the word of pos
+ * in : pos : position after the last bit counted, not before the previous one
+ * out : long : different bits
+ *
+ * The words before the word of pos are counted once by the cursor, the bits of the word of pos
+ * before pos are masked: the positions start to end - 1 of a word are its bits (start - w) % 64
+ * and the next ones (get_binary_value).
+ */
+static inline long matching_mismatches(const long int* seq1, const long int* seq2, matching_cursor_t* cursor,
+                                       const long int pos){
+    while (cursor->end <= pos) {
+        cursor->mismatches += __builtin_popcountl(seq1[cursor->w] ^ seq2[cursor->w]);
+        cursor->w++;
+        cursor->start = cursor->end;
+        cursor->end = cursor->w == 1 ? 126 : cursor->start + 63;
+    }
+    long int n = pos - cursor->start;
+    if (!n)
+        return cursor->mismatches;
+
+    int rot = (cursor->start - cursor->w) & 63;
+    unsigned long mask = (1UL << n) - 1;
+    if (rot)
+        mask = mask << rot | mask >> (64 - rot);
+    return cursor->mismatches + __builtin_popcountl((seq1[cursor->w] ^ seq2[cursor->w]) & mask);
+}
+
+/**
+ * Calculates the matching score of every window of two binary array sequences.
+ *
+ * in : seq1, start_pos1 : first sequence in binary, and the position of its first bit compared
+ * in : seq2, start_pos2 : second sequence in binary, and the position of its first bit compared
+ * in : size : number of bits compared
+ * in : window, step : bits of a window, and between the starts of two windows
+ * out : profile : matching score of the window i, from the bit i * step: percentage of its equal bits
+ * out : long : number of windows, -1 on error
+ *
+ * The sequences are xored word by word once: a cursor counts the different bits up to the end of
+ * each window and another up to its start, so the cost does not depend on the size of the windows.
+ * Sequences compared from different positions are first realigned by get_piece_binary_array.
+ */
+GENE_KERNEL
+long calculating_matching_profile(const long int* seq1, const long int start_pos1, const long int* seq2,
+                                  const long int start_pos2, const int size, const int window, const int step,
+                                  float* profile){
+    if (!seq1 || !seq2 || !profile)
+        return printf("ERROR: calculating_matching_profile: undefined sequence\n"), -1;
+    if (start_pos1 < 0 || start_pos2 < 0 || size < 0 || window <= 0 || step <= 0)
+        return printf("ERROR: calculating_matching_profile: invalid window\n"), -1;
+    if (size < window)
+        return 0;
+
+    // Pieces starting at the same position of their words when the sequences are not aligned
+    arena_t* arena = NULL;
+    arena_mark_t mark;
+    long int pos = start_pos1;
+    if (start_pos1 != start_pos2) {
+        if (!(arena = arena_thread()))
+            return -1;
+        mark = arena_mark(arena);
+        seq1 = get_piece_binary_array_into(seq1, start_pos1, size,
+                                           arena_alloc(arena, binary_array_size(size) * sizeof(long int)));
+        seq2 = get_piece_binary_array_into(seq2, start_pos2, size,
+                                           arena_alloc(arena, binary_array_size(size) * sizeof(long int)));
+        pos = 0;
+        if (!seq1 || !seq2)
+            return arena_rewind(arena, mark), -1;
+    }
+
+    long nb_windows = (size - window) / step + 1;
+    matching_cursor_t head, tail;
+    matching_cursor_init(&head, pos);
+    matching_cursor_init(&tail, pos);
+    for (long i = 0; i < nb_windows; i++, pos += step) {
+        long pop = matching_mismatches(seq1, seq2, &head, pos + window) - matching_mismatches(seq1, seq2, &tail, pos);
+        float y = ((float)pop * 100.0) / (float)window;
+        profile[i] = 100.0 - y;
+    }
+
+    if (arena)
+        arena_rewind(arena, mark);
+    return nb_windows;
+}
+
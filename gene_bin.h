@@ -1,9 +1,23 @@
 #pragma once 
 
+#include <stddef.h>
+
 #define MAX_GENES 1024
 // Number of bits in an integer
 #define int_SIZE 63
 
+// Hot kernels are compiled for several instruction sets (scalar, SSE4.2, AVX2, AVX-512),
+// the best one for the CPU is selected once, when the library is loaded (GNU ifunc).
+// Build with -DGENE_NO_DISPATCH to only keep the variant of the compiler flags.
+#if defined(__GNUC__) && __GNUC__ >= 11 && !defined(__clang__) && !defined(__INTEL_COMPILER) \
+    && defined(__x86_64__) && defined(__linux__) && !defined(GENE_NO_DISPATCH)
+#define GENE_DISPATCH 1
+#define GENE_KERNEL __attribute__((target_clones("default", "arch=x86-64-v2", "arch=x86-64-v3", "arch=x86-64-v4")))
+#else
+#define GENE_DISPATCH 0
+#define GENE_KERNEL
+#endif
+
 typedef struct gene_map_s {
 
     //
@@ -23,29 +37,77 @@ typedef struct mutation_map {
     unsigned long *end_mut;
 }mutation_map;
 
+// Mutation zones kept per gene by analysing_genes (a gene cannot have more zones of 1/5th of its length)
+#define GENE_MUTATIONS 5
+
+typedef struct gene_analysis_s {
+
+    //Genes, as detecting_genes
+    gene_map_t genes;
+
+    //mRNA of each gene, as generating_mRNA(seq, start, end - start): null terminated, at rna + rna_offset[gene]
+    char* rna;
+    size_t* rna_offset;
+
+    //Amino acid chain of each gene, as generating_amino_acid_chain(seq, start, end - start + 1),
+    //empty when it cannot be generated: null terminated, at proteins + protein_offset[gene]
+    char* proteins;
+    size_t* protein_offset;
+
+    //Mutation zones of each gene, as detecting_mutations(seq, start, end - start):
+    //GENE_MUTATIONS per gene, size 0: no zone
+    unsigned long* mut_size;
+    unsigned long* mut_start;
+    unsigned long* mut_end;
+
+}gene_analysis_t;
+
 
 /********** BINARIES FUNCTION **********/
 
+const char* cpu_dispatch_level(void);
 int get_binary_value(const long int *seq_bin, const int pos);
 long int* change_binary_value(long int *seq_bin, const int pos, const int value);
+long int binary_array_size(const long int nb_bits);
 long int* set_binary_array(const char *array, const unsigned size);
+long int* set_binary_array_into(const char *array, const unsigned size, long int* seq_bin);
 long int* xor_binary_array(long int * const seq1, const unsigned array_size1,
                                 long int * const seq2, const unsigned array_size2);
+long int* xor_binary_array_into(const long int* seq1, const unsigned array_size1,
+                                const long int* seq2, const unsigned array_size2, long int* xor);
 int popcount_binary_array(const long int *seq, const long int size);
 long int* get_piece_binary_array(const long int* seq_bin,  const long int pos_start, const long int size);
+long int* get_piece_binary_array_into(const long int* seq_bin, const long int pos_start, const long int size,
+                                      long int* piece_seq_bin);
+void get_bases_binary_array(const long int* seq_bin, const long int nb_words, const unsigned long long base,
+                            unsigned long long bits[2]);
 
 
 /******** DNA & GENES FUNCTION *********/
 
 long int* convert_to_binary(const char* dna_seq, const unsigned size);
 char* binary_to_dna(long int* bin_dna_seq, const unsigned size);
+char* binary_to_dna_into(const long int* bin_dna_seq, const unsigned size, char* dna_seq);
 char* generating_mRNA(const long int* gene_seq, const long start_pos,const long int seq_size);
+char* generating_mRNA_into(const long int* gene_seq, const long start_pos, const long int seq_size, char* rna_seq);
 void detecting_genes(const long int *gene, const long int gene_size,
                      gene_map_t* gene_map);
 char* generating_amino_acid_chain(const long int *gene_seq,const long int start_pos, const long int seq_size);
+char* generating_amino_acid_chain_into(const long int *gene_seq, const long int start_pos, const long int seq_size,
+                                       char* aa_seq);
+char* generating_amino_acid_chain_table(const long int *gene_seq, const long int start_pos, const long int seq_size,
+                                        const int table_id);
+char* generating_amino_acid_chain_table_into(const long int *gene_seq, const long int start_pos, const long int seq_size,
+                                             const int table_id, char* aa_seq);
+const char* codon_table_name(const int table_id);
 void detecting_mutations(const long int *gene_seq,const long int start_pos, const long int size_sequence,
                          mutation_map mut_m);
+int analysing_genes(const long int* seq_bin, const long int nb_bits, gene_analysis_t* analysis);
+void gene_analysis_free(gene_analysis_t* analysis);
 float calculating_matching_score(const long int *seq1, long int start_pos1,const int seq_size1,
                                  const long int *seq2, long int start_pos2,const int seq_size2);
+long calculating_matching_profile(const long int* seq1, const long int start_pos1, const long int* seq2,
+                                  const long int start_pos2, const int size, const int window, const int step,
+                                  float* profile);
 
 
@@ -0,0 +1,293 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gene_stream.h"
+
+// Codon values (3 nucleotides of 2 bits, first nucleotide in the high bits), A = 00, G = 01, C = 10, T/U = 11
+#define CODON_AUG 0x0d
+#define CODON_UAA 0x30
+#define CODON_UAG 0x31
+#define CODON_UGA 0x34
+
+// Characters that are not nucleotides
+#define NOT_NUCLEOTIDE 4
+
+// Nucleotide values, with the same encoding as set_binary_array (the other IUPAC codes are A = 00).
+// Lower case (soft-masked) nucleotides are read as upper case ones, U as T.
+static const unsigned char gene_stream_codes[256] = {
+    ['T'] = 3, ['U'] = 3, ['G'] = 1, ['C'] = 2, ['K'] = 1, ['H'] = 1, ['Y'] = 2, ['S'] = 2, ['B'] = 2,
+    ['t'] = 3, ['u'] = 3, ['g'] = 1, ['c'] = 2, ['k'] = 1, ['h'] = 1, ['y'] = 2, ['s'] = 2, ['b'] = 2,
+    [' '] = NOT_NUCLEOTIDE, ['\t'] = NOT_NUCLEOTIDE, ['\r'] = NOT_NUCLEOTIDE, ['\n'] = NOT_NUCLEOTIDE,
+};
+
+
+/**
+ * Send an event to the callback.
+ */
+static void gene_stream_emit(gene_stream_t* stream, gene_stream_event_t* event){
+    event->record = stream->record;
+    event->name = stream->name;
+    if (stream->callback(event, stream->arg))
+        stream->stopped = 1;
+}
+
+/**
+ * Start a new sequence: no open gene.
+ */
+static void gene_stream_reset_sequence(gene_stream_t* stream){
+    stream->pos = 0;
+    stream->codon = 0;
+    stream->next = 0;
+    stream->gene_start = -1;
+    stream->run_size = 0;
+    stream->run_start = 0;
+    stream->nb_zones = 0;
+}
+
+/**
+ * Initialize a stream.
+ *
+ * in : stream : stream to initialize
+ * in : callback : function called for each record, gene and mutation zone
+ * in : arg : argument of the callback
+ */
+void gene_stream_init(gene_stream_t* stream, gene_stream_callback_t callback, void* arg){
+    stream->callback = callback;
+    stream->arg = arg;
+    stream->stopped = 0;
+    stream->record = -1;
+    stream->at_line_start = 1;
+    stream->in_header = 0;
+    stream->name[0] = '\0';
+    stream->name_size = 0;
+    gene_stream_reset_sequence(stream);
+}
+
+/**
+ * Forget the finished GC runs that cannot reach 1/5th of the gene length anymore.
+ *
+ * The gene is at least as long as what has been read, so the threshold can only grow.
+ */
+static void gene_stream_prune_zones(gene_stream_t* stream, const unsigned long long threshold){
+    unsigned kept = 0;
+    for (unsigned z = 0; z < stream->nb_zones; z++) {
+        if (stream->zone_size[z] < threshold)
+            continue;
+        stream->zone_start[kept] = stream->zone_start[z];
+        stream->zone_end[kept] = stream->zone_end[z];
+        stream->zone_size[kept] = stream->zone_size[z];
+        kept++;
+    }
+    stream->nb_zones = kept;
+}
+
+/**
+ * Follow the GC runs of the open gene, as detecting_mutations scans a gene.
+ */
+static void gene_stream_gc(gene_stream_t* stream, const unsigned long long pos, const unsigned code){
+    // Bits from the gene start
+    unsigned long long offset = 2 * (pos - stream->gene_start);
+
+    // G or C: the run goes on
+    if (code == 1 || code == 2) {
+        if (!stream->run_size)
+            stream->run_start = offset;
+        stream->run_size += 2;
+        return;
+    }
+    if (!stream->run_size)
+        return;
+
+    // A or T: the run is finished, keep it if it can still be a mutation zone
+    unsigned long long threshold = (offset + 1) / 5;
+    gene_stream_prune_zones(stream, threshold);
+    if (stream->run_size >= threshold && stream->nb_zones < GENE_STREAM_MAX_ZONES) {
+        stream->zone_start[stream->nb_zones] = stream->run_start;
+        stream->zone_end[stream->nb_zones] = offset;
+        stream->zone_size[stream->nb_zones] = stream->run_size;
+        stream->nb_zones++;
+    }
+    stream->run_size = 0;
+}
+
+/**
+ * A stop codon ends the open gene: emit it with its mutation zones.
+ */
+static void gene_stream_gene(gene_stream_t* stream, const unsigned long long pos){
+    gene_stream_event_t event;
+    event.type = GENE_STREAM_GENE;
+    event.gene_start = 2 * stream->gene_start;
+    event.gene_end = 2 * pos + 1;
+    event.mut_start = event.mut_end = event.mut_size = 0;
+    gene_stream_emit(stream, &event);
+
+    // Same zones as detecting_mutations(seq, gene_start, gene_end - gene_start)
+    unsigned long long size_sequence = event.gene_end - event.gene_start;
+    unsigned long long threshold = size_sequence / 5;
+    event.type = GENE_STREAM_MUTATION;
+    for (unsigned z = 0; z < stream->nb_zones && !stream->stopped; z++) {
+        if (stream->zone_size[z] < threshold)
+            continue;
+        event.mut_start = stream->zone_start[z];
+        event.mut_end = stream->zone_end[z];
+        event.mut_size = stream->zone_size[z] - 1;
+        gene_stream_emit(stream, &event);
+    }
+    // GC run up to the end of the gene
+    if (stream->run_size && stream->run_size >= threshold && !stream->stopped) {
+        event.mut_start = stream->run_start;
+        event.mut_end = size_sequence;
+        event.mut_size = stream->run_size - 1;
+        gene_stream_emit(stream, &event);
+    }
+}
+
+/**
+ * Read one nucleotide.
+ *
+ * The codons are checked at the same positions as detecting_genes: one nucleotide after another,
+ * three after a start or a stop codon.
+ */
+static void gene_stream_nucleotide(gene_stream_t* stream, const unsigned code){
+    unsigned long long pos = stream->pos++;
+    stream->codon = ((stream->codon << 2) | code) & 0x3f;
+
+    if (stream->gene_start >= 0)
+        gene_stream_gc(stream, pos, code);
+
+    // The codon to check is not complete yet
+    if (pos < stream->next + 2)
+        return;
+
+    if (stream->codon == CODON_AUG) {
+        // (Re)start a gene: its scan starts on A, U, and G starts a GC run
+        stream->gene_start = stream->next;
+        stream->run_size = 2;
+        stream->run_start = 4;
+        stream->nb_zones = 0;
+        stream->next += 3;
+    }
+    else if (stream->gene_start >= 0
+             && (stream->codon == CODON_UAA || stream->codon == CODON_UAG || stream->codon == CODON_UGA)) {
+        gene_stream_gene(stream, pos);
+        stream->gene_start = -1;
+        stream->run_size = 0;
+        stream->nb_zones = 0;
+        stream->next += 3;
+    }
+    else
+        stream->next += 1;
+}
+
+/**
+ * End of a header line: emit the record.
+ */
+static void gene_stream_record(gene_stream_t* stream){
+    gene_stream_event_t event;
+    memset(&event, 0, sizeof(event));
+    event.type = GENE_STREAM_RECORD;
+    stream->name[stream->name_size] = '\0';
+    stream->in_header = 0;
+    gene_stream_emit(stream, &event);
+}
+
+/**
+ * Analyse a chunk of a FASTA file.
+ *
+ * in : stream : stream
+ * in : chunk : next characters of the FASTA file (any size, records and lines may be cut anywhere)
+ * in : size : number of characters
+ * out : int : 0, -1 if the callback has stopped the stream
+ *
+ * Genes are emitted when their stop codon is read, followed by their mutation zones.
+ * The memory used does not depend on the size of the input: only the open gene state is kept between chunks.
+ * A sequence without header is the record 0, without name.
+ */
+int gene_stream_feed(gene_stream_t* stream, const char* chunk, const size_t size){
+    for (size_t i = 0; i < size && !stream->stopped; i++) {
+        char c = chunk[i];
+
+        if (stream->in_header) {
+            if (c == '\n')
+                gene_stream_record(stream);
+            else if (c != '\r' && stream->name_size < GENE_STREAM_NAME_SIZE - 1)
+                stream->name[stream->name_size++] = c;
+            continue;
+        }
+        if (c == '\n') {
+            stream->at_line_start = 1;
+            continue;
+        }
+        if (stream->at_line_start && c == '>') {
+            stream->record++;
+            gene_stream_reset_sequence(stream);
+            stream->name_size = 0;
+            stream->in_header = 1;
+            continue;
+        }
+        stream->at_line_start = 0;
+
+        unsigned code = gene_stream_codes[(unsigned char)c];
+        if (code == NOT_NUCLEOTIDE)
+            continue;
+        if (stream->record < 0) {
+            stream->record = 0;
+            stream->name_size = 0;
+            gene_stream_record(stream);
+        }
+        gene_stream_nucleotide(stream, code);
+    }
+    return stream->stopped ? -1 : 0;
+}
+
+/**
+ * End of the FASTA file.
+ *
+ * in : stream : stream
+ * out : int : 0, -1 if the callback has stopped the stream
+ *
+ * A gene without stop codon at the end of a record is not a gene (as in detecting_genes).
+ */
+int gene_stream_end(gene_stream_t* stream){
+    // Header on the last line, without end of line
+    if (stream->in_header && !stream->stopped)
+        gene_stream_record(stream);
+    gene_stream_reset_sequence(stream);
+    return stream->stopped ? -1 : 0;
+}
+
+/**
+ * Analyse a whole FASTA file, chunk by chunk.
+ *
+ * in : in : FASTA file
+ * in : chunk_size : number of characters read at once (0 = GENE_STREAM_CHUNK_SIZE)
+ * in : callback : function called for each record, gene and mutation zone
+ * in : arg : argument of the callback
+ * out : int : 0, -1 on error or if the callback has stopped the stream
+ */
+int gene_stream_file(FILE* in, const size_t chunk_size, gene_stream_callback_t callback, void* arg){
+    size_t size = chunk_size ? chunk_size : GENE_STREAM_CHUNK_SIZE;
+
+    // Allocate memory and verify it has been allocated
+    char* chunk = malloc(size);
+    if (!chunk)
+        return printf("ERROR: gene_stream_file: cannot allocate memory\n"), -1;
+
+    gene_stream_t stream;
+    gene_stream_init(&stream, callback, arg);
+
+    int res = 0;
+    size_t nb;
+    while (!res && (nb = fread(chunk, 1, size, in)) > 0)
+        res = gene_stream_feed(&stream, chunk, nb);
+    if (!res)
+        res = gene_stream_end(&stream);
+    if (!res && ferror(in)) {
+        printf("ERROR: gene_stream_file: cannot read the file\n");
+        res = -1;
+    }
+
+    free(chunk);
+    return res;
+}
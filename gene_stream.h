@@ -0,0 +1,85 @@
+#pragma once
+
+#include <stdio.h>
+#include <stddef.h>
+
+// Default size of the chunks read from a FASTA file
+#define GENE_STREAM_CHUNK_SIZE (1 << 20)
+// Longest kept record name (the rest of the header line is skipped)
+#define GENE_STREAM_NAME_SIZE 256
+// Candidate mutation zones of an open gene (at most 5 can reach 1/5th of the gene length)
+#define GENE_STREAM_MAX_ZONES 8
+
+typedef enum gene_stream_event_type_e {
+    //New FASTA record: record, name
+    GENE_STREAM_RECORD,
+    //Gene found: record, gene_start, gene_end
+    GENE_STREAM_GENE,
+    //Mutation zone of the last gene: record, gene_start, gene_end, mut_start, mut_end, mut_size
+    GENE_STREAM_MUTATION
+}gene_stream_event_type_t;
+
+typedef struct gene_stream_event_s {
+
+    gene_stream_event_type_t type;
+
+    //Index of the FASTA record (0 for a sequence without header)
+    unsigned long record;
+    //Record name: header line without the '>'
+    const char* name;
+
+    //Gene position in the record, in bits as gene_map_t (start of AUG, last bit of the stop codon)
+    unsigned long long gene_start;
+    unsigned long long gene_end;
+
+    //Mutation zone, in bits from the gene start, as mutation_map
+    unsigned long long mut_start;
+    unsigned long long mut_end;
+    unsigned long long mut_size;
+
+}gene_stream_event_t;
+
+// Called for each event, stops the stream when it does not return 0
+typedef int (*gene_stream_callback_t)(const gene_stream_event_t* event, void* arg);
+
+typedef struct gene_stream_s {
+
+    gene_stream_callback_t callback;
+    void* arg;
+    int stopped;
+
+    //FASTA parsing state
+    long record;
+    int at_line_start;
+    int in_header;
+    char name[GENE_STREAM_NAME_SIZE];
+    size_t name_size;
+
+    //Position of the next nucleotide in the record
+    unsigned long long pos;
+    //Three last nucleotides (2 bits each, the last one in the low bits)
+    unsigned codon;
+    //Position of the next codon to check (detecting_genes steps)
+    unsigned long long next;
+    //Start of the open gene, -1 if none
+    long long gene_start;
+
+    //GC run in progress in the open gene (bits), and its start from the gene start
+    unsigned long long run_size;
+    unsigned long long run_start;
+
+    //Finished GC runs that can still reach 1/5th of the open gene length
+    unsigned nb_zones;
+    unsigned long long zone_start[GENE_STREAM_MAX_ZONES];
+    unsigned long long zone_end[GENE_STREAM_MAX_ZONES];
+    unsigned long long zone_size[GENE_STREAM_MAX_ZONES];
+
+}gene_stream_t;
+
+
+/******** STREAMING FUNCTION *********/
+
+void gene_stream_init(gene_stream_t* stream, gene_stream_callback_t callback, void* arg);
+int gene_stream_feed(gene_stream_t* stream, const char* chunk, const size_t size);
+int gene_stream_end(gene_stream_t* stream);
+int gene_stream_file(FILE* in, const size_t chunk_size, gene_stream_callback_t callback, void* arg);
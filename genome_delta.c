@@ -0,0 +1,696 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "genome_delta.h"
+
+#define DELTA_READ(ptr, nb, f) (fread((ptr), sizeof(*(ptr)), (nb), (f)) != (size_t)(nb))
+#define DELTA_WRITE(ptr, nb, f) (fwrite((ptr), sizeof(*(ptr)), (nb), (f)) != (size_t)(nb))
+
+
+/***************************************/
+/**************** EDITS ****************/
+/***************************************/
+
+// Bases of the genome covered by an edit
+static inline uint64_t genome_edit_glen(const genome_edit_t* edit){
+    return edit->kind == GENOME_EDIT_DELETION ? 0 : edit->len;
+}
+
+// Bases of the reference covered by an edit
+static inline uint64_t genome_edit_rlen(const genome_edit_t* edit){
+    return edit->kind == GENOME_EDIT_INSERTION ? 0 : edit->len;
+}
+
+// Room for needed items in an array grown by doubling
+static int genome_delta_reserve(void** array, uint64_t* capacity, const uint64_t needed, const size_t item){
+    if (needed <= *capacity)
+        return 0;
+    uint64_t size = *capacity ? *capacity : 16;
+    while (size < needed)
+        size *= 2;
+    void* tmp = realloc(*array, size * item);
+    if (!tmp)
+        return -1;
+    *array = tmp;
+    *capacity = size;
+    return 0;
+}
+
+/**
+ * Append an edit to the edits of the reference or of the last genome.
+ *
+ * in : delta : collection
+ * in : edits, nb_edits, capacity : edits of the reference or of the genomes, and their allocated size
+ * in : kind, pos, gpos, len : edit
+ * in : bases : substituted or inserted bases, NULL for a deletion or a N-run
+ * in : first : first edit of the genome, the previous ones are not merged with
+ * out : int : 0, -1 on error
+ *
+ * A substitution or a N-run following one of the same kind is merged with it, edits longer than
+ * GENOME_DELTA_MAX_EDIT are split.
+ */
+static int genome_delta_edit(genome_delta_t* delta, genome_edit_t** edits, uint64_t* nb_edits, uint64_t* capacity,
+                             const uint64_t first, const uint32_t kind, const uint64_t pos, const uint64_t gpos,
+                             const uint64_t len, const char* bases){
+    if (!len)
+        return 0;
+    if (len > GENOME_DELTA_MAX_EDIT) {
+        uint64_t ref_len = kind == GENOME_EDIT_INSERTION ? 0 : GENOME_DELTA_MAX_EDIT;
+        uint64_t seq_len = kind == GENOME_EDIT_DELETION ? 0 : GENOME_DELTA_MAX_EDIT;
+        return genome_delta_edit(delta, edits, nb_edits, capacity, first, kind, pos, gpos,
+                                 GENOME_DELTA_MAX_EDIT, bases)
+            || genome_delta_edit(delta, edits, nb_edits, capacity, first, kind, pos + ref_len, gpos + seq_len,
+                                 len - GENOME_DELTA_MAX_EDIT, bases ? bases + GENOME_DELTA_MAX_EDIT : NULL) ? -1 : 0;
+    }
+
+    genome_edit_t* last = *nb_edits > first ? *edits + *nb_edits - 1 : NULL;
+    int merged = last && last->kind == kind && (kind == GENOME_EDIT_SUBSTITUTION || kind == GENOME_EDIT_N_RUN)
+        && last->pos + genome_edit_rlen(last) == pos && last->gpos + genome_edit_glen(last) == gpos
+        && (!bases || last->data + last->len == delta->bases_size) && last->len + len <= GENOME_DELTA_MAX_EDIT;
+
+    if (bases) {
+        if (delta->bases_size + len > UINT32_MAX)
+            return printf("ERROR: genome_delta_edit: too many bases\n"), -1;
+        if (genome_delta_reserve((void**)&delta->bases, &delta->capacity_bases, delta->bases_size + len, 1))
+            return printf("ERROR: genome_delta_edit: cannot allocate memory\n"), -1;
+        memcpy(delta->bases + delta->bases_size, bases, len);
+    }
+    if (merged) {
+        last->len += len;
+        delta->bases_size += bases ? len : 0;
+        return 0;
+    }
+
+    if (genome_delta_reserve((void**)edits, capacity, *nb_edits + 1, sizeof(**edits)))
+        return printf("ERROR: genome_delta_edit: cannot allocate memory\n"), -1;
+    (*edits)[(*nb_edits)++] = (genome_edit_t){ pos, gpos, bases ? delta->bases_size : 0, len, kind };
+    delta->bases_size += bases ? len : 0;
+    return 0;
+}
+
+// Append an edit to the edits of the genome being added
+static inline int genome_edit(genome_delta_t* delta, uint64_t* nb_edits, const uint64_t first, const uint32_t kind,
+                              const uint64_t pos, const uint64_t gpos, const uint64_t len, const char* bases){
+    return genome_delta_edit(delta, &delta->edits, nb_edits, &delta->capacity_edits, first, kind,
+                             pos, gpos, len, bases);
+}
+
+
+
+/***************************************/
+/*********** RECONSTRUCTION ************/
+/***************************************/
+
+// Bases of the packed reference, from pos
+static void genome_delta_packed(const genome_delta_t* delta, const uint64_t pos, const uint64_t count, char* seq){
+    for (uint64_t i = 0; i < count; i++) {
+        int bit = 2 * (pos + i);
+        seq[i] = "AGCT"[2 * get_binary_value(delta->ref_bin, bit) + get_binary_value(delta->ref_bin, bit + 1)];
+    }
+}
+
+/**
+ * Bases of a sequence given by its edits.
+ *
+ * in : delta : collection
+ * in : edits, nb_edits : edits of the sequence, sorted by position
+ * in : reference : 1 if the edits are those of the reference (over the packed reference),
+ *                  0 if they are those of a genome (over the reference)
+ * in : start, count : window of the sequence
+ * out : seq : count bases
+ *
+ * The first edit of the window is found by a binary search, the bases between two edits are
+ * those of the reference, shifted by the indels before them.
+ */
+static void genome_delta_apply(const genome_delta_t* delta, const genome_edit_t* edits, const uint64_t nb_edits,
+                               const int reference, const uint64_t start, const uint64_t count, char* seq){
+    // First edit ending after start
+    uint64_t low = 0, high = nb_edits;
+    while (low < high) {
+        uint64_t mid = (low + high) / 2;
+        if (edits[mid].gpos + genome_edit_glen(&edits[mid]) <= start)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    uint64_t e = low, gpos = start, end = start + count;
+    while (gpos < end) {
+        if (e < nb_edits && gpos >= edits[e].gpos) {
+            const genome_edit_t* edit = &edits[e];
+            uint64_t edit_end = edit->gpos + genome_edit_glen(edit);
+            if (gpos >= edit_end) {
+                e++;
+                continue;
+            }
+            uint64_t n = (edit_end < end ? edit_end : end) - gpos;
+            if (edit->kind == GENOME_EDIT_N_RUN)
+                memset(seq, 'N', n);
+            else
+                memcpy(seq, delta->bases + edit->data + (gpos - edit->gpos), n);
+            seq += n;
+            gpos += n;
+            continue;
+        }
+
+        // Bases of the reference up to the next edit
+        uint64_t next = e < nb_edits && edits[e].gpos < end ? edits[e].gpos : end;
+        uint64_t pos = gpos;
+        if (e < nb_edits)
+            pos = edits[e].pos - (edits[e].gpos - gpos);
+        else if (nb_edits) {
+            const genome_edit_t* last = &edits[nb_edits - 1];
+            pos = last->pos + genome_edit_rlen(last) + (gpos - last->gpos - genome_edit_glen(last));
+        }
+        if (reference)
+            genome_delta_packed(delta, pos, next - gpos, seq);
+        else
+            genome_delta_apply(delta, delta->ref_edits, delta->nb_ref_edits, 1, pos, next - gpos, seq);
+        seq += next - gpos;
+        gpos = next;
+    }
+}
+
+/**
+ * Window of a genome of the collection.
+ *
+ * in : delta : collection
+ * in : genome : index of the genome, GENOME_DELTA_REFERENCE for the reference
+ * in : start, length : window, within the genome
+ * out : seq : length bases, null terminated
+ * out : int : 0, -1 on error
+ */
+int genome_delta_window(const genome_delta_t* delta, const uint64_t genome, const uint64_t start,
+                        const uint64_t length, char* seq){
+    if (!delta || !seq)
+        return printf("ERROR: genome_delta_window: undefined collection\n"), -1;
+    if (genome != GENOME_DELTA_REFERENCE && genome >= delta->nb_genomes)
+        return printf("ERROR: genome_delta_window: no genome %llu\n", (unsigned long long)genome), -1;
+    uint64_t size = genome_delta_length(delta, genome);
+    if (start > size || length > size - start)
+        return printf("ERROR: genome_delta_window: window out of the genome\n"), -1;
+
+    if (genome == GENOME_DELTA_REFERENCE)
+        genome_delta_apply(delta, delta->ref_edits, delta->nb_ref_edits, 1, start, length, seq);
+    else
+        genome_delta_apply(delta, delta->edits + delta->edit_offset[genome],
+                           delta->edit_offset[genome + 1] - delta->edit_offset[genome], 0, start, length, seq);
+    seq[length] = '\0';
+    return 0;
+}
+
+/**
+ * Whole genome of the collection.
+ *
+ * in : delta, genome : see genome_delta_window
+ * out : char* : sequence, to free, NULL on error
+ */
+char* genome_delta_genome(const genome_delta_t* delta, const uint64_t genome){
+    if (!delta)
+        return printf("ERROR: genome_delta_genome: undefined collection\n"), NULL;
+    uint64_t length = genome_delta_length(delta, genome);
+    char* seq = malloc(length + 1);
+    if (!seq)
+        return printf("ERROR: genome_delta_genome: cannot allocate memory\n"), NULL;
+    if (genome_delta_window(delta, genome, 0, length, seq))
+        return free(seq), NULL;
+    return seq;
+}
+
+/**
+ * Window of a genome of the collection, in binary array format.
+ *
+ * in : delta, genome, start, length : see genome_delta_window
+ * in : seq_bin : output array of binary_array_size(2 * length) values
+ * out : seq_bin : window as set_binary_array gives it, NULL on error
+ */
+long int* genome_delta_window_binary(const genome_delta_t* delta, const uint64_t genome, const uint64_t start,
+                                     const uint64_t length, long int* seq_bin){
+    if (!seq_bin)
+        return printf("ERROR: genome_delta_window_binary: undefined array\n"), NULL;
+    char* seq = malloc(length + 1);
+    if (!seq)
+        return printf("ERROR: genome_delta_window_binary: cannot allocate memory\n"), NULL;
+    if (genome_delta_window(delta, genome, start, length, seq))
+        return free(seq), NULL;
+    set_binary_array_into(seq, length, seq_bin);
+    free(seq);
+    return seq_bin;
+}
+
+uint64_t genome_delta_length(const genome_delta_t* delta, const uint64_t genome){
+    if (genome == GENOME_DELTA_REFERENCE)
+        return delta->ref_length;
+    return genome < delta->nb_genomes ? delta->length[genome] : 0;
+}
+
+const char* genome_delta_name(const genome_delta_t* delta, const uint64_t genome){
+    return genome < delta->nb_genomes ? delta->names + delta->name_offset[genome] : NULL;
+}
+
+/**
+ * Bytes of the collection in memory, without the reference text and k-mer index built by genome_delta_add.
+ */
+uint64_t genome_delta_size(const genome_delta_t* delta){
+    uint64_t nb_edits = delta->edit_offset ? delta->edit_offset[delta->nb_genomes] : 0;
+    return binary_array_size(2 * delta->ref_length) * sizeof(*delta->ref_bin)
+        + (delta->nb_ref_edits + nb_edits) * sizeof(genome_edit_t)
+        + (3 * delta->nb_genomes + 1) * sizeof(uint64_t) + delta->bases_size + delta->names_size;
+}
+
+
+
+/***************************************/
+/************* COLLECTIONS *************/
+/***************************************/
+
+/**
+ * Start a collection of genomes stored as their differences with a reference.
+ *
+ * in : ref, length : reference sequence
+ * out : delta : collection, to free with genome_delta_free
+ * out : int : 0, -1 on error
+ *
+ * The A, C, G and T of the reference are packed, its N-runs and other letters are kept as edits.
+ */
+int genome_delta_init(genome_delta_t* delta, const char* ref, const uint64_t length){
+    memset(delta, 0, sizeof(*delta));
+    if (!ref)
+        return printf("ERROR: genome_delta_init: undefined reference\n"), -1;
+    if (length >= INT32_MAX / 2)
+        return printf("ERROR: genome_delta_init: reference too long\n"), -1;
+
+    delta->ref_length = length;
+    delta->ref_bin = malloc(binary_array_size(2 * length) * sizeof(*delta->ref_bin));
+    delta->edit_offset = calloc(1, sizeof(*delta->edit_offset));
+    if (!delta->ref_bin || !delta->edit_offset)
+        return genome_delta_free(delta), printf("ERROR: genome_delta_init: cannot allocate memory\n"), -1;
+    set_binary_array_into(ref, length, delta->ref_bin);
+
+    uint64_t capacity = 0;
+    for (uint64_t i = 0; i < length; i++) {
+        if (ref[i] == 'A' || ref[i] == 'C' || ref[i] == 'G' || ref[i] == 'T')
+            continue;
+        if (genome_delta_edit(delta, &delta->ref_edits, &delta->nb_ref_edits, &capacity, 0,
+                              ref[i] == 'N' ? GENOME_EDIT_N_RUN : GENOME_EDIT_SUBSTITUTION, i, i, 1,
+                              ref[i] == 'N' ? NULL : ref + i))
+            return genome_delta_free(delta), -1;
+    }
+    return 0;
+}
+
+// Reference and genome aligned from ref_pos and seq_pos: GENOME_DELTA_ANCHOR equal bases (a N of the genome
+// is equal to any base, the N-runs come after the differences), or their equal ends
+static inline int genome_delta_anchored(const char* ref, const uint64_t ref_length, const uint64_t ref_pos,
+                                        const char* seq, const uint64_t length, const uint64_t seq_pos){
+    if (ref_pos > ref_length || seq_pos > length)
+        return 0;
+    uint64_t n = GENOME_DELTA_ANCHOR;
+    if (ref_length - ref_pos < n || length - seq_pos < n) {
+        if (ref_length - ref_pos != length - seq_pos)
+            return 0;
+        n = length - seq_pos;
+    }
+    for (uint64_t k = 0; k < n; k++)
+        if (ref[ref_pos + k] != seq[seq_pos + k] && seq[seq_pos + k] != 'N')
+            return 0;
+    return 1;
+}
+
+// Bucket of the GENOME_DELTA_ANCHOR bases from seq in the k-mer index, -1 if they are not all A, C, G or T
+static inline long genome_delta_kmer(const genome_delta_t* delta, const char* seq){
+    uint64_t code = 0;
+    for (int k = 0; k < GENOME_DELTA_ANCHOR; k++) {
+        switch (seq[k]) {
+        case 'A': code = code << 2; break;
+        case 'G': code = code << 2 | 1; break;
+        case 'C': code = code << 2 | 2; break;
+        case 'T': code = code << 2 | 3; break;
+        default: return -1;
+        }
+    }
+    return (code * 0x9E3779B97F4A7C15ULL) >> (64 - delta->kmer_bits);
+}
+
+/**
+ * Build the k-mer index of the reference: the positions of the GENOME_DELTA_ANCHOR bases of each bucket,
+ * chained in increasing order from kmer_head through kmer_next (UINT32_MAX ends a chain).
+ */
+static int genome_delta_indexing(genome_delta_t* delta){
+    uint64_t n = delta->ref_length;
+    delta->kmer_bits = 4;
+    while ((1ULL << delta->kmer_bits) < 2 * n)
+        delta->kmer_bits++;
+    delta->kmer_head = malloc((1ULL << delta->kmer_bits) * sizeof(*delta->kmer_head));
+    delta->kmer_next = malloc((n + 1) * sizeof(*delta->kmer_next));
+    if (!delta->kmer_head || !delta->kmer_next)
+        return printf("ERROR: genome_delta_indexing: cannot allocate memory\n"), -1;
+
+    memset(delta->kmer_head, 0xff, (1ULL << delta->kmer_bits) * sizeof(*delta->kmer_head));
+    for (uint64_t i = n >= GENOME_DELTA_ANCHOR ? n - GENOME_DELTA_ANCHOR + 1 : 0; i-- > 0; ) {
+        long bucket = genome_delta_kmer(delta, delta->ref_text + i);
+        delta->kmer_next[i] = UINT32_MAX;
+        if (bucket >= 0) {
+            delta->kmer_next[i] = delta->kmer_head[bucket];
+            delta->kmer_head[bucket] = i;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Shifts aligning a genome again on the reference after a difference.
+ *
+ * in : delta : collection, with the reference text and its k-mer index
+ * in : ref_pos : first different base of the reference
+ * in : seq, length, seq_pos : genome, and its first different base
+ * out : ref_shift, seq_shift : bases of the reference and of the genome up to the next alignment
+ *
+ * Every mix of substitutions and indels up to GENOME_DELTA_MIXED bases is tried, closest first.
+ * Farther alignments, up to GENOME_DELTA_SHIFT bases, are looked up in the k-mer index: the first
+ * base of the genome starting an anchor, at the reference position the closest to the diagonal.
+ * Without any, the rest of the genome is different from the rest of the reference.
+ */
+static void genome_delta_aligning(const genome_delta_t* delta, const uint64_t ref_pos,
+                                  const char* seq, const uint64_t length, const uint64_t seq_pos,
+                                  uint64_t* ref_shift, uint64_t* seq_shift){
+    const char* ref = delta->ref_text;
+    uint64_t ref_length = delta->ref_length;
+    for (uint64_t d = 1; d <= GENOME_DELTA_MIXED; d++) {
+        if (genome_delta_anchored(ref, ref_length, ref_pos + d, seq, length, seq_pos + d)) {
+            *ref_shift = *seq_shift = d;
+            return;
+        }
+        for (uint64_t k = d; k-- > 0; ) {
+            if (genome_delta_anchored(ref, ref_length, ref_pos + d, seq, length, seq_pos + k)) {
+                *ref_shift = d, *seq_shift = k;
+                return;
+            }
+            if (genome_delta_anchored(ref, ref_length, ref_pos + k, seq, length, seq_pos + d)) {
+                *ref_shift = k, *seq_shift = d;
+                return;
+            }
+        }
+    }
+
+    for (uint64_t dj = 0; dj <= GENOME_DELTA_SHIFT && seq_pos + dj + GENOME_DELTA_ANCHOR <= length; dj++) {
+        long bucket = genome_delta_kmer(delta, seq + seq_pos + dj);
+        if (bucket < 0)
+            continue;
+        uint64_t best = UINT64_MAX, best_gap = UINT64_MAX;
+        for (uint32_t p = delta->kmer_head[bucket]; p != UINT32_MAX && p <= ref_pos + GENOME_DELTA_SHIFT;
+             p = delta->kmer_next[p]) {
+            if (p < ref_pos || !genome_delta_anchored(ref, ref_length, p, seq, length, seq_pos + dj))
+                continue;
+            uint64_t gap = p - ref_pos > dj ? p - ref_pos - dj : dj - (p - ref_pos);
+            if (gap < best_gap)
+                best = p, best_gap = gap;
+        }
+        if (best != UINT64_MAX) {
+            *ref_shift = best - ref_pos, *seq_shift = dj;
+            return;
+        }
+    }
+    *ref_shift = ref_length - ref_pos;
+    *seq_shift = length - seq_pos;
+}
+
+/**
+ * Add a genome to a collection.
+ *
+ * in : delta : collection
+ * in : name : name of the genome, NULL for none
+ * in : seq, length : genome sequence
+ * out : long : index of the genome, -1 on error
+ *
+ * The genome is stored as its edits against the reference: runs of substitutions, insertions,
+ * deletions, and N-runs replacing as many bases of the reference.
+ */
+long genome_delta_add(genome_delta_t* delta, const char* name, const char* seq, const uint64_t length){
+    if (!delta || !delta->ref_bin || !seq)
+        return printf("ERROR: genome_delta_add: undefined sequence\n"), -1;
+    if (length >= UINT32_MAX)
+        return printf("ERROR: genome_delta_add: sequence too long\n"), -1;
+    if (!delta->ref_text) {
+        if (!(delta->ref_text = genome_delta_genome(delta, GENOME_DELTA_REFERENCE)) || genome_delta_indexing(delta))
+            return -1;
+    }
+
+    uint64_t g = delta->nb_genomes;
+    if (!name)
+        name = "";
+    size_t name_size = strlen(name) + 1;
+    if (genome_delta_reserve((void**)&delta->names, &delta->capacity_names, delta->names_size + name_size, 1))
+        return printf("ERROR: genome_delta_add: cannot allocate memory\n"), -1;
+    if (g + 2 > delta->capacity_genomes) {
+        uint64_t capacity = delta->capacity_genomes ? 2 * delta->capacity_genomes : 16;
+        uint64_t* offsets = realloc(delta->edit_offset, (capacity + 1) * sizeof(*offsets));
+        if (offsets)
+            delta->edit_offset = offsets;
+        uint64_t* lengths = realloc(delta->length, capacity * sizeof(*lengths));
+        if (lengths)
+            delta->length = lengths;
+        uint64_t* names = realloc(delta->name_offset, capacity * sizeof(*names));
+        if (names)
+            delta->name_offset = names;
+        if (!offsets || !lengths || !names)
+            return printf("ERROR: genome_delta_add: cannot allocate memory\n"), -1;
+        delta->capacity_genomes = capacity;
+    }
+
+    const char* ref = delta->ref_text;
+    uint64_t ref_length = delta->ref_length, first = delta->edit_offset[g], nb_edits = first;
+    uint64_t bases_size = delta->bases_size, i = 0, j = 0;
+    int res = 0;
+    while (!res && i < ref_length && j < length) {
+        if (ref[i] == seq[j]) {
+            i++, j++;
+            continue;
+        }
+
+        if (seq[j] == 'N') {
+            uint64_t n = 1;
+            while (j + n < length && i + n < ref_length && seq[j + n] == 'N')
+                n++;
+            res = genome_edit(delta, &nb_edits, first, GENOME_EDIT_N_RUN, i, j, n, NULL);
+            i += n, j += n;
+            continue;
+        }
+
+        // Substitutions, then the indel
+        uint64_t di, dj;
+        genome_delta_aligning(delta, i, seq, length, j, &di, &dj);
+        uint64_t common = di < dj ? di : dj;
+        res = genome_edit(delta, &nb_edits, first, GENOME_EDIT_SUBSTITUTION, i, j, common, seq + j);
+        if (!res && di > dj)
+            res = genome_edit(delta, &nb_edits, first, GENOME_EDIT_DELETION, i + common, j + common, di - dj, NULL);
+        if (!res && dj > di)
+            res = genome_edit(delta, &nb_edits, first, GENOME_EDIT_INSERTION,
+                              i + common, j + common, dj - di, seq + j + common);
+        i += di, j += dj;
+    }
+    if (!res)
+        res = genome_edit(delta, &nb_edits, first, GENOME_EDIT_DELETION, i, j, ref_length - i, NULL);
+    if (!res)
+        res = genome_edit(delta, &nb_edits, first, GENOME_EDIT_INSERTION, i, j, length - j, seq + j);
+    if (res) {
+        delta->bases_size = bases_size;
+        return -1;
+    }
+
+    memcpy(delta->names + delta->names_size, name, name_size);
+    delta->name_offset[g] = delta->names_size;
+    delta->names_size += name_size;
+    delta->length[g] = length;
+    delta->edit_offset[g + 1] = nb_edits;
+    delta->nb_genomes++;
+    return g;
+}
+
+// Variable length integer: 7 bits per byte, the high bit set on all but the last byte
+static int genome_delta_put(FILE* f, uint64_t value){
+    while (value >= 0x80) {
+        if (putc((int)(value & 0x7f) | 0x80, f) == EOF)
+            return -1;
+        value >>= 7;
+    }
+    return putc((int)value, f) == EOF ? -1 : 0;
+}
+
+static int genome_delta_get(FILE* f, uint64_t* value){
+    *value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int c = getc(f);
+        if (c == EOF)
+            return -1;
+        *value |= (uint64_t)(c & 0x7f) << shift;
+        if (!(c & 0x80))
+            return 0;
+    }
+    return -1;
+}
+
+// Edits of a sequence: the bases of the reference since the previous edit, with the kind in the 2 low bits,
+// then the length
+static int genome_delta_put_edits(FILE* f, const genome_edit_t* edits, const uint64_t nb_edits){
+    uint64_t ref_end = 0;
+    for (uint64_t e = 0; e < nb_edits; e++) {
+        if (genome_delta_put(f, (edits[e].pos - ref_end) << 2 | edits[e].kind) || genome_delta_put(f, edits[e].len))
+            return -1;
+        ref_end = edits[e].pos + genome_edit_rlen(&edits[e]);
+    }
+    return 0;
+}
+
+/**
+ * Read the edits of a sequence written by genome_delta_put_edits.
+ *
+ * in : f : file read
+ * in : nb, length : number of edits, and bases of the sequence
+ * in : data : first base of the edits in the bases of the collection, updated
+ * out : edits, nb_edits, capacity : edits of the reference or of the genomes, the new ones appended
+ * out : int : 0, -1 on error or if the edits do not fit the reference and the sequence
+ */
+static int genome_delta_get_edits(FILE* f, const genome_delta_t* delta, const uint64_t nb, const uint64_t length,
+                                  uint64_t* data, genome_edit_t** edits, uint64_t* nb_edits, uint64_t* capacity){
+    if (genome_delta_reserve((void**)edits, capacity, *nb_edits + nb, sizeof(**edits)))
+        return -1;
+    uint64_t ref_end = 0, seq_end = 0;
+    for (uint64_t e = 0; e < nb; e++) {
+        uint64_t gap, len;
+        if (genome_delta_get(f, &gap) || genome_delta_get(f, &len) || !len || len > GENOME_DELTA_MAX_EDIT)
+            return -1;
+        genome_edit_t edit = { ref_end + (gap >> 2), seq_end + (gap >> 2), 0, len, gap & 3 };
+        if (edit.kind == GENOME_EDIT_SUBSTITUTION || edit.kind == GENOME_EDIT_INSERTION) {
+            edit.data = *data;
+            *data += len;
+        }
+        ref_end = (gap >> 2) + ref_end + genome_edit_rlen(&edit);
+        seq_end = (gap >> 2) + seq_end + genome_edit_glen(&edit);
+        if (ref_end > delta->ref_length || seq_end > length || *data > delta->bases_size)
+            return -1;
+        (*edits)[(*nb_edits)++] = edit;
+    }
+    return delta->ref_length - ref_end == length - seq_end ? 0 : -1;
+}
+
+/**
+ * Save a collection to a file.
+ *
+ * in : delta : collection
+ * in : path : file written
+ * out : int : 0, -1 on error
+ *
+ * The edits are written as variable length integers, the genome positions and the offsets of
+ * their bases are found again from the lengths of the edits.
+ */
+int genome_delta_save(const genome_delta_t* delta, const char* path){
+    FILE* f = fopen(path, "wb");
+    if (!f)
+        return printf("ERROR: genome_delta_save: cannot open file %s\n", path), -1;
+
+    uint64_t header[5] = { delta->ref_length, delta->nb_ref_edits, delta->nb_genomes, delta->bases_size,
+                           delta->names_size };
+    int res = DELTA_WRITE(GENOME_DELTA_MAGIC, sizeof(GENOME_DELTA_MAGIC), f) || DELTA_WRITE(header, 5, f)
+        || DELTA_WRITE(delta->ref_bin, binary_array_size(2 * delta->ref_length), f)
+        || genome_delta_put_edits(f, delta->ref_edits, delta->nb_ref_edits);
+    for (uint64_t g = 0; !res && g < delta->nb_genomes; g++) {
+        uint64_t nb_edits = delta->edit_offset[g + 1] - delta->edit_offset[g];
+        res = genome_delta_put(f, delta->length[g]) || genome_delta_put(f, nb_edits)
+            || genome_delta_put_edits(f, delta->edits + delta->edit_offset[g], nb_edits);
+    }
+    res = res || DELTA_WRITE(delta->bases, delta->bases_size, f) || DELTA_WRITE(delta->names, delta->names_size, f);
+    res |= fclose(f) != 0;
+    if (res)
+        return printf("ERROR: genome_delta_save: cannot write file %s\n", path), -1;
+    return 0;
+}
+
+/**
+ * Load a collection saved by genome_delta_save.
+ *
+ * in : path : file read
+ * out : delta : collection, to free with genome_delta_free
+ * out : int : 0, -1 on error
+ */
+int genome_delta_load(genome_delta_t* delta, const char* path){
+    memset(delta, 0, sizeof(*delta));
+    FILE* f = fopen(path, "rb");
+    if (!f)
+        return printf("ERROR: genome_delta_load: cannot open file %s\n", path), -1;
+
+    char magic[sizeof(GENOME_DELTA_MAGIC)];
+    uint64_t header[5];
+    if (DELTA_READ(magic, sizeof(magic), f) || memcmp(magic, GENOME_DELTA_MAGIC, sizeof(magic))
+        || DELTA_READ(header, 5, f) || header[0] >= INT32_MAX / 2 || header[3] > UINT32_MAX) {
+        fclose(f);
+        return printf("ERROR: genome_delta_load: %s is not a genome collection\n", path), -1;
+    }
+
+    uint64_t nb = header[2];
+    delta->ref_length = header[0];
+    delta->nb_genomes = nb;
+    delta->capacity_genomes = nb;
+    delta->bases_size = delta->capacity_bases = header[3];
+    delta->names_size = delta->capacity_names = header[4];
+    long words = binary_array_size(2 * delta->ref_length);
+    delta->ref_bin = malloc(words * sizeof(*delta->ref_bin));
+    delta->edit_offset = malloc((nb + 1) * sizeof(*delta->edit_offset));
+    delta->length = malloc((nb + 1) * sizeof(*delta->length));
+    delta->name_offset = malloc((nb + 1) * sizeof(*delta->name_offset));
+    delta->bases = malloc(delta->bases_size + 1);
+    delta->names = malloc(delta->names_size + 1);
+    if (!delta->ref_bin || !delta->edit_offset || !delta->length || !delta->name_offset
+        || !delta->bases || !delta->names) {
+        fclose(f);
+        genome_delta_free(delta);
+        return printf("ERROR: genome_delta_load: cannot allocate memory\n"), -1;
+    }
+
+    uint64_t data = 0, ref_capacity = 0;
+    int res = DELTA_READ(delta->ref_bin, words, f)
+        || genome_delta_get_edits(f, delta, header[1], delta->ref_length, &data,
+                                  &delta->ref_edits, &delta->nb_ref_edits, &ref_capacity);
+    delta->edit_offset[0] = 0;
+    for (uint64_t g = 0; !res && g < nb; g++) {
+        uint64_t nb_edits = 0, total = delta->edit_offset[g];
+        res = genome_delta_get(f, &delta->length[g]) || delta->length[g] >= UINT32_MAX
+            || genome_delta_get(f, &nb_edits)
+            || genome_delta_get_edits(f, delta, nb_edits, delta->length[g], &data,
+                                      &delta->edits, &total, &delta->capacity_edits);
+        delta->edit_offset[g + 1] = total;
+    }
+    res = res || data != delta->bases_size || DELTA_READ(delta->bases, delta->bases_size, f)
+        || DELTA_READ(delta->names, delta->names_size, f);
+
+    // Names
+    uint64_t offset = 0;
+    for (uint64_t g = 0; !res && g < nb; g++) {
+        delta->name_offset[g] = offset;
+        while (offset < delta->names_size && delta->names[offset])
+            offset++;
+        res = offset++ >= delta->names_size;
+    }
+    fclose(f);
+    if (res) {
+        genome_delta_free(delta);
+        return printf("ERROR: genome_delta_load: cannot read file %s\n", path), -1;
+    }
+    return 0;
+}
+
+void genome_delta_free(genome_delta_t* delta){
+    free(delta->ref_bin);
+    free(delta->ref_edits);
+    free(delta->edit_offset);
+    free(delta->length);
+    free(delta->edits);
+    free(delta->name_offset);
+    free(delta->names);
+    free(delta->bases);
+    free(delta->ref_text);
+    free(delta->kmer_head);
+    free(delta->kmer_next);
+    memset(delta, 0, sizeof(*delta));
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "gene_bin.h"
+
+// Header of the collection files, to change when their format changes
+#define GENOME_DELTA_MAGIC "DNADLT1"
+// Genome index of the reference itself, for genome_delta_window
+#define GENOME_DELTA_REFERENCE UINT64_MAX
+// Equal bases needed to align a genome again on the reference after a difference
+#define GENOME_DELTA_ANCHOR 12
+// Longest edit, longer ones are split
+#define GENOME_DELTA_MAX_EDIT ((1U << 30) - 1)
+// Greatest shifts tried to align again: any mix of substitutions and indels up to GENOME_DELTA_MIXED bases,
+// then the anchors of the k-mer index of the reference up to GENOME_DELTA_SHIFT bases
+#define GENOME_DELTA_MIXED 32
+#define GENOME_DELTA_SHIFT 8192
+
+typedef enum genome_edit_kind_e {
+    GENOME_EDIT_SUBSTITUTION,
+    GENOME_EDIT_INSERTION,
+    GENOME_EDIT_DELETION,
+    GENOME_EDIT_N_RUN
+}genome_edit_kind_t;
+
+typedef struct genome_edit_s {
+
+    //First position of the edit in the reference, and in the genome
+    uint32_t pos;
+    uint32_t gpos;
+
+    //Substituted or inserted bases, at bases + data
+    uint32_t data;
+
+    //Number of bases substituted, inserted, deleted or replaced by N, and genome_edit_kind_t
+    uint32_t len : 30;
+    uint32_t kind : 2;
+
+}genome_edit_t;
+
+typedef struct genome_delta_s {
+
+    //Reference: A, C, G and T in binary array format, its other letters as substitutions and N-runs
+    long int* ref_bin;
+    uint64_t ref_length;
+    uint64_t nb_ref_edits;
+    genome_edit_t* ref_edits;
+
+    //Genomes: the edits of genome g are edits[edit_offset[g]] to edits[edit_offset[g + 1] - 1], sorted by position
+    uint64_t nb_genomes;
+    uint64_t* edit_offset;
+    uint64_t* length;
+    genome_edit_t* edits;
+
+    //Name of genome g: null terminated, at names + name_offset[g]
+    uint64_t* name_offset;
+    char* names;
+    uint64_t names_size;
+
+    //Substituted and inserted bases of all the edits
+    char* bases;
+    uint64_t bases_size;
+
+    //Allocated genomes, edits, name and base bytes
+    uint64_t capacity_genomes;
+    uint64_t capacity_edits;
+    uint64_t capacity_names;
+    uint64_t capacity_bases;
+
+    //Reference as text and its k-mer index (2^kmer_bits buckets), built by genome_delta_add
+    char* ref_text;
+    uint32_t* kmer_head;
+    uint32_t* kmer_next;
+    int kmer_bits;
+
+}genome_delta_t;
+
+
+/******** GENOME DELTA FUNCTION *********/
+
+int genome_delta_init(genome_delta_t* delta, const char* ref, const uint64_t length);
+long genome_delta_add(genome_delta_t* delta, const char* name, const char* seq, const uint64_t length);
+uint64_t genome_delta_length(const genome_delta_t* delta, const uint64_t genome);
+const char* genome_delta_name(const genome_delta_t* delta, const uint64_t genome);
+int genome_delta_window(const genome_delta_t* delta, const uint64_t genome, const uint64_t start,
+                        const uint64_t length, char* seq);
+char* genome_delta_genome(const genome_delta_t* delta, const uint64_t genome);
+long int* genome_delta_window_binary(const genome_delta_t* delta, const uint64_t genome, const uint64_t start,
+                                     const uint64_t length, long int* seq_bin);
+uint64_t genome_delta_size(const genome_delta_t* delta);
+int genome_delta_save(const genome_delta_t* delta, const char* path);
+int genome_delta_load(genome_delta_t* delta, const char* path);
+void genome_delta_free(genome_delta_t* delta);
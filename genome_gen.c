@@ -0,0 +1,414 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gene_bin.h"
+#include "genome_gen.h"
+
+
+/***************************************/
+/********** RANDOM GENERATOR ***********/
+/***************************************/
+
+/**
+ * Derive a random stream state from a seed (splitmix64).
+ *
+ * in : seed : any 64 bits value
+ * out : unsigned long long : non-zero state for genome_gen_random
+ */
+static unsigned long long genome_gen_seed(unsigned long long seed){
+    unsigned long long z = seed + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31;
+    return z ? z : 0x9E3779B97F4A7C15ULL;
+}
+
+/**
+ * Next value of a random stream (xorshift64*).
+ *
+ * in : state : random stream state, updated
+ * out : unsigned long long : 64 random bits
+ */
+static unsigned long long genome_gen_random(unsigned long long *state){
+    unsigned long long x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+/**
+ * Uniform double in [0, 1) from a random stream.
+ */
+static double genome_gen_uniform(unsigned long long *state){
+    return (genome_gen_random(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+
+
+/***************************************/
+/********** GENOME GENERATOR ***********/
+/***************************************/
+
+/**
+ * Fill the generator parameters with their default values.
+ *
+ * in : params : parameters to fill
+ * out : void
+ *
+ * 30 kb genome (SARS-CoV-2 size), 38% GC, no ambiguity code, no planted ORF, a single genome.
+ */
+void genome_gen_default_params(genome_gen_params_t* params){
+    params->seed = 42;
+    params->length = 30000;
+    params->gc_content = 0.38;
+    params->n_rate = 0.0;
+    params->iupac_rate = 0.0;
+    params->orf_count = 0;
+    params->orf_codons = 300;
+    params->copies = 1;
+    params->mutation_rate = 0.001;
+}
+
+/**
+ * Initialize a generator for one genome of the family.
+ *
+ * in : gen : generator to initialize
+ * in : params : generation parameters
+ * in : copy : index of the genome in the family (0 = ancestor, 0 <= copy < params->copies)
+ * out : int : 0 on success, -1 if the parameters are inconsistent
+ *
+ * The planted ORFs are evenly spaced: ORF i is centered in the i-th block of length / orf_count nucleotides.
+ */
+int genome_gen_init(genome_gen_t* gen, const genome_gen_params_t* params, const unsigned long copy){
+    // Check the input arguments
+    if (!gen || !params)
+        return printf("ERROR: genome_gen_init: undefined parameters\n"), -1;
+    if (params->gc_content < 0.0 || params->gc_content > 1.0
+        || params->n_rate < 0.0 || params->iupac_rate < 0.0 || params->n_rate + params->iupac_rate > 1.0
+        || params->mutation_rate < 0.0 || params->mutation_rate > 1.0)
+        return printf("ERROR: genome_gen_init: rates must be between 0 and 1\n"), -1;
+
+    gen->params = *params;
+    gen->copy = copy;
+    gen->pos = 0;
+    gen->prev1 = gen->prev2 = 'A';
+
+    // The ancestor stream is shared by every copy, each copy has its own stream
+    gen->rng_ancestor = genome_gen_seed(params->seed);
+    gen->rng_copy = genome_gen_seed(params->seed ^ (0xD1B54A32D192ED03ULL * (copy + 1)));
+
+    gen->orf_spacing = 0;
+    gen->orf_offset = 0;
+    if (params->orf_count) {
+        unsigned long long orf_size = 3 * params->orf_codons;
+        gen->orf_spacing = params->length / params->orf_count;
+
+        // Each ORF needs its start and stop codons, and two nucleotides of padding before it
+        if (params->orf_codons < 2 || gen->orf_spacing < orf_size + 2)
+            return printf("ERROR: genome_gen_init: %lu ORFs of %lu codons do not fit in %llu nucleotides\n",
+                          params->orf_count, params->orf_codons, params->length), -1;
+
+        gen->orf_offset = (gen->orf_spacing - orf_size) / 2;
+        if (gen->orf_offset < 2)
+            gen->orf_offset = 2;
+    }
+    return 0;
+}
+
+/**
+ * Check if a three nucleotides window would be seen by detecting_genes (AUG or a stop codon).
+ */
+static int genome_gen_is_signal(const char n1, const char n2, const char n3){
+    return (n1 == 'A' && n2 == 'T' && n3 == 'G')
+        || (n1 == 'T' && n2 == 'A' && (n3 == 'A' || n3 == 'G'))
+        || (n1 == 'T' && n2 == 'G' && n3 == 'A');
+}
+
+/**
+ * Draw a background nucleotide according to the GC content.
+ */
+static char genome_gen_background(genome_gen_t* gen){
+    unsigned long long r = genome_gen_random(&gen->rng_ancestor);
+    double u = (r >> 11) * (1.0 / 9007199254740992.0);
+    if (u < gen->params.gc_content)
+        return r & 1 ? 'G' : 'C';
+    return r & 1 ? 'T' : 'A';
+}
+
+/**
+ * Generate the next nucleotide of the ancestor.
+ *
+ * in : gen : generator
+ * out : char : nucleotide (A, C, G or T)
+ *
+ * Inside a planted ORF, the nucleotides are drawn again until no AUG or stop codon appears in any frame,
+ * so that detecting_genes reports exactly the planted ORF.
+ * The two nucleotides before a planted ORF are set to 'CC' so that the scan cannot skip its start codon.
+ */
+static char genome_gen_ancestor(genome_gen_t* gen){
+    unsigned long long pos = gen->pos;
+
+    if (gen->orf_spacing) {
+        unsigned long long block = pos / gen->orf_spacing;
+        unsigned long long rel = pos - block * gen->orf_spacing;
+        unsigned long long orf_size = 3 * gen->params.orf_codons;
+
+        if (block < gen->params.orf_count) {
+            if (rel + 2 == gen->orf_offset || rel + 1 == gen->orf_offset)
+                return 'C';
+
+            if (rel >= gen->orf_offset && rel < gen->orf_offset + orf_size) {
+                unsigned long long k = rel - gen->orf_offset;
+
+                // Start codon, the stop codon of this ORF is chosen now
+                if (k < 3) {
+                    if (k == 0) {
+                        static const char* stops[3] = { "TAA", "TAG", "TGA" };
+                        memcpy(gen->stop_codon, stops[genome_gen_random(&gen->rng_ancestor) % 3], 3);
+                    }
+                    return "ATG"[k];
+                }
+                // Stop codon
+                if (k >= orf_size - 3)
+                    return gen->stop_codon[k - (orf_size - 3)];
+
+                // Coding nucleotide
+                char n = 'A';
+                for (int tries = 0; ; tries++) {
+                    n = tries < 16 ? genome_gen_background(gen) : "ACGT"[genome_gen_random(&gen->rng_ancestor) & 3];
+                    if (genome_gen_is_signal(gen->prev2, gen->prev1, n))
+                        continue;
+                    // The last coding nucleotide must not form a signal with the stop codon
+                    if (k == orf_size - 4 && genome_gen_is_signal(n, gen->stop_codon[0], gen->stop_codon[1]))
+                        continue;
+                    break;
+                }
+                return n;
+            }
+        }
+    }
+
+    return genome_gen_background(gen);
+}
+
+/**
+ * Apply the copy mutations and the ambiguity codes to an ancestor nucleotide.
+ */
+static char genome_gen_copy(genome_gen_t* gen, char n){
+    static const char* bases = "ACGT";
+    static const char* iupac = "RYKMSWBDHV";
+
+    if (gen->copy && genome_gen_uniform(&gen->rng_copy) < gen->params.mutation_rate) {
+        const char* b = strchr(bases, n);
+        n = bases[(b - bases + 1 + genome_gen_random(&gen->rng_copy) % 3) % 4];
+    }
+
+    if (gen->params.n_rate > 0.0 || gen->params.iupac_rate > 0.0) {
+        double u = genome_gen_uniform(&gen->rng_copy);
+        if (u < gen->params.n_rate)
+            n = 'N';
+        else if (u < gen->params.n_rate + gen->params.iupac_rate)
+            n = iupac[genome_gen_random(&gen->rng_copy) % 10];
+    }
+    return n;
+}
+
+/**
+ * Generate the next nucleotides of a genome.
+ *
+ * in : gen : generator initialized by genome_gen_init
+ * in : buffer : output char array, not null terminated
+ * in : size : maximum number of nucleotides to generate
+ * out : unsigned long long : number of generated nucleotides (0 at the end of the genome)
+ *
+ * The genome is generated chunk by chunk, so that genomes larger than the memory can be written.
+ */
+unsigned long long genome_gen_fill(genome_gen_t* gen, char* buffer, const unsigned long long size){
+    unsigned long long n = gen->params.length - gen->pos;
+    if (n > size)
+        n = size;
+
+    for (unsigned long long i = 0; i < n; i++) {
+        char a = genome_gen_ancestor(gen);
+        gen->prev2 = gen->prev1;
+        gen->prev1 = a;
+        buffer[i] = genome_gen_copy(gen, a);
+        gen->pos++;
+    }
+    return n;
+}
+
+/**
+ * Generate a whole genome in char array format.
+ *
+ * in : params : generation parameters
+ * in : copy : index of the genome in the family (0 = ancestor)
+ * out : seq_char : null terminated DNA sequence (params->length nucleotides)
+ */
+char* generating_genome(const genome_gen_params_t* params, const unsigned long copy){
+    genome_gen_t gen;
+    if (genome_gen_init(&gen, params, copy))
+        return NULL;
+
+    // Allocate memory and verify it has been allocated
+    char* seq_char = malloc(params->length + 1);
+    if (!seq_char)
+        return printf("ERROR: generating_genome: cannot allocate memory\n"), NULL;
+
+    genome_gen_fill(&gen, seq_char, params->length);
+    seq_char[params->length] = '\0';
+    return seq_char;
+}
+
+/**
+ * Generate a whole genome in binary array format.
+ *
+ * in : params : generation parameters, params->length less than GENOME_GEN_MAX_BINARY_BASES
+ * in : copy : index of the genome in the family (0 = ancestor)
+ * out : seq_bin : sequence in binary array format (2 * params->length used bits), NULL on error
+ *
+ * The whole genome is in memory, and the binary library is limited to about 1.07 Gb: genomes of
+ * several GB in binary array format are written by writing_genomes with GENOME_GEN_PACKED, which
+ * streams the values.
+ */
+long int* generating_binary_genome(const genome_gen_params_t* params, const unsigned long copy){
+    if (params && params->length >= GENOME_GEN_MAX_BINARY_BASES)
+        return printf("ERROR: generating_binary_genome: genome too long, write it with writing_genomes\n"), NULL;
+
+    char* seq_char = generating_genome(params, copy);
+    if (!seq_char)
+        return NULL;
+
+    long int* seq_bin = set_binary_array(seq_char, params->length);
+    free(seq_char);
+    return seq_bin;
+}
+
+
+
+/***************************************/
+/************ GENOME WRITERS ***********/
+/***************************************/
+
+typedef struct genome_pack_s {
+    //Binary array value being filled, and its index
+    long int value;
+    unsigned long long index;
+    //Number of values already written
+    unsigned long long written;
+    //Next bit position
+    unsigned long long pos;
+}genome_pack_t;
+
+/**
+ * Set one bit of the packed stream, writing the binary array values as soon as they are complete.
+ *
+ * The value / bit placement is the one of get_binary_value and change_binary_value.
+ */
+static void genome_gen_pack_bit(genome_pack_t* pack, const int bit, FILE* out){
+    unsigned long long pos = pack->pos++;
+    unsigned long long index = pos > int_SIZE ? pos / int_SIZE : 0;
+
+    if (index != pack->index) {
+        fwrite(&pack->value, sizeof(pack->value), 1, out);
+        pack->written++;
+        pack->value = 0;
+        pack->index = index;
+    }
+    if (bit)
+        pack->value |= (long)1 << ((pos - index) & int_SIZE);
+}
+
+/**
+ * Append nucleotides to the packed stream, with the same encoding as set_binary_array.
+ */
+static void genome_gen_pack(genome_pack_t* pack, const char* seq_char, const unsigned long long size, FILE* out){
+    for (unsigned long long i = 0; i < size; i++) {
+        switch (seq_char[i]) {
+        case 'T': // T = 11
+            genome_gen_pack_bit(pack, 1, out);
+            genome_gen_pack_bit(pack, 1, out);
+            break;
+        case 'G': // G = 01
+        case 'K': // K = G
+        case 'H': // H = G
+            genome_gen_pack_bit(pack, 0, out);
+            genome_gen_pack_bit(pack, 1, out);
+            break;
+        case 'C': // C = 10
+        case 'Y': // Y = C
+        case 'S': // S = C
+        case 'B': // B = C
+            genome_gen_pack_bit(pack, 1, out);
+            genome_gen_pack_bit(pack, 0, out);
+            break;
+        default: // A, N, R, M, W, D, V = 00
+            genome_gen_pack_bit(pack, 0, out);
+            genome_gen_pack_bit(pack, 0, out);
+            break;
+        }
+    }
+}
+
+/**
+ * Write the whole genome family to a file.
+ *
+ * in : out : output file
+ * in : params : generation parameters
+ * in : format : GENOME_GEN_FASTA or GENOME_GEN_PACKED
+ * out : int : 0 on success, -1 on error
+ *
+ * FASTA : one record per genome, named SYN<seed>.<copy>, GENOME_GEN_LINE_WIDTH nucleotides per line.
+ * PACKED : for each genome, its number of nucleotides (unsigned long long) followed by the long int values
+ *          of its binary array format, exactly as returned by set_binary_array.
+ */
+int writing_genomes(FILE* out, const genome_gen_params_t* params, const genome_gen_format_t format){
+    // Generate per chunk of full lines
+    const unsigned long long chunk_size = GENOME_GEN_LINE_WIDTH * 4096;
+    char* chunk = malloc(chunk_size);
+    if (!chunk)
+        return printf("ERROR: writing_genomes: cannot allocate memory\n"), -1;
+
+    for (unsigned long copy = 0; copy < params->copies; copy++) {
+        genome_gen_t gen;
+        if (genome_gen_init(&gen, params, copy))
+            return free(chunk), -1;
+
+        if (format == GENOME_GEN_FASTA) {
+            fprintf(out, ">SYN%llu.%lu |Synthetic genome, seed %llu, copy %lu, %llu nt, GC %.2f\n",
+                    params->seed, copy, params->seed, copy, params->length, params->gc_content);
+
+            unsigned long long n;
+            while ((n = genome_gen_fill(&gen, chunk, chunk_size)) > 0)
+                for (unsigned long long i = 0; i < n; i += GENOME_GEN_LINE_WIDTH) {
+                    unsigned long long line = n - i < GENOME_GEN_LINE_WIDTH ? n - i : GENOME_GEN_LINE_WIDTH;
+                    fwrite(chunk + i, 1, line, out);
+                    fputc('\n', out);
+                }
+        }
+        else {
+            fwrite(&params->length, sizeof(params->length), 1, out);
+
+            genome_pack_t pack = { 0, 0, 0, 0 };
+            unsigned long long n;
+            while ((n = genome_gen_fill(&gen, chunk, chunk_size)) > 0)
+                genome_gen_pack(&pack, chunk, n, out);
+
+            // Same number of values as set_binary_array
+            unsigned long long nb = (2 * params->length) / int_SIZE + ((2 * params->length) % int_SIZE != 0);
+            for (; pack.written < nb; pack.written++) {
+                fwrite(&pack.value, sizeof(pack.value), 1, out);
+                pack.value = 0;
+            }
+        }
+
+        if (ferror(out))
+            return printf("ERROR: writing_genomes: cannot write the output\n"), free(chunk), -1;
+    }
+
+    free(chunk);
+    return 0;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <stdio.h>
+#include <limits.h>
+
+// Number of nucleotides per line in the generated FASTA files (same as the NCBI fastas)
+#define GENOME_GEN_LINE_WIDTH 60
+
+// Longest genome of generating_binary_genome, below 1.07 Gb: the binary library sets the bits at int positions
+// (2 per base). Longer packed genomes are written by writing_genomes (GENOME_GEN_PACKED)
+#define GENOME_GEN_MAX_BINARY_BASES (INT_MAX / 2)
+
+typedef enum genome_gen_format_e {
+    GENOME_GEN_FASTA,
+    GENOME_GEN_PACKED
+}genome_gen_format_t;
+
+typedef struct genome_gen_params_s {
+
+    //Seed of the generator, the same parameters always give the same genomes
+    unsigned long long seed;
+
+    //Number of nucleotides of each genome
+    unsigned long long length;
+
+    //Probability of a G or C nucleotide in the background sequence (0.0 to 1.0)
+    double gc_content;
+
+    //Probability of a N nucleotide
+    double n_rate;
+
+    //Probability of another IUPAC ambiguity code (R, Y, K, M, S, W, B, D, H, V)
+    double iupac_rate;
+
+    //Number of planted open reading frames (AUG ... UAA / UAG / UGA)
+    unsigned long orf_count;
+
+    //Number of codons of each planted ORF, start and stop codons included
+    unsigned long orf_codons;
+
+    //Number of genomes in the family, the first one is the ancestor
+    unsigned long copies;
+
+    //Substitution probability of each nucleotide of the mutated copies
+    double mutation_rate;
+
+}genome_gen_params_t;
+
+typedef struct genome_gen_s {
+
+    genome_gen_params_t params;
+
+    //Index of the generated genome in the family (0 = ancestor)
+    unsigned long copy;
+
+    //Position of the next nucleotide
+    unsigned long long pos;
+
+    //Random streams of the ancestor and of the copy
+    unsigned long long rng_ancestor;
+    unsigned long long rng_copy;
+
+    //Distance between two planted ORFs, and first nucleotide of the first one
+    unsigned long long orf_spacing;
+    unsigned long long orf_offset;
+
+    //Stop codon of the current planted ORF
+    char stop_codon[3];
+
+    //Two last nucleotides of the ancestor
+    char prev1;
+    char prev2;
+
+}genome_gen_t;
+
+
+/******** GENOME GENERATOR FUNCTION *********/
+
+void genome_gen_default_params(genome_gen_params_t* params);
+int genome_gen_init(genome_gen_t* gen, const genome_gen_params_t* params, const unsigned long copy);
+unsigned long long genome_gen_fill(genome_gen_t* gen, char* buffer, const unsigned long long size);
+char* generating_genome(const genome_gen_params_t* params, const unsigned long copy);
+long int* generating_binary_genome(const genome_gen_params_t* params, const unsigned long copy);
+int writing_genomes(FILE* out, const genome_gen_params_t* params, const genome_gen_format_t format);
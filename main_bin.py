@@ -11,6 +11,7 @@ def main():
   sequence = list()
   i = 0
   gene = list()
+  pairs = list()
 
 
   try:
@@ -84,16 +85,19 @@ def main():
 
       read = m.read_file(file)
 
-      sequence.append(DNA_bin.convert_to_binary(read,len(read)))
+      sequence.append(DNA_bin.convert_to_binary_array(read,len(read)))
 
-      gene.append(DNA_bin.detecting_genes(array.array('l',sequence[i])))
+      # Genes with their mRNA, amino acid chain and mutation zones, in one pass
+      gene.append(DNA_bin.analysing_genes(sequence[i]))
+      # (start, length) pairs of the genes, for the batched scores
+      pairs.append(array.array('q',[v for g in gene[i] for v in (g[0], g[1]-g[0]+1)]))
 
       fh.write("<details><summary>"+str(file.replace("fastas/","").replace(".fasta",""))+"</summary>"+message+"<a href=\"sequences/"+str(file).replace("fastas/","")+"_bin.html\">"+str(file.replace("fastas/","").replace(".fasta",""))+"</a></details>")
 
       for j in range(len(gene[i])-1):
 
 
-          res = (DNA_bin.generating_mRNA(array.array('l',sequence[i]),gene[i][j][0],gene[i][j][1]-gene[i][j][0]))
+          res = gene[i][j][2]
           if res:
               message += "<tr><td>"+res.decode("cp1252", "replace").replace("U","T")+"</td>\n"
               message+="<td>"+str(res.decode("cp1252", "replace"))+ "</td>\n"
@@ -102,13 +106,13 @@ def main():
               message+="<td> none </td>\n"
             
 
-          res2 =  DNA_bin.generating_amino_acid_chain(array.array('l',sequence[i]),gene[i][j][0],(gene[i][j][1]-gene[i][j][0])+1)
+          res2 = gene[i][j][3]
 
           if res2:
               message+="<td>"+str(res2.decode("cp1252", "replace"))+ "</td>\n"
           else:
               message+="<td> none </td>\n"            
-          mutres = DNA_bin.detecting_mutations(array.array('l',sequence[i]),gene[i][j][0],gene[i][j][1]-gene[i][j][0])
+          mutres = gene[i][j][4]
           if len(mutres) == 0:
             message+="<td>none</td>\n</tr>\n"
           else:
@@ -119,10 +123,12 @@ def main():
       message += "<table>\n<tr>\n<th class = \"title\">Sequence</th>\n<th class = \"title\">Matching</th>\n</tr>\n<tbody>\n"
 
       if (len(gene[i])-1 > 2):
-          for j in range((int((len(gene[i]))/2)), -1, -1):
-              for k in range((int((len(gene[i]))/2))):     
+          half = int((len(gene[i]))/2)
+          scores = DNA_bin.calculating_matching_score_batch(sequence[i],pairs[i][:2*(half+1)],sequence[i],pairs[i][:2*half])
+          for j in range(half, -1, -1):
+              for k in range(half):     
 
-                  res = DNA_bin.calculating_matching_score(array.array('l',sequence[i]),gene[i][j][0],(gene[i][j][1]- gene[i][j][0])+1,array.array('l',sequence[i]),gene[i][k][0],(gene[i][k][1]- gene[i][k][0])+1)
+                  res = scores[j,k]
 
                   message+="<tr><td>Sequence ["+str(gene[i][j][0])+":"+str(gene[i][j][1])+"] - ["+str(gene[i][k][0])+":"+str(gene[i][k][1])+"]</td>\n"
                   message+="<td>"+str(res)+ "</td> \n</tr>\n"
@@ -135,9 +141,10 @@ def main():
           messagematch+="<details><summary>Sequence "+str(i)+" - "+str(c)+"</summary><a href=\"sequences/cmp"+str(i)+"-"+str(c)+"_bin.html\">Comparaison "+str(i)+"-"+str(c)+"</a></details>\n"
 
           msgtmp = "<table>\n<tr>\n<th class = \"title\">Sequence</th>\n<th class = \"title\">Matching</th>\n</tr>\n<tbody>"
+          scores = DNA_bin.calculating_matching_score_batch(sequence[i],pairs[i],sequence[c],pairs[c])
           for j in range(int((len(gene[i])))):
             for k in range(len(gene[c])):
-                  res = DNA_bin.calculating_matching_score(array.array('l',sequence[i]),gene[i][j][0],(gene[i][j][1]- gene[i][j][0])+1,array.array('l',sequence[c]),gene[c][k][0],(gene[c][k][1]- gene[c][k][0])+1)       
+                  res = scores[j,k]
                   msgtmp+="<tr><td>Sequence ["+str(gene[i][j][0])+":"+str(gene[i][j][1])+"] - ["+str(gene[c][k][0])+":"+str(gene[c][k][1])+"]</td>\n"
                   msgtmp+="<td>"+str(res)+ "</td> \n</tr>\n"
           fhtmp2.write(msgtmp)
@@ -0,0 +1,310 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+#include "perf_counters.h"
+
+
+/***************************************/
+/******* PERF_EVENT_OPEN GROUPS ********/
+/***************************************/
+
+// -1 : not read yet, 0 : disabled, 1 : enabled
+static int perf_enabled = -1;
+
+// Totals of every call site, updated atomically by all threads
+static perf_counters_t perf_totals[PERF_SITES];
+
+// Events that could be opened (the same for every thread)
+static int perf_available[PERF_EVENTS];
+
+// Event group of the current thread: -2 : not opened yet, -1 : unavailable
+static __thread int perf_group_fd = -2;
+
+// Position of each event in the group read, -1 if unavailable
+static __thread int perf_group_index[PERF_EVENTS];
+
+// File descriptors of the group of each thread, closed when the thread exits (perf_close_group)
+#ifdef __linux__
+static pthread_key_t perf_group_key;
+static pthread_once_t perf_group_once = PTHREAD_ONCE_INIT;
+#endif
+
+static const char* perf_site_names[PERF_SITES] = {
+    "set_binary_array",
+    "xor_binary_array",
+    "popcount_binary_array",
+    "get_piece_binary_array",
+    "convert_to_binary",
+    "binary_to_dna",
+    "generating_mRNA",
+    "detecting_genes",
+    "generating_amino_acid_chain",
+    "detecting_mutations",
+    "calculating_matching_score",
+    "analysing_genes",
+};
+
+static const char* perf_event_names[PERF_EVENTS] = {
+    "cycles",
+    "instructions",
+    "l1d_misses",
+    "llc_misses",
+    "branch_misses",
+};
+
+#ifdef __linux__
+/**
+ * Open one hardware event of the current thread.
+ *
+ * in : type, config : perf_event_attr event
+ * in : group_fd : group leader, -1 to open the leader
+ * out : int : event file descriptor, -1 if the event is not available
+ */
+static int perf_open_event(const unsigned type, const unsigned long long config, const int group_fd){
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.read_format = PERF_FORMAT_GROUP;
+    // User space only, so that it works with perf_event_paranoid = 2
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0);
+}
+
+/**
+ * Close the event group of a thread that exits (destructor of perf_group_key).
+ *
+ * in : fds : file descriptors of the group, -1 for the events not opened
+ *
+ * The thread pools are created and destroyed at each call of the Python module:
+ * without it, each worker thread would leak its descriptors.
+ */
+static void perf_close_group(void* fds){
+    for (int e = 0; e < PERF_EVENTS; e++)
+        if (((int*)fds)[e] >= 0)
+            close(((int*)fds)[e]);
+    free(fds);
+}
+
+static void perf_create_key(void){
+    pthread_key_create(&perf_group_key, perf_close_group);
+}
+#endif
+
+/**
+ * Open the event group of the current thread.
+ *
+ * The group leader counts the cycles. The other events are added if the CPU (or the hypervisor) exposes them.
+ */
+static void perf_open_group(void){
+    perf_group_fd = -1;
+    for (int e = 0; e < PERF_EVENTS; e++)
+        perf_group_index[e] = -1;
+
+#ifdef __linux__
+    static const unsigned types[PERF_EVENTS] = {
+        PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE
+    };
+    static const unsigned long long configs[PERF_EVENTS] = {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+        PERF_COUNT_HW_CACHE_MISSES,
+        PERF_COUNT_HW_BRANCH_MISSES
+    };
+
+    int* fds = malloc(PERF_EVENTS * sizeof(*fds));
+    if (!fds)
+        return;
+    int leader = fds[PERF_CYCLES] = perf_open_event(types[PERF_CYCLES], configs[PERF_CYCLES], -1);
+    if (leader < 0){
+        free(fds);
+        return;
+    }
+
+    int nb = 0;
+    perf_group_index[PERF_CYCLES] = nb++;
+    for (int e = PERF_CYCLES + 1; e < PERF_EVENTS; e++)
+        if ((fds[e] = perf_open_event(types[e], configs[e], leader)) >= 0)
+            perf_group_index[e] = nb++;
+
+    pthread_once(&perf_group_once, perf_create_key);
+    pthread_setspecific(perf_group_key, fds);
+
+    for (int e = 0; e < PERF_EVENTS; e++)
+        perf_available[e] = perf_group_index[e] != -1;
+    perf_group_fd = leader;
+#endif
+}
+
+/**
+ * Read the event group of the current thread.
+ *
+ * in : values : event values, indexed by perf_event_t (0 for unavailable events)
+ */
+static void perf_read_group(unsigned long long* values){
+    // nr, then one value per event
+    unsigned long long buffer[PERF_EVENTS + 1];
+
+    memset(values, 0, sizeof(*values) * PERF_EVENTS);
+    if (perf_group_fd < 0 || read(perf_group_fd, buffer, sizeof(buffer)) <= 0)
+        return;
+
+    for (int e = 0; e < PERF_EVENTS; e++)
+        if (perf_group_index[e] != -1 && (unsigned long long)perf_group_index[e] < buffer[0])
+            values[e] = buffer[1 + perf_group_index[e]];
+}
+
+static unsigned long long perf_time_ns(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+
+
+/***************************************/
+/**** PERFORMANCE COUNTERS FUNCTION ****/
+/***************************************/
+
+/**
+ * Check if the instrumentation is enabled.
+ *
+ * out : int : 1 if the instrumented calls are counted, 0 otherwise
+ *
+ * Enabled by default, disabled by the environment variable GENE_PERF=0 or by perf_counters_enable(0).
+ */
+int perf_counters_enabled(void){
+    if (perf_enabled == -1) {
+        const char* env = getenv("GENE_PERF");
+        perf_enabled = !(env && !strcmp(env, "0"));
+    }
+    return perf_enabled;
+}
+
+/**
+ * Enable or disable the instrumentation.
+ */
+void perf_counters_enable(const int enable){
+    perf_enabled = enable ? 1 : 0;
+}
+
+/**
+ * Check if a hardware event can be counted on this machine.
+ *
+ * out : int : 1 if the event is counted, 0 if its totals stay at 0
+ */
+int perf_event_available(const perf_event_t event){
+    if (perf_group_fd == -2)
+        perf_open_group();
+    return event < PERF_EVENTS && perf_available[event];
+}
+
+/**
+ * Start an instrumented call.
+ *
+ * in : sample : counter values at the beginning of the call
+ * out : int : 1 if the call must be ended by perf_counters_end, 0 if the instrumentation is disabled
+ */
+int perf_counters_begin(perf_sample_t* sample){
+    if (!perf_counters_enabled())
+        return 0;
+    if (perf_group_fd == -2)
+        perf_open_group();
+
+    sample->time_ns = perf_time_ns();
+    perf_read_group(sample->values);
+    return 1;
+}
+
+/**
+ * End an instrumented call and add its counters to the totals of its call site.
+ *
+ * in : site : instrumented function
+ * in : sample : counter values at the beginning of the call
+ *
+ * Nested instrumented calls are counted in both call sites (inclusive totals).
+ */
+void perf_counters_end(const perf_site_t site, const perf_sample_t* sample){
+    unsigned long long values[PERF_EVENTS];
+    perf_read_group(values);
+    unsigned long long time_ns = perf_time_ns();
+
+    perf_counters_t* totals = &perf_totals[site];
+    __atomic_fetch_add(&totals->calls, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&totals->time_ns, time_ns - sample->time_ns, __ATOMIC_RELAXED);
+    for (int e = 0; e < PERF_EVENTS; e++)
+        __atomic_fetch_add(&totals->values[e], values[e] - sample->values[e], __ATOMIC_RELAXED);
+}
+
+/**
+ * Retrieve the totals of one call site.
+ */
+void perf_counters_get(const perf_site_t site, perf_counters_t* counters){
+    counters->calls = __atomic_load_n(&perf_totals[site].calls, __ATOMIC_RELAXED);
+    counters->time_ns = __atomic_load_n(&perf_totals[site].time_ns, __ATOMIC_RELAXED);
+    for (int e = 0; e < PERF_EVENTS; e++)
+        counters->values[e] = __atomic_load_n(&perf_totals[site].values[e], __ATOMIC_RELAXED);
+}
+
+/**
+ * Reset the totals of every call site.
+ */
+void perf_counters_reset(void){
+    for (int s = 0; s < PERF_SITES; s++) {
+        __atomic_store_n(&perf_totals[s].calls, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&perf_totals[s].time_ns, 0, __ATOMIC_RELAXED);
+        for (int e = 0; e < PERF_EVENTS; e++)
+            __atomic_store_n(&perf_totals[s].values[e], 0, __ATOMIC_RELAXED);
+    }
+}
+
+const char* perf_site_name(const perf_site_t site){
+    return site < PERF_SITES ? perf_site_names[site] : NULL;
+}
+
+const char* perf_event_name(const perf_event_t event){
+    return event < PERF_EVENTS ? perf_event_names[event] : NULL;
+}
+
+/**
+ * Print the totals of every called site: calls, time, hardware events, IPC and miss rates.
+ *
+ * in : out : output file
+ */
+void perf_counters_print(FILE* out){
+    fprintf(out, "%-28s %10s %14s", "Call site", "Calls", "Time (ns)");
+    for (int e = 0; e < PERF_EVENTS; e++)
+        fprintf(out, " %14s", perf_event_names[e]);
+    fprintf(out, " %6s\n", "IPC");
+
+    for (int s = 0; s < PERF_SITES; s++) {
+        perf_counters_t c;
+        perf_counters_get(s, &c);
+        if (!c.calls)
+            continue;
+
+        fprintf(out, "%-28s %10llu %14llu", perf_site_names[s], c.calls, c.time_ns);
+        for (int e = 0; e < PERF_EVENTS; e++)
+            if (perf_event_available(e))
+                fprintf(out, " %14llu", c.values[e]);
+            else
+                fprintf(out, " %14s", "-");
+        if (c.values[PERF_CYCLES])
+            fprintf(out, " %6.2f\n", (double)c.values[PERF_INSTRUCTIONS] / c.values[PERF_CYCLES]);
+        else
+            fprintf(out, " %6s\n", "-");
+    }
+}
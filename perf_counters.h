@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stdio.h>
+
+// Instrumented functions of the binary library (one call site per function)
+typedef enum perf_site_e {
+    PERF_SET_BINARY_ARRAY,
+    PERF_XOR_BINARY_ARRAY,
+    PERF_POPCOUNT_BINARY_ARRAY,
+    PERF_GET_PIECE_BINARY_ARRAY,
+    PERF_CONVERT_TO_BINARY,
+    PERF_BINARY_TO_DNA,
+    PERF_GENERATING_MRNA,
+    PERF_DETECTING_GENES,
+    PERF_GENERATING_AMINO_ACID_CHAIN,
+    PERF_DETECTING_MUTATIONS,
+    PERF_CALCULATING_MATCHING_SCORE,
+    PERF_ANALYSING_GENES,
+    PERF_SITES
+}perf_site_t;
+
+// Hardware events read with perf_event_open
+typedef enum perf_event_e {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_L1D_MISSES,
+    PERF_LLC_MISSES,
+    PERF_BRANCH_MISSES,
+    PERF_EVENTS
+}perf_event_t;
+
+typedef struct perf_counters_s {
+
+    //Number of instrumented calls
+    unsigned long long calls;
+
+    //Wall time spent in the calls (ns)
+    unsigned long long time_ns;
+
+    //Hardware event totals, indexed by perf_event_t
+    unsigned long long values[PERF_EVENTS];
+
+}perf_counters_t;
+
+// Counter values at the beginning of an instrumented call
+typedef struct perf_sample_s {
+    unsigned long long time_ns;
+    unsigned long long values[PERF_EVENTS];
+}perf_sample_t;
+
+
+/******** PERFORMANCE COUNTERS FUNCTION *********/
+
+int perf_counters_enabled(void);
+void perf_counters_enable(const int enable);
+int perf_event_available(const perf_event_t event);
+int perf_counters_begin(perf_sample_t* sample);
+void perf_counters_end(const perf_site_t site, const perf_sample_t* sample);
+void perf_counters_get(const perf_site_t site, perf_counters_t* counters);
+void perf_counters_reset(void);
+const char* perf_site_name(const perf_site_t site);
+const char* perf_event_name(const perf_event_t event);
+void perf_counters_print(FILE* out);
+
+
+// Instrumentation of the binary library functions, only compiled with -DGENE_PERF
+#ifdef GENE_PERF
+#define PERF_BEGIN(site) perf_sample_t perf_sample_; const int perf_on_ = perf_counters_begin(&perf_sample_)
+#define PERF_END(site) do { if (perf_on_) perf_counters_end(site, &perf_sample_); } while (0)
+#else
+#define PERF_BEGIN(site)
+#define PERF_END(site)
+#endif
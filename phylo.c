@@ -0,0 +1,453 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <limits.h>
+#include <math.h>
+
+#include "phylo.h"
+
+
+/***************************************/
+/************** DISTANCES **************/
+/***************************************/
+
+/**
+ * Mismatch distance of two genomes, as calculating_matching_score counts it.
+ *
+ * in : seq1, seq2 : genomes in binary array format
+ * in : nb_bases : bases compared, from the first one
+ * out : float : different bits over the bits compared (1 when there are none)
+ *
+ * The arrays are compared in place: the bits past the bases compared are masked in their last word.
+ */
+GENE_KERNEL
+static float phylo_mismatch(const long int* seq1, const long int* seq2, const unsigned long long nb_bases){
+    const long int nb_bits = 2 * nb_bases;
+    if (!nb_bits)
+        return 1;
+
+    // Word of the last position compared, holding the positions start to nb_bits - 1 (get_binary_value)
+    long int last = nb_bits - 1 > 63 ? (nb_bits - 1) / 63 : 0;
+    long int start = last < 2 ? 64 * last : 63 * last;
+    uint64_t mismatches = 0;
+    for (long int w = 0; w < last; w++)
+        mismatches += __builtin_popcountll((uint64_t)(seq1[w] ^ seq2[w]));
+
+    long int n = nb_bits - start;
+    int rot = (start - last) & 63;
+    uint64_t mask = n < 64 ? (1ULL << n) - 1 : UINT64_MAX;
+    if (rot)
+        mask = mask << rot | mask >> (64 - rot);
+    mismatches += __builtin_popcountll((uint64_t)(seq1[last] ^ seq2[last]) & mask);
+    return (float)mismatches / nb_bits;
+}
+
+static int phylo_compare(const void* a, const void* b){
+    uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * K-mers of a genome.
+ *
+ * in : seq_bin, nb_bases : genome in binary array format
+ * in : k : length of the k-mers
+ * out : nb_kmers : number of different k-mers
+ * out : uint32_t* : different k-mers (2 bits per base), sorted, NULL on error
+ */
+static uint32_t* phylo_kmers(const long int* seq_bin, const unsigned long long nb_bases, const int k,
+                             unsigned long long* nb_kmers){
+    uint32_t* kmers = malloc((nb_bases + 1) * sizeof(*kmers));
+    if (!kmers)
+        return NULL;
+
+    const uint32_t mask = k < 16 ? (1U << 2 * k) - 1 : UINT32_MAX;
+    uint32_t code = 0;
+    unsigned long long n = 0;
+    for (unsigned long long i = 0; i < nb_bases; i++) {
+        code = (code << 2 | get_binary_value(seq_bin, 2 * i) << 1 | get_binary_value(seq_bin, 2 * i + 1)) & mask;
+        if (i + 1 >= (unsigned long long)k)
+            kmers[n++] = code;
+    }
+    qsort(kmers, n, sizeof(*kmers), phylo_compare);
+
+    *nb_kmers = 0;
+    for (unsigned long long i = 0; i < n; i++)
+        if (!i || kmers[i] != kmers[i - 1])
+            kmers[(*nb_kmers)++] = kmers[i];
+    return kmers;
+}
+
+/**
+ * K-mer distance of two genomes.
+ *
+ * in : kmers1, nb_kmers1, kmers2, nb_kmers2 : different k-mers of the genomes, sorted
+ * in : k : length of the k-mers
+ * out : float : Mash distance -ln(2J / (1 + J)) / k of the Jaccard index J of the k-mers, at most 1
+ *
+ * Unlike the Jaccard index, the Mash distance estimates the substitutions per base,
+ * which keeps the distances additive for the neighbor joining.
+ */
+static float phylo_kmer_distance(const uint32_t* kmers1, const unsigned long long nb_kmers1, const uint32_t* kmers2,
+                                 const unsigned long long nb_kmers2, const int k){
+    unsigned long long shared = 0;
+    for (unsigned long long i = 0, j = 0; i < nb_kmers1 && j < nb_kmers2;) {
+        if (kmers1[i] == kmers2[j])
+            shared++, i++, j++;
+        else if (kmers1[i] < kmers2[j])
+            i++;
+        else
+            j++;
+    }
+    if (!shared)
+        return 1;
+    double jaccard = (double)shared / (nb_kmers1 + nb_kmers2 - shared);
+    double distance = -log(2 * jaccard / (1 + jaccard)) / k;
+    return distance < 1 ? distance : 1;
+}
+
+typedef struct phylo_distances_s {
+    const long int* const* seqs_bin;
+    const unsigned long long* nb_bases;
+    unsigned long long nb_genomes;
+    int k;
+    uint32_t** kmers;
+    unsigned long long* nb_kmers;
+    float* distances;
+    int error;
+}phylo_distances_t;
+
+// K-mers of a range of genomes (thread pool task)
+static void phylo_kmers_task(void* arg, const unsigned long long begin, const unsigned long long end,
+                             const unsigned thread_id){
+    phylo_distances_t* job = arg;
+    for (unsigned long long g = begin; g < end; g++)
+        if (!(job->kmers[g] = phylo_kmers(job->seqs_bin[g], job->nb_bases[g], job->k, &job->nb_kmers[g])))
+            job->error = 1;
+}
+
+/**
+ * Distances of a range of pairs of tiles (thread pool task).
+ *
+ * The pair p is the tiles (t1, t2), t1 <= t2, numbered row by row: the PHYLO_TILE genomes
+ * of both tiles stay in the cache while they are compared together.
+ */
+static void phylo_distances_task(void* arg, const unsigned long long begin, const unsigned long long end,
+                                 const unsigned thread_id){
+    phylo_distances_t* job = arg;
+    const unsigned long long n = job->nb_genomes, nb_tiles = (n + PHYLO_TILE - 1) / PHYLO_TILE;
+
+    unsigned long long t1 = 0, first = 0;
+    for (unsigned long long p = begin; p < end; p++) {
+        while (p >= first + nb_tiles - t1)
+            first += nb_tiles - t1++;
+        unsigned long long t2 = t1 + p - first;
+
+        for (unsigned long long a = t1 * PHYLO_TILE; a < (t1 + 1) * PHYLO_TILE && a < n; a++)
+            for (unsigned long long b = t1 == t2 ? a + 1 : t2 * PHYLO_TILE; b < (t2 + 1) * PHYLO_TILE && b < n; b++) {
+                float d;
+                if (job->k)
+                    d = phylo_kmer_distance(job->kmers[a], job->nb_kmers[a], job->kmers[b], job->nb_kmers[b], job->k);
+                else
+                    d = phylo_mismatch(job->seqs_bin[a], job->seqs_bin[b],
+                                       job->nb_bases[a] < job->nb_bases[b] ? job->nb_bases[a] : job->nb_bases[b]);
+                job->distances[a * n + b] = job->distances[b * n + a] = d;
+            }
+    }
+}
+
+/**
+ * Distances between all the genomes of a collection.
+ *
+ * in : pool : threads sharing the pairs of genomes, NULL for the calling thread only
+ * in : seqs_bin, nb_bases, nb_genomes : genomes in binary array format, and their bases
+ * in : k : 0 for the mismatch distance of aligned genomes (on the bases of the shortest),
+ *          1 to PHYLO_MAX_K for the k-mer distance of genomes of any alignment
+ * out : distances : nb_genomes x nb_genomes symmetric matrix, by rows
+ * out : int : 0, -1 on error
+ */
+int computing_distances(thread_pool_t* pool, const long int* const* seqs_bin, const unsigned long long* nb_bases,
+                        const unsigned long long nb_genomes, const int k, float* distances){
+    if (!seqs_bin || !nb_bases || !distances)
+        return printf("ERROR: computing_distances: undefined genomes\n"), -1;
+    if (k < 0 || k > PHYLO_MAX_K)
+        return printf("ERROR: computing_distances: invalid k-mer length\n"), -1;
+    for (unsigned long long g = 0; g < nb_genomes; g++)
+        if (!seqs_bin[g] || nb_bases[g] >= INT_MAX / 2)
+            return printf("ERROR: computing_distances: invalid genome\n"), -1;
+
+    phylo_distances_t job = { seqs_bin, nb_bases, nb_genomes, k, NULL, NULL, distances, 0 };
+    if (k) {
+        job.kmers = calloc(nb_genomes + 1, sizeof(*job.kmers));
+        job.nb_kmers = malloc((nb_genomes + 1) * sizeof(*job.nb_kmers));
+        if (!job.kmers || !job.nb_kmers)
+            job.error = 1;
+        else if (pool)
+            thread_pool_run_dynamic(pool, nb_genomes, 1, phylo_kmers_task, &job);
+        else
+            phylo_kmers_task(&job, 0, nb_genomes, 0);
+    }
+
+    if (!job.error) {
+        for (unsigned long long g = 0; g < nb_genomes; g++)
+            distances[g * nb_genomes + g] = 0;
+        unsigned long long nb_tiles = (nb_genomes + PHYLO_TILE - 1) / PHYLO_TILE;
+        if (pool)
+            thread_pool_run_dynamic(pool, nb_tiles * (nb_tiles + 1) / 2, 1, phylo_distances_task, &job);
+        else
+            phylo_distances_task(&job, 0, nb_tiles * (nb_tiles + 1) / 2, 0);
+    }
+
+    if (job.kmers)
+        for (unsigned long long g = 0; g < nb_genomes; g++)
+            free(job.kmers[g]);
+    free(job.kmers);
+    free(job.nb_kmers);
+    if (job.error)
+        return printf("ERROR: computing_distances: cannot allocate memory\n"), -1;
+    return 0;
+}
+
+
+
+/***************************************/
+/*********** NEIGHBOR JOINING **********/
+/***************************************/
+
+typedef struct phylo_pair_s {
+    double q;
+    unsigned long long i;
+    unsigned long long j;
+}phylo_pair_t;
+
+typedef struct phylo_join_s {
+    const float* distances;
+    unsigned long long stride;
+    unsigned long long nb_active;
+    const double* sums;
+    //Best pair found by each thread
+    phylo_pair_t* best;
+}phylo_join_t;
+
+// Pair i < j of smallest Q(i, j) = (r - 2) d(i, j) - S(i) - S(j) in a range of rows (thread pool task)
+static void phylo_join_task(void* arg, const unsigned long long begin, const unsigned long long end,
+                            const unsigned thread_id){
+    const phylo_join_t* job = arg;
+    const double factor = job->nb_active - 2.0;
+    phylo_pair_t best = job->best[thread_id];
+    for (unsigned long long i = begin; i < end; i++) {
+        const float* row = job->distances + i * job->stride;
+        const double sum = job->sums[i];
+        for (unsigned long long j = i + 1; j < job->nb_active; j++) {
+            double q = factor * row[j] - sum - job->sums[j];
+            if (q < best.q)
+                best = (phylo_pair_t){ q, i, j };
+        }
+    }
+    job->best[thread_id] = best;
+}
+
+// Node joining two others, or three for the root
+static long phylo_node(phylo_tree_t* tree, const long a, const float la, const long b, const float lb,
+                       const long c, const float lc){
+    unsigned long long i = tree->nb_nodes++ - tree->nb_leaves;
+    tree->children[3 * i] = a;
+    tree->children[3 * i + 1] = b;
+    tree->children[3 * i + 2] = c;
+    tree->lengths[3 * i] = la > 0 ? la : 0;
+    tree->lengths[3 * i + 1] = lb > 0 ? lb : 0;
+    tree->lengths[3 * i + 2] = lc > 0 ? lc : 0;
+    return tree->nb_nodes - 1;
+}
+
+/**
+ * Neighbor joining tree of genomes.
+ *
+ * in : pool : threads sharing the search of the pairs to join, NULL for the calling thread only
+ * in : distances : nb_genomes x nb_genomes symmetric matrix, by rows (computing_distances), overwritten
+ * in : nb_genomes : number of genomes
+ * out : tree : unrooted tree, its last node holding the 3 last subtrees, to free with phylo_tree_free
+ * out : int : 0, -1 on error
+ *
+ * The matrix is the only quadratic memory: the subtrees left take its first rows and columns, a joined
+ * subtree takes the row of the first one and the last row moves to the row of the second one. The pair
+ * to join is searched over the upper triangle, row by row, by all the threads, and the ties go to the
+ * first pair in row order. Negative branch lengths are set to 0.
+ */
+int joining_neighbors(thread_pool_t* pool, float* distances, const unsigned long long nb_genomes,
+                      phylo_tree_t* tree){
+    memset(tree, 0, sizeof(*tree));
+    if (!distances || !nb_genomes)
+        return printf("ERROR: joining_neighbors: undefined distances\n"), -1;
+    if (nb_genomes > LONG_MAX / 2)
+        return printf("ERROR: joining_neighbors: too many genomes\n"), -1;
+
+    const unsigned long long n = nb_genomes;
+    unsigned nb_threads = pool ? pool->nb_threads : 1;
+    tree->nb_leaves = tree->nb_nodes = n;
+    tree->root = 0;
+    tree->children = malloc(3 * n * sizeof(*tree->children));
+    tree->lengths = malloc(3 * n * sizeof(*tree->lengths));
+    long* nodes = malloc(n * sizeof(*nodes));
+    double* sums = malloc(n * sizeof(*sums));
+    phylo_pair_t* best = malloc(nb_threads * sizeof(*best));
+    if (!tree->children || !tree->lengths || !nodes || !sums || !best) {
+        free(nodes);
+        free(sums);
+        free(best);
+        phylo_tree_free(tree);
+        return printf("ERROR: joining_neighbors: cannot allocate memory\n"), -1;
+    }
+
+    for (unsigned long long i = 0; i < n; i++) {
+        nodes[i] = i;
+        sums[i] = 0;
+        for (unsigned long long j = 0; j < n; j++)
+            sums[i] += j != i ? distances[i * n + j] : 0;
+    }
+
+    unsigned long long r = n;
+    while (r > 3) {
+        phylo_join_t job = { distances, n, r, sums, best };
+        for (unsigned t = 0; t < nb_threads; t++)
+            best[t] = (phylo_pair_t){ INFINITY, 0, 1 };
+        if (pool && r > 2 * PHYLO_CHUNK)
+            thread_pool_run_dynamic(pool, r - 1, PHYLO_CHUNK, phylo_join_task, &job);
+        else
+            phylo_join_task(&job, 0, r - 1, 0);
+        phylo_pair_t join = best[0];
+        for (unsigned t = 1; t < nb_threads; t++)
+            if (best[t].q < join.q || (best[t].q == join.q && (best[t].i < join.i
+                                                              || (best[t].i == join.i && best[t].j < join.j))))
+                join = best[t];
+
+        // Joined subtree in the row i
+        unsigned long long i = join.i, j = join.j;
+        float* row_i = distances + i * n;
+        float* row_j = distances + j * n;
+        float dij = row_i[j];
+        float li = dij / 2 + (sums[i] - sums[j]) / (2 * (r - 2.0));
+        nodes[i] = phylo_node(tree, nodes[i], li, nodes[j], dij - li, -1, 0);
+        sums[i] = 0;
+        for (unsigned long long k = 0; k < r; k++) {
+            if (k == i || k == j)
+                continue;
+            float d = (row_i[k] + row_j[k] - dij) / 2;
+            sums[k] += d - row_i[k] - row_j[k];
+            sums[i] += d;
+            row_i[k] = distances[k * n + i] = d;
+        }
+
+        // Last subtree in the row j
+        unsigned long long last = r - 1;
+        if (j != last) {
+            const float* row_last = distances + last * n;
+            for (unsigned long long k = 0; k < last; k++)
+                row_j[k] = distances[k * n + j] = row_last[k];
+            row_j[j] = 0;
+            sums[j] = sums[last];
+            nodes[j] = nodes[last];
+        }
+        r--;
+    }
+
+    if (r == 3) {
+        float d01 = distances[1], d02 = distances[2], d12 = distances[n + 2];
+        tree->root = phylo_node(tree, nodes[0], (d01 + d02 - d12) / 2, nodes[1], (d01 + d12 - d02) / 2,
+                                nodes[2], (d02 + d12 - d01) / 2);
+    }
+    else if (r == 2)
+        tree->root = phylo_node(tree, nodes[0], distances[1] / 2, nodes[1], distances[1] / 2, -1, 0);
+
+    free(nodes);
+    free(sums);
+    free(best);
+    return 0;
+}
+
+void phylo_tree_free(phylo_tree_t* tree){
+    free(tree->children);
+    free(tree->lengths);
+    memset(tree, 0, sizeof(*tree));
+}
+
+
+
+/***************************************/
+/**************** NEWICK ***************/
+/***************************************/
+
+typedef struct phylo_text_s {
+    char* text;
+    size_t size;
+    size_t capacity;
+}phylo_text_t;
+
+// Append to a text, it grows by doubling
+static int phylo_append(phylo_text_t* text, const char* format, ...){
+    for (;;) {
+        va_list args;
+        va_start(args, format);
+        int n = vsnprintf(text->text + text->size, text->capacity - text->size, format, args);
+        va_end(args);
+        if (n < 0)
+            return -1;
+        if (text->size + n < text->capacity) {
+            text->size += n;
+            return 0;
+        }
+        size_t capacity = 2 * text->capacity + n;
+        char* grown = realloc(text->text, capacity);
+        if (!grown)
+            return -1;
+        text->text = grown;
+        text->capacity = capacity;
+    }
+}
+
+// Name of a leaf, between quotes if it has Newick punctuation
+static int phylo_name(phylo_text_t* text, const char* name){
+    if (*name && !name[strcspn(name, " \t\n\r()[]':;,")])
+        return phylo_append(text, "%s", name);
+    if (phylo_append(text, "'"))
+        return -1;
+    for (const char* c = name; *c; c++)
+        if (phylo_append(text, *c == '\'' ? "''" : "%c", *c))
+            return -1;
+    return phylo_append(text, "'");
+}
+
+static int phylo_subtree(const phylo_tree_t* tree, const char* const* names, const long node, phylo_text_t* text){
+    if ((unsigned long long)node < tree->nb_leaves)
+        return names ? phylo_name(text, names[node]) : phylo_append(text, "%ld", node);
+
+    const long* children = tree->children + 3 * (node - tree->nb_leaves);
+    const float* lengths = tree->lengths + 3 * (node - tree->nb_leaves);
+    if (phylo_append(text, "("))
+        return -1;
+    for (int c = 0; c < 3 && children[c] != -1; c++)
+        if ((c && phylo_append(text, ",")) || phylo_subtree(tree, names, children[c], text)
+            || phylo_append(text, ":%.6g", lengths[c]))
+            return -1;
+    return phylo_append(text, ")");
+}
+
+/**
+ * Newick text of a tree.
+ *
+ * in : tree : tree of genomes (joining_neighbors)
+ * in : names : names of the genomes, NULL for their numbers
+ * out : char* : Newick text, ended by ';', to free, NULL on error
+ */
+char* writing_newick(const phylo_tree_t* tree, const char* const* names){
+    if (!tree || !tree->nb_leaves)
+        return printf("ERROR: writing_newick: undefined tree\n"), NULL;
+
+    phylo_text_t text = { malloc(64), 0, 64 };
+    if (!text.text || phylo_subtree(tree, names, tree->root, &text) || phylo_append(&text, ";")) {
+        free(text.text);
+        return printf("ERROR: writing_newick: cannot allocate memory\n"), NULL;
+    }
+    return text.text;
+}
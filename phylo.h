@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "gene_bin.h"
+#include "thread_pool.h"
+
+// Genomes of a tile of the distance matrix, compared with those of another tile by one thread
+#define PHYLO_TILE 32
+// Longest k-mers of the k-mer distance (2 bits per base in 32 bits)
+#define PHYLO_MAX_K 16
+// Rows searched at once by a thread for the pair to join
+#define PHYLO_CHUNK 32
+
+typedef struct phylo_tree_s {
+
+    //Leaves 0 to nb_leaves - 1 (the genomes), then the internal nodes
+    unsigned long long nb_leaves;
+    unsigned long long nb_nodes;
+
+    //Internal node nb_leaves + i joins children[3 * i] to children[3 * i + 2] (-1 for none),
+    //at the branch lengths lengths[3 * i] to lengths[3 * i + 2]
+    long* children;
+    float* lengths;
+
+    //Last node joined, which holds the others (3 children for 3 genomes or more)
+    long root;
+
+}phylo_tree_t;
+
+
+/******** PHYLOGENY FUNCTION *********/
+
+int computing_distances(thread_pool_t* pool, const long int* const* seqs_bin, const unsigned long long* nb_bases,
+                        const unsigned long long nb_genomes, const int k, float* distances);
+int joining_neighbors(thread_pool_t* pool, float* distances, const unsigned long long nb_genomes,
+                      phylo_tree_t* tree);
+char* writing_newick(const phylo_tree_t* tree, const char* const* names);
+void phylo_tree_free(phylo_tree_t* tree);
@@ -0,0 +1,322 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "protein_score.h"
+
+#define PROTEIN_MAX(a, b) ((a) > (b) ? (a) : (b))
+
+
+/***************************************/
+/*************** PROFILE ***************/
+/***************************************/
+
+/**
+ * Striped profile of a query protein (Farrar, 2007).
+ *
+ * in : query : amino acid chain (one letter codes)
+ * in : length : residues of the query
+ * in : matrix_id : substitution matrix (substitution_matrix_id_t)
+ * out : profile : scores of the residues against the query, to free with protein_profile_free
+ * out : int : 0, -1 on error
+ *
+ * The lanes of a segment are rows nb_segments apart, so that a row depends on the row of the same lane
+ * in the previous segment: a column of the alignment is updated segment by segment, PROTEIN_LANES rows
+ * at once, and the scores of a residue against a segment are a single load from the profile.
+ */
+int protein_profile_init(protein_profile_t* profile, const char* query, const uint64_t length, const int matrix_id){
+    memset(profile, 0, sizeof(*profile));
+    const int8_t* matrix = substitution_matrix(matrix_id);
+    if (!matrix)
+        return -1;
+    if (!query && length)
+        return printf("ERROR: protein_profile_init: undefined query\n"), -1;
+
+    profile->length = length;
+    profile->nb_segments = (length + PROTEIN_LANES - 1) / PROTEIN_LANES;
+    uint64_t size = profile->nb_segments * PROTEIN_LANES;
+    void* scores = NULL;
+    void* rows = NULL;
+    if (posix_memalign(&scores, 64, (SUBSTITUTION_SIZE * size + 1) * sizeof(*profile->scores)))
+        scores = NULL;
+    if (posix_memalign(&rows, 64, (3 * size + 1) * sizeof(*profile->rows)))
+        rows = NULL;
+    profile->scores = scores;
+    profile->rows = rows;
+    if (!scores || !rows)
+        return protein_profile_free(profile), printf("ERROR: protein_profile_init: cannot allocate memory\n"), -1;
+
+    for (int r = 0; r < SUBSTITUTION_SIZE; r++)
+        for (uint64_t s = 0; s < profile->nb_segments; s++)
+            for (int l = 0; l < PROTEIN_LANES; l++) {
+                uint64_t row = l * profile->nb_segments + s;
+                profile->scores[(r * profile->nb_segments + s) * PROTEIN_LANES + l] =
+                    row < length ? matrix[substitution_code(query[row]) * SUBSTITUTION_SIZE + r] : 0;
+            }
+    return 0;
+}
+
+void protein_profile_free(protein_profile_t* profile){
+    free(profile->scores);
+    free(profile->rows);
+    memset(profile, 0, sizeof(*profile));
+}
+
+// Moves the lanes up by one, the lane 0 taking the value of an empty row
+static inline void protein_shifting(int32_t* lanes){
+    for (int l = PROTEIN_LANES - 1; l > 0; l--)
+        lanes[l] = lanes[l - 1];
+    lanes[0] = 0;
+}
+
+/**
+ * Local alignment score of a chain against a query profile (Smith-Waterman with affine gaps).
+ *
+ * in : profile : striped profile of the query
+ * in : chain, length : amino acid chain and its residues
+ * in : gap_open, gap_extend : cost of a gap of k residues, gap_open + k * gap_extend
+ * out : int64_t : best local alignment score (0 or more), -1 on error
+ *
+ * Each column is computed with the gaps in the query (E) and the gaps in the chain (F) of the rows
+ * above in the same lane; the F coming from the previous lane are then carried over by the lazy F loop,
+ * which stops as soon as they cannot change a score, usually after one segment.
+ */
+GENE_KERNEL
+int64_t aligning_protein_profile(protein_profile_t* profile, const char* chain, const uint64_t length,
+                                 const int gap_open, const int gap_extend){
+    if (!profile || !profile->scores || (!chain && length))
+        return printf("ERROR: aligning_protein_profile: undefined sequence\n"), -1;
+    if (gap_open < 0 || gap_extend <= 0)
+        return printf("ERROR: aligning_protein_profile: invalid gap costs\n"), -1;
+    const uint64_t nb_segments = profile->nb_segments;
+    if (!nb_segments || !length)
+        return 0;
+
+    const int32_t open = gap_open + gap_extend, extend = gap_extend;
+    const uint64_t size = nb_segments * PROTEIN_LANES;
+    int32_t* h_load = profile->rows;
+    int32_t* h_store = h_load + size;
+    int32_t* e = h_store + size;
+    memset(profile->rows, 0, 3 * size * sizeof(*profile->rows));
+    int32_t best[PROTEIN_LANES] = { 0 };
+
+    for (uint64_t j = 0; j < length; j++) {
+        const int32_t* scores = profile->scores + substitution_code(chain[j]) * size;
+        int32_t* swap = h_load;
+        h_load = h_store;
+        h_store = swap;
+
+        // Diagonal of the first segment: the last segment of the previous column, one lane up
+        int32_t h[PROTEIN_LANES], f[PROTEIN_LANES] = { 0 };
+        memcpy(h, h_load + size - PROTEIN_LANES, sizeof(h));
+        protein_shifting(h);
+
+        for (uint64_t s = 0; s < nb_segments; s++) {
+            const int32_t* score = scores + s * PROTEIN_LANES;
+            const int32_t* load = h_load + s * PROTEIN_LANES;
+            int32_t* store = h_store + s * PROTEIN_LANES;
+            int32_t* gap = e + s * PROTEIN_LANES;
+            for (int l = 0; l < PROTEIN_LANES; l++) {
+                int32_t x = PROTEIN_MAX(h[l] + score[l], 0);
+                x = PROTEIN_MAX(x, gap[l]);
+                x = PROTEIN_MAX(x, f[l]);
+                best[l] = PROTEIN_MAX(best[l], x);
+                store[l] = x;
+                gap[l] = PROTEIN_MAX(gap[l] - extend, x - open);
+                f[l] = PROTEIN_MAX(f[l] - extend, x - open);
+                h[l] = load[l];
+            }
+        }
+
+        // Lazy F: the gaps in the chain going on from the last row of a lane to the first of the next
+        protein_shifting(f);
+        for (uint64_t s = 0;;) {
+            int32_t* store = h_store + s * PROTEIN_LANES;
+            int32_t* gap = e + s * PROTEIN_LANES;
+            int changed = 0;
+            for (int l = 0; l < PROTEIN_LANES; l++)
+                changed |= f[l] > 0 && f[l] > store[l] - open;
+            if (!changed)
+                break;
+            for (int l = 0; l < PROTEIN_LANES; l++) {
+                store[l] = PROTEIN_MAX(store[l], f[l]);
+                gap[l] = PROTEIN_MAX(gap[l], store[l] - open);
+                f[l] -= extend;
+            }
+            if (++s == nb_segments) {
+                s = 0;
+                protein_shifting(f);
+            }
+        }
+    }
+
+    int32_t score = 0;
+    for (int l = 0; l < PROTEIN_LANES; l++)
+        score = PROTEIN_MAX(score, best[l]);
+    return score;
+}
+
+
+
+/***************************************/
+/*************** SCORES ****************/
+/***************************************/
+
+// Score of the residues at the same positions of two chains
+GENE_KERNEL
+static int64_t protein_ungapped(const int8_t* matrix, const char* chain1, const char* chain2, const uint64_t length){
+    int64_t score = 0;
+    for (uint64_t i = 0; i < length; i++)
+        score += matrix[substitution_code(chain1[i]) * SUBSTITUTION_SIZE + substitution_code(chain2[i])];
+    return score;
+}
+
+static int protein_checking(const protein_scoring_t* scoring, const char* function){
+    if (!scoring)
+        return printf("ERROR: %s: undefined scoring\n", function), -1;
+    if (!substitution_matrix(scoring->matrix_id))
+        return -1;
+    if (scoring->gapped && (scoring->gap_open < 0 || scoring->gap_extend <= 0))
+        return printf("ERROR: %s: invalid gap costs\n", function), -1;
+    return 0;
+}
+
+/**
+ * Protein level similarity of two amino acid chains.
+ *
+ * in : chain1, length1 : amino acid chain (from generating_amino_acid_chain) and its residues
+ * in : chain2, length2 : amino acid chain and its residues
+ * in : scoring : matrix, and gapped local alignment or ungapped score
+ * out : score : best local alignment score if gapped, else score of the min(length1, length2) residues
+ *               at the same positions
+ * out : int : 0, -1 on error
+ *
+ * Unlike the matching score of the bases, the synonymous mutations do not change the score, and the
+ * substitutions of close amino acids cost less than the others.
+ */
+int scoring_proteins(const char* chain1, const uint64_t length1, const char* chain2, const uint64_t length2,
+                     const protein_scoring_t* scoring, int64_t* score){
+    if ((!chain1 && length1) || (!chain2 && length2))
+        return printf("ERROR: scoring_proteins: undefined sequence\n"), -1;
+    if (protein_checking(scoring, "scoring_proteins"))
+        return -1;
+
+    if (!scoring->gapped) {
+        *score = protein_ungapped(substitution_matrix(scoring->matrix_id), chain1, chain2,
+                                  length1 < length2 ? length1 : length2);
+        return 0;
+    }
+    protein_profile_t profile;
+    if (protein_profile_init(&profile, chain1, length1, scoring->matrix_id))
+        return -1;
+    *score = aligning_protein_profile(&profile, chain2, length2, scoring->gap_open, scoring->gap_extend);
+    protein_profile_free(&profile);
+    return *score < 0 ? -1 : 0;
+}
+
+typedef struct protein_scores_s {
+    const protein_chains_t* chains1;
+    const protein_chains_t* chains2;
+    const protein_scoring_t* scoring;
+    int64_t* scores;
+    int error;
+}protein_scores_t;
+
+#define PROTEIN_CHAIN(chains, i) (chains)->data + (chains)->offsets[i], \
+                                 (uint64_t)((chains)->offsets[(i) + 1] - (chains)->offsets[i])
+
+// Scores of the pairs of chains [begin, end) (thread pool task)
+static void protein_batch_task(void* arg, const unsigned long long begin, const unsigned long long end,
+                               const unsigned thread_id){
+    protein_scores_t* job = arg;
+    for (unsigned long long i = begin; i < end; i++)
+        if (scoring_proteins(PROTEIN_CHAIN(job->chains1, i), PROTEIN_CHAIN(job->chains2, i), job->scoring,
+                             &job->scores[i]))
+            job->error = 1;
+}
+
+/**
+ * Scores the chain i of a set against the chain i of another one.
+ *
+ * in : pool : thread pool running the chunks of pairs (NULL to run in the calling thread)
+ * in : chains1, chains2 : as many chains, in bulk translation buffers
+ * in : scoring : matrix, and gapped or ungapped score (see scoring_proteins)
+ * out : scores : score of each pair
+ * out : int : 0, -1 on error
+ */
+int scoring_proteins_batch(thread_pool_t* pool, const protein_chains_t* chains1, const protein_chains_t* chains2,
+                           const protein_scoring_t* scoring, int64_t* scores){
+    if (!chains1 || !chains2 || !scores || (chains1->nb_chains && (!chains1->offsets || !chains2->offsets)))
+        return printf("ERROR: scoring_proteins_batch: undefined chains\n"), -1;
+    if (chains1->nb_chains != chains2->nb_chains)
+        return printf("ERROR: scoring_proteins_batch: not as many chains\n"), -1;
+    if (protein_checking(scoring, "scoring_proteins_batch"))
+        return -1;
+
+    protein_scores_t job = { chains1, chains2, scoring, scores, 0 };
+    if (pool)
+        thread_pool_run_dynamic(pool, chains1->nb_chains, PROTEIN_SCORE_CHUNK, protein_batch_task, &job);
+    else
+        protein_batch_task(&job, 0, chains1->nb_chains, 0);
+    return job.error ? -1 : 0;
+}
+
+/**
+ * Scores of a row of the all pairs matrix (thread pool task).
+ *
+ * The chain i is scored against the chains i to n - 1 with a single profile, and each score is written
+ * at both places of the symmetric matrix.
+ */
+static void protein_all_pairs_task(void* arg, const unsigned long long begin, const unsigned long long end,
+                                   const unsigned thread_id){
+    protein_scores_t* job = arg;
+    const protein_chains_t* chains = job->chains1;
+    const protein_scoring_t* scoring = job->scoring;
+    const unsigned long long n = chains->nb_chains;
+    const int8_t* matrix = substitution_matrix(scoring->matrix_id);
+
+    for (unsigned long long i = begin; i < end; i++) {
+        const char* chain1 = chains->data + chains->offsets[i];
+        uint64_t length1 = chains->offsets[i + 1] - chains->offsets[i];
+        protein_profile_t profile = { 0 };
+        if (scoring->gapped && protein_profile_init(&profile, chain1, length1, scoring->matrix_id)) {
+            job->error = 1;
+            return;
+        }
+        for (unsigned long long j = i; j < n; j++) {
+            const char* chain2 = chains->data + chains->offsets[j];
+            uint64_t length2 = chains->offsets[j + 1] - chains->offsets[j];
+            int64_t score = scoring->gapped
+                            ? aligning_protein_profile(&profile, chain2, length2, scoring->gap_open, scoring->gap_extend)
+                            : protein_ungapped(matrix, chain1, chain2, length1 < length2 ? length1 : length2);
+            job->scores[i * n + j] = job->scores[j * n + i] = score;
+        }
+        if (scoring->gapped)
+            protein_profile_free(&profile);
+    }
+}
+
+/**
+ * Scores of all the pairs of a set of chains.
+ *
+ * in : pool : thread pool running the rows of the matrix (NULL to run in the calling thread)
+ * in : chains : chains, in a bulk translation buffer
+ * in : scoring : matrix, and gapped or ungapped score (see scoring_proteins)
+ * out : scores : nb_chains x nb_chains symmetric matrix of the scores, by rows
+ * out : int : 0, -1 on error
+ */
+int scoring_proteins_all_pairs(thread_pool_t* pool, const protein_chains_t* chains, const protein_scoring_t* scoring,
+                               int64_t* scores){
+    if (!chains || !scores || (chains->nb_chains && !chains->offsets))
+        return printf("ERROR: scoring_proteins_all_pairs: undefined chains\n"), -1;
+    if (protein_checking(scoring, "scoring_proteins_all_pairs"))
+        return -1;
+
+    protein_scores_t job = { chains, chains, scoring, scores, 0 };
+    if (pool)
+        thread_pool_run_dynamic(pool, chains->nb_chains, 1, protein_all_pairs_task, &job);
+    else
+        protein_all_pairs_task(&job, 0, chains->nb_chains, 0);
+    return job.error ? -1 : 0;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "gene_bin.h"
+#include "substitution_matrix.h"
+#include "thread_pool.h"
+
+// Rows of the query updated at once by the gapped alignment (striped profile)
+#define PROTEIN_LANES 16
+// Pairs scored at once by a thread in batch mode
+#define PROTEIN_SCORE_CHUNK 16
+
+typedef struct protein_scoring_s {
+
+    //Substitution matrix (substitution_matrix_id_t)
+    int matrix_id;
+
+    //Local alignment with gaps (Smith-Waterman), or score of the residues at the same positions
+    int gapped;
+
+    //Cost of a gap of k residues: gap_open + k * gap_extend
+    int gap_open;
+    int gap_extend;
+
+}protein_scoring_t;
+
+typedef struct protein_chains_s {
+
+    //Chain i: the residues data[offsets[i]] to data[offsets[i + 1] - 1], as the bulk translations
+    //(generating_amino_acid_chain_batch)
+    const char* data;
+    const int64_t* offsets;
+    unsigned long long nb_chains;
+
+}protein_chains_t;
+
+typedef struct protein_profile_s {
+
+    //Residues of the query, and segments of PROTEIN_LANES rows: the row l * nb_segments + s is the lane l
+    //of the segment s
+    uint64_t length;
+    uint64_t nb_segments;
+
+    //Score of each residue of the matrix against each row, by residue then segment then lane (0 after the query)
+    int32_t* scores;
+
+    //Scores of the last two columns and gaps of the alignment, the profile being used by one thread at a time
+    int32_t* rows;
+
+}protein_profile_t;
+
+
+/******** PROTEIN SCORE FUNCTION *********/
+
+int protein_profile_init(protein_profile_t* profile, const char* query, const uint64_t length, const int matrix_id);
+void protein_profile_free(protein_profile_t* profile);
+int64_t aligning_protein_profile(protein_profile_t* profile, const char* chain, const uint64_t length,
+                                 const int gap_open, const int gap_extend);
+int scoring_proteins(const char* chain1, const uint64_t length1, const char* chain2, const uint64_t length2,
+                     const protein_scoring_t* scoring, int64_t* score);
+int scoring_proteins_batch(thread_pool_t* pool, const protein_chains_t* chains1, const protein_chains_t* chains2,
+                           const protein_scoring_t* scoring, int64_t* scores);
+int scoring_proteins_all_pairs(thread_pool_t* pool, const protein_chains_t* chains, const protein_scoring_t* scoring,
+                               int64_t* scores);
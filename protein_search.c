@@ -0,0 +1,398 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "protein_search.h"
+
+// Letters of the seeds: the 20 amino acids, or the 10 groups of Murphy et al. (2000) separated by spaces
+static const char* const protein_alphabets[2] = {
+    "A C D E F G H I K L M N P Q R S T V W Y",
+    "LVIM C A G ST P FYW EDNQ KR H"
+};
+
+
+/***************************************/
+/*************** FRAMES ****************/
+/***************************************/
+
+// Reverse complement of a sequence in binary array format (A, G, C and T being 00, 01, 10 and 11)
+static long int* protein_reverse_complement(const long int* seq_bin, const uint64_t nb_bases){
+    long int* rc_bin = calloc(binary_array_size(2 * nb_bases), sizeof(*rc_bin));
+    if (!rc_bin)
+        return NULL;
+    for (uint64_t i = 0; i < nb_bases; i++) {
+        int pos = 2 * (nb_bases - 1 - i);
+        change_binary_value(rc_bin, 2 * i, !get_binary_value(seq_bin, pos));
+        change_binary_value(rc_bin, 2 * i + 1, !get_binary_value(seq_bin, pos + 1));
+    }
+    return rc_bin;
+}
+
+// Translation of the six frames of a genome, each ended by a '\0'
+static int protein_translating(protein_db_t* db, const long int* seq_bin, const int table_id){
+    uint64_t total = 0;
+    for (int f = 0; f < 6; f++) {
+        db->frame_start[f] = total;
+        total += (db->nb_bases > (uint64_t)f % 3 ? (db->nb_bases - f % 3) / 3 : 0) + 1;
+    }
+    db->frame_start[6] = total;
+    if (total >= UINT32_MAX)
+        return printf("ERROR: indexing_proteins: genome too long\n"), -1;
+
+    long int* rc_bin = protein_reverse_complement(seq_bin, db->nb_bases);
+    if (!rc_bin || !(db->residues = malloc(total)))
+        return free(rc_bin), printf("ERROR: indexing_proteins: cannot allocate memory\n"), -1;
+    for (int f = 0; f < 6; f++) {
+        long int nb_codons = db->frame_start[f + 1] - db->frame_start[f] - 1;
+        if (!generating_amino_acid_chain_table_into(f < 3 ? seq_bin : rc_bin, 2 * (f % 3), 6 * nb_codons, table_id,
+                                                    db->residues + db->frame_start[f]))
+            return free(rc_bin), -1;
+    }
+    free(rc_bin);
+    return 0;
+}
+
+// Frame of a position of the residues
+static inline int protein_frame(const protein_db_t* db, const uint64_t pos){
+    int f = 0;
+    while (pos >= db->frame_start[f + 1])
+        f++;
+    return f;
+}
+
+
+
+/***************************************/
+/*************** INDEX *****************/
+/***************************************/
+
+/**
+ * Calls visit on each seed of a chain of residues.
+ *
+ * The code of a seed is its k letters in base nb_letters, updated at each residue; the residues out of
+ * the alphabet (stops, X...) end the seeds.
+ */
+#define PROTEIN_SEEDS(db, chain, length, visit)                                 \
+    do {                                                                        \
+        uint32_t code_ = 0;                                                     \
+        int run_ = 0;                                                           \
+        for (uint64_t p_ = 0; p_ < (length); p_++) {                            \
+            int letter_ = (db)->letters[(unsigned char)(chain)[p_]];            \
+            if (letter_ < 0) {                                                  \
+                run_ = 0;                                                       \
+                continue;                                                       \
+            }                                                                   \
+            code_ = (code_ * nb_letters + letter_) % (db)->nb_codes;            \
+            if (++run_ >= (db)->k)                                              \
+                visit(code_, p_ + 1 - (db)->k);                                 \
+        }                                                                       \
+    } while (0)
+
+/**
+ * Translates a genome in its six frames and indexes the protein k-mers (seeds) of the frames.
+ *
+ * in : seq_bin : genome in binary array format
+ * in : nb_bases : bases of the genome
+ * in : table_id : genetic code (see generating_amino_acid_chain_table), with '*' stops (not 0)
+ * in : k : residues of a seed, from 1 to PROTEIN_MAX_K
+ * in : reduced : 1 for seeds on 10 groups of amino acids (more sensitive), 0 on the 20 amino acids
+ * out : db : frames and seeds, to free with protein_db_free
+ * out : int : 0, -1 on error
+ *
+ * The seeds are counted then placed (counting sort), so that the positions of a seed are contiguous.
+ */
+int indexing_proteins(const long int* seq_bin, const uint64_t nb_bases, const int table_id, const int k,
+                      const int reduced, protein_db_t* db){
+    memset(db, 0, sizeof(*db));
+    if (!seq_bin)
+        return printf("ERROR: indexing_proteins: undefined sequence\n"), -1;
+    if (nb_bases >= INT_MAX / 2)
+        return printf("ERROR: indexing_proteins: genome too long\n"), -1;
+    if (!table_id || !codon_table_name(table_id))
+        return printf("ERROR: indexing_proteins: unknown translation table %d\n", table_id), -1;
+
+    // Alphabet of the seeds
+    memset(db->letters, -1, sizeof(db->letters));
+    int nb_letters = 0;
+    for (const char* c = protein_alphabets[!!reduced]; *c; c++) {
+        if (*c == ' ')
+            nb_letters++;
+        else
+            db->letters[(unsigned char)*c] = db->letters[(unsigned char)(*c - 'A' + 'a')] = nb_letters;
+    }
+    nb_letters++;
+    uint64_t nb_codes = 1;
+    for (int i = 0; i < k && nb_codes <= PROTEIN_MAX_CODES; i++)
+        nb_codes *= nb_letters;
+    if (k < 1 || k > PROTEIN_MAX_K || nb_codes > PROTEIN_MAX_CODES)
+        return printf("ERROR: indexing_proteins: invalid seed length %d\n", k), -1;
+    db->nb_bases = nb_bases;
+    db->k = k;
+    db->reduced = !!reduced;
+    db->nb_codes = nb_codes;
+
+    if (protein_translating(db, seq_bin, table_id))
+        return protein_db_free(db), -1;
+
+    db->offsets = calloc(nb_codes + 1, sizeof(*db->offsets));
+    if (!db->offsets)
+        return protein_db_free(db), printf("ERROR: indexing_proteins: cannot allocate memory\n"), -1;
+    uint64_t length = db->frame_start[6];
+#define PROTEIN_COUNT(code, pos) db->offsets[(code) + 1]++
+    PROTEIN_SEEDS(db, db->residues, length, PROTEIN_COUNT);
+#undef PROTEIN_COUNT
+    for (uint64_t c = 0; c < nb_codes; c++)
+        db->offsets[c + 1] += db->offsets[c];
+
+    if (!(db->positions = malloc((db->offsets[nb_codes] + 1) * sizeof(*db->positions))))
+        return protein_db_free(db), printf("ERROR: indexing_proteins: cannot allocate memory\n"), -1;
+    // Each seed placed after the previous ones of its code, offsets[c] then being the end of the code c
+#define PROTEIN_PLACE(code, pos) db->positions[db->offsets[code]++] = (pos)
+    PROTEIN_SEEDS(db, db->residues, length, PROTEIN_PLACE);
+#undef PROTEIN_PLACE
+    memmove(db->offsets + 1, db->offsets, nb_codes * sizeof(*db->offsets));
+    db->offsets[0] = 0;
+    return 0;
+}
+
+void protein_db_free(protein_db_t* db){
+    free(db->residues);
+    free(db->offsets);
+    free(db->positions);
+    memset(db, 0, sizeof(*db));
+}
+
+
+
+/***************************************/
+/*************** SEARCH ****************/
+/***************************************/
+
+typedef struct protein_search_s {
+    const protein_db_t* db;
+    const char* const* queries;
+    const int8_t* matrix;
+    int min_score;
+    int x_drop;
+
+    //Hits of each query, and error of a thread
+    protein_hit_t** hits;
+    uint64_t* nb_hits;
+    int error;
+}protein_search_t;
+
+// Higher scores first, then by frame and position
+static int protein_hit_cmp(const void* a, const void* b){
+    const protein_hit_t* x = a;
+    const protein_hit_t* y = b;
+    if (x->score != y->score)
+        return x->score < y->score ? 1 : -1;
+    if (x->frame != y->frame)
+        return x->frame - y->frame;
+    if (x->subject_start != y->subject_start)
+        return x->subject_start < y->subject_start ? -1 : 1;
+    return (x->query_start > y->query_start) - (x->query_start < y->query_start);
+}
+
+static int protein_seed_cmp(const void* a, const void* b){
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * Ungapped extension of a seed, in both directions, until the score drops x_drop below its best.
+ *
+ * in : query, q : query and first residue of the seed in the query
+ * in : subject, s : residues of a frame and first residue of the seed in the frame
+ * out : hit : query_start, subject_start, length and score of the best extension
+ */
+static void protein_extending(const protein_search_t* job, const char* query, const uint32_t query_length,
+                              uint32_t q, const char* subject, const uint32_t subject_length, uint32_t s,
+                              protein_hit_t* hit){
+    const int8_t* matrix = job->matrix;
+    const int k = job->db->k;
+#define PROTEIN_SCORE(a, b) matrix[substitution_code(a) * SUBSTITUTION_SIZE + substitution_code(b)]
+    int score = 0;
+    for (int i = 0; i < k; i++)
+        score += PROTEIN_SCORE(query[q + i], subject[s + i]);
+
+    // Right, from the end of the seed
+    int best = score, right = k;
+    for (uint32_t i = k; q + i < query_length && s + i < subject_length; i++) {
+        score += PROTEIN_SCORE(query[q + i], subject[s + i]);
+        if (score > best) {
+            best = score;
+            right = i + 1;
+        } else if (score < best - job->x_drop)
+            break;
+    }
+
+    // Left, from the start of the seed
+    score = best;
+    uint32_t left = 0;
+    for (uint32_t i = 1; i <= q && i <= s; i++) {
+        score += PROTEIN_SCORE(query[q - i], subject[s - i]);
+        if (score > best) {
+            best = score;
+            left = i;
+        } else if (score < best - job->x_drop)
+            break;
+    }
+#undef PROTEIN_SCORE
+
+    hit->query_start = q - left;
+    hit->subject_start = s - left;
+    hit->length = left + right;
+    hit->score = best;
+}
+
+/**
+ * Hits of a batch of queries (thread pool task).
+ *
+ * The seeds of a query found in the index are sorted by diagonal (position in the frames - position in
+ * the query), then by position in the query, and each seed is extended unless an extension on its
+ * diagonal already covers it.
+ */
+static void protein_search_task(void* arg, const unsigned long long begin, const unsigned long long end,
+                                const unsigned thread_id){
+    protein_search_t* job = arg;
+    const protein_db_t* db = job->db;
+    const int nb_letters = db->reduced ? 10 : 20;
+    uint64_t* seeds = NULL;
+    uint64_t capacity = 0;
+
+    for (unsigned long long i = begin; i < end && !job->error; i++) {
+        const char* query = job->queries[i];
+        uint64_t query_length = strlen(query);
+        if (query_length >= UINT32_MAX) {
+            job->error = 1;
+            break;
+        }
+
+        // Seeds, as (diagonal + query_length) << 32 | position in the query
+        uint64_t nb_seeds = 0;
+#define PROTEIN_COUNT(code, pos) nb_seeds += db->offsets[(code) + 1] - db->offsets[code]
+        PROTEIN_SEEDS(db, query, query_length, PROTEIN_COUNT);
+#undef PROTEIN_COUNT
+        if (nb_seeds > capacity) {
+            free(seeds);
+            capacity = nb_seeds + nb_seeds / 2;
+            if (!(seeds = malloc(capacity * sizeof(*seeds)))) {
+                job->error = 1;
+                break;
+            }
+        }
+        nb_seeds = 0;
+#define PROTEIN_LISTING(code, pos)                                                              \
+        for (uint32_t j = db->offsets[code]; j < db->offsets[(code) + 1]; j++)                  \
+            seeds[nb_seeds++] = (db->positions[j] + query_length - (pos)) << 32 | (pos)
+        PROTEIN_SEEDS(db, query, query_length, PROTEIN_LISTING);
+#undef PROTEIN_LISTING
+        if (nb_seeds)
+            qsort(seeds, nb_seeds, sizeof(*seeds), protein_seed_cmp);
+
+        protein_hit_t* hits = NULL;
+        uint64_t nb_hits = 0, hits_capacity = 0;
+        uint64_t diagonal = UINT64_MAX, covered = 0;
+        for (uint64_t j = 0; j < nb_seeds; j++) {
+            uint32_t q = seeds[j];
+            if (seeds[j] >> 32 == diagonal && q < covered)
+                continue;
+            diagonal = seeds[j] >> 32;
+            uint64_t pos = diagonal - query_length + q;
+            int f = protein_frame(db, pos);
+            const char* subject = db->residues + db->frame_start[f];
+            uint32_t subject_length = db->frame_start[f + 1] - db->frame_start[f] - 1;
+
+            protein_hit_t hit = { .query = i, .frame = f };
+            protein_extending(job, query, query_length, q, subject, subject_length, pos - db->frame_start[f], &hit);
+            covered = hit.query_start + hit.length;
+            if (hit.score < job->min_score)
+                continue;
+            hit.nt_start = f < 3 ? f + 3ULL * hit.subject_start
+                                 : db->nb_bases - (f - 3) - 3ULL * (hit.subject_start + hit.length);
+            if (nb_hits == hits_capacity) {
+                hits_capacity = 2 * hits_capacity + 4;
+                protein_hit_t* tmp = realloc(hits, hits_capacity * sizeof(*hits));
+                if (!tmp) {
+                    job->error = 1;
+                    break;
+                }
+                hits = tmp;
+            }
+            hits[nb_hits++] = hit;
+        }
+        if (nb_hits)
+            qsort(hits, nb_hits, sizeof(*hits), protein_hit_cmp);
+        job->hits[i] = hits;
+        job->nb_hits[i] = nb_hits;
+    }
+    free(seeds);
+}
+
+/**
+ * Hits of query proteins in the six frames of a genome (tblastn-like search).
+ *
+ * in : pool : thread pool running the batches of queries (NULL to run in the calling thread)
+ * in : db : genome indexed by indexing_proteins
+ * in : queries : amino acid chains (one letter codes)
+ * in : nb_queries : number of queries
+ * in : min_score : lowest BLOSUM62 score of a hit
+ * in : x_drop : drop of the score below its best ending an extension
+ * out : hits : hits of the queries, by query then by decreasing score, to free
+ * out : long : number of hits, -1 on error
+ *
+ * Every seed shared by a query and the frames is extended without gaps, with BLOSUM62, and the hits
+ * are the extensions of min_score or more, a single one for seeds on the same stretch of a diagonal.
+ */
+long searching_proteins(thread_pool_t* pool, const protein_db_t* db, const char* const* queries,
+                        const uint64_t nb_queries, const int min_score, const int x_drop, protein_hit_t** hits){
+    *hits = NULL;
+    if (!db || !db->residues || (!queries && nb_queries))
+        return printf("ERROR: searching_proteins: undefined index\n"), -1;
+    if (x_drop < 0)
+        return printf("ERROR: searching_proteins: invalid X-drop\n"), -1;
+    for (uint64_t i = 0; i < nb_queries; i++)
+        if (!queries[i])
+            return printf("ERROR: searching_proteins: undefined query\n"), -1;
+
+    protein_search_t job = { db, queries, substitution_matrix(SUBSTITUTION_BLOSUM62), min_score, x_drop,
+                             calloc(nb_queries + 1, sizeof(*job.hits)), calloc(nb_queries + 1, sizeof(*job.nb_hits)),
+                             0 };
+    long nb_hits = -1;
+    if (!job.hits || !job.nb_hits) {
+        printf("ERROR: searching_proteins: cannot allocate memory\n");
+        goto end;
+    }
+    if (pool)
+        thread_pool_run_dynamic(pool, nb_queries, PROTEIN_BATCH, protein_search_task, &job);
+    else
+        protein_search_task(&job, 0, nb_queries, 0);
+    if (job.error) {
+        printf("ERROR: searching_proteins: cannot allocate memory\n");
+        goto end;
+    }
+
+    uint64_t total = 0;
+    for (uint64_t i = 0; i < nb_queries; i++)
+        total += job.nb_hits[i];
+    if (!(*hits = malloc((total + 1) * sizeof(**hits)))) {
+        printf("ERROR: searching_proteins: cannot allocate memory\n");
+        goto end;
+    }
+    total = 0;
+    for (uint64_t i = 0; i < nb_queries; i++) {
+        if (job.nb_hits[i])
+            memcpy(*hits + total, job.hits[i], job.nb_hits[i] * sizeof(**hits));
+        total += job.nb_hits[i];
+    }
+    nb_hits = total;
+
+end:
+    for (uint64_t i = 0; job.hits && i < nb_queries; i++)
+        free(job.hits[i]);
+    free(job.hits);
+    free(job.nb_hits);
+    return nb_hits;
+}
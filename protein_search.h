@@ -0,0 +1,64 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "gene_bin.h"
+#include "substitution_matrix.h"
+#include "thread_pool.h"
+
+// Longest seeds, and most distinct seeds of the index
+#define PROTEIN_MAX_K 8
+#define PROTEIN_MAX_CODES (1u << 24)
+// Queries searched at once by a thread
+#define PROTEIN_BATCH 4
+
+typedef struct protein_db_s {
+
+    //Bases of the genome
+    uint64_t nb_bases;
+
+    //Residues of the frames 0 to 2 (from the bases 0, 1 and 2 of the genome) and 3 to 5 (from the bases 0, 1 and 2
+    //of its reverse complement), each ended by a '\0': the frame f starts at residues[frame_start[f]]
+    char* residues;
+    uint64_t frame_start[7];
+
+    //Residues of a seed, and letter of each residue in the seeds (-1 for the residues out of the alphabet),
+    //among 20 amino acids or 10 groups of amino acids for the reduced alphabet
+    int k;
+    int reduced;
+    int8_t letters[256];
+
+    //Positions in residues of the seeds of code c: positions[offsets[c]] to positions[offsets[c + 1] - 1]
+    uint32_t nb_codes;
+    uint32_t* offsets;
+    uint32_t* positions;
+
+}protein_db_t;
+
+typedef struct protein_hit_s {
+
+    //Query, and frame of the genome (0 to 2 forward, 3 to 5 reverse)
+    uint32_t query;
+    int frame;
+
+    //First residue of the hit in the query and in the frame, and residues of the hit
+    uint32_t query_start;
+    uint32_t subject_start;
+    uint32_t length;
+
+    //Ungapped score of the hit (BLOSUM62)
+    int score;
+
+    //First base of the hit on the forward strand (the hit covers 3 * length bases)
+    uint64_t nt_start;
+
+}protein_hit_t;
+
+
+/******** PROTEIN SEARCH FUNCTION *********/
+
+int indexing_proteins(const long int* seq_bin, const uint64_t nb_bases, const int table_id, const int k,
+                      const int reduced, protein_db_t* db);
+void protein_db_free(protein_db_t* db);
+long searching_proteins(thread_pool_t* pool, const protein_db_t* db, const char* const* queries,
+                        const uint64_t nb_queries, const int min_score, const int x_drop, protein_hit_t** hits);
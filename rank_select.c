@@ -0,0 +1,244 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "rank_select.h"
+
+// Counts of G and C together, after those of A, C, G and T
+#define RANK_SELECT_GC 4
+
+
+/***************************************/
+/*************** BLOCKS ****************/
+/***************************************/
+
+// Index of a base in the counts (A, C, G, T), -1 for the other letters
+static inline int rank_select_letter(const char base){
+    switch (base) {
+        case 'A': case 'a': return 0;
+        case 'C': case 'c': return 1;
+        case 'G': case 'g': return 2;
+        case 'T': case 't': case 'U': case 'u': return 3;
+        default: return -1;
+    }
+}
+
+// Bases of a block equal to a letter (or G and C), A, G, C and T being 00, 01, 10 and 11
+static inline uint64_t rank_select_plane(const uint64_t* bits, const int letter){
+    switch (letter) {
+        case 0: return ~bits[0] & ~bits[1];
+        case 1: return bits[0] & ~bits[1];
+        case 2: return ~bits[0] & bits[1];
+        case 3: return bits[0] & bits[1];
+        default: return bits[0] ^ bits[1];
+    }
+}
+
+static inline uint64_t rank_select_before(const rank_select_superblock_t* superblock, const int block,
+                                          const int letter){
+    if (letter == RANK_SELECT_GC)
+        return superblock->counts[1] + superblock->counts[2]
+               + (block ? superblock->blocks[block - 1][1] + superblock->blocks[block - 1][2] : 0);
+    return superblock->counts[letter] + (block ? superblock->blocks[block - 1][letter] : 0);
+}
+
+// Number of a letter (or of G and C) before a position
+static inline uint64_t rank_select_ranking(const rank_select_t* index, const int letter, uint64_t pos){
+    if (pos > index->nb_bases)
+        pos = index->nb_bases;
+    uint64_t s = pos / RANK_SELECT_SUPERBLOCK;
+    int block = pos % RANK_SELECT_SUPERBLOCK / RANK_SELECT_BLOCK, rest = pos % RANK_SELECT_BLOCK;
+    uint64_t count = rank_select_before(&index->superblocks[s], block, letter);
+    if (rest) {
+        const uint64_t* bits = index->bits + 2 * (s * RANK_SELECT_BLOCKS + block);
+        count += __builtin_popcountll(rank_select_plane(bits, letter) & ((1ULL << rest) - 1));
+    }
+    return count;
+}
+
+// Position of the bit k (from 0) set in a word
+static inline int rank_select_bit(uint64_t x, unsigned k){
+    int pos = 0;
+    for (unsigned n; k >= (n = __builtin_popcountll(x & 0xFF)); x >>= 8, pos += 8)
+        k -= n;
+    for (; k; k--)
+        x &= x - 1;
+    return pos + __builtin_ctzll(x);
+}
+
+
+
+/***************************************/
+/*************** INDEX *****************/
+/***************************************/
+
+/**
+ * Rank and select index of a sequence.
+ *
+ * in : seq_bin : sequence in binary array format
+ * in : nb_bases : bases of the sequence
+ * out : index : counts of the bases and bits of the sequence, to free with rank_select_free
+ * out : int : 0, -1 on error
+ *
+ * Each superblock of RANK_SELECT_SUPERBLOCK bases holds, in one cache line, the A, C, G and T
+ * before it and before each of its blocks: the number of a base before a position is these counts
+ * and the popcount of the bits of one block. The index takes about 1.6 times the binary array.
+ */
+int rank_select_init(rank_select_t* index, const long int* seq_bin, const uint64_t nb_bases){
+    memset(index, 0, sizeof(*index));
+    if (!seq_bin)
+        return printf("ERROR: rank_select_init: undefined sequence\n"), -1;
+    if (nb_bases >= INT_MAX / 2)
+        return printf("ERROR: rank_select_init: sequence too long\n"), -1;
+
+    index->nb_bases = nb_bases;
+    index->nb_superblocks = nb_bases / RANK_SELECT_SUPERBLOCK + 1;
+    uint64_t nb_blocks = index->nb_superblocks * RANK_SELECT_BLOCKS;
+    void* superblocks = NULL;
+    if (posix_memalign(&superblocks, 64, index->nb_superblocks * sizeof(*index->superblocks)))
+        superblocks = NULL;
+    index->superblocks = superblocks;
+    index->bits = calloc(2 * nb_blocks, sizeof(*index->bits));
+    if (!index->superblocks || !index->bits)
+        return rank_select_free(index), printf("ERROR: rank_select_init: cannot allocate memory\n"), -1;
+
+    const long int nb_words = binary_array_size(2 * nb_bases);
+    uint32_t total[4] = { 0 };
+    for (uint64_t b = 0; b < nb_blocks; b++) {
+        rank_select_superblock_t* superblock = &index->superblocks[b / RANK_SELECT_BLOCKS];
+        int block = b % RANK_SELECT_BLOCKS;
+        for (int letter = 0; letter < 4; letter++) {
+            if (!block)
+                superblock->counts[letter] = total[letter];
+            else
+                superblock->blocks[block - 1][letter] = total[letter] - superblock->counts[letter];
+        }
+
+        uint64_t base = b * RANK_SELECT_BLOCK;
+        if (base >= nb_bases)
+            continue;
+        uint64_t* bits = index->bits + 2 * b;
+        get_bases_binary_array(seq_bin, nb_words, base, (unsigned long long*)bits);
+        uint64_t valid = nb_bases - base < 64 ? (1ULL << (nb_bases - base)) - 1 : UINT64_MAX;
+        for (int letter = 0; letter < 4; letter++)
+            total[letter] += __builtin_popcountll(rank_select_plane(bits, letter) & valid);
+    }
+
+    // Superblock of every RANK_SELECT_SAMPLE occurrences of each base
+    for (int letter = 0; letter < 4; letter++) {
+        uint64_t nb_samples = total[letter] / RANK_SELECT_SAMPLE + 1;
+        if (!(index->samples[letter] = malloc(nb_samples * sizeof(*index->samples[letter]))))
+            return rank_select_free(index), printf("ERROR: rank_select_init: cannot allocate memory\n"), -1;
+        uint64_t s = 0;
+        for (uint64_t j = 0; j < nb_samples; j++) {
+            while (s + 1 < index->nb_superblocks && index->superblocks[s + 1].counts[letter] <= j * RANK_SELECT_SAMPLE)
+                s++;
+            index->samples[letter][j] = s;
+        }
+    }
+    return 0;
+}
+
+void rank_select_free(rank_select_t* index){
+    free(index->superblocks);
+    free(index->bits);
+    for (int letter = 0; letter < 4; letter++)
+        free(index->samples[letter]);
+    memset(index, 0, sizeof(*index));
+}
+
+
+
+/***************************************/
+/*************** QUERIES ***************/
+/***************************************/
+
+/**
+ * Number of a base before a position.
+ *
+ * in : index : rank and select index of a sequence
+ * in : base : A, C, G or T (U for T, in upper or lower case)
+ * in : pos : position, the end of the sequence after it
+ * out : uint64_t : bases equal to base in [0, pos), 0 for the other letters
+ */
+uint64_t rank_select_rank(const rank_select_t* index, const char base, const uint64_t pos){
+    int letter = rank_select_letter(base);
+    return letter < 0 ? 0 : rank_select_ranking(index, letter, pos);
+}
+
+// Number of a base in [start, end)
+uint64_t rank_select_count(const rank_select_t* index, const char base, const uint64_t start, const uint64_t end){
+    int letter = rank_select_letter(base);
+    if (letter < 0 || start >= end)
+        return 0;
+    return rank_select_ranking(index, letter, end) - rank_select_ranking(index, letter, start);
+}
+
+// Number of G and C in [start, end)
+uint64_t rank_select_gc(const rank_select_t* index, const uint64_t start, const uint64_t end){
+    if (start >= end)
+        return 0;
+    return rank_select_ranking(index, RANK_SELECT_GC, end) - rank_select_ranking(index, RANK_SELECT_GC, start);
+}
+
+/**
+ * Position of an occurrence of a base.
+ *
+ * in : index : rank and select index of a sequence
+ * in : base : A, C, G or T (U for T, in upper or lower case)
+ * in : k : occurrence, from 0
+ * out : int64_t : position of the occurrence k of base, -1 if there are not as many
+ *
+ * The samples bound the superblocks of the occurrence, searched by dichotomy (usually one or two),
+ * then the counts of the blocks give its block, and its word gives its position.
+ */
+int64_t rank_select_select(const rank_select_t* index, const char base, const uint64_t k){
+    int letter = rank_select_letter(base);
+    if (letter < 0)
+        return -1;
+    uint64_t total = rank_select_ranking(index, letter, index->nb_bases);
+    if (k >= total)
+        return -1;
+
+    uint64_t j = k / RANK_SELECT_SAMPLE;
+    uint64_t low = index->samples[letter][j];
+    uint64_t high = j + 1 <= total / RANK_SELECT_SAMPLE ? index->samples[letter][j + 1] : index->nb_superblocks - 1;
+    // Last superblock with at most k occurrences before it
+    while (low < high) {
+        uint64_t mid = (low + high + 1) / 2;
+        if (index->superblocks[mid].counts[letter] <= k)
+            low = mid;
+        else
+            high = mid - 1;
+    }
+
+    const rank_select_superblock_t* superblock = &index->superblocks[low];
+    int block = RANK_SELECT_BLOCKS - 1;
+    while (block && rank_select_before(superblock, block, letter) > k)
+        block--;
+    uint64_t b = low * RANK_SELECT_BLOCKS + block;
+    uint64_t plane = rank_select_plane(index->bits + 2 * b, letter);
+    return b * RANK_SELECT_BLOCK + rank_select_bit(plane, k - rank_select_before(superblock, block, letter));
+}
+
+/**
+ * GC content of the windows of a sequence.
+ *
+ * in : index : rank and select index of a sequence
+ * in : window, step : bases of a window, and between the starts of two windows
+ * out : gc : percentage of G and C of the window i, from the base i * step
+ * out : long : number of windows, -1 on error
+ */
+long rank_select_gc_windows(const rank_select_t* index, const uint64_t window, const uint64_t step, float* gc){
+    if (!index || !gc || !window || !step)
+        return printf("ERROR: rank_select_gc_windows: invalid window\n"), -1;
+    if (index->nb_bases < window)
+        return 0;
+
+    long nb_windows = (index->nb_bases - window) / step + 1;
+    for (long i = 0; i < nb_windows; i++)
+        gc[i] = rank_select_gc(index, i * step, i * step + window) * 100.0 / window;
+    return nb_windows;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "gene_bin.h"
+
+// Bases of a block, counted by a popcount of its bits
+#define RANK_SELECT_BLOCK 64
+// Blocks of a superblock: its counts take one cache line
+#define RANK_SELECT_BLOCKS 7
+#define RANK_SELECT_SUPERBLOCK (RANK_SELECT_BLOCK * RANK_SELECT_BLOCKS)
+// Occurrences of a base between two samples of the select queries
+#define RANK_SELECT_SAMPLE 1024
+
+typedef struct rank_select_superblock_s {
+
+    //A, C, G and T before the superblock
+    uint32_t counts[4];
+
+    //A, C, G and T in the superblock before its blocks 1 to RANK_SELECT_BLOCKS - 1
+    uint16_t blocks[RANK_SELECT_BLOCKS - 1][4];
+
+}__attribute__((aligned(64))) rank_select_superblock_t;
+
+typedef struct rank_select_s {
+
+    //Bases of the sequence
+    uint64_t nb_bases;
+
+    //Counts of each superblock, and one more for the whole sequence
+    uint64_t nb_superblocks;
+    rank_select_superblock_t* superblocks;
+
+    //First and second bits of the bases of each block (get_bases_binary_array)
+    uint64_t* bits;
+
+    //Superblock of the occurrences 0, RANK_SELECT_SAMPLE, 2 RANK_SELECT_SAMPLE... of A, C, G and T
+    uint32_t* samples[4];
+
+}rank_select_t;
+
+
+/******** RANK SELECT FUNCTION *********/
+
+int rank_select_init(rank_select_t* index, const long int* seq_bin, const uint64_t nb_bases);
+uint64_t rank_select_rank(const rank_select_t* index, const char base, const uint64_t pos);
+uint64_t rank_select_count(const rank_select_t* index, const char base, const uint64_t start, const uint64_t end);
+uint64_t rank_select_gc(const rank_select_t* index, const uint64_t start, const uint64_t end);
+int64_t rank_select_select(const rank_select_t* index, const char base, const uint64_t k);
+long rank_select_gc_windows(const rank_select_t* index, const uint64_t window, const uint64_t step, float* gc);
+void rank_select_free(rank_select_t* index);
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stdlib.h>
+#include "rdtsc.h"
+
+// Each kernel is timed MAX_SAMPLES times over MAX_LOOP / MAX_SAMPLES calls, the median sample is reported
+#define MAX_SAMPLES 25
+
+static int compare_cycles(const void *a, const void *b)
+{
+	double x = *(const double *)a, y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+
+static double median_cycles(double *samples, const int nb_samples)
+{
+	qsort(samples, nb_samples, sizeof(*samples), compare_cycles);
+	if (nb_samples % 2)
+		return samples[nb_samples / 2];
+	return (samples[nb_samples / 2 - 1] + samples[nb_samples / 2]) / 2;
+}
+
+// Median cycles per call of the statement given after result (a context switch only spoils one sample)
+#define BENCH(result, ...) do { \
+	double samples_[MAX_SAMPLES]; \
+	for (int s_ = 0; s_ < MAX_SAMPLES; s_++) { \
+		unsigned long long before_ = rdtsc(); \
+		for (int i = 0; i < MAX_LOOP / MAX_SAMPLES; i++) { \
+			__VA_ARGS__; \
+		} \
+		samples_[s_] = (double)(rdtsc() - before_) / (MAX_LOOP / MAX_SAMPLES); \
+	} \
+	result = median_cycles(samples_, MAX_SAMPLES); \
+} while (0)
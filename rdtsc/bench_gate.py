@@ -0,0 +1,190 @@
+"""
+Benchmark regression gate of the naive (gene.c) and binary (gene_bin.c) libraries.
+
+Usage: python3 bench_gate.py [--nobin ./gcc_nobin] [--bin ./gcc_bin] [--runs 3]
+                             [--tolerance 10] [--baseline FILE] [--update]
+
+Runs both benchmarks, takes the median cycles of each kernel over the runs and their spread
+(median absolute deviation, in percent of the median), and compares them with the baseline of the CPU model
+(baselines/<cpu model>.tsv). Prints the comparison and the speedup of the binary library over
+the naive one. A kernel fails when it is slower than its baseline by more than --tolerance
+percent and by more than SPREAD_FACTOR times the spreads of the baseline and of the current
+runs, so that a noisy kernel does not fail on an unchanged tree. The libraries with a failing
+kernel are measured again over UPDATE_RUNS runs, and only the kernels still slower on this second
+measure fail. --update writes the baseline instead, over UPDATE_RUNS runs by default: record it on
+a quiet machine.
+"""
+import argparse
+import os
+import platform
+import re
+import statistics
+import subprocess
+import sys
+
+BENCH_DIR = os.path.dirname(os.path.abspath(__file__))
+BASELINE_DIR = os.path.join(BENCH_DIR, "baselines")
+
+# Kernel lines of the benchmark tables: "detecting_genes\t\t    : 685677.118"
+KERNEL_LINE = re.compile(r"^(\w+)\s*:\s*([0-9.]+)\s*$")
+# Slowdown allowed, in spreads of the baseline and current runs
+SPREAD_FACTOR = 3
+# Runs of each benchmark for a baseline, and to confirm a regression
+UPDATE_RUNS = 15
+
+
+def cpu_model():
+    try:
+        with open("/proc/cpuinfo") as f:
+            for line in f:
+                if line.startswith("model name"):
+                    return line.split(":", 1)[1].strip()
+    except OSError:
+        pass
+    return platform.processor() or platform.machine()
+
+
+def baseline_path(model):
+    name = re.sub(r"[^0-9a-z]+", "_", model.lower()).strip("_")
+    return os.path.join(BASELINE_DIR, name + ".tsv")
+
+
+def running(binaries, runs):
+    """Median cycles of each kernel of the benchmarks over several runs, and their spread in percent.
+
+    The benchmarks run in turn at each run, so that a slower period of the machine weighs on all of them."""
+    samples = {}
+    for _ in range(runs):
+        for library, binary in binaries.items():
+            # The benchmarks read their FASTA files from the rdtsc directory
+            out = subprocess.run([binary], cwd = BENCH_DIR, stdout = subprocess.PIPE,
+                                 universal_newlines = True, check = True).stdout
+            for line in out.splitlines():
+                match = KERNEL_LINE.match(line)
+                if match:
+                    samples.setdefault((library, match.group(1)), []).append(float(match.group(2)))
+    results = {}
+    for key, values in samples.items():
+        median = statistics.median(values)
+        deviation = statistics.median(abs(value - median) for value in values)
+        results[key] = (median, deviation * 100 / median if median else 0)
+    return results
+
+
+def reading_baseline(path):
+    baseline = {}
+    with open(path) as f:
+        for line in f:
+            if line.startswith("#") or not line.strip():
+                continue
+            fields = line.rstrip("\n").split("\t")
+            # Baselines without spread: the tolerance only
+            spread = float(fields[3]) if len(fields) > 3 else 0
+            baseline[(fields[0], fields[1])] = (float(fields[2]), spread)
+    return baseline
+
+
+def allowing(baseline, tolerance, library, kernel, cycles, spread):
+    """Change in percent of a kernel from its baseline, and the slowdown allowed."""
+    base, base_spread = baseline[(library, kernel)]
+    change = (cycles - base) * 100 / base if base else 0
+    return change, max(tolerance, SPREAD_FACTOR * (base_spread + spread))
+
+
+def writing_baseline(path, model, runs, results):
+    os.makedirs(os.path.dirname(path), exist_ok = True)
+    with open(path, "w") as f:
+        f.write("# %s, %d runs\n# library\tkernel\tmedian cycles\tspread (%%)\n" % (model, runs))
+        for (library, kernel), (cycles, spread) in results.items():
+            f.write("%s\t%s\t%.1f\t%.1f\n" % (library, kernel, cycles, spread))
+
+
+def printing_speedups(results, baseline):
+    print("\nSpeedup of the binary library (naive / binary cycles)")
+    print("%-28s %10s %10s" % ("kernel", "baseline", "current"))
+    for (library, kernel), (cycles, _) in results.items():
+        if library != "binary" or ("naive", kernel) not in results:
+            continue
+        current = results[("naive", kernel)][0] / cycles
+        base = "-"
+        if ("naive", kernel) in baseline and ("binary", kernel) in baseline:
+            base = "%.2fx" % (baseline[("naive", kernel)][0] / baseline[("binary", kernel)][0])
+        print("%-28s %10s %10s" % (kernel, base, "%.2fx" % current))
+
+
+def main():
+    parser = argparse.ArgumentParser(description = "Benchmark regression gate")
+    parser.add_argument("--nobin", default = "./gcc_nobin", help = "benchmark of the naive library")
+    parser.add_argument("--bin", default = "./gcc_bin", help = "benchmark of the binary library")
+    parser.add_argument("--runs", type = int, help = "runs of each benchmark (default: 3, %d with --update)" % UPDATE_RUNS)
+    parser.add_argument("--tolerance", type = float, default = 10, help = "slowdown allowed, in percent")
+    parser.add_argument("--baseline", help = "baseline file (default: baselines/<cpu model>.tsv)")
+    parser.add_argument("--update", action = "store_true", help = "write the baseline")
+    args = parser.parse_args()
+
+    model = cpu_model()
+    path = args.baseline or baseline_path(model)
+    runs = args.runs or (UPDATE_RUNS if args.update else 3)
+
+    binaries = {"naive": args.nobin, "binary": args.bin}
+    results = running(binaries, runs)
+
+    if args.update:
+        writing_baseline(path, model, runs, results)
+        print("Baseline written to " + os.path.relpath(path))
+        return 0
+
+    baseline = {}
+    if os.path.exists(path):
+        baseline = reading_baseline(path)
+    else:
+        print("No baseline for " + model + " (" + os.path.relpath(path) + "), run with --update to write it")
+
+    # Measure again the libraries with a regression, to tell it from a noisy run
+    suspects = []
+    for (library, kernel), (cycles, spread) in results.items():
+        if (library, kernel) in baseline:
+            change, allowed = allowing(baseline, args.tolerance, library, kernel, cycles, spread)
+            if change > allowed:
+                suspects.append((library, kernel))
+    if suspects:
+        libraries = sorted(set(library for library, _ in suspects))
+        print("Measuring the %s library again over %d runs" % (" and ".join(libraries), UPDATE_RUNS))
+        again = running({library: binaries[library] for library in libraries}, UPDATE_RUNS)
+        for key in suspects:
+            results[key] = again[key]
+
+    print("CPU: %s, runs: %d, tolerance: %.1f%% or %d x the spreads\n" % (model, runs, args.tolerance, SPREAD_FACTOR))
+    print("%-7s %-28s %14s %7s %14s %7s %9s %9s  %s" % ("library", "kernel", "baseline", "spread", "current", "spread",
+                                                       "change", "allowed", "status"))
+    regressions = 0
+    for (library, kernel), (cycles, spread) in results.items():
+        if (library, kernel) not in baseline:
+            print("%-7s %-28s %14s %7s %14.1f %6.1f%% %9s %9s  %s" % (library, kernel, "-", "-", cycles, spread, "-", "-",
+                                                                      "new"))
+            continue
+        base, base_spread = baseline[(library, kernel)]
+        change, allowed = allowing(baseline, args.tolerance, library, kernel, cycles, spread)
+        status = "ok"
+        if change > allowed:
+            status = "REGRESSION"
+            regressions += 1
+        elif change < -allowed:
+            status = "faster"
+        print("%-7s %-28s %14.1f %6.1f%% %14.1f %6.1f%% %+8.1f%% %8.1f%%  %s" % (library, kernel, base, base_spread, cycles,
+                                                                               spread, change, allowed, status))
+    for library, kernel in baseline:
+        if (library, kernel) not in results:
+            print("%-7s %-28s %14.1f %7s %14s %7s %9s %9s  %s" % (library, kernel, baseline[(library, kernel)][0], "-", "-",
+                                                                  "-", "-", "-", "missing"))
+
+    printing_speedups(results, baseline)
+
+    if regressions:
+        print("\n%d kernel(s) slower than their baseline by more than allowed" % regressions)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -1,6 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
-#include "rdtsc.h"
+#include "bench.h"
 #include "../gene.h"
 #include <string.h>
 
@@ -32,8 +32,6 @@ void load_gene(char *filename, char *seq_char)
 
 int main(int argc, char *argv[])
 {
-	unsigned long long before = 0;
-	unsigned long long after = 0;
 	double elapsed = 0.0;
 
 	char seq_char[MAX] = "";
@@ -76,74 +74,33 @@ int main(int argc, char *argv[])
     	m.end_mut[i]=0;   	
     }
 
-    printf("Naive Functions\t\t    | Cycles\n");
+    printf("Naive Functions\t\t    | Cycles (median)\n");
     printf("-----------------------------------------\n");
 
 	/*-----convert_to_binary-----*/
-    before = rdtsc();
-	for(int i = 0; i < MAX_LOOP; i++)
-	{
-    	seq_short = convert_to_binary(seq_char, 2 * seq_char_size);
-	}
-    after = rdtsc();
-    elapsed = (double)(after - before);
-	printf("convert_to_binary\t    : %.3lf\n", elapsed / MAX_LOOP);
-	elapsed = 0;
+	BENCH(elapsed, seq_short = convert_to_binary(seq_char, 2 * seq_char_size));
+	printf("convert_to_binary\t    : %.3lf\n", elapsed);
 
 	// /*-----generating_mRNA-----*/
-    before = rdtsc();
-	for(int i = 0; i < MAX_LOOP; i++)
-	{
-		rna_seq_short = generating_mRNA(seq_short, 2 * seq_char_size);
-	}
-    after = rdtsc();
-    elapsed = (double)(after - before);
-	printf("generating_mRNA\t\t    : %.3lf\n", elapsed / MAX_LOOP);
-	elapsed = 0;
+	BENCH(elapsed, rna_seq_short = generating_mRNA(seq_short, 2 * seq_char_size));
+	printf("generating_mRNA\t\t    : %.3lf\n", elapsed);
 	
 	// /*-----detecting_genes-----*/
-	before = rdtsc();
-	for(int i = 0; i < MAX_LOOP; i++)
-	{
-		detecting_genes(seq_long, 2 * seq_char_size, &g);
-	}
-	after = rdtsc();
-	elapsed = (double)(after - before);
-	printf("detecting_genes\t\t    : %.3lf\n", elapsed / MAX_LOOP);
-	elapsed = 0;
+	BENCH(elapsed, detecting_genes(seq_long, 2 * seq_char_size, &g));
+	printf("detecting_genes\t\t    : %.3lf\n", elapsed);
 	
 	// /*-----generating_amino_acid_chain-----*/
-    before = rdtsc();
-	for(int i = 0; i < MAX_LOOP; i++)
-	{
-		aa_seq_short = generating_amino_acid_chain(seq_short, 2 * seq_char_size);
-	}
-    after = rdtsc();
-    elapsed = (double)(after - before);
-	printf("generating_amino_acid_chain : %.3lf\n", elapsed / MAX_LOOP);
-	elapsed = 0;
+	// Whole codons only, the translation of a length that is not a multiple of 3 bases fails at once
+	BENCH(elapsed, aa_seq_short = generating_amino_acid_chain(seq_short, 2 * seq_char_size - 2 * seq_char_size % 6));
+	printf("generating_amino_acid_chain : %.3lf\n", elapsed);
 
 	// /*-----detecting_mutations-----*/
-    before = rdtsc();
-	for(int i = 0; i < MAX_LOOP; i++)
-	{
-    	detecting_mutations(seq_short, 2 * seq_char_size, m);;
-	}
-    after = rdtsc();
-    elapsed = (double)(after - before);
-	printf("detecting_mutations\t    : %.3lf\n", elapsed / MAX_LOOP);
-	elapsed = 0;
+	BENCH(elapsed, detecting_mutations(seq_short, 2 * seq_char_size, m));
+	printf("detecting_mutations\t    : %.3lf\n", elapsed);
 
 	// /*-----calculating_matching_score-----*/
-    before = rdtsc();
-	for(int i = 0; i < MAX_LOOP; i++)
-	{
-		cms = calculating_matching_score(seq_short, 2 * seq_char_size, seq_short2, 2 * seq_char_size2);
-	}
-    after = rdtsc();
-    elapsed = (double)(after - before);
-	printf("calculating_matching_score  : %.3lf\n", elapsed / MAX_LOOP);
-	elapsed = 0;
+	BENCH(elapsed, cms = calculating_matching_score(seq_short, 2 * seq_char_size, seq_short2, 2 * seq_char_size2));
+	printf("calculating_matching_score  : %.3lf\n", elapsed);
 
 	printf("\n");
 
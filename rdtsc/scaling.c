@@ -0,0 +1,347 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "../gene_bin.h"
+#include "../arena.h"
+#include "../genome_gen.h"
+#include "../thread_pool.h"
+
+// Number of genes of a genome compared two by two
+#define MAX_PAIR_GENES 32
+
+enum stage_e {
+	STAGE_CONVERT,
+	STAGE_GENES,
+	STAGE_TRANSLATE,
+	STAGE_MUTATIONS,
+	STAGE_SCORES,
+	NB_STAGES
+};
+
+static const char *stage_names[NB_STAGES] = { "convert", "genes", "translate", "mutations", "scores" };
+
+typedef struct scaling_s {
+	char **genomes;
+	unsigned long long length;
+	// Time spent in each stage, per thread (one cache line per thread)
+	double (*stage_time)[8];
+} scaling_t;
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Full analysis of one genome, as main_bin.py does it:
+ * convert -> detect genes -> mRNA and protein of each gene -> mutations of each gene -> scores between genes.
+ */
+static void analyse_genome(const char *seq_char, const unsigned long long length, double *stage_time)
+{
+	long int bin_size = 2 * length;
+	double t0 = now();
+
+	long int *seq_bin = convert_to_binary(seq_char, length);
+	double t1 = now();
+
+	gene_map_t g;
+	g.gene_start = malloc(sizeof(*g.gene_start) * (bin_size / 12 + 1));
+	g.gene_end = malloc(sizeof(*g.gene_end) * (bin_size / 12 + 1));
+	detecting_genes(seq_bin, bin_size, &g);
+	double t2 = now();
+
+	// The mRNA and proteins are written in the thread arena, reset once the genome is analysed
+	arena_t *arena = arena_thread();
+	for (unsigned long long j = 0; j < g.genes_counter; j++) {
+		long start = g.gene_start[j], end = g.gene_end[j];
+		generating_mRNA_into(seq_bin, start, end - start, arena_alloc(arena, (end - start) / 2 + 2));
+		generating_amino_acid_chain_into(seq_bin, start, end - start + 1, arena_alloc(arena, (end - start + 1) / 6 + 1));
+	}
+	double t3 = now();
+
+	mutation_map m;
+	unsigned long sizes[5], starts[5], ends[5];
+	m.size = sizes;
+	m.start_mut = starts;
+	m.end_mut = ends;
+	for (unsigned long long j = 0; j < g.genes_counter; j++) {
+		memset(sizes, 0, sizeof(sizes));
+		detecting_mutations(seq_bin, g.gene_start[j], g.gene_end[j] - g.gene_start[j], m);
+	}
+	double t4 = now();
+
+	unsigned long long nb = g.genes_counter < MAX_PAIR_GENES ? g.genes_counter : MAX_PAIR_GENES;
+	for (unsigned long long j = 0; j < nb; j++)
+		for (unsigned long long k = j + 1; k < nb; k++)
+			calculating_matching_score(seq_bin, g.gene_start[j], g.gene_end[j] - g.gene_start[j] + 1,
+			                           seq_bin, g.gene_start[k], g.gene_end[k] - g.gene_start[k] + 1);
+	double t5 = now();
+
+	stage_time[STAGE_CONVERT] += t1 - t0;
+	stage_time[STAGE_GENES] += t2 - t1;
+	stage_time[STAGE_TRANSLATE] += t3 - t2;
+	stage_time[STAGE_MUTATIONS] += t4 - t3;
+	stage_time[STAGE_SCORES] += t5 - t4;
+
+	arena_reset(arena);
+	free(g.gene_start);
+	free(g.gene_end);
+	free(seq_bin);
+}
+
+static void analyse_task(void *arg, const unsigned long long begin, const unsigned long long end, const unsigned thread_id)
+{
+	scaling_t *s = arg;
+	for (unsigned long long i = begin; i < end; i++)
+		analyse_genome(s->genomes[i], s->length, s->stage_time[thread_id]);
+}
+
+/**
+ * Analyse nb_genomes genomes with nb_threads threads, keep the fastest of the repeats.
+ * stages receives the average time per thread of each stage.
+ */
+static double run(scaling_t *s, const unsigned long nb_genomes, const unsigned nb_threads, const int repeats, double *stages)
+{
+	thread_pool_t *pool = thread_pool_create(nb_threads);
+	double best = -1.0;
+
+	for (int r = 0; r < repeats; r++) {
+		memset(s->stage_time, 0, sizeof(*s->stage_time) * nb_threads);
+
+		double before = now();
+		thread_pool_run_dynamic(pool, nb_genomes, 1, analyse_task, s);
+		double elapsed = now() - before;
+
+		if (best < 0 || elapsed < best) {
+			best = elapsed;
+			for (int st = 0; st < NB_STAGES; st++) {
+				stages[st] = 0.0;
+				for (unsigned t = 0; t < nb_threads; t++)
+					stages[st] += s->stage_time[t][st];
+				stages[st] /= nb_threads;
+			}
+		}
+	}
+
+	thread_pool_destroy(pool);
+	return best;
+}
+
+/***** Packed collection *****/
+
+// Placements of a packed collection: the malloc one is packed by the calling thread, the others by the scanning threads
+static const struct {
+	const char *name;
+	int flags;
+} policies[] = {
+	{ "malloc", 0 },
+	{ "first touch", ARENA_PAGES },
+	{ "interleave", ARENA_PAGES | ARENA_INTERLEAVE },
+	{ "huge pages", ARENA_HUGE },
+	{ "hugetlb", ARENA_HUGETLB },
+};
+
+typedef struct packed_s {
+	scaling_t *s;
+	long int *seq_bin;
+	// Integers of a genome in the collection
+	long int words;
+} packed_t;
+
+static void pack_task(void *arg, const unsigned long long begin, const unsigned long long end, const unsigned thread_id)
+{
+	packed_t *p = arg;
+	for (unsigned long long i = begin; i < end; i++)
+		set_binary_array_into(p->s->genomes[i], p->s->length, p->seq_bin + i * p->words);
+}
+
+static void scan_task(void *arg, const unsigned long long begin, const unsigned long long end, const unsigned thread_id)
+{
+	packed_t *p = arg;
+	long int bin_size = 2 * p->s->length;
+	gene_map_t g;
+	g.gene_start = malloc(sizeof(*g.gene_start) * (bin_size / 12 + 1));
+	g.gene_end = malloc(sizeof(*g.gene_end) * (bin_size / 12 + 1));
+	for (unsigned long long i = begin; i < end; i++)
+		detecting_genes(p->seq_bin + i * p->words, bin_size, &g);
+	free(g.gene_start);
+	free(g.gene_end);
+}
+
+/**
+ * Scan of nb_genomes genomes packed in one arena of each placement, statically partitioned between nb_threads threads.
+ * The arenas of the page policies are placed by the threads that scan them (first touch), unless interleaved.
+ */
+static void run_packed(scaling_t *s, const unsigned long nb_genomes, const unsigned nb_threads, const int repeats)
+{
+	thread_pool_t *pool = thread_pool_create(nb_threads);
+	packed_t p = { s, NULL, binary_array_size(2 * s->length) };
+	size_t size = sizeof(long int) * p.words * nb_genomes;
+	double base = 0.0;
+
+	printf("Packed collection (%.1f MB, %u threads)\n", size / 1e6, nb_threads);
+	printf("Placement   |   Pack (s) |   Scan (s) | Speedup |\n");
+	printf("------------------------------------------------\n");
+	for (unsigned c = 0; c < sizeof(policies) / sizeof(*policies); c++) {
+		arena_t arena;
+		if (arena_init_pages(&arena, size, policies[c].flags))
+			continue;
+		p.seq_bin = arena_alloc(&arena, size);
+
+		double before = now();
+		if (policies[c].flags && !(policies[c].flags & ARENA_INTERLEAVE))
+			thread_pool_first_touch(pool, p.seq_bin, nb_genomes, p.words * sizeof(long int));
+		if (policies[c].flags)
+			thread_pool_run(pool, nb_genomes, pack_task, &p);
+		else
+			pack_task(&p, 0, nb_genomes, 0);
+		double pack = now() - before;
+
+		double best = -1.0;
+		for (int r = 0; r < repeats; r++) {
+			before = now();
+			thread_pool_run(pool, nb_genomes, scan_task, &p);
+			double elapsed = now() - before;
+			if (best < 0 || elapsed < best)
+				best = elapsed;
+		}
+		if (c == 0)
+			base = best;
+		printf("%-11s | %10.4lf | %10.4lf | %7.2lf |\n", policies[c].name, pack, best, base / best);
+		arena_release(&arena);
+	}
+	printf("\n");
+	thread_pool_destroy(pool);
+}
+
+static void print_header(const char *title)
+{
+	printf("%s\n", title);
+	printf("Threads | Genomes |   Time (s) | Speedup | Efficiency |");
+	for (int st = 0; st < NB_STAGES; st++)
+		printf(" %9s |", stage_names[st]);
+	printf("\n");
+	printf("-------------------------------------------------------------------------------------------------------------\n");
+}
+
+static void print_row(const unsigned nb_threads, const unsigned long nb_genomes, const double elapsed,
+                      const double speedup, const double efficiency, const double *stages)
+{
+	double total = 0.0;
+	for (int st = 0; st < NB_STAGES; st++)
+		total += stages[st];
+
+	printf("%7u | %7lu | %10.4lf | %7.2lf | %9.1lf%% |", nb_threads, nb_genomes, elapsed, speedup, 100.0 * efficiency);
+	for (int st = 0; st < NB_STAGES; st++)
+		printf(" %8.1lf%% |", total > 0.0 ? 100.0 * stages[st] / total : 0.0);
+	printf("\n");
+}
+
+static void usage(const char *name)
+{
+	printf("Usage: %s [-t max_threads] [-n genomes] [-l length] [-r repeats] [-m strong|weak|both|packed|all]\n"
+	       "  strong scaling : n genomes analysed with 1..max_threads threads\n"
+	       "  weak scaling   : n genomes per thread\n"
+	       "  packed         : scan of n genomes packed in one arena, with each page placement (max_threads threads)\n", name);
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned max_threads = thread_pool_default_size();
+	unsigned long nb_genomes = 64;
+	unsigned long long length = 30000;
+	int repeats = 3;
+	int strong = 1, weak = 1, packed = 1;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "t:n:l:r:m:h")) != -1) {
+		switch (opt) {
+		case 't': max_threads = atoi(optarg); break;
+		case 'n': nb_genomes = atol(optarg); break;
+		case 'l': length = atoll(optarg); break;
+		case 'r': repeats = atoi(optarg); break;
+		case 'm':
+			strong = !strcmp(optarg, "strong") || !strcmp(optarg, "both") || !strcmp(optarg, "all");
+			weak = !strcmp(optarg, "weak") || !strcmp(optarg, "both") || !strcmp(optarg, "all");
+			packed = !strcmp(optarg, "packed") || !strcmp(optarg, "all");
+			break;
+		default:
+			usage(argv[0]);
+			return opt == 'h' ? 0 : 1;
+		}
+	}
+	if (!max_threads || !nb_genomes || !length || repeats < 1 || (!strong && !weak && !packed))
+		return usage(argv[0]), 1;
+
+	// Thread counts: powers of two, and max_threads
+	unsigned counts[64];
+	int nb_counts = 0;
+	for (unsigned t = 1; t < max_threads && nb_counts < 63; t *= 2)
+		counts[nb_counts++] = t;
+	counts[nb_counts++] = max_threads;
+
+	// Dataset: one family of mutated genomes with planted genes
+	unsigned long total = weak ? nb_genomes * max_threads : nb_genomes;
+	genome_gen_params_t params;
+	genome_gen_default_params(&params);
+	params.length = length;
+	params.copies = total;
+	params.mutation_rate = 0.01;
+	params.orf_count = length / 1500;
+	params.orf_codons = 300;
+
+	scaling_t s;
+	s.length = length;
+	s.genomes = malloc(sizeof(*s.genomes) * total);
+	s.stage_time = calloc(max_threads, sizeof(*s.stage_time));
+	if (!s.genomes || !s.stage_time)
+		return printf("ERROR: scaling: cannot allocate memory\n"), 1;
+	for (unsigned long i = 0; i < total; i++)
+		if (!(s.genomes[i] = generating_genome(&params, i)))
+			return 1;
+
+	printf("Dataset: %lu genomes of %llu nucleotides, %u threads max, best of %d runs\n\n", total, length, max_threads, repeats);
+
+	double stages[NB_STAGES];
+
+	if (strong) {
+		print_header("Strong scaling (fixed dataset)");
+		double t1 = 0.0;
+		for (int c = 0; c < nb_counts; c++) {
+			double elapsed = run(&s, nb_genomes, counts[c], repeats, stages);
+			if (c == 0)
+				t1 = elapsed;
+			print_row(counts[c], nb_genomes, elapsed, t1 / elapsed, t1 / elapsed / counts[c], stages);
+		}
+		printf("\n");
+	}
+
+	if (weak) {
+		print_header("Weak scaling (dataset grows with the threads)");
+		double t1 = 0.0;
+		for (int c = 0; c < nb_counts; c++) {
+			unsigned long n = nb_genomes * counts[c];
+			double elapsed = run(&s, n, counts[c], repeats, stages);
+			if (c == 0)
+				t1 = elapsed;
+			// Speedup in throughput, efficiency = T1 / TN
+			print_row(counts[c], n, elapsed, t1 * counts[c] / elapsed, t1 / elapsed, stages);
+		}
+		printf("\n");
+	}
+
+	if (packed)
+		run_packed(&s, nb_genomes, max_threads, repeats);
+
+	for (unsigned long i = 0; i < total; i++)
+		free(s.genomes[i]);
+	free(s.genomes);
+	free(s.stage_time);
+
+	return 0;
+}
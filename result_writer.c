@@ -0,0 +1,468 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "result_writer.h"
+
+static const char* result_type_names[RESULT_TYPES] = { "gene", "protein", "mutation", "score" };
+
+
+/***************************************/
+/************ OUTPUT BUFFER ************/
+/***************************************/
+
+/**
+ * Write the formatted output of the writer thread.
+ */
+static void result_writer_drain(result_writer_t* writer){
+    if (writer->buffer_used && fwrite(writer->buffer, 1, writer->buffer_used, writer->out) != writer->buffer_used)
+        writer->error = 1;
+    writer->buffer_used = 0;
+}
+
+/**
+ * Append bytes to the output buffer.
+ */
+static void result_writer_put(result_writer_t* writer, const void* data, const size_t size){
+    if (writer->buffer_used + size > RESULT_WRITER_BUFFER_SIZE)
+        result_writer_drain(writer);
+    if (size >= RESULT_WRITER_BUFFER_SIZE) {
+        if (fwrite(data, 1, size, writer->out) != size)
+            writer->error = 1;
+        return;
+    }
+    memcpy(writer->buffer + writer->buffer_used, data, size);
+    writer->buffer_used += size;
+}
+
+/**
+ * Append formatted text (numbers and names, without protein chains) to the output buffer.
+ */
+static void result_writer_printf(result_writer_t* writer, const char* format, ...){
+    // Longest line of numbers
+    if (writer->buffer_used + 512 > RESULT_WRITER_BUFFER_SIZE)
+        result_writer_drain(writer);
+
+    va_list args;
+    va_start(args, format);
+    int nb = vsnprintf(writer->buffer + writer->buffer_used, RESULT_WRITER_BUFFER_SIZE - writer->buffer_used,
+                       format, args);
+    va_end(args);
+    if (nb > 0)
+        writer->buffer_used += nb;
+}
+
+/**
+ * Append a score: nan in TSV, null in JSON, else the shortest float representation.
+ */
+static void result_writer_score(result_writer_t* writer, const float score){
+    if (isnan(score))
+        result_writer_printf(writer, writer->format == RESULT_WRITER_JSONL ? "null" : "nan");
+    else
+        result_writer_printf(writer, "%.9g", score);
+}
+
+/**
+ * Append a protein chain as a JSON string.
+ */
+static void result_writer_json_string(result_writer_t* writer, const char* str){
+    result_writer_put(writer, "\"", 1);
+    const char* begin = str;
+    for (const char* c = str; *c; c++) {
+        if ((unsigned char)*c >= 0x20 && *c != '"' && *c != '\\')
+            continue;
+        result_writer_put(writer, begin, c - begin);
+        result_writer_printf(writer, "\\u%04x", (unsigned char)*c);
+        begin = c + 1;
+    }
+    result_writer_put(writer, begin, strlen(begin));
+    result_writer_put(writer, "\"", 1);
+}
+
+
+
+/***************************************/
+/************ FORMATTING ***************/
+/***************************************/
+
+/**
+ * Format one block in TSV or JSON Lines.
+ *
+ * TSV columns: type, record, gene_start, gene_end, then
+ *   protein: chain
+ *   mutation: mut_start, mut_end, mut_size
+ *   score: record2, gene2_start, gene2_end, score
+ */
+static void result_writer_text(result_writer_t* writer, const result_block_t* block){
+    int json = writer->format == RESULT_WRITER_JSONL;
+
+    for (unsigned i = 0; i < block->nb_records; i++) {
+        const result_t* r = &block->records[i];
+        if (json)
+            result_writer_printf(writer, "{\"type\":\"%s\",\"record\":%lu,\"gene_start\":%llu,\"gene_end\":%llu",
+                                 result_type_names[r->type], r->record, r->gene_start, r->gene_end);
+        else
+            result_writer_printf(writer, "%s\t%lu\t%llu\t%llu",
+                                 result_type_names[r->type], r->record, r->gene_start, r->gene_end);
+
+        switch (r->type) {
+        case RESULT_PROTEIN:
+            if (json) {
+                result_writer_printf(writer, ",\"protein\":");
+                result_writer_json_string(writer, block->text + block->protein[i]);
+            }
+            else {
+                result_writer_put(writer, "\t", 1);
+                result_writer_put(writer, block->text + block->protein[i], strlen(block->text + block->protein[i]));
+            }
+            break;
+        case RESULT_MUTATION:
+            result_writer_printf(writer, json ? ",\"mut_start\":%llu,\"mut_end\":%llu,\"mut_size\":%llu"
+                                              : "\t%llu\t%llu\t%llu", r->mut_start, r->mut_end, r->mut_size);
+            break;
+        case RESULT_SCORE:
+            result_writer_printf(writer, json ? ",\"record2\":%lu,\"gene2_start\":%llu,\"gene2_end\":%llu,\"score\":"
+                                              : "\t%lu\t%llu\t%llu\t", r->record2, r->gene2_start, r->gene2_end);
+            result_writer_score(writer, r->score);
+            break;
+        default:
+            break;
+        }
+        result_writer_put(writer, json ? "}\n" : "\n", json ? 2 : 1);
+    }
+}
+
+/**
+ * Write one column of 64 bits integers of the records of a type.
+ */
+static void result_writer_column(result_writer_t* writer, const result_block_t* block, const result_type_t type,
+                                 const size_t offset){
+    for (unsigned i = 0; i < block->nb_records; i++) {
+        if (block->records[i].type != type)
+            continue;
+        const char* field = (const char*)&block->records[i] + offset;
+        uint64_t value = offset == offsetof(result_t, record) || offset == offsetof(result_t, record2)
+                       ? *(const unsigned long*)field : *(const unsigned long long*)field;
+        result_writer_put(writer, &value, sizeof(value));
+    }
+}
+
+/**
+ * Format one block in the binary columnar format.
+ *
+ * Block: number of records of each type (4 uint32), then the columns of each type, in the type order:
+ *   all the types: record, gene_start, gene_end (uint64)
+ *   protein: length of each chain (uint32), then the chains, without terminating null
+ *   mutation: mut_start, mut_end, mut_size (uint64)
+ *   score: record2, gene2_start, gene2_end (uint64), score (float32)
+ * Numbers are in the byte order of the machine.
+ */
+static void result_writer_binary(result_writer_t* writer, const result_block_t* block){
+    uint32_t counts[RESULT_TYPES] = { 0 };
+    for (unsigned i = 0; i < block->nb_records; i++)
+        counts[block->records[i].type]++;
+    result_writer_put(writer, counts, sizeof(counts));
+
+    for (result_type_t type = 0; type < RESULT_TYPES; type++) {
+        if (!counts[type])
+            continue;
+        result_writer_column(writer, block, type, offsetof(result_t, record));
+        result_writer_column(writer, block, type, offsetof(result_t, gene_start));
+        result_writer_column(writer, block, type, offsetof(result_t, gene_end));
+
+        switch (type) {
+        case RESULT_PROTEIN:
+            for (unsigned i = 0; i < block->nb_records; i++)
+                if (block->records[i].type == type) {
+                    uint32_t length = strlen(block->text + block->protein[i]);
+                    result_writer_put(writer, &length, sizeof(length));
+                }
+            for (unsigned i = 0; i < block->nb_records; i++)
+                if (block->records[i].type == type)
+                    result_writer_put(writer, block->text + block->protein[i], strlen(block->text + block->protein[i]));
+            break;
+        case RESULT_MUTATION:
+            result_writer_column(writer, block, type, offsetof(result_t, mut_start));
+            result_writer_column(writer, block, type, offsetof(result_t, mut_end));
+            result_writer_column(writer, block, type, offsetof(result_t, mut_size));
+            break;
+        case RESULT_SCORE:
+            result_writer_column(writer, block, type, offsetof(result_t, record2));
+            result_writer_column(writer, block, type, offsetof(result_t, gene2_start));
+            result_writer_column(writer, block, type, offsetof(result_t, gene2_end));
+            for (unsigned i = 0; i < block->nb_records; i++)
+                if (block->records[i].type == type)
+                    result_writer_put(writer, &block->records[i].score, sizeof(float));
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+
+
+/***************************************/
+/************ WRITER THREAD ************/
+/***************************************/
+
+/**
+ * Writer thread: format the queued blocks, in order, and give them back.
+ */
+static void* result_writer_thread(void* arg){
+    result_writer_t* writer = arg;
+
+    pthread_mutex_lock(&writer->lock);
+    for (;;) {
+        while (!writer->queue_head && !writer->closing)
+            pthread_cond_wait(&writer->queued, &writer->lock);
+        result_block_t* block = writer->queue_head;
+        if (!block)
+            break;
+        writer->queue_head = block->next;
+        if (!writer->queue_head)
+            writer->queue_tail = NULL;
+        pthread_mutex_unlock(&writer->lock);
+
+        // Formatting and writing without the lock: the analysis threads go on filling blocks
+        if (writer->format == RESULT_WRITER_BINARY)
+            result_writer_binary(writer, block);
+        else
+            result_writer_text(writer, block);
+
+        pthread_mutex_lock(&writer->lock);
+        block->nb_records = 0;
+        block->text_used = 0;
+        block->next = writer->free_blocks;
+        writer->free_blocks = block;
+        pthread_cond_signal(&writer->freed);
+    }
+    pthread_mutex_unlock(&writer->lock);
+
+    result_writer_drain(writer);
+    if (fflush(writer->out))
+        writer->error = 1;
+    return NULL;
+}
+
+/**
+ * Take an empty block, wait for the writer thread if max_blocks are in use.
+ */
+static result_block_t* result_writer_get_block(result_writer_t* writer){
+    pthread_mutex_lock(&writer->lock);
+    while (!writer->free_blocks && writer->nb_blocks >= writer->max_blocks)
+        pthread_cond_wait(&writer->freed, &writer->lock);
+
+    result_block_t* block = writer->free_blocks;
+    if (block)
+        writer->free_blocks = block->next;
+    else {
+        block = malloc(sizeof(*block));
+        if (block && !(block->text = malloc(RESULT_WRITER_BLOCK_TEXT))) {
+            free(block);
+            block = NULL;
+        }
+        if (block) {
+            block->nb_records = 0;
+            block->text_used = 0;
+            block->text_size = RESULT_WRITER_BLOCK_TEXT;
+            writer->nb_blocks++;
+        }
+    }
+    pthread_mutex_unlock(&writer->lock);
+
+    if (!block)
+        printf("ERROR: result_writer_get_block: cannot allocate memory\n");
+    return block;
+}
+
+/**
+ * Hand a block to the writer thread.
+ */
+static int result_writer_queue(result_writer_t* writer, result_block_t* block){
+    pthread_mutex_lock(&writer->lock);
+    block->next = NULL;
+    if (writer->queue_tail)
+        writer->queue_tail->next = block;
+    else
+        writer->queue_head = block;
+    writer->queue_tail = block;
+    int error = writer->error;
+    pthread_cond_signal(&writer->queued);
+    pthread_mutex_unlock(&writer->lock);
+    return error ? -1 : 0;
+}
+
+
+
+/***************************************/
+/************ WRITER API ***************/
+/***************************************/
+
+/**
+ * Format of a name: tsv, jsonl or binary.
+ *
+ * out : int : 0, -1 if the name is unknown
+ */
+int result_writer_parse_format(const char* name, result_writer_format_t* format){
+    if (!strcmp(name, "tsv"))
+        *format = RESULT_WRITER_TSV;
+    else if (!strcmp(name, "jsonl"))
+        *format = RESULT_WRITER_JSONL;
+    else if (!strcmp(name, "binary"))
+        *format = RESULT_WRITER_BINARY;
+    else
+        return -1;
+    return 0;
+}
+
+/**
+ * Start a writer.
+ *
+ * in : out : output file, written by the writer thread only until result_writer_close
+ * in : format : output format
+ * in : nb_threads : number of analysis threads (thread_id of result_writer_write < nb_threads)
+ * out : result_writer_t* : writer, NULL on error
+ */
+result_writer_t* result_writer_open(FILE* out, const result_writer_format_t format, const unsigned nb_threads){
+    result_writer_t* writer = calloc(1, sizeof(*writer));
+    if (!writer)
+        return printf("ERROR: result_writer_open: cannot allocate memory\n"), NULL;
+
+    writer->out = out;
+    writer->format = format;
+    writer->nb_threads = nb_threads ? nb_threads : 1;
+    // Two blocks per thread: one being filled while the other is written
+    writer->max_blocks = 2 * writer->nb_threads + 1;
+    writer->current = calloc(writer->nb_threads, sizeof(*writer->current));
+    writer->buffer = malloc(RESULT_WRITER_BUFFER_SIZE);
+    if (!writer->current || !writer->buffer) {
+        free(writer->current);
+        free(writer->buffer);
+        free(writer);
+        return printf("ERROR: result_writer_open: cannot allocate memory\n"), NULL;
+    }
+
+    if (format == RESULT_WRITER_BINARY)
+        result_writer_put(writer, RESULT_WRITER_MAGIC, sizeof(RESULT_WRITER_MAGIC));
+
+    pthread_mutex_init(&writer->lock, NULL);
+    pthread_cond_init(&writer->queued, NULL);
+    pthread_cond_init(&writer->freed, NULL);
+    if (pthread_create(&writer->thread, NULL, result_writer_thread, writer)) {
+        pthread_mutex_destroy(&writer->lock);
+        pthread_cond_destroy(&writer->queued);
+        pthread_cond_destroy(&writer->freed);
+        free(writer->current);
+        free(writer->buffer);
+        free(writer);
+        return printf("ERROR: result_writer_open: cannot create the writer thread\n"), NULL;
+    }
+    return writer;
+}
+
+/**
+ * Write a result.
+ *
+ * in : writer : writer
+ * in : thread_id : number of the calling analysis thread (one thread per number at a time)
+ * in : result : result, copied (with its protein chain)
+ * out : int : 0, -1 on error
+ *
+ * The result is only copied in the block of the thread: the formatting is done by the writer thread,
+ * when the block is full or flushed. The results of different threads are interleaved block by block.
+ */
+int result_writer_write(result_writer_t* writer, const unsigned thread_id, const result_t* result){
+    if (thread_id >= writer->nb_threads || result->type >= RESULT_TYPES)
+        return printf("ERROR: result_writer_write: invalid argument\n"), -1;
+
+    result_block_t* block = writer->current[thread_id];
+    if (!block && !(block = writer->current[thread_id] = result_writer_get_block(writer)))
+        return -1;
+
+    unsigned i = block->nb_records;
+    block->records[i] = *result;
+    if (result->type == RESULT_PROTEIN) {
+        const char* protein = result->protein ? result->protein : "";
+        size_t length = strlen(protein) + 1;
+        if (block->text_used + length > block->text_size) {
+            size_t size = block->text_size;
+            while (block->text_used + length > size)
+                size *= 2;
+            char* text = realloc(block->text, size);
+            if (!text)
+                return printf("ERROR: result_writer_write: cannot allocate memory\n"), -1;
+            block->text = text;
+            block->text_size = size;
+        }
+        memcpy(block->text + block->text_used, protein, length);
+        block->protein[i] = block->text_used;
+        block->text_used += length;
+    }
+    block->records[i].protein = NULL;
+    block->nb_records++;
+
+    if (block->nb_records < RESULT_WRITER_BLOCK_RECORDS)
+        return 0;
+    writer->current[thread_id] = NULL;
+    return result_writer_queue(writer, block);
+}
+
+/**
+ * Hand the results of a thread to the writer thread, even if its block is not full.
+ */
+int result_writer_flush(result_writer_t* writer, const unsigned thread_id){
+    if (thread_id >= writer->nb_threads)
+        return printf("ERROR: result_writer_flush: invalid argument\n"), -1;
+
+    result_block_t* block = writer->current[thread_id];
+    if (!block || !block->nb_records)
+        return 0;
+    writer->current[thread_id] = NULL;
+    return result_writer_queue(writer, block);
+}
+
+/**
+ * Write all the results, stop the writer thread and free the writer.
+ *
+ * in : writer : writer (no analysis thread may still use it)
+ * out : int : 0, -1 if a result could not be written
+ *
+ * The output file is flushed, not closed.
+ */
+int result_writer_close(result_writer_t* writer){
+    int res = 0;
+    for (unsigned t = 0; t < writer->nb_threads; t++)
+        res |= result_writer_flush(writer, t);
+
+    pthread_mutex_lock(&writer->lock);
+    writer->closing = 1;
+    pthread_cond_signal(&writer->queued);
+    pthread_mutex_unlock(&writer->lock);
+    pthread_join(writer->thread, NULL);
+    if (writer->error)
+        res = -1;
+
+    for (unsigned t = 0; t < writer->nb_threads; t++)
+        if (writer->current[t]) {
+            writer->current[t]->next = writer->free_blocks;
+            writer->free_blocks = writer->current[t];
+        }
+    while (writer->free_blocks) {
+        result_block_t* next = writer->free_blocks->next;
+        free(writer->free_blocks->text);
+        free(writer->free_blocks);
+        writer->free_blocks = next;
+    }
+
+    pthread_mutex_destroy(&writer->lock);
+    pthread_cond_destroy(&writer->queued);
+    pthread_cond_destroy(&writer->freed);
+    free(writer->current);
+    free(writer->buffer);
+    free(writer);
+    return res ? -1 : 0;
+}
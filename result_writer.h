@@ -0,0 +1,117 @@
+#pragma once
+
+#include <stdio.h>
+#include <stddef.h>
+#include <pthread.h>
+
+// Results buffered by an analysis thread before being handed to the writer thread
+#define RESULT_WRITER_BLOCK_RECORDS 4096
+// Initial size of the protein chains of a block
+#define RESULT_WRITER_BLOCK_TEXT (1 << 20)
+// Formatted bytes written at once by the writer thread
+#define RESULT_WRITER_BUFFER_SIZE (1 << 20)
+// Header of the binary columnar format
+#define RESULT_WRITER_MAGIC "DNARES1"
+
+typedef enum result_writer_format_e {
+    //One line per result, tab separated, the columns depend on the type (first column)
+    RESULT_WRITER_TSV,
+    //One JSON object per line
+    RESULT_WRITER_JSONL,
+    //RESULT_WRITER_MAGIC (8 bytes), then blocks of columns (see result_writer.c)
+    RESULT_WRITER_BINARY
+}result_writer_format_t;
+
+typedef enum result_type_e {
+    //Gene: record, gene_start, gene_end
+    RESULT_GENE,
+    //Amino acid chain of a gene: record, gene_start, gene_end, protein
+    RESULT_PROTEIN,
+    //Mutation zone of a gene: record, gene_start, gene_end, mut_start, mut_end, mut_size
+    RESULT_MUTATION,
+    //Matching score of two genes: record, gene_start, gene_end, record2, gene2_start, gene2_end, score
+    RESULT_SCORE,
+    RESULT_TYPES
+}result_type_t;
+
+typedef struct result_s {
+
+    result_type_t type;
+
+    //Genome (FASTA file or record) and gene, in bits as gene_map_t
+    unsigned long record;
+    unsigned long long gene_start;
+    unsigned long long gene_end;
+
+    //RESULT_PROTEIN: null terminated chain, copied by result_writer_write
+    const char* protein;
+
+    //RESULT_MUTATION: zone in bits from the gene start, as mutation_map
+    unsigned long long mut_start;
+    unsigned long long mut_end;
+    unsigned long long mut_size;
+
+    //RESULT_SCORE: second gene, and the matching score
+    unsigned long record2;
+    unsigned long long gene2_start;
+    unsigned long long gene2_end;
+    float score;
+
+}result_t;
+
+typedef struct result_block_s {
+
+    struct result_block_s* next;
+
+    unsigned nb_records;
+    result_t records[RESULT_WRITER_BLOCK_RECORDS];
+
+    //Protein chains of the records: offset of each chain in text
+    size_t protein[RESULT_WRITER_BLOCK_RECORDS];
+    char* text;
+    size_t text_used;
+    size_t text_size;
+
+}result_block_t;
+
+typedef struct result_writer_s {
+
+    FILE* out;
+    result_writer_format_t format;
+
+    //Block being filled by each analysis thread
+    unsigned nb_threads;
+    result_block_t** current;
+
+    pthread_mutex_t lock;
+    //Signals the writer thread that a block is queued, or that the writer is closed
+    pthread_cond_t queued;
+    //Signals the analysis threads that a block is free
+    pthread_cond_t freed;
+
+    //Full blocks, in order, and empty blocks
+    result_block_t* queue_head;
+    result_block_t* queue_tail;
+    result_block_t* free_blocks;
+    //Allocated blocks, at most max_blocks: the analysis threads wait when the writer is late
+    unsigned nb_blocks;
+    unsigned max_blocks;
+
+    int closing;
+    int error;
+    pthread_t thread;
+
+    //Formatted output of the writer thread
+    char* buffer;
+    size_t buffer_used;
+
+}result_writer_t;
+
+
+/******** RESULT WRITER FUNCTION *********/
+
+int result_writer_parse_format(const char* name, result_writer_format_t* format);
+result_writer_t* result_writer_open(FILE* out, const result_writer_format_t format, const unsigned nb_threads);
+int result_writer_write(result_writer_t* writer, const unsigned thread_id, const result_t* result);
+int result_writer_flush(result_writer_t* writer, const unsigned thread_id);
+int result_writer_close(result_writer_t* writer);
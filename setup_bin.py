@@ -1,6 +1,24 @@
 from distutils.core import setup, Extension
+import os
+import gen_codon_tables
 
-DNAb_module = Extension("DNA_bin", sources = [ "gene_bin.c", "DNA_bin.c" ])
+# Translation tables of the genetic codes
+gen_codon_tables.writing_header()
+
+# GENE_PERF=1 instruments the library functions with the hardware counters
+macros = [("GENE_PERF", None)] if os.environ.get("GENE_PERF", "0") != "0" else []
+
+DNAb_module = Extension("DNA_bin", sources = [ "gene_bin.c", "arena.c", "gene_stream.c", "perf_counters.c", "similarity.c",
+                                                   "thread_pool.c", "variants.c", "consensus.c", "phylo.c",
+                                                   "rank_select.c", "substitution_matrix.c", "protein_search.c",
+                                                   "protein_score.c", "DNA_bin.c" ],
+                        define_macros = macros,
+                        # The hot kernels select their instruction set at load time (GENE_KERNEL),
+                        # the other flags stay portable
+                        extra_compile_args = [ "-O3" ],
+                        depends = [ "gene_bin.h", "similarity.h", "variants.h", "consensus.h", "phylo.h",
+                                   "rank_select.h", "substitution_matrix.h", "protein_search.h", "protein_score.h",
+                                   "codon_tables.h" ])
 
 setup(name        = "DNA_bin",
       version     = "2.0",
@@ -0,0 +1,257 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "similarity.h"
+
+
+/***************************************/
+/************** GENE SETS **************/
+/***************************************/
+
+/**
+ * Prepare the genes of a genome for the similarity queries.
+ *
+ * in : seq_bin : sequence in binary array format
+ * in : genes : genes of the sequence (detecting_genes)
+ * out : set : piece and popcounts of each gene, to free with similarity_free
+ * out : int : 0, -1 on error
+ *
+ * The pieces are extracted once per gene, not once per compared pair as calculating_matching_score does.
+ */
+int similarity_prepare(const long int* seq_bin, const gene_map_t* genes, similarity_genes_t* set){
+    memset(set, 0, sizeof(*set));
+    if (!seq_bin || !genes)
+        return printf("ERROR: similarity_prepare: undefined sequence\n"), -1;
+
+    unsigned long long n = genes->genes_counter;
+    set->nb_genes = n;
+    set->size = malloc((n + 1) * sizeof(*set->size));
+    set->offset = malloc((n + 1) * sizeof(*set->offset));
+    if (!set->size || !set->offset)
+        return similarity_free(set), printf("ERROR: similarity_prepare: cannot allocate memory\n"), -1;
+
+    set->offset[0] = 0;
+    for (unsigned long long g = 0; g < n; g++) {
+        set->size[g] = genes->gene_end[g] - genes->gene_start[g] + 1;
+        set->offset[g + 1] = set->offset[g] + binary_array_size(set->size[g]);
+    }
+    set->words = malloc((set->offset[n] + 1) * sizeof(*set->words));
+    set->popcounts = malloc((set->offset[n] + n + 1) * sizeof(*set->popcounts));
+    if (!set->words || !set->popcounts)
+        return similarity_free(set), printf("ERROR: similarity_prepare: cannot allocate memory\n"), -1;
+
+    for (unsigned long long g = 0; g < n; g++) {
+        long int* piece = get_piece_binary_array_into(seq_bin, genes->gene_start[g], set->size[g],
+                                                      set->words + set->offset[g]);
+        uint32_t* popcounts = set->popcounts + set->offset[g] + g;
+        popcounts[0] = 0;
+        for (unsigned long long w = 0; w < set->offset[g + 1] - set->offset[g]; w++)
+            popcounts[w + 1] = popcounts[w] + __builtin_popcountl(piece[w]);
+    }
+    return 0;
+}
+
+void similarity_free(similarity_genes_t* set){
+    free(set->size);
+    free(set->offset);
+    free(set->words);
+    free(set->popcounts);
+    memset(set, 0, sizeof(*set));
+}
+
+
+
+/***************************************/
+/*************** SCORES ****************/
+/***************************************/
+
+// Score of calculating_matching_score for pop bits set in the xor, never increases with pop
+static inline float similarity_of(const long pop, const int xor_size){
+    float y = ((float)pop * 100.0) / (float)xor_size;
+    return 100.0 - y;
+}
+
+// Integers of a piece xored by xor_binary_array_into
+static inline long similarity_words(const long size){
+    long words = size / (int_SIZE + 1) + ((size / (int_SIZE + 1)) % (int_SIZE + 1) != 0);
+    return words ? words : 1;
+}
+
+static inline long similarity_distance(const uint32_t* p1, const uint32_t* p2, const long begin, const long end){
+    long d = (long)(p1[end] - p1[begin]) - (long)(p2[end] - p2[begin]);
+    return d < 0 ? -d : d;
+}
+
+/**
+ * Score of two genes, unless it is known to be under min_score.
+ *
+ * in : set1, gene1, set2, gene2 : genes to compare
+ * in : min_score : lowest score looked for
+ * out : score : score of calculating_matching_score, if the pair is scored in full
+ * out : int : 1 if the score is at least min_score, 0 otherwise
+ *
+ * The xor is the one of xor_binary_array_into, word by word. The number of 1 of the xor of two words
+ * is at least the difference of their numbers of 1, so the prefix popcounts of the pieces give
+ * an upper bound of the score: first for the whole pieces, then block by block, then while the
+ * words are xored, where each exact block replaces its bound.
+ */
+static inline int similarity_scoring(const similarity_genes_t* set1, const unsigned long long gene1,
+                                     const similarity_genes_t* set2, const unsigned long long gene2,
+                                     const float min_score, float* score, similarity_stats_t* stats){
+    const long int* s1 = set1->words + set1->offset[gene1];
+    const long int* s2 = set2->words + set2->offset[gene2];
+    const uint32_t* p1 = set1->popcounts + set1->offset[gene1] + gene1;
+    const uint32_t* p2 = set2->popcounts + set2->offset[gene2] + gene2;
+    long sbs1 = set1->size[gene1], sbs2 = set2->size[gene2];
+
+    // s1 is the greater piece, as in xor_binary_array_into
+    if (sbs1 < sbs2) {
+        const long int* s = s1; s1 = s2; s2 = s;
+        const uint32_t* p = p1; p1 = p2; p2 = p;
+        long sbs = sbs1; sbs1 = sbs2; sbs2 = sbs;
+    }
+    int xor_size = sbs1;
+    long ss1 = similarity_words(sbs1), ss2 = similarity_words(sbs2);
+    // Words xored as they are, the next one is shifted
+    long common = ss2 - 1;
+    stats->pairs++;
+
+    // Words of s1 after s2: kept as they are
+    long pop = p1[ss1] - p1[ss2];
+
+    // Whole pieces
+    long bound = pop + similarity_distance(p1, p2, 0, common);
+    if (similarity_of(bound, xor_size) < min_score)
+        return stats->pruned_pieces++, 0;
+
+    // Blocks
+    bound = pop;
+    for (long b = 0; b < common; b += SIMILARITY_BLOCK)
+        bound += similarity_distance(p1, p2, b, b + SIMILARITY_BLOCK < common ? b + SIMILARITY_BLOCK : common);
+    if (similarity_of(bound, xor_size) < min_score)
+        return stats->pruned_blocks++, 0;
+
+    // Words
+    for (long b = 0; b < common; b += SIMILARITY_BLOCK) {
+        long end = b + SIMILARITY_BLOCK < common ? b + SIMILARITY_BLOCK : common;
+        long block = 0;
+        for (long w = b; w < end; w++)
+            block += __builtin_popcountl(s1[w] ^ s2[w]);
+        bound += block - similarity_distance(p1, p2, b, end);
+        if (similarity_of(bound, xor_size) < min_score)
+            return stats->pruned_words++, 0;
+    }
+    bound += __builtin_popcountl(s1[common] ^ (long)((unsigned long)s2[common] << ((sbs1 - sbs2) % (int_SIZE + 1))));
+
+    stats->scored++;
+    *score = similarity_of(bound, xor_size);
+    return *score >= min_score;
+}
+
+
+
+/***************************************/
+/*************** QUERIES ***************/
+/***************************************/
+
+/**
+ * Genes of a genome matching a gene of another genome (or of the same one) with a score of at least min_score.
+ *
+ * in : set1, gene1 : gene compared
+ * in : set2 : genes it is compared with, except gene1 itself if set2 is set1
+ * in : min_score : lowest score kept
+ * out : hits : pairs found, in the order of the genes of set2 (room for set2->nb_genes pairs)
+ * out : stats : pruning counters, updated
+ * out : unsigned long long : number of pairs found
+ *
+ * The scores are those of calculating_matching_score, most pairs under min_score are not scored in full.
+ */
+GENE_KERNEL
+unsigned long long similarity_above(const similarity_genes_t* set1, const unsigned long long gene1,
+                                   const similarity_genes_t* set2, const float min_score,
+                                   similarity_hit_t* hits, similarity_stats_t* stats){
+    unsigned long long nb_hits = 0;
+    for (unsigned long long gene2 = 0; gene2 < set2->nb_genes; gene2++) {
+        if (set1 == set2 && gene1 == gene2)
+            continue;
+        float score;
+        if (similarity_scoring(set1, gene1, set2, gene2, min_score, &score, stats))
+            hits[nb_hits++] = (similarity_hit_t){ gene1, gene2, score };
+    }
+    return nb_hits;
+}
+
+// Order of the top-k pairs: greater scores first, then the first genes
+static inline int similarity_before(const similarity_hit_t* a, const similarity_hit_t* b){
+    return a->score > b->score || (a->score == b->score && a->gene2 < b->gene2);
+}
+
+static int similarity_comparing(const void* a, const void* b){
+    return similarity_before(b, a) - similarity_before(a, b);
+}
+
+// Move down the root of the heap of the k best pairs, whose root is the worst one
+static void similarity_sifting(similarity_hit_t* heap, const unsigned long long size){
+    unsigned long long i = 0;
+    for (;;) {
+        unsigned long long last = i, left = 2 * i + 1, right = left + 1;
+        if (left < size && similarity_before(&heap[last], &heap[left]))
+            last = left;
+        if (right < size && similarity_before(&heap[last], &heap[right]))
+            last = right;
+        if (last == i)
+            return;
+        similarity_hit_t tmp = heap[i];
+        heap[i] = heap[last];
+        heap[last] = tmp;
+        i = last;
+    }
+}
+
+/**
+ * The k genes of a genome matching a gene of another genome (or of the same one) the best.
+ *
+ * in : set1, gene1, set2, min_score, stats : see similarity_above
+ * in : k : number of pairs kept
+ * out : hits : pairs found (room for the smallest of k and set2->nb_genes pairs),
+ *              best score first, then in the order of the genes of set2
+ * out : unsigned long long : number of pairs found, k unless set2 has fewer genes with a score of at least min_score
+ *
+ * Once k pairs are found, the following ones are only scored in full if they can beat the worst of them.
+ */
+GENE_KERNEL
+unsigned long long similarity_top_k(const similarity_genes_t* set1, const unsigned long long gene1,
+                                    const similarity_genes_t* set2, const unsigned long long k, const float min_score,
+                                    similarity_hit_t* hits, similarity_stats_t* stats){
+    unsigned long long nb_hits = 0;
+    if (!k)
+        return 0;
+
+    for (unsigned long long gene2 = 0; gene2 < set2->nb_genes; gene2++) {
+        if (set1 == set2 && gene1 == gene2)
+            continue;
+        float score;
+        float lowest = nb_hits == k && hits[0].score > min_score ? hits[0].score : min_score;
+        if (!similarity_scoring(set1, gene1, set2, gene2, lowest, &score, stats))
+            continue;
+
+        similarity_hit_t hit = { gene1, gene2, score };
+        if (nb_hits < k) {
+            // Heap built up from the leaves
+            unsigned long long i = nb_hits++;
+            while (i && similarity_before(&hits[(i - 1) / 2], &hit)) {
+                hits[i] = hits[(i - 1) / 2];
+                i = (i - 1) / 2;
+            }
+            hits[i] = hit;
+        }
+        // Ties go to the first genes
+        else if (score > hits[0].score) {
+            hits[0] = hit;
+            similarity_sifting(hits, k);
+        }
+    }
+    qsort(hits, nb_hits, sizeof(*hits), similarity_comparing);
+    return nb_hits;
+}
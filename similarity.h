@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "gene_bin.h"
+
+// Words of the pieces bounded together by the second pruning test
+#define SIMILARITY_BLOCK 8
+
+typedef struct similarity_genes_s {
+
+    //Genes of a genome
+    unsigned long long nb_genes;
+
+    //Number of bits of each gene, as given to calculating_matching_score
+    int* size;
+
+    //Gene pieces (get_piece_binary_array), the piece of a gene is at words + offset[gene]
+    long int* words;
+    unsigned long long* offset;
+
+    //Number of 1 before each word of a piece, the counts of a gene are at popcounts + offset[gene] + gene
+    uint32_t* popcounts;
+
+}similarity_genes_t;
+
+typedef struct similarity_hit_s {
+
+    unsigned long long gene1;
+    unsigned long long gene2;
+    float score;
+
+}similarity_hit_t;
+
+typedef struct similarity_stats_s {
+
+    //Pairs given to the queries
+    unsigned long long pairs;
+
+    //Pairs left out by the popcounts of the whole pieces, of their blocks, and while being scored
+    unsigned long long pruned_pieces;
+    unsigned long long pruned_blocks;
+    unsigned long long pruned_words;
+
+    //Pairs scored in full
+    unsigned long long scored;
+
+}similarity_stats_t;
+
+
+/******** SIMILARITY FUNCTION *********/
+
+int similarity_prepare(const long int* seq_bin, const gene_map_t* genes, similarity_genes_t* set);
+void similarity_free(similarity_genes_t* set);
+unsigned long long similarity_above(const similarity_genes_t* set1, const unsigned long long gene1,
+                                   const similarity_genes_t* set2, const float min_score,
+                                   similarity_hit_t* hits, similarity_stats_t* stats);
+unsigned long long similarity_top_k(const similarity_genes_t* set1, const unsigned long long gene1,
+                                    const similarity_genes_t* set2, const unsigned long long k, const float min_score,
+                                    similarity_hit_t* hits, similarity_stats_t* stats);
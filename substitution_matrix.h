@@ -0,0 +1,22 @@
+#pragma once
+
+#include <stdint.h>
+
+// Residues of the matrices, in the order of the NCBI matrices: the 20 amino acids, B (D or N), Z (E or Q),
+// X (any) and * (stop)
+#define SUBSTITUTION_ALPHABET "ARNDCQEGHILKMFPSTWYVBZX*"
+#define SUBSTITUTION_SIZE 24
+#define SUBSTITUTION_X 22
+#define SUBSTITUTION_STOP 23
+
+typedef enum substitution_matrix_id_e {
+    SUBSTITUTION_BLOSUM62,
+    SUBSTITUTION_PAM250
+}substitution_matrix_id_t;
+
+
+/******** SUBSTITUTION MATRIX FUNCTION *********/
+
+const int8_t* substitution_matrix(const int matrix_id);
+const char* substitution_matrix_name(const int matrix_id);
+int substitution_code(const char residue);
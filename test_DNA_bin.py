@@ -3,6 +3,8 @@ import DNA_bin
 import array
 import moduleDNA as m
 import ctypes
+import math
+import struct
 
 int_SIZE = 31
 
@@ -161,6 +163,13 @@ def test_generating_amino_acid_chain():
 	assert b'LLFF' == DNA_bin.generating_amino_acid_chain(array.array('l', [16645071]), 0, 24)
 	assert b'MRGOMQKKKK' == DNA_bin.generating_amino_acid_chain(array.array('l', [1821290092, 18263]), 0, 60)
 
+	# Alternative genetic codes: TGA (UGA) is a stop in the standard code, tryptophan in mitochondria
+	assert b'MRG*MQKKKK' == DNA_bin.generating_amino_acid_chain(array.array('l', [1821290092, 18263]), 0, 60, 1)
+	assert b'YYOWCKKKKK' == DNA_bin.generating_amino_acid_chain(array.array('l', [464305363]), 0, 60, 0)
+	assert b'YY*WCKKKKK' == DNA_bin.generating_amino_acid_chain(array.array('l', [464305363]), 0, 60, 11)
+	assert b'YYWWCKKKKK' == DNA_bin.generating_amino_acid_chain(array.array('l', [464305363]), 0, 60, 2)
+	assert None == DNA_bin.generating_amino_acid_chain(array.array('l', [464305363]), 0, 60, 7)
+
 
 	# Test whether the function correctly detects errors:
 	with pytest.raises(TypeError):
@@ -223,3 +232,300 @@ def test_detecting_mutations():
 	assert 16 == DNA_bin.detecting_mutations(array.array('l',[-983172758, 17224372]),0,60)[1][1]
 	assert 28 == DNA_bin.detecting_mutations(array.array('l',[-983172758, 17224372]),0,60)[1][2]
 
+
+def test_analysing_genes():
+	seq = "CCATGGCGCGCGCCTAGAA" * 20 + "ATGAAATGA"
+	seq_bin = array.array('l', DNA_bin.convert_to_binary(seq, len(seq)))
+	genes = DNA_bin.analysing_genes(seq_bin)
+	assert [[g[0], g[1]] for g in genes] == DNA_bin.detecting_genes(seq_bin)
+	assert [4, 33, b"AUGGCGCGCGCCUAG", b"MARAO", [[19, 4, 24]]] == genes[0]
+
+	# Same results as the functions called on each gene
+	for start, end, rna, aa, mutations in genes:
+		assert rna == DNA_bin.generating_mRNA(seq_bin, start, end - start)
+		assert aa == (DNA_bin.generating_amino_acid_chain(seq_bin, start, end - start + 1) or b"")
+		assert mutations == DNA_bin.detecting_mutations(seq_bin, start, end - start)
+
+
+def test_batch_functions():
+	seq = ("CCATGGCGCGCGCCTAGAA" * 20 + "ATGAAATGA" + "TTATGCCCGGGAAATTTCCCTAAGG") * 3
+	seq_bin = array.array('l', DNA_bin.convert_to_binary(seq, len(seq)))
+	genes = DNA_bin.detecting_genes(seq_bin)
+	assert len(genes) > 3
+
+	# Same results as the functions called on each gene, one call per sequence
+	pairs = array.array('q', [v for start, end in genes for v in (start, end - start)])
+	offsets, data = DNA_bin.generating_mRNA_batch(seq_bin, pairs)
+	assert len(genes) + 1 == len(offsets)
+	for i, (start, end) in enumerate(genes):
+		assert data[offsets[i]:offsets[i + 1]] == DNA_bin.generating_mRNA(seq_bin, start, end - start)
+
+	offsets, zones = DNA_bin.detecting_mutations_batch(seq_bin, pairs)
+	zones = zones.tolist()
+	for i, (start, end) in enumerate(genes):
+		found = zones[offsets[i]:offsets[i + 1]]
+		assert found == DNA_bin.detecting_mutations(seq_bin, start, end - start)
+	assert offsets[-1] > 0
+
+	pairs = array.array('q', [v for start, end in genes for v in (start, end - start + 1)])
+	offsets, data = DNA_bin.generating_amino_acid_chain_batch(seq_bin, pairs, 11)
+	for i, (start, end) in enumerate(genes):
+		aa = DNA_bin.generating_amino_acid_chain(seq_bin, start, end - start + 1, 11) or b""
+		assert data[offsets[i]:offsets[i + 1]] == aa
+
+	other = "GGATGTTTCCCGGGTAATTATGCGCGCGCCTAGAA" * 4
+	other_bin = array.array('l', DNA_bin.convert_to_binary(other, len(other)))
+	other_pairs = array.array('q', [v for start, end in DNA_bin.detecting_genes(other_bin) for v in (start, end - start + 1)])
+	scores = DNA_bin.calculating_matching_score_batch(seq_bin, pairs, other_bin, other_pairs)
+	assert (len(pairs) // 2, len(other_pairs) // 2) == scores.shape
+	for j in range(len(pairs) // 2):
+		for k in range(len(other_pairs) // 2):
+			score = DNA_bin.calculating_matching_score(seq_bin, pairs[2 * j], pairs[2 * j + 1],
+			                                           other_bin, other_pairs[2 * k], other_pairs[2 * k + 1])
+			assert score == scores[j, k]
+
+	# Pairs out of the sequence, or of the wrong type
+	with pytest.raises(ValueError):
+		DNA_bin.generating_mRNA_batch(seq_bin, array.array('q', [0, len(seq_bin) * 64]))
+	with pytest.raises(ValueError):
+		DNA_bin.generating_mRNA_batch(seq_bin, array.array('q', [-2, 4]))
+	with pytest.raises(TypeError):
+		DNA_bin.generating_mRNA_batch(seq_bin, array.array('i', [0, 4]))
+	with pytest.raises(ValueError):
+		DNA_bin.generating_amino_acid_chain_batch(seq_bin, pairs, 42)
+	assert 0 == len(DNA_bin.calculating_matching_score_batch(seq_bin, array.array('q'), other_bin, other_pairs))
+
+
+def test_buffer_outputs():
+	seq = "CCATGGCGCGCGCCTAGAA" * 20 + "ATGAAATGA"
+	seq_bin = DNA_bin.convert_to_binary_array(seq, len(seq))
+	assert "l" == seq_bin.format
+	assert DNA_bin.convert_to_binary(seq, len(seq)) == seq_bin.tolist()
+	# Bytes-like DNA sequences (numpy.uint8)
+	assert seq_bin.tolist() == DNA_bin.convert_to_binary(seq.encode(), len(seq))
+	assert seq_bin.tolist() == DNA_bin.convert_to_binary(bytearray(seq.encode()), len(seq))
+	with pytest.raises(ValueError):
+		DNA_bin.convert_to_binary(seq, len(seq) + 1)
+
+	# Unsigned 64 bits sequences
+	unsigned = array.array('Q', [v % 2**64 for v in seq_bin.tolist()])
+	assert DNA_bin.detecting_genes(seq_bin) == DNA_bin.detecting_genes(unsigned)
+
+	# (start, end) structured array, without copy of the library memory
+	genes = DNA_bin.detecting_genes_array(unsigned)
+	assert "T{Q:start:Q:end:}" == genes.format
+	assert 16 == genes.itemsize
+	flat = genes.cast('B').cast('Q').tolist()
+	assert DNA_bin.detecting_genes(seq_bin) == [flat[i:i + 2] for i in range(0, len(flat), 2)]
+	assert isinstance(genes.obj, DNA_bin.Array)
+
+	# Empty matrices keep their 2 dimensions
+	pairs = array.array('q', [4, 30])
+	assert (1, 0) == DNA_bin.calculating_matching_score_batch(seq_bin, pairs, seq_bin, array.array('q')).shape
+	assert (0, 3) == DNA_bin.detecting_mutations_batch(seq_bin, array.array('q'))[1].shape
+
+def test_calculating_matching_profile():
+	seq1 = "ACGT" * 100
+	seq2 = "ACGT" * 50 + "TGCA" * 50
+	seq_bin1 = DNA_bin.convert_to_binary_array(seq1, len(seq1))
+	seq_bin2 = DNA_bin.convert_to_binary_array(seq2, len(seq2))
+
+	profile = DNA_bin.calculating_matching_profile(seq_bin1, 0, seq_bin2, 0, 800, 100, 50)
+	assert "f" == profile.format
+	assert 15 == len(profile)
+	assert [100.0] * 7 == list(profile[:7])
+	assert profile[14] == DNA_bin.calculating_matching_score(seq_bin1, 700, 100, seq_bin2, 700, 100)
+	assert 0 == len(DNA_bin.calculating_matching_profile(seq_bin1, 0, seq_bin2, 0, 10, 100, 1))
+	with pytest.raises(ValueError):
+		DNA_bin.calculating_matching_profile(seq_bin1, 0, seq_bin2, 0, 800, 0, 1)
+	with pytest.raises(ValueError):
+		DNA_bin.calculating_matching_profile(seq_bin1, 10, seq_bin2, 0, len(seq_bin1) * 63, 100, 1)
+
+def test_gc_content_windows():
+	seq = "GCGC" * 100 + "ATAT" * 100 + "ACGT" * 100
+	seq_bin = DNA_bin.convert_to_binary_array(seq, len(seq))
+
+	gc = DNA_bin.gc_content_windows(seq_bin, 400, 400, len(seq))
+	assert "f" == gc.format
+	assert [100.0, 0.0, 50.0] == list(gc)
+	assert 1200 - 9 == len(DNA_bin.gc_content_windows(seq_bin, 10, 1, len(seq)))
+	with pytest.raises(ValueError):
+		DNA_bin.gc_content_windows(seq_bin, 0, 1)
+
+def test_detecting_variants():
+	ref = "CCATGGCGCGCGCCTAGAA" * 20 + "ATGAAATGA"
+	seq = list(ref)
+	for pos, base in ((0, "T"), (63, "A"), (64, "G"), (200, "C"), (len(ref) - 1, "C")):
+		seq[pos] = base
+	seq = "".join(seq)
+	ref_bin = DNA_bin.convert_to_binary_array(ref, len(ref))
+	seq_bin = DNA_bin.convert_to_binary_array(seq, len(seq))
+
+	variants = DNA_bin.detecting_variants(ref_bin, seq_bin, len(ref))
+	assert "T{I:pos:c:ref:c:alt:2x}" == variants.format
+	assert 8 == variants.itemsize
+	expected = [(i, ref[i], seq[i]) for i in range(len(ref)) if ref[i] != seq[i]]
+	flat = bytes(variants)
+	assert expected == [(int.from_bytes(flat[i:i + 4], "little"), chr(flat[i + 4]), chr(flat[i + 5]))
+	                    for i in range(0, len(flat), 8)]
+
+	# Same sequences, and more bases than in the arrays
+	assert 0 == len(DNA_bin.detecting_variants(ref_bin, ref_bin))
+	with pytest.raises(ValueError):
+		DNA_bin.detecting_variants(ref_bin, seq_bin, len(ref_bin) * 64)
+
+def test_building_consensus():
+	seqs = ["ACGTACGTTGCA" * 20, "ACGAACGTTGCA" * 20, "TCGAACGTTGCC" * 20]
+	seqs_bin = [DNA_bin.convert_to_binary_array(seq, len(seq)) for seq in seqs]
+
+	consensus, entropy = DNA_bin.building_consensus(seqs_bin, len(seqs[0]))
+	assert "ACGAACGTTGCA" * 20 == consensus.decode()
+	assert "f" == entropy.format
+	assert len(seqs[0]) == len(entropy)
+	expected = -(1 / 3 * math.log2(1 / 3) + 2 / 3 * math.log2(2 / 3))
+	assert [0 if len(set(column)) == 1 else pytest.approx(expected) for column in zip(*seqs)] == list(entropy)
+
+	# All the bases of the arrays by default
+	assert len(seqs_bin[0]) * 63 // 2 == len(DNA_bin.building_consensus(seqs_bin[:1])[0])
+	with pytest.raises(ValueError):
+		DNA_bin.building_consensus([])
+	with pytest.raises(ValueError):
+		DNA_bin.building_consensus(seqs_bin, len(seqs_bin[0]) * 64)
+
+def test_building_phylogeny():
+	ref = "CCATGGCGCGCGCCTAGAATTGACCA" * 10
+	seqs = [ref, "A" + ref[1:], "AT" + ref[2:], "GGGG" + ref[4:]]
+	seqs_bin = [DNA_bin.convert_to_binary_array(seq, len(seq)) for seq in seqs]
+
+	distances, newick = DNA_bin.building_phylogeny(seqs_bin, ["ref", "one", "two", "four"])
+	assert "f" == distances.format
+	assert (4, 4) == distances.shape
+	assert 0 == distances[0, 0]
+	assert distances[0, 1] < distances[0, 2] < distances[0, 3]
+	assert newick.endswith(";")
+	for name in ("ref", "one", "two", "four"):
+		assert name in newick
+	# Any iterable of names, copied in a tuple before the GIL is released
+	assert "two" in DNA_bin.building_phylogeny(seqs_bin, (name for name in ["ref", "one", "two", "four"]))[1]
+
+	# Numbers as names, k-mer distances
+	assert "0" in DNA_bin.building_phylogeny(seqs_bin[:2], None, 8)[1]
+	with pytest.raises(ValueError):
+		DNA_bin.building_phylogeny(seqs_bin, ["ref"])
+	with pytest.raises(ValueError):
+		DNA_bin.building_phylogeny(seqs_bin, None, 40)
+
+def test_searching_proteins():
+	# ATG AAA CCC GGG TTT TGG TGG TAA: MKPGFWW* on the forward strand
+	seq = "CC" + "ATGAAACCCGGGTTTTGGTGGTAA" + "CC"
+	seq_bin = DNA_bin.convert_to_binary_array(seq, len(seq))
+
+	hits = DNA_bin.searching_proteins(seq_bin, ["WWWW", "MKPGFWW", "KPGF"], 30)
+	assert 32 == hits.itemsize
+	flat = bytes(hits)
+	fields = [struct.unpack_from("=IiIIIiQ", flat, i * 32) for i in range(len(hits))]
+	# (query, frame, query_start, subject_start, length, score, nt_start)
+	assert [(1, 2, 0, 0, 7, 5 + 5 + 7 + 6 + 6 + 11 + 11, 2)] == fields
+
+	assert 0 == len(DNA_bin.searching_proteins(seq_bin, []))
+	# Any iterable of queries, copied in a tuple before the GIL is released
+	assert 1 == len(DNA_bin.searching_proteins(seq_bin, iter(["WWWW", "MKPGFWW", "KPGF"]), 30))
+	# Seeds of the reduced alphabet
+	flat = bytes(DNA_bin.searching_proteins(seq_bin, ["MKPGFWW", "KPGF"], 20, 10, 4, True))
+	fields = [struct.unpack_from("=IiIIIiQ", flat, i) for i in range(0, len(flat), 32)]
+	assert {(0, 0), (1, 1)} <= {(query, subject_start) for query, frame, _, subject_start, *_ in fields if frame == 2}
+	with pytest.raises(ValueError):
+		DNA_bin.searching_proteins(seq_bin, ["MKPGF"], 20, 10, 9)
+	with pytest.raises(ValueError):
+		DNA_bin.searching_proteins(seq_bin, ["MKPGF"], 20, 10, 3, False, 0)
+
+def test_scoring_proteins():
+	assert 5 + 2 + 11 == DNA_bin.scoring_proteins("MKW", "MRWAAA", "BLOSUM62", False)
+	assert 110 - 11 - 2 == DNA_bin.scoring_proteins("WWWWWCCWWWWW", "WWWWWWWWWW")
+	assert 6 + 5 == DNA_bin.scoring_proteins(b"MK", b"MK", "pam250")
+	with pytest.raises(ValueError):
+		DNA_bin.scoring_proteins("MK", "MK", "BLOSUM99")
+	with pytest.raises(ValueError):
+		DNA_bin.scoring_proteins("MK", "MK", "BLOSUM62", True, 11, 0)
+
+	# Translations of genes, one of them with a synonymous mutation (GGG to GGA)
+	genes = ["ATGAAACCCGGGTTTTGGTGGTAA", "ATGAAACCCGGATTTTGGTGGTAA", "ATGCCCCCCCCCCCCCCCCCCTAA"]
+	seq = "".join(genes)
+	seq_bin = DNA_bin.convert_to_binary_array(seq, len(seq))
+	pairs = array.array("q", [v for g in range(3) for v in (2 * 24 * g, 2 * 24)])
+	chains = DNA_bin.generating_amino_acid_chain_batch(seq_bin, pairs, 1)
+	scores = DNA_bin.scoring_proteins_all_pairs(chains)
+	assert "q" == scores.format
+	assert (3, 3) == scores.shape
+	assert scores[0, 0] == scores[0, 1] == scores[1, 1] > scores[0, 2] == scores[2, 0]
+	assert [scores[0, 0], scores[1, 1], scores[2, 2]] == list(DNA_bin.scoring_proteins_batch(chains, ["MKPGFWW*", "MKPGFWW*", "MPPPPPP*"]))
+	assert scores[0, 2] == DNA_bin.scoring_proteins_all_pairs(["MKPGFWW*", "", "MPPPPPP*"])[0, 2]
+	assert 0 == DNA_bin.scoring_proteins_all_pairs([], "PAM250", False).shape[0]
+	with pytest.raises(ValueError):
+		DNA_bin.scoring_proteins_batch(chains, ["MKPGFWW*"])
+
+def test_numpy_arrays():
+	np = pytest.importorskip("numpy")
+	seq = "CCATGGCGCGCGCCTAGAA" * 20 + "ATGAAATGA"
+	seq_bin = np.asarray(DNA_bin.convert_to_binary_array(np.frombuffer(seq.encode(), np.uint8), len(seq)))
+	assert np.int64 == seq_bin.dtype
+
+	genes = np.asarray(DNA_bin.detecting_genes_array(seq_bin.view(np.uint64)))
+	assert ("start", "end") == genes.dtype.names
+	assert DNA_bin.detecting_genes(array.array('l', seq_bin.tolist())) == [[int(s), int(e)] for s, e in genes]
+
+	pairs = np.stack([genes["start"], genes["end"] - genes["start"] + 1], axis = 1).astype(np.int64)
+	scores = np.asarray(DNA_bin.calculating_matching_score_batch(seq_bin, pairs, seq_bin, pairs))
+	assert np.float32 == scores.dtype
+	assert (len(genes), len(genes)) == scores.shape
+	assert 100 == scores[0, 0]
+
+	variants = np.asarray(DNA_bin.detecting_variants(seq_bin, seq_bin.copy()))
+	assert ("pos", "ref", "alt") == variants.dtype.names
+	assert 0 == len(variants)
+
+
+def test_perf_counters():
+	# Only filled when the module is built with GENE_PERF=1
+	DNA_bin.perf_counters_reset()
+	counters = DNA_bin.perf_counters()
+	assert isinstance(counters, dict)
+	assert 0 == len(counters)
+
+	DNA_bin.detecting_genes(array.array('l',[963808024, 42]))
+	counters = DNA_bin.perf_counters()
+	if counters:
+		assert 1 == counters["detecting_genes"]["calls"]
+		assert counters["detecting_genes"]["time_ns"] > 0
+		assert "ipc" in counters["detecting_genes"]
+
+def test_cpu_dispatch_level():
+	assert DNA_bin.cpu_dispatch_level() in ("scalar", "sse4.2", "avx2", "avx512")
+
+def test_streaming_analysis(tmp_path):
+	seq = "CCATGGCGCGCGCCTAGAA" * 20 + "ATGAAATGA"
+	fasta = tmp_path / "genome.fasta"
+	fasta.write_text(">first\n" + "\n".join(seq[i:i+60] for i in range(0, len(seq), 60)) + "\n>second\nATGCCCTAG\n")
+
+	events = []
+	DNA_bin.streaming_analysis(str(fasta), events.append, 7)
+	assert ("record", 0, "first") == events[0]
+	assert ("gene", 0, 4, 33) == events[1]
+	assert ("mutation", 0, 4, 33, 4, 24, 19) == events[2]
+	assert ("record", 1, "second") == events[-3]
+	assert ("gene", 1, 0, 17) == events[-2]
+
+	# Same genes as the array function
+	genes = [[e[2], e[3]] for e in events if e[0] == "gene" and e[1] == 0]
+	assert genes == DNA_bin.detecting_genes(array.array('l', DNA_bin.convert_to_binary(seq, len(seq))))
+	mutations = [list(e[4:]) for e in events if e[0] == "mutation" and e[2] == 4]
+	assert [[19, 4, 24]] == [[m[2], m[0], m[1]] for m in mutations]
+	assert mutations[0][2] == DNA_bin.detecting_mutations(array.array('l', DNA_bin.convert_to_binary(seq, len(seq))), 4, 29)[0][0]
+
+	# The callback exceptions stop the stream
+	def stop(event):
+		raise ValueError("stop")
+	with pytest.raises(ValueError):
+		DNA_bin.streaming_analysis(str(fasta), stop)
+	with pytest.raises(OSError):
+		DNA_bin.streaming_analysis(str(tmp_path / "missing.fasta"), events.append)
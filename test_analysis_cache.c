@@ -0,0 +1,212 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdint.h>
+#include <string.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+
+#include "analysis_cache.h"
+#include "analysis_cache.c"
+
+// Four genes (the second one with a GC run), and another sequence of two genes
+#define SEQ1 "CCATGAAATAACCATGGCGCGCGCCTAGAAATGCCCTTTGGGTGAATGTTTTAG"
+#define SEQ2 "TTATGCCCTAAATGAAACCCTGAGG"
+
+static long int* packing(const char* seq, long int* nb_bits){
+  *nb_bits = binary_array_size(2 * strlen(seq)) * int_SIZE;
+  return convert_to_binary(seq, strlen(seq));
+}
+
+static char cache_dir[64];
+
+// Cache in a new temporary directory
+static analysis_cache_t* opening_cache(void){
+  strcpy(cache_dir, "/tmp/test_analysis_cacheXXXXXX");
+  assert_non_null(mkdtemp(cache_dir));
+  return analysis_cache_open(cache_dir);
+}
+
+static void removing_cache(analysis_cache_t* cache){
+  char command[128];
+  snprintf(command, sizeof(command), "rm -rf %s", cache_dir);
+  assert_int_equal(0, system(command));
+  analysis_cache_close(cache);
+}
+
+static void test_analysis_hash(void ** state){
+  long int nb_bits1, nb_bits2;
+  long int* seq1 = packing(SEQ1, &nb_bits1);
+  long int* seq2 = packing(SEQ1, &nb_bits2);
+  assert_true(analysis_hash(seq1, nb_bits1) == analysis_hash(seq2, nb_bits2));
+
+  // One nucleotide changed
+  change_binary_value(seq2, 40, !get_binary_value(seq2, 40));
+  assert_true(analysis_hash(seq1, nb_bits1) != analysis_hash(seq2, nb_bits2));
+  // Same integers, different size (one base less, in the same words)
+  assert_true(analysis_hash(seq1, nb_bits1) != analysis_hash(seq1, nb_bits1 - 2));
+  free(seq1);
+  free(seq2);
+}
+
+static void test_analysing_genome(void ** state){
+  long int nb_bits;
+  long int* seq = packing(SEQ1, &nb_bits);
+  analysis_genome_t genome;
+  assert_int_equal(0, analysing_genome(seq, nb_bits, &genome));
+
+  // Same genes as detecting_genes
+  gene_map_t g = { 0, NULL, NULL };
+  detecting_genes(seq, nb_bits, &g);
+  assert_int_equal(g.genes_counter, genome.genes.genes_counter);
+  assert_true(g.genes_counter >= 4);
+  for (unsigned long long j = 0; j < g.genes_counter; j++) {
+    assert_int_equal(g.gene_start[j], genome.genes.gene_start[j]);
+    assert_int_equal(g.gene_end[j], genome.genes.gene_end[j]);
+
+    // Same mRNA as generating_mRNA, same chains as generating_amino_acid_chain
+    char* rna = generating_mRNA(seq, g.gene_start[j], g.gene_end[j] - g.gene_start[j]);
+    assert_string_equal(rna, genome.rna + genome.rna_offset[j]);
+    free(rna);
+    char* aa = generating_amino_acid_chain(seq, g.gene_start[j], g.gene_end[j] - g.gene_start[j] + 1);
+    assert_string_equal(aa, genome.proteins + genome.protein_offset[j]);
+    free(aa);
+  }
+  // The GC run of the second gene
+  assert_int_not_equal(0, genome.mut_size[ANALYSIS_MUTATIONS]);
+
+  // Scores of the intra-genome pairs, j from the middle gene down
+  assert_int_equal((g.genes_counter / 2 + 1) * (g.genes_counter / 2), genome.nb_scores);
+  unsigned long long j, k;
+  analysis_intra_pair(g.genes_counter, 0, &j, &k);
+  assert_int_equal(g.genes_counter / 2, j);
+  assert_int_equal(0, k);
+  assert_true(genome.scores[0] == calculating_matching_score(seq, g.gene_start[j], g.gene_end[j] - g.gene_start[j] + 1,
+                                                             seq, g.gene_start[k], g.gene_end[k] - g.gene_start[k] + 1));
+  analysis_intra_pair(g.genes_counter, genome.nb_scores - 1, &j, &k);
+  assert_int_equal(0, j);
+  assert_int_equal(g.genes_counter / 2 - 1, k);
+
+  free(g.gene_start);
+  free(g.gene_end);
+  analysis_genome_free(&genome);
+  free(seq);
+}
+
+static void test_analysis_cache_genome(void ** state){
+  analysis_cache_t* cache = opening_cache();
+  assert_non_null(cache);
+
+  long int nb_bits;
+  long int* seq = packing(SEQ1, &nb_bits);
+  analysis_genome_t genome, loaded;
+  assert_int_equal(0, analysing_genome(seq, nb_bits, &genome));
+
+  // Missing, then stored
+  assert_int_equal(1, analysis_cache_load_genome(cache, genome.hash, nb_bits, &loaded));
+  assert_int_equal(0, analysis_cache_store_genome(cache, &genome));
+  assert_int_equal(0, analysis_cache_load_genome(cache, genome.hash, nb_bits, &loaded));
+  analysis_genome_free(&loaded);
+  // A sequence of another size with the same hash is not taken
+  assert_int_equal(1, analysis_cache_load_genome(cache, genome.hash, nb_bits + 1, &loaded));
+
+  assert_int_equal(0, analysis_cache_load_genome(cache, genome.hash, nb_bits, &loaded));
+  unsigned long long n = genome.genes.genes_counter;
+  assert_int_equal(n, loaded.genes.genes_counter);
+  assert_memory_equal(genome.genes.gene_start, loaded.genes.gene_start, n * sizeof(*genome.genes.gene_start));
+  assert_memory_equal(genome.genes.gene_end, loaded.genes.gene_end, n * sizeof(*genome.genes.gene_end));
+  for (unsigned long long j = 0; j < n; j++) {
+    assert_string_equal(genome.rna + genome.rna_offset[j], loaded.rna + loaded.rna_offset[j]);
+    assert_string_equal(genome.proteins + genome.protein_offset[j], loaded.proteins + loaded.protein_offset[j]);
+  }
+  assert_memory_equal(genome.mut_size, loaded.mut_size, ANALYSIS_MUTATIONS * n * sizeof(*genome.mut_size));
+  assert_memory_equal(genome.mut_start, loaded.mut_start, ANALYSIS_MUTATIONS * n * sizeof(*genome.mut_start));
+  assert_memory_equal(genome.mut_end, loaded.mut_end, ANALYSIS_MUTATIONS * n * sizeof(*genome.mut_end));
+  assert_int_equal(genome.nb_scores, loaded.nb_scores);
+  assert_memory_equal(genome.scores, loaded.scores, genome.nb_scores * sizeof(*genome.scores));
+  assert_int_equal(2, cache->genome_hits);
+  assert_int_equal(2, cache->genome_misses);
+
+  analysis_genome_free(&loaded);
+  analysis_genome_free(&genome);
+  free(seq);
+  removing_cache(cache);
+}
+
+static void test_analysis_cache_scores(void ** state){
+  analysis_cache_t* cache = opening_cache();
+  assert_non_null(cache);
+
+  long int nb_bits1, nb_bits2;
+  long int* seq1 = packing(SEQ1, &nb_bits1);
+  long int* seq2 = packing(SEQ2, &nb_bits2);
+  analysis_genome_t g1, g2;
+  assert_int_equal(0, analysing_genome(seq1, nb_bits1, &g1));
+  assert_int_equal(0, analysing_genome(seq2, nb_bits2, &g2));
+  unsigned long long n1 = g1.genes.genes_counter, n2 = g2.genes.genes_counter;
+  assert_true(n2 >= 2);
+
+  float* scores = malloc(sizeof(*scores) * n1 * n2);
+  float* loaded = malloc(sizeof(*loaded) * n1 * n2);
+  comparing_genomes(seq1, &g1, seq2, &g2, scores);
+  assert_true(scores[n2 + 1] == calculating_matching_score(
+    seq1, g1.genes.gene_start[1], g1.genes.gene_end[1] - g1.genes.gene_start[1] + 1,
+    seq2, g2.genes.gene_start[1], g2.genes.gene_end[1] - g2.genes.gene_start[1] + 1));
+
+  // No block yet
+  analysis_cache_row_t row;
+  assert_int_equal(0, analysis_cache_load_row(cache, g1.hash, &row));
+  assert_int_equal(0, row.nb_blocks);
+  assert_int_equal(1, analysis_cache_load_scores(cache, &row, g2.hash, n1, n2, loaded));
+  analysis_cache_close_row(&row);
+
+  // Two blocks in the pair file of the first genome
+  assert_int_equal(0, analysis_cache_store_scores(cache, g1.hash, g2.hash, n1, n2, scores));
+  assert_int_equal(0, analysis_cache_store_scores(cache, g1.hash, g1.hash, 1, 1, scores));
+  assert_int_equal(0, analysis_cache_load_row(cache, g1.hash, &row));
+  assert_int_equal(2, row.nb_blocks);
+  assert_int_equal(0, analysis_cache_load_scores(cache, &row, g2.hash, n1, n2, loaded));
+  assert_memory_equal(scores, loaded, sizeof(*scores) * n1 * n2);
+  // Other numbers of genes
+  assert_int_equal(1, analysis_cache_load_scores(cache, &row, g2.hash, n1, n2 + 1, loaded));
+  analysis_cache_close_row(&row);
+
+  // Interrupted run: the cut block is dropped, the others are kept
+  char path[ANALYSIS_CACHE_PATH_SIZE];
+  analysis_cache_path(cache, path, g1.hash, "pairs");
+  FILE* f = fopen(path, "ab");
+  uint64_t header[3] = { 42, 10, 10 };
+  fwrite(header, sizeof(header), 1, f);
+  fwrite(scores, sizeof(float), 3, f);
+  fclose(f);
+  assert_int_equal(0, analysis_cache_load_row(cache, g1.hash, &row));
+  assert_int_equal(2, row.nb_blocks);
+  analysis_cache_close_row(&row);
+  assert_int_equal(0, analysis_cache_store_scores(cache, g1.hash, 42, 1, 2, scores));
+  assert_int_equal(0, analysis_cache_load_row(cache, g1.hash, &row));
+  assert_int_equal(3, row.nb_blocks);
+  assert_int_equal(0, analysis_cache_load_scores(cache, &row, 42, 1, 2, loaded));
+  assert_memory_equal(scores, loaded, 2 * sizeof(*scores));
+  analysis_cache_close_row(&row);
+
+  free(scores);
+  free(loaded);
+  analysis_genome_free(&g1);
+  analysis_genome_free(&g2);
+  free(seq1);
+  free(seq2);
+  removing_cache(cache);
+}
+
+int main(void) {
+  int result = 0;
+  const struct CMUnitTest tests[] = {
+    cmocka_unit_test(test_analysis_hash),
+    cmocka_unit_test(test_analysing_genome),
+    cmocka_unit_test(test_analysis_cache_genome),
+    cmocka_unit_test(test_analysis_cache_scores),
+  };
+  result |= cmocka_run_group_tests_name("analysis_cache", tests, NULL, NULL);
+
+  return result;
+}
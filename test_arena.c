@@ -0,0 +1,174 @@
+#define _GNU_SOURCE
+#include <stdint.h>
+#include <string.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+
+#include "arena.h"
+#include "arena.c"
+
+static void test_arena_alloc(void ** state){
+  arena_t arena;
+  assert_int_equal(0, arena_init(&arena, 256));
+
+  // Aligned allocations, one after the other
+  char* a = arena_alloc(&arena, 3);
+  char* b = arena_alloc(&arena, 40);
+  assert_non_null(a);
+  assert_non_null(b);
+  assert_int_equal(0, (uintptr_t)a % ARENA_ALIGN);
+  assert_int_equal(0, (uintptr_t)b % ARENA_ALIGN);
+  assert_ptr_equal(a + ARENA_ALIGN, b);
+
+  // Growth: the memory already allocated does not move
+  memset(b, 'G', 40);
+  char* c = arena_alloc(&arena, 1000);
+  assert_non_null(c);
+  memset(c, 'C', 1000);
+  for (int i = 0; i < 40; i++)
+    assert_int_equal('G', b[i]);
+  assert_true(arena_capacity(&arena) >= 256 + 1000);
+
+  // Test whether the function correctly detects errors:
+  // --- Too large allocation
+  assert_null(arena_alloc(&arena, SIZE_MAX - 8));
+
+  arena_release(&arena);
+  assert_int_equal(0, arena_capacity(&arena));
+}
+
+static void test_arena_rewind(void ** state){
+  arena_t arena;
+  assert_int_equal(0, arena_init(&arena, 256));
+
+  arena_alloc(&arena, 100);
+  arena_mark_t mark = arena_mark(&arena);
+  char* a = arena_alloc(&arena, 50);
+
+  // Same block: the memory is given back
+  arena_rewind(&arena, mark);
+  assert_ptr_equal(a, arena_alloc(&arena, 50));
+
+  // New blocks are freed by the rewind
+  arena_rewind(&arena, mark);
+  arena_alloc(&arena, 5000);
+  assert_true(arena_capacity(&arena) > 256);
+  arena_rewind(&arena, mark);
+  assert_int_equal(256, arena_capacity(&arena));
+  assert_ptr_equal(a, arena_alloc(&arena, 50));
+
+  arena_release(&arena);
+}
+
+static void test_arena_rewind_cycles(void ** state){
+  arena_t arena;
+  assert_int_equal(0, arena_init(&arena, 256));
+  const size_t block_size = arena.block_size;
+
+  // Allocations larger than the block between a mark and a rewind: the next block size stays the same
+  for (int i = 0; i < 100; i++) {
+    arena_mark_t mark = arena_mark(&arena);
+    assert_non_null(arena_alloc(&arena, 3 * block_size / 2));
+    assert_non_null(arena_alloc(&arena, 10 * block_size));
+    arena_rewind(&arena, mark);
+    assert_int_equal(block_size, arena.block_size);
+    assert_int_equal(256, arena_capacity(&arena));
+  }
+
+  arena_release(&arena);
+}
+
+static void test_arena_reset(void ** state){
+  arena_t arena;
+  assert_int_equal(0, arena_init(&arena, 256));
+
+  // Several blocks are merged into one of the same capacity
+  for (int i = 0; i < 10; i++)
+    arena_alloc(&arena, 200);
+  size_t capacity = arena_capacity(&arena);
+  arena_reset(&arena);
+  assert_int_equal(capacity, arena_capacity(&arena));
+  assert_null(arena.block->prev);
+
+  // The same allocations do not need any new block
+  for (int i = 0; i < 10; i++)
+    arena_alloc(&arena, 200);
+  assert_null(arena.block->prev);
+  assert_int_equal(capacity, arena_capacity(&arena));
+
+  arena_release(&arena);
+}
+
+static void test_arena_pages(void ** state){
+  // Every policy gives memory, huge pages falling back to regular ones
+  const int policies[] = { ARENA_PAGES, ARENA_HUGE, ARENA_HUGETLB, ARENA_INTERLEAVE, ARENA_HUGE | ARENA_INTERLEAVE };
+  for (int p = 0; p < 5; p++) {
+    char* ptr = arena_pages_alloc(3 * ARENA_HUGE_PAGE_SIZE + 5, policies[p]);
+    assert_non_null(ptr);
+    assert_int_equal(0, (uintptr_t)ptr % sysconf(_SC_PAGESIZE));
+    if (policies[p] & ARENA_HUGE)
+      assert_int_equal(0, (uintptr_t)ptr % ARENA_HUGE_PAGE_SIZE);
+    // Zero until written
+    assert_int_equal(0, ptr[3 * ARENA_HUGE_PAGE_SIZE + 4]);
+    memset(ptr, 'P', 3 * ARENA_HUGE_PAGE_SIZE + 5);
+    arena_pages_free(ptr, 3 * ARENA_HUGE_PAGE_SIZE + 5, policies[p]);
+  }
+  arena_pages_free(NULL, 10, ARENA_PAGES);
+
+  // Arena of huge pages: the blocks are whole mappings
+  arena_t arena;
+  assert_int_equal(0, arena_init_pages(&arena, 256, ARENA_HUGE));
+  assert_int_equal(ARENA_HUGE_PAGE_SIZE - sizeof(arena_block_t), arena_capacity(&arena));
+  char* a = arena_alloc(&arena, 100);
+  assert_int_equal(0, (uintptr_t)a % ARENA_ALIGN);
+  arena_mark_t mark = arena_mark(&arena);
+  char* b = arena_alloc(&arena, 3 * ARENA_HUGE_PAGE_SIZE);
+  assert_non_null(b);
+  memset(b, 'B', 3 * ARENA_HUGE_PAGE_SIZE);
+  arena_rewind(&arena, mark);
+  assert_null(arena.block->prev);
+
+  // Reset keeps the policy
+  for (int i = 0; i < 3; i++)
+    arena_alloc(&arena, ARENA_HUGE_PAGE_SIZE);
+  size_t capacity = arena_capacity(&arena);
+  arena_reset(&arena);
+  assert_true(arena_capacity(&arena) >= capacity);
+  assert_int_not_equal(0, arena.block->mapped);
+  arena_release(&arena);
+}
+
+static void* thread_arena(void* arg){
+  return arena_thread();
+}
+
+static void test_arena_thread(void ** state){
+  arena_t* arena = arena_thread();
+  assert_non_null(arena);
+  assert_ptr_equal(arena, arena_thread());
+
+  // Each thread has its own arena
+  pthread_t thread;
+  void* other = NULL;
+  assert_int_equal(0, pthread_create(&thread, NULL, thread_arena, NULL));
+  pthread_join(thread, &other);
+  assert_non_null(other);
+  assert_ptr_not_equal(arena, other);
+}
+
+int main(void) {
+  int result = 0;
+  const struct CMUnitTest tests[] = {
+    cmocka_unit_test(test_arena_alloc),
+    cmocka_unit_test(test_arena_rewind),
+    cmocka_unit_test(test_arena_rewind_cycles),
+    cmocka_unit_test(test_arena_reset),
+    cmocka_unit_test(test_arena_pages),
+    cmocka_unit_test(test_arena_thread),
+  };
+  result |= cmocka_run_group_tests_name("arena", tests, NULL, NULL);
+
+  return result;
+}
@@ -0,0 +1,124 @@
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+
+#include "consensus.h"
+#include "consensus.c"
+
+// Genomes: copies of a random sequence with about one substitution every rate bases
+static char** generating_genomes(const unsigned long long nb_genomes, const unsigned long long length, const int rate){
+  char* ref = malloc(length + 1);
+  for (unsigned long long i = 0; i < length; i++)
+    ref[i] = "ACGT"[rand() % 4];
+  char** seqs = malloc(nb_genomes * sizeof(*seqs));
+  for (unsigned long long g = 0; g < nb_genomes; g++) {
+    seqs[g] = malloc(length + 1);
+    for (unsigned long long i = 0; i < length; i++)
+      seqs[g][i] = rand() % rate ? ref[i] : "ACGT"[rand() % 4];
+    seqs[g][length] = '\0';
+  }
+  free(ref);
+  return seqs;
+}
+
+// Counts of the decoded strings
+static void checking(char** seqs, const unsigned long long nb_genomes, const unsigned long long length,
+                     const char* consensus, const float* entropy, const uint32_t* counts){
+  assert_int_equal(length, strlen(consensus));
+  for (unsigned long long i = 0; i < length; i++) {
+    uint32_t count[4] = { 0 };
+    for (unsigned long long g = 0; g < nb_genomes; g++)
+      count[strchr("ACGT", seqs[g][i]) - "ACGT"]++;
+    assert_memory_equal(count, counts + 4 * i, sizeof(count));
+
+    int best = 0;
+    double h = 0;
+    for (int c = 0; c < 4; c++) {
+      if (count[c] > count[best])
+        best = c;
+      if (count[c])
+        h -= (double)count[c] / nb_genomes * log2((double)count[c] / nb_genomes);
+    }
+    assert_int_equal("ACGT"[best], consensus[i]);
+    assert_true(fabs(h - entropy[i]) < 1e-5);
+  }
+}
+
+static void running(thread_pool_t* pool, const unsigned long long nb_genomes, const unsigned long long length,
+                    const int rate){
+  char** seqs = generating_genomes(nb_genomes, length, rate);
+  long int** seqs_bin = malloc(nb_genomes * sizeof(*seqs_bin));
+  for (unsigned long long g = 0; g < nb_genomes; g++)
+    seqs_bin[g] = set_binary_array(seqs[g], length);
+
+  char* consensus = malloc(length + 1);
+  float* entropy = malloc((length + 1) * sizeof(*entropy));
+  uint32_t* counts = malloc((4 * length + 1) * sizeof(*counts));
+  assert_int_equal(0, building_consensus(pool, (const long int* const*)seqs_bin, nb_genomes, length,
+                                         consensus, entropy, counts));
+  checking(seqs, nb_genomes, length, consensus, entropy, counts);
+
+  free(consensus);
+  free(entropy);
+  free(counts);
+  for (unsigned long long g = 0; g < nb_genomes; g++) {
+    free(seqs[g]);
+    free(seqs_bin[g]);
+  }
+  free(seqs);
+  free(seqs_bin);
+}
+
+static void test_building_consensus(void ** state){
+  srand(1);
+  // Every end of a block and of a word, odd and even numbers of genomes
+  for (unsigned long long length = 0; length < 300; length++)
+    running(NULL, 1 + length % 5, length, 2);
+  running(NULL, 1, 1000, 2);
+  running(NULL, 300, 2000, 10);
+}
+
+static void test_building_consensus_threads(void ** state){
+  srand(2);
+  thread_pool_t* pool = thread_pool_create(4);
+  assert_non_null(pool);
+  running(pool, 57, 50000, 20);
+  running(pool, 1000, 3000, 4);
+  thread_pool_destroy(pool);
+}
+
+static void test_building_consensus_errors(void ** state){
+  srand(3);
+  char** seqs = generating_genomes(2, 100, 3);
+  long int* seqs_bin[2] = { set_binary_array(seqs[0], 100), NULL };
+  char consensus[101];
+
+  // Outputs are optional
+  assert_int_equal(0, building_consensus(NULL, (const long int* const*)seqs_bin, 1, 100, consensus, NULL, NULL));
+  assert_memory_equal(seqs[0], consensus, 101);
+
+  assert_int_equal(-1, building_consensus(NULL, (const long int* const*)seqs_bin, 2, 100, consensus, NULL, NULL));
+  assert_int_equal(-1, building_consensus(NULL, (const long int* const*)seqs_bin, 0, 100, consensus, NULL, NULL));
+  assert_int_equal(-1, building_consensus(NULL, NULL, 1, 100, consensus, NULL, NULL));
+
+  free(seqs_bin[0]);
+  free(seqs[0]);
+  free(seqs[1]);
+  free(seqs);
+}
+
+int main(void) {
+  int result = 0;
+  const struct CMUnitTest tests[] = {
+    cmocka_unit_test(test_building_consensus),
+    cmocka_unit_test(test_building_consensus_threads),
+    cmocka_unit_test(test_building_consensus_errors),
+  };
+  result |= cmocka_run_group_tests_name("consensus", tests, NULL, NULL);
+
+  return result;
+}
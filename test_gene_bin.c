@@ -44,6 +44,15 @@ static void test_change_binary_value(void ** state){
   // Invert again values of seq_bin.
   for (int i = 0;i < 7;i++) change_binary_value(&seq_bin, i, (i+1)%2);
   assert_int_equal(seq_bin, 85);
+
+  // Past the first values, the bit of position pos of the value w is at (pos - w) % 64
+  long int seq_bins[12] = { 0 };
+  change_binary_value(seq_bins, 567, 1);
+  assert_int_equal(1L << 46, seq_bins[9]);
+  assert_int_equal(1, get_binary_value(seq_bins, 567));
+  assert_int_equal(0, get_binary_value(seq_bins, 566));
+  change_binary_value(seq_bins, 567, 0);
+  assert_int_equal(0, seq_bins[9]);
 }
 
 static void test_convert_to_binary(void** state) {
@@ -166,6 +175,14 @@ static void test_popcount_binary_array(void ** state){
     popc_result = popcount_binary_array((long int  []) { i }, 31);
     assert_int_equal(popc_expected_result, popc_result);
   }
+
+  // The upper 32 bits of the values are counted
+  assert_int_equal(63, popcount_binary_array((long int []){ 0x7fffffffffffffff }, 63));
+  assert_int_equal(3, popcount_binary_array((long int []){ 1L << 40, 1L << 62, 1 }, 189));
+
+  // The kernels run whatever the selected instruction set
+  const char* level = cpu_dispatch_level();
+  assert_true(!strcmp(level, "scalar") || !strcmp(level, "sse4.2") || !strcmp(level, "avx2") || !strcmp(level, "avx512"));
 }
 
 static void test_binary_to_dna(void ** state){
@@ -355,6 +372,47 @@ static void test_generating_aa_chain(void ** state){
 }
 
 
+static void test_generating_aa_chain_table(void ** state){
+  // Test if the algorithm is OK
+  // All the codons, in the order of test_generating_aa_chain
+  long int* seq_bin = convert_to_binary("AAAAAGAACAATAGAAGGAGCAGTACAACGACCACTATAATGATCATTGAAGAGGACGATGGCGGTGCAGCGGCCGCTGTAGTGGTCGTTCAACAGCACCATCGACGGCGCCGTCCACCGCTACTGCTCCTTTAATAGTACTATTGATGGTGCTGTTCATCGTCCTCTTTATTGTTCTTTGGAGGGCCCCCT", 384);
+  char* aa_chain = NULL;
+
+  // --- 0 = standard code with 'O' stops, as generating_amino_acid_chain
+  aa_chain = generating_amino_acid_chain_table(seq_bin, 0, 384, 0);
+  assert_string_equal("KKNNRRSSTTTTIMIIEEDDGGAAAAVVVVQQHHRRRRPPLLLLOOYYOWCCSSSSLLFFGGPP", aa_chain);
+  free(aa_chain);
+  // --- 1 = standard code
+  aa_chain = generating_amino_acid_chain_table(seq_bin, 0, 384, 1);
+  assert_string_equal("KKNNRRSSTTTTIMIIEEDDGGAAAAVVVVQQHHRRRRPPLLLL**YY*WCCSSSSLLFFGGPP", aa_chain);
+  free(aa_chain);
+  // --- 2 = vertebrate mitochondrial code: AGA, AGG stops, ATA methionine, TGA tryptophan
+  aa_chain = generating_amino_acid_chain_table(seq_bin, 0, 384, 2);
+  assert_string_equal("KKNN**SSTTTTMMIIEEDDGGAAAAVVVVQQHHRRRRPPLLLL**YYWWCCSSSSLLFFGGPP", aa_chain);
+  free(aa_chain);
+  // --- 6 = ciliate nuclear code: TAA, TAG glutamine
+  char aa[65];
+  assert_string_equal("KKNNRRSSTTTTIMIIEEDDGGAAAAVVVVQQHHRRRRPPLLLLQQYY*WCCSSSSLLFFGGPP",
+                      generating_amino_acid_chain_table_into(seq_bin, 0, 384, 6, aa));
+  // --- A part of the sequence
+  assert_string_equal("MI", generating_amino_acid_chain_table_into(seq_bin, 78, 12, 1, aa));
+
+  assert_string_equal("Vertebrate Mitochondrial", codon_table_name(2));
+  assert_string_equal("Bacterial, Archaeal and Plant Plastid", codon_table_name(11));
+
+  // Test whether the function correctly detects errors:
+  // --- Unknown tables
+  assert_null(codon_table_name(7));
+  assert_null(codon_table_name(-1));
+  assert_null(generating_amino_acid_chain_table(seq_bin, 0, 384, 7));
+  assert_null(generating_amino_acid_chain_table(seq_bin, 0, 384, -1));
+  assert_null(generating_amino_acid_chain_table(seq_bin, 0, 384, 34));
+  // --- NULL error
+  assert_null(generating_amino_acid_chain_table(NULL, 0, 0, 1));
+
+  free(seq_bin);
+}
+
 static void test_detecting_mutations(void ** state){
   mutation_map M;
   unsigned short nb_mutations = 6;
@@ -473,6 +531,54 @@ static void test_calculating_matching_score(void ** state){
 
 }
 
+static void test_calculating_matching_profile(void ** state){
+  srand(6);
+  char seq1[3001], seq2[3001];
+  for (int i = 0; i < 3000; i++) {
+    seq1[i] = "ACGT"[rand() % 4];
+    // Identical halves, then one substitution every few bases
+    seq2[i] = i < 1500 || rand() % 4 ? seq1[i] : "ACGT"[rand() % 4];
+  }
+  seq1[3000] = seq2[3000] = '\0';
+  long int* seq_bin1 = set_binary_array(seq1, 3000);
+  long int* seq_bin2 = set_binary_array(seq2, 3000);
+  float profile[6000];
+
+  // Equal bits of each window, aligned or not
+  const int windows[][4] = { { 0, 0, 1, 1 }, { 0, 0, 100, 10 }, { 126, 126, 63, 64 }, { 5, 5, 1000, 333 },
+                             { 0, 2, 200, 50 }, { 7, 1, 64, 1 }, { 1000, 1000, 4000, 4000 } };
+  for (int t = 0; t < 7; t++) {
+    int start1 = windows[t][0], start2 = windows[t][1], window = windows[t][2], step = windows[t][3];
+    int size = 6000 - (start1 > start2 ? start1 : start2);
+    long n = calculating_matching_profile(seq_bin1, start1, seq_bin2, start2, size, window, step, profile);
+    assert_int_equal((size - window) / step + 1, n);
+    for (long i = 0; i < n; i++) {
+      int mismatches = 0;
+      for (int b = 0; b < window; b++)
+        mismatches += get_binary_value(seq_bin1, start1 + i * step + b) != get_binary_value(seq_bin2, start2 + i * step + b);
+      assert_float_equal(100.0 - mismatches * 100.0 / window, profile[i], 1e-4);
+    }
+    // Small windows as calculating_matching_score
+    if (window <= 200)
+      for (long i = 0; i < n; i += 17)
+        assert_float_equal(calculating_matching_score(seq_bin1, start1 + i * step, window,
+                                                      seq_bin2, start2 + i * step, window), profile[i], 0);
+  }
+  // Identical first half
+  assert_int_equal(30, calculating_matching_profile(seq_bin1, 0, seq_bin2, 0, 6000, 200, 200, profile));
+  for (int i = 0; i < 15; i++)
+    assert_float_equal(100.0, profile[i], 0);
+  assert_true(profile[29] < 90);
+
+  // No window, and errors
+  assert_int_equal(0, calculating_matching_profile(seq_bin1, 0, seq_bin2, 0, 10, 20, 1, profile));
+  assert_int_equal(-1, calculating_matching_profile(seq_bin1, 0, seq_bin2, 0, 100, 0, 1, profile));
+  assert_int_equal(-1, calculating_matching_profile(NULL, 0, seq_bin2, 0, 100, 10, 1, profile));
+
+  free(seq_bin1);
+  free(seq_bin2);
+}
+
 static void test_get_piece_binary_array(){
   // Test if the algorithm is OK
 
@@ -527,6 +633,112 @@ static void test_get_piece_binary_array(){
   free(arr);
 }
 
+static void test_into_functions(void ** state){
+  // Same results as the allocating functions, in caller provided buffers
+  char* seq_char = "ATGCGTGGGTAGATGCATCGATCGATCGATCGATCGATCGATCGATCGATCGATCGATCGATCGTAAGC";
+  long int seq_size = 69;
+  long int* seq_bin = convert_to_binary(seq_char, seq_size);
+
+  char dna[seq_size + 1];
+  assert_string_equal(seq_char, binary_to_dna_into(seq_bin, 2 * seq_size, dna));
+
+  char rna[seq_size + 2];
+  char* expected = generating_mRNA(seq_bin, 0, 2 * seq_size);
+  assert_string_equal(expected, generating_mRNA_into(seq_bin, 0, 2 * seq_size, rna));
+  free(expected);
+
+  char aa[seq_size / 3 + 1];
+  expected = generating_amino_acid_chain(seq_bin, 0, 2 * seq_size);
+  assert_string_equal(expected, generating_amino_acid_chain_into(seq_bin, 0, 2 * seq_size, aa));
+  free(expected);
+
+  // The output arrays are fully overwritten
+  long int piece[3] = { -1, -1, -1 };
+  long int* expected_bin = get_piece_binary_array(seq_bin, 10, 100);
+  assert_ptr_equal(piece, get_piece_binary_array_into(seq_bin, 10, 100, piece));
+  assert_int_equal(binary_array_size(100), 2);
+  assert_int_equal(expected_bin[0], piece[0]);
+  assert_int_equal(expected_bin[1], piece[1]);
+  assert_int_equal(-1, piece[2]);
+  free(expected_bin);
+
+  long int xor[3] = { -1, -1, -1 };
+  expected_bin = xor_binary_array(seq_bin, 2 * seq_size, seq_bin, 2 * seq_size);
+  xor_binary_array_into(seq_bin, 2 * seq_size, seq_bin, 2 * seq_size, xor);
+  for (long int i = 0; i < binary_array_size(2 * seq_size); i++) {
+    assert_int_equal(0, xor[i]);
+    assert_int_equal(expected_bin[i], xor[i]);
+  }
+  free(expected_bin);
+
+  // Test whether the function correctly detects errors:
+  // --- NULL output buffer
+  assert_null(binary_to_dna_into(seq_bin, 2 * seq_size, NULL));
+  assert_null(generating_mRNA_into(seq_bin, 0, 2 * seq_size, NULL));
+  assert_null(generating_amino_acid_chain_into(seq_bin, 0, 2 * seq_size, NULL));
+  assert_null(get_piece_binary_array_into(seq_bin, 0, 10, NULL));
+  assert_null(xor_binary_array_into(seq_bin, 10, seq_bin, 10, NULL));
+
+  free(seq_bin);
+}
+
+static void test_analysing_genes(void ** state){
+  // Random sequence, GC rich in places for the mutation zones
+  long int seq_size = 20000;
+  char* seq_char = malloc(seq_size + 1);
+  srand(42);
+  for (long int i = 0; i < seq_size; i++)
+    seq_char[i] = (i / 500) % 2 && rand() % 10 ? "GC"[rand() % 2] : "ACGT"[rand() % 4];
+  seq_char[seq_size] = '\0';
+  long int* seq_bin = convert_to_binary(seq_char, seq_size);
+  long int nb_bits = binary_array_size(2 * seq_size) * int_SIZE;
+
+  gene_analysis_t analysis;
+  assert_int_equal(0, analysing_genes(seq_bin, nb_bits, &analysis));
+
+  // Same results as the functions called on each gene
+  gene_map_t g = { 0, malloc(sizeof(unsigned long long) * nb_bits), malloc(sizeof(unsigned long long) * nb_bits) };
+  detecting_genes(seq_bin, nb_bits, &g);
+  assert_true(g.genes_counter > 100);
+  assert_int_equal(g.genes_counter, analysis.genes.genes_counter);
+
+  int zones = 0;
+  for (unsigned long long j = 0; j < g.genes_counter; j++) {
+    unsigned long long start = g.gene_start[j], end = g.gene_end[j];
+    assert_int_equal(start, analysis.genes.gene_start[j]);
+    assert_int_equal(end, analysis.genes.gene_end[j]);
+
+    char* rna = generating_mRNA(seq_bin, start, end - start);
+    assert_string_equal(rna, analysis.rna + analysis.rna_offset[j]);
+    free(rna);
+
+    char* aa = generating_amino_acid_chain(seq_bin, start, end - start + 1);
+    assert_string_equal(aa ? aa : "", analysis.proteins + analysis.protein_offset[j]);
+    free(aa);
+
+    unsigned long sizes[GENE_MUTATIONS] = { 0 }, starts[GENE_MUTATIONS] = { 0 }, ends[GENE_MUTATIONS] = { 0 };
+    mutation_map m = { sizes, starts, ends };
+    detecting_mutations(seq_bin, start, end - start, m);
+    for (int z = 0; z < GENE_MUTATIONS; z++) {
+      assert_int_equal(sizes[z], analysis.mut_size[GENE_MUTATIONS * j + z]);
+      assert_int_equal(starts[z], analysis.mut_start[GENE_MUTATIONS * j + z]);
+      assert_int_equal(ends[z], analysis.mut_end[GENE_MUTATIONS * j + z]);
+      zones += sizes[z] != 0;
+    }
+  }
+  assert_true(zones > 0);
+
+  gene_analysis_free(&analysis);
+  free(g.gene_start);
+  free(g.gene_end);
+  free(seq_bin);
+  free(seq_char);
+
+  // Test whether the function correctly detects errors:
+  // --- NULL sequence
+  assert_int_equal(-1, analysing_genes(NULL, 10, &analysis));
+}
+
 int main(void) {
   int result = 0;
   const struct CMUnitTest tests[] = {
@@ -543,8 +755,12 @@ int main(void) {
     cmocka_unit_test(test_generating_mRNA),
     cmocka_unit_test(test_detecting_genes),
     cmocka_unit_test(test_generating_aa_chain),
+    cmocka_unit_test(test_generating_aa_chain_table),
     cmocka_unit_test(test_detecting_mutations),
     cmocka_unit_test(test_calculating_matching_score),
+    cmocka_unit_test(test_calculating_matching_profile),
+    cmocka_unit_test(test_into_functions),
+    cmocka_unit_test(test_analysing_genes),
   };
   result |= cmocka_run_group_tests_name("gene", tests, NULL, NULL);
 
@@ -0,0 +1,223 @@
+#include <stdint.h>
+#include <string.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+
+#include "gene_bin.h"
+#include "genome_gen.h"
+#include "gene_stream.h"
+#include "gene_stream.c"
+
+#define MAX_EVENTS 100000
+
+typedef struct events_s {
+  unsigned long nb;
+  unsigned long stop_after;
+  gene_stream_event_t events[MAX_EVENTS];
+  char names[4][GENE_STREAM_NAME_SIZE];
+}events_t;
+
+static int collect(const gene_stream_event_t* event, void* arg){
+  events_t* e = arg;
+  if (event->type == GENE_STREAM_RECORD && event->record < 4)
+    strcpy(e->names[event->record], event->name);
+  if (e->nb < MAX_EVENTS)
+    e->events[e->nb++] = *event;
+  return e->stop_after && e->nb >= e->stop_after;
+}
+
+// Events of the array functions: detecting_genes, then detecting_mutations on each gene (as main_bin.py)
+static unsigned long reference_events(const char* seq, const unsigned long length, const unsigned long record,
+                                      gene_stream_event_t* events){
+  unsigned long nb = 0;
+  long int* seq_bin = convert_to_binary(seq, length);
+  gene_map_t g;
+  g.gene_start = malloc(sizeof(*g.gene_start) * length);
+  g.gene_end = malloc(sizeof(*g.gene_end) * length);
+  detecting_genes(seq_bin, 2 * length, &g);
+
+  memset(&events[nb], 0, sizeof(*events));
+  events[nb].type = GENE_STREAM_RECORD;
+  events[nb++].record = record;
+  for (unsigned long long i = 0; i < g.genes_counter; i++) {
+    memset(&events[nb], 0, sizeof(*events));
+    events[nb].type = GENE_STREAM_GENE;
+    events[nb].record = record;
+    events[nb].gene_start = g.gene_start[i];
+    events[nb++].gene_end = g.gene_end[i];
+
+    unsigned long sizes[5] = { 0 }, starts[5] = { 0 }, ends[5] = { 0 };
+    mutation_map m = { sizes, starts, ends };
+    detecting_mutations(seq_bin, g.gene_start[i], g.gene_end[i] - g.gene_start[i], m);
+    for (int z = 0; z < 5 && sizes[z]; z++) {
+      events[nb] = events[nb - 1 - z];
+      events[nb].type = GENE_STREAM_MUTATION;
+      events[nb].mut_start = starts[z];
+      events[nb].mut_end = ends[z];
+      events[nb++].mut_size = sizes[z];
+    }
+  }
+  free(g.gene_start);
+  free(g.gene_end);
+  free(seq_bin);
+  return nb;
+}
+
+static void assert_same_events(const gene_stream_event_t* expected, const unsigned long nb_expected, const events_t* e){
+  assert_int_equal(nb_expected, e->nb);
+  for (unsigned long i = 0; i < nb_expected; i++) {
+    assert_int_equal(expected[i].type, e->events[i].type);
+    assert_int_equal(expected[i].record, e->events[i].record);
+    assert_int_equal(expected[i].gene_start, e->events[i].gene_start);
+    assert_int_equal(expected[i].gene_end, e->events[i].gene_end);
+    assert_int_equal(expected[i].mut_start, e->events[i].mut_start);
+    assert_int_equal(expected[i].mut_end, e->events[i].mut_end);
+    assert_int_equal(expected[i].mut_size, e->events[i].mut_size);
+  }
+}
+
+static void test_gene_stream_feed(void ** state){
+  // Two records of a genome family, 60 nucleotides per line
+  genome_gen_params_t params;
+  genome_gen_default_params(&params);
+  params.length = 20000;
+  params.orf_count = 10;
+  params.orf_codons = 40;
+  params.gc_content = 0.6;
+  params.n_rate = 0.01;
+  params.iupac_rate = 0.01;
+  params.copies = 2;
+  params.mutation_rate = 0.02;
+
+  char* fasta = malloc(2 * (params.length + params.length / GENOME_GEN_LINE_WIDTH + 64));
+  gene_stream_event_t* expected = malloc(sizeof(*expected) * MAX_EVENTS);
+  unsigned long fasta_size = 0, nb_expected = 0;
+  for (unsigned long c = 0; c < 2; c++) {
+    char* seq = generating_genome(&params, c);
+    nb_expected += reference_events(seq, params.length, c, expected + nb_expected);
+    fasta_size += sprintf(fasta + fasta_size, ">genome %lu\r\n", c);
+    for (unsigned long i = 0; i < params.length; i += GENOME_GEN_LINE_WIDTH) {
+      // The last line is shorter
+      unsigned long width = params.length - i < GENOME_GEN_LINE_WIDTH ? params.length - i : GENOME_GEN_LINE_WIDTH;
+      memcpy(fasta + fasta_size, seq + i, width);
+      fasta_size += width;
+      fasta[fasta_size++] = '\n';
+    }
+    free(seq);
+  }
+  // Planted genes and mutation zones are found
+  assert_true(nb_expected > 2 + 2 * params.orf_count);
+
+  // Same events whatever the chunk size
+  events_t* e = malloc(sizeof(*e));
+  size_t chunk_sizes[] = { 1, 2, 3, 61, 4096, fasta_size };
+  for (int s = 0; s < 6; s++) {
+    gene_stream_t stream;
+    e->nb = 0;
+    e->stop_after = 0;
+    gene_stream_init(&stream, collect, e);
+    for (size_t i = 0; i < fasta_size; i += chunk_sizes[s])
+      assert_int_equal(0, gene_stream_feed(&stream, fasta + i,
+                                           fasta_size - i < chunk_sizes[s] ? fasta_size - i : chunk_sizes[s]));
+    assert_int_equal(0, gene_stream_end(&stream));
+    assert_same_events(expected, nb_expected, e);
+    assert_string_equal("genome 0", e->names[0]);
+    assert_string_equal("genome 1", e->names[1]);
+  }
+
+  // The callback stops the stream
+  gene_stream_t stream;
+  e->nb = 0;
+  e->stop_after = 3;
+  gene_stream_init(&stream, collect, e);
+  assert_int_equal(-1, gene_stream_feed(&stream, fasta, fasta_size));
+  assert_int_equal(3, e->nb);
+  assert_int_equal(-1, gene_stream_feed(&stream, fasta, fasta_size));
+  assert_int_equal(3, e->nb);
+
+  free(e);
+  free(expected);
+  free(fasta);
+}
+
+static void test_gene_stream_sequence(void ** state){
+  events_t* e = malloc(sizeof(*e));
+  e->nb = 0;
+  e->stop_after = 0;
+
+  // Sequence without header, cut in the middle of a codon, lower case and RNA nucleotides
+  gene_stream_t stream;
+  gene_stream_init(&stream, collect, e);
+  gene_stream_feed(&stream, "ccAU", 4);
+  gene_stream_feed(&stream, "gGCGCGC\nGcCuA", 13);
+  gene_stream_feed(&stream, "Gaa", 3);
+  gene_stream_end(&stream);
+
+  // Record, gene AUG...UAG, and the GC run of the gene
+  assert_int_equal(3, e->nb);
+  assert_int_equal(GENE_STREAM_RECORD, e->events[0].type);
+  assert_int_equal(0, e->events[0].record);
+  assert_string_equal("", e->names[0]);
+  assert_int_equal(GENE_STREAM_GENE, e->events[1].type);
+  assert_int_equal(4, e->events[1].gene_start);
+  assert_int_equal(2 * 16 + 1, e->events[1].gene_end);
+  assert_int_equal(GENE_STREAM_MUTATION, e->events[2].type);
+  assert_int_equal(4, e->events[2].mut_start);
+  assert_int_equal(24, e->events[2].mut_end);
+  assert_int_equal(19, e->events[2].mut_size);
+
+  // Same result as the array functions
+  gene_stream_event_t expected[8];
+  unsigned long nb = reference_events("CCATGGCGCGCGCCTAGAA", 19, 0, expected);
+  assert_same_events(expected, nb, e);
+
+  free(e);
+}
+
+static void test_gene_stream_file(void ** state){
+  FILE* f = tmpfile();
+  assert_non_null(f);
+  fputs(">first\nCCATGAAATAA\n>second record\nATGCCCCCCCCCCCCTGA\n>empty", f);
+  rewind(f);
+
+  events_t* e = malloc(sizeof(*e));
+  e->nb = 0;
+  e->stop_after = 0;
+  assert_int_equal(0, gene_stream_file(f, 5, collect, e));
+  fclose(f);
+
+  assert_int_equal(6, e->nb);
+  assert_string_equal("first", e->names[0]);
+  assert_string_equal("second record", e->names[1]);
+  assert_string_equal("empty", e->names[2]);
+  // Positions start again at each record
+  assert_int_equal(GENE_STREAM_GENE, e->events[1].type);
+  assert_int_equal(0, e->events[1].record);
+  assert_int_equal(4, e->events[1].gene_start);
+  assert_int_equal(GENE_STREAM_GENE, e->events[3].type);
+  assert_int_equal(1, e->events[3].record);
+  assert_int_equal(0, e->events[3].gene_start);
+  assert_int_equal(35, e->events[3].gene_end);
+  assert_int_equal(GENE_STREAM_MUTATION, e->events[4].type);
+  assert_int_equal(4, e->events[4].mut_start);
+  assert_int_equal(30, e->events[4].mut_end);
+  assert_int_equal(25, e->events[4].mut_size);
+  assert_int_equal(GENE_STREAM_RECORD, e->events[5].type);
+  assert_int_equal(2, e->events[5].record);
+
+  free(e);
+}
+
+int main(void) {
+  int result = 0;
+  const struct CMUnitTest tests[] = {
+    cmocka_unit_test(test_gene_stream_feed),
+    cmocka_unit_test(test_gene_stream_sequence),
+    cmocka_unit_test(test_gene_stream_file),
+  };
+  result |= cmocka_run_group_tests_name("gene_stream", tests, NULL, NULL);
+
+  return result;
+}
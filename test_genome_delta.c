@@ -0,0 +1,234 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+
+#include "genome_delta.h"
+#include "genome_delta.c"
+
+#define REF_LENGTH 30000
+#define NB_GENOMES 20
+
+static char* generating_reference(void){
+  char* ref = malloc(REF_LENGTH + 1);
+  srand(42);
+  for (int i = 0; i < REF_LENGTH; i++)
+    ref[i] = "ACGT"[rand() % 4];
+  ref[REF_LENGTH] = '\0';
+  return ref;
+}
+
+// Copy of the reference with substitutions, indels, N-runs, other IUPAC letters and trimmed ends
+static char* generating_variant(const char* ref, const unsigned seed, uint64_t* length){
+  char* seq = malloc(2 * REF_LENGTH);
+  srand(seed);
+  uint64_t i = rand() % 60, j = 0, end = REF_LENGTH - rand() % 2 * 40;
+  while (i < end) {
+    int r = rand() % 2000;
+    if (r == 0) {
+      // Insertion
+      for (int k = rand() % 30 + 1; k > 0; k--)
+        seq[j++] = "ACGT"[rand() % 4];
+    }
+    else if (r == 1)
+      // Deletion
+      i += rand() % 30 + 1;
+    else if (r == 2) {
+      // N-run
+      for (int k = rand() % 300 + 1; k > 0 && i < REF_LENGTH; k--, i++)
+        seq[j++] = 'N';
+    }
+    else if (r < 8)
+      seq[j++] = ref[i++] == 'A' ? 'G' : 'A';
+    else if (r == 8)
+      seq[j++] = "RYKMSW"[rand() % 6], i++;
+    else
+      seq[j++] = ref[i++];
+  }
+  seq[j] = '\0';
+  *length = j;
+  return seq;
+}
+
+static void test_genome_delta_edits(void ** state){
+  const char* ref = "ACGTTGCAACGTAGCTAGGTCCATNNNNGATTACAGATTACAGGCATTAGCCAT";
+  genome_delta_t delta;
+  assert_int_equal(0, genome_delta_init(&delta, ref, strlen(ref)));
+  // The N-run of the reference is an edit
+  assert_int_equal(1, delta.nb_ref_edits);
+  assert_int_equal(GENOME_EDIT_N_RUN, delta.ref_edits[0].kind);
+  assert_int_equal(24, delta.ref_edits[0].pos);
+  assert_int_equal(4, delta.ref_edits[0].len);
+
+  // Same sequence: no edit
+  assert_int_equal(0, genome_delta_add(&delta, "same", ref, strlen(ref)));
+  assert_int_equal(0, delta.edit_offset[1]);
+
+  // Two substitutions, then 3 bases deleted, then 2 inserted
+  const char* seq = "ACGTTGCTTCGTAGCTAGGTCCATNNNNGACAGATTACAGGCATTAGGGCCAT";
+  assert_int_equal(1, genome_delta_add(&delta, "edited", seq, strlen(seq)));
+  assert_string_equal("edited", genome_delta_name(&delta, 1));
+  genome_edit_t* edits = delta.edits + delta.edit_offset[1];
+  assert_int_equal(3, delta.edit_offset[2] - delta.edit_offset[1]);
+  assert_int_equal(GENOME_EDIT_SUBSTITUTION, edits[0].kind);
+  assert_int_equal(7, edits[0].pos);
+  assert_int_equal(2, edits[0].len);
+  assert_memory_equal("TT", delta.bases + edits[0].data, 2);
+  assert_int_equal(GENOME_EDIT_DELETION, edits[1].kind);
+  assert_int_equal(3, edits[1].len);
+  assert_int_equal(GENOME_EDIT_INSERTION, edits[2].kind);
+  assert_int_equal(2, edits[2].len);
+
+  char* rebuilt = genome_delta_genome(&delta, 1);
+  assert_string_equal(seq, rebuilt);
+  free(rebuilt);
+  rebuilt = genome_delta_genome(&delta, GENOME_DELTA_REFERENCE);
+  assert_string_equal(ref, rebuilt);
+  free(rebuilt);
+
+  // Out of the collection
+  char window[8];
+  assert_int_equal(-1, genome_delta_window(&delta, 2, 0, 1, window));
+  assert_int_equal(-1, genome_delta_window(&delta, 1, strlen(seq) - 2, 3, window));
+  genome_delta_free(&delta);
+}
+
+static void test_genome_delta_windows(void ** state){
+  char* ref = generating_reference();
+  genome_delta_t delta;
+  assert_int_equal(0, genome_delta_init(&delta, ref, REF_LENGTH));
+
+  char* seqs[NB_GENOMES];
+  uint64_t lengths[NB_GENOMES], size = 0;
+  for (int g = 0; g < NB_GENOMES; g++) {
+    seqs[g] = generating_variant(ref, g + 1, &lengths[g]);
+    size += lengths[g];
+    assert_int_equal(g, genome_delta_add(&delta, NULL, seqs[g], lengths[g]));
+  }
+
+  char* window = malloc(REF_LENGTH * 2);
+  for (int g = 0; g < NB_GENOMES; g++) {
+    assert_int_equal(lengths[g], genome_delta_length(&delta, g));
+    assert_string_equal("", genome_delta_name(&delta, g));
+
+    // Edits sorted, and a few per genome
+    uint64_t nb_edits = delta.edit_offset[g + 1] - delta.edit_offset[g];
+    genome_edit_t* edits = delta.edits + delta.edit_offset[g];
+    assert_true(nb_edits < 200);
+    for (uint64_t e = 1; e < nb_edits; e++) {
+      assert_true(edits[e].pos >= edits[e - 1].pos + genome_edit_rlen(&edits[e - 1]));
+      assert_true(edits[e].gpos >= edits[e - 1].gpos + genome_edit_glen(&edits[e - 1]));
+    }
+
+    assert_int_equal(0, genome_delta_window(&delta, g, 0, lengths[g], window));
+    assert_string_equal(seqs[g], window);
+    for (int w = 0; w < 50; w++) {
+      uint64_t start = rand() % lengths[g], length = rand() % (lengths[g] - start + 1);
+      assert_int_equal(0, genome_delta_window(&delta, g, start, length, window));
+      assert_memory_equal(seqs[g] + start, window, length);
+      assert_int_equal('\0', window[length]);
+    }
+  }
+  // Far smaller than the genomes
+  assert_true(genome_delta_size(&delta) * 5 < size);
+
+  free(window);
+  for (int g = 0; g < NB_GENOMES; g++)
+    free(seqs[g]);
+  genome_delta_free(&delta);
+  free(ref);
+}
+
+static void test_genome_delta_binary(void ** state){
+  char* ref = generating_reference();
+  genome_delta_t delta;
+  assert_int_equal(0, genome_delta_init(&delta, ref, REF_LENGTH));
+  uint64_t length;
+  char* seq = generating_variant(ref, 7, &length);
+  assert_int_equal(0, genome_delta_add(&delta, "variant", seq, length));
+
+  // Same packing as set_binary_array
+  long int* expected = set_binary_array(seq + 1000, 5000);
+  long int* seq_bin = malloc(binary_array_size(2 * 5000) * sizeof(long int));
+  assert_ptr_equal(seq_bin, genome_delta_window_binary(&delta, 0, 1000, 5000, seq_bin));
+  assert_memory_equal(expected, seq_bin, binary_array_size(2 * 5000) * sizeof(long int));
+
+  free(expected);
+  free(seq_bin);
+  free(seq);
+  genome_delta_free(&delta);
+  free(ref);
+}
+
+static void test_genome_delta_save(void ** state){
+  char* ref = generating_reference();
+  ref[100] = 'N';
+  ref[101] = 'Y';
+  genome_delta_t delta, loaded;
+  assert_int_equal(0, genome_delta_init(&delta, ref, REF_LENGTH));
+  char* seqs[3];
+  uint64_t lengths[3];
+  for (int g = 0; g < 3; g++) {
+    seqs[g] = generating_variant(ref, 100 + g, &lengths[g]);
+    genome_delta_add(&delta, g ? "second" : "first", seqs[g], lengths[g]);
+  }
+
+  char path[] = "/tmp/test_genome_deltaXXXXXX";
+  int fd = mkstemp(path);
+  assert_true(fd >= 0);
+  close(fd);
+  assert_int_equal(0, genome_delta_save(&delta, path));
+  // Edits as variable length integers
+  FILE* f = fopen(path, "rb");
+  fseek(f, 0, SEEK_END);
+  assert_true(ftell(f) < genome_delta_size(&delta));
+  fclose(f);
+  genome_delta_free(&delta);
+  assert_int_equal(0, genome_delta_load(&loaded, path));
+
+  assert_int_equal(3, loaded.nb_genomes);
+  assert_string_equal("second", genome_delta_name(&loaded, 2));
+  char* rebuilt = genome_delta_genome(&loaded, GENOME_DELTA_REFERENCE);
+  assert_string_equal(ref, rebuilt);
+  free(rebuilt);
+  for (int g = 0; g < 3; g++) {
+    rebuilt = genome_delta_genome(&loaded, g);
+    assert_string_equal(seqs[g], rebuilt);
+    free(rebuilt);
+  }
+
+  // Genomes added after the load
+  assert_int_equal(3, genome_delta_add(&loaded, "fourth", seqs[0], lengths[0]));
+  rebuilt = genome_delta_genome(&loaded, 3);
+  assert_string_equal(seqs[0], rebuilt);
+  free(rebuilt);
+  genome_delta_free(&loaded);
+
+  // Other files
+  f = fopen(path, "wb");
+  fputs(">not a collection\n", f);
+  fclose(f);
+  assert_int_equal(-1, genome_delta_load(&loaded, path));
+  remove(path);
+
+  for (int g = 0; g < 3; g++)
+    free(seqs[g]);
+  free(ref);
+}
+
+int main(void) {
+  int result = 0;
+  const struct CMUnitTest tests[] = {
+    cmocka_unit_test(test_genome_delta_edits),
+    cmocka_unit_test(test_genome_delta_windows),
+    cmocka_unit_test(test_genome_delta_binary),
+    cmocka_unit_test(test_genome_delta_save),
+  };
+  result |= cmocka_run_group_tests_name("genome_delta", tests, NULL, NULL);
+
+  return result;
+}
@@ -0,0 +1,199 @@
+#include <stdint.h>
+#include <string.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+
+#include "gene_bin.h"
+#include "genome_gen.h"
+#include "genome_gen.c"
+
+static void test_generating_genome(void ** state){
+  genome_gen_params_t params;
+  genome_gen_default_params(&params);
+  params.length = 100000;
+  params.gc_content = 0.6;
+
+  // Same parameters, same genome
+  char* seq1 = generating_genome(&params, 0);
+  char* seq2 = generating_genome(&params, 0);
+  assert_ptr_not_equal(NULL, seq1);
+  assert_int_equal(params.length, strlen(seq1));
+  assert_string_equal(seq1, seq2);
+
+  // GC content
+  unsigned long gc = 0;
+  for (unsigned long i = 0; i < params.length; i++)
+    gc += seq1[i] == 'G' || seq1[i] == 'C';
+  assert_true(gc > 58000 && gc < 62000);
+
+  // Another seed, another genome
+  params.seed = 43;
+  char* seq3 = generating_genome(&params, 0);
+  assert_int_not_equal(0, strcmp(seq1, seq3));
+
+  // N and IUPAC rates
+  params.n_rate = 0.1;
+  params.iupac_rate = 0.05;
+  char* seq4 = generating_genome(&params, 0);
+  unsigned long n = 0, iupac = 0;
+  for (unsigned long i = 0; i < params.length; i++) {
+    n += seq4[i] == 'N';
+    iupac += strchr("RYKMSWBDHV", seq4[i]) != NULL;
+  }
+  assert_true(n > 9000 && n < 11000);
+  assert_true(iupac > 4000 && iupac < 6000);
+
+  // Inconsistent parameters
+  params.gc_content = 1.5;
+  assert_ptr_equal(NULL, generating_genome(&params, 0));
+
+  free(seq1);
+  free(seq2);
+  free(seq3);
+  free(seq4);
+}
+
+static void test_genome_gen_fill(void ** state){
+  genome_gen_params_t params;
+  genome_gen_default_params(&params);
+  params.length = 10007;
+  params.orf_count = 4;
+  params.orf_codons = 50;
+
+  // Generating chunk by chunk gives the whole genome
+  char* seq = generating_genome(&params, 0);
+  char* chunked = calloc(params.length + 1, 1);
+  genome_gen_t gen;
+  assert_int_equal(0, genome_gen_init(&gen, &params, 0));
+  unsigned long long pos = 0, n = 0;
+  while ((n = genome_gen_fill(&gen, chunked + pos, 997)) > 0)
+    pos += n;
+  assert_int_equal(params.length, pos);
+  assert_string_equal(seq, chunked);
+
+  // ORFs that cannot fit
+  params.orf_codons = 1000;
+  assert_int_equal(-1, genome_gen_init(&gen, &params, 0));
+
+  free(seq);
+  free(chunked);
+}
+
+static void test_planted_orfs(void ** state){
+  genome_gen_params_t params;
+  genome_gen_default_params(&params);
+  params.length = 6000;
+  params.gc_content = 0.5;
+  params.orf_count = 5;
+  params.orf_codons = 100;
+
+  long int* seq_bin = generating_binary_genome(&params, 0);
+  assert_ptr_not_equal(NULL, seq_bin);
+
+  gene_map_t gene_map = { 0, NULL, NULL };
+  detecting_genes(seq_bin, 2 * params.length, &gene_map);
+
+  // Every planted ORF is detected, from its start codon to its stop codon
+  unsigned long long spacing = params.length / params.orf_count;
+  unsigned long long offset = (spacing - 3 * params.orf_codons) / 2;
+  for (unsigned long i = 0; i < params.orf_count; i++) {
+    unsigned long long start = 2 * (i * spacing + offset);
+    unsigned long long end = start + 2 * 3 * params.orf_codons - 1;
+    int found = 0;
+    for (unsigned long long g = 0; g < gene_map.genes_counter; g++)
+      found |= gene_map.gene_start[g] == start && gene_map.gene_end[g] == end;
+    assert_true(found);
+  }
+
+  free(gene_map.gene_start);
+  free(gene_map.gene_end);
+  free(seq_bin);
+
+  // Too long for the int bit positions of the binary library, before anything is generated
+  params.length = GENOME_GEN_MAX_BINARY_BASES;
+  assert_ptr_equal(NULL, generating_binary_genome(&params, 0));
+}
+
+static void test_mutated_copies(void ** state){
+  genome_gen_params_t params;
+  genome_gen_default_params(&params);
+  params.length = 20000;
+  params.copies = 3;
+  params.mutation_rate = 0.01;
+
+  char* ancestor = generating_genome(&params, 0);
+  char* copy1 = generating_genome(&params, 1);
+  char* copy2 = generating_genome(&params, 2);
+
+  // Each copy differs from the ancestor at about mutation_rate * length positions
+  unsigned long diff1 = 0, diff2 = 0, diff12 = 0;
+  for (unsigned long i = 0; i < params.length; i++) {
+    diff1 += ancestor[i] != copy1[i];
+    diff2 += ancestor[i] != copy2[i];
+    diff12 += copy1[i] != copy2[i];
+  }
+  assert_true(diff1 > 100 && diff1 < 300);
+  assert_true(diff2 > 100 && diff2 < 300);
+  assert_true(diff12 > diff1 / 2);
+
+  free(ancestor);
+  free(copy1);
+  free(copy2);
+}
+
+static void test_writing_genomes(void ** state){
+  genome_gen_params_t params;
+  genome_gen_default_params(&params);
+  params.length = 1000;
+  params.copies = 2;
+  params.n_rate = 0.01;
+
+  // Packed format: length, then the values of set_binary_array
+  FILE* out = tmpfile();
+  assert_int_equal(0, writing_genomes(out, &params, GENOME_GEN_PACKED));
+  rewind(out);
+  for (unsigned long copy = 0; copy < params.copies; copy++) {
+    char* seq_char = generating_genome(&params, copy);
+    long int* seq_bin = set_binary_array(seq_char, params.length);
+    unsigned long long nb = 2 * params.length / int_SIZE + (2 * params.length % int_SIZE != 0);
+
+    unsigned long long length = 0;
+    assert_int_equal(1, fread(&length, sizeof(length), 1, out));
+    assert_int_equal(params.length, length);
+    long int* packed = malloc(nb * sizeof(*packed));
+    assert_int_equal(nb, fread(packed, sizeof(*packed), nb, out));
+    assert_memory_equal(seq_bin, packed, nb * sizeof(*packed));
+
+    free(packed);
+    free(seq_bin);
+    free(seq_char);
+  }
+  fclose(out);
+
+  // FASTA format: a header, then lines of GENOME_GEN_LINE_WIDTH nucleotides
+  out = tmpfile();
+  assert_int_equal(0, writing_genomes(out, &params, GENOME_GEN_FASTA));
+  rewind(out);
+  char line[256];
+  assert_ptr_not_equal(NULL, fgets(line, sizeof(line), out));
+  assert_int_equal(0, strncmp(line, ">SYN42.0 |", 10));
+  assert_ptr_not_equal(NULL, fgets(line, sizeof(line), out));
+  assert_int_equal(GENOME_GEN_LINE_WIDTH + 1, strlen(line));
+  fclose(out);
+}
+
+int main(void) {
+  int result = 0;
+  const struct CMUnitTest tests[] = {
+    cmocka_unit_test(test_generating_genome),
+    cmocka_unit_test(test_genome_gen_fill),
+    cmocka_unit_test(test_planted_orfs),
+    cmocka_unit_test(test_mutated_copies),
+    cmocka_unit_test(test_writing_genomes),
+  };
+  result |= cmocka_run_group_tests_name("genome_gen", tests, NULL, NULL);
+
+  return result;
+}
@@ -0,0 +1,116 @@
+#define _GNU_SOURCE
+#include <stdint.h>
+#include <string.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+#include <pthread.h>
+#include <dirent.h>
+
+// Instrument the library functions
+#define GENE_PERF
+
+#include "gene_bin.h"
+#include "gene_bin.c"
+#include "perf_counters.h"
+#include "perf_counters.c"
+
+static void test_perf_counters_sites(void ** state){
+  perf_counters_reset();
+  perf_counters_enable(1);
+
+  perf_counters_t c;
+  perf_counters_get(PERF_DETECTING_GENES, &c);
+  assert_int_equal(0, c.calls);
+
+  // One call to each function
+  gene_map_t gene_map = { 0, NULL, NULL };
+  detecting_genes((long int []){963808024, 42}, 126, &gene_map);
+  perf_counters_get(PERF_DETECTING_GENES, &c);
+  assert_int_equal(1, c.calls);
+  assert_true(c.time_ns > 0);
+  if (perf_event_available(PERF_INSTRUCTIONS))
+    assert_true(c.values[PERF_INSTRUCTIONS] > 0);
+
+  // Nested calls are counted in every call site
+  calculating_matching_score((long int []){18770}, 0, 16, (long int []){26714}, 0, 16);
+  perf_counters_get(PERF_CALCULATING_MATCHING_SCORE, &c);
+  assert_int_equal(1, c.calls);
+  perf_counters_get(PERF_GET_PIECE_BINARY_ARRAY, &c);
+  assert_int_equal(2, c.calls);
+  perf_counters_get(PERF_POPCOUNT_BINARY_ARRAY, &c);
+  assert_int_equal(1, c.calls);
+
+  // Disabled instrumentation
+  perf_counters_enable(0);
+  detecting_genes((long int []){963808024, 42}, 126, &gene_map);
+  perf_counters_get(PERF_DETECTING_GENES, &c);
+  assert_int_equal(1, c.calls);
+  perf_counters_enable(1);
+
+  perf_counters_reset();
+  perf_counters_get(PERF_DETECTING_GENES, &c);
+  assert_int_equal(0, c.calls);
+  assert_int_equal(0, c.time_ns);
+
+  free(gene_map.gene_start);
+  free(gene_map.gene_end);
+}
+
+static void test_perf_names(void ** state){
+  assert_string_equal("detecting_genes", perf_site_name(PERF_DETECTING_GENES));
+  assert_string_equal("calculating_matching_score", perf_site_name(PERF_CALCULATING_MATCHING_SCORE));
+  assert_string_equal("branch_misses", perf_event_name(PERF_BRANCH_MISSES));
+  assert_ptr_equal(NULL, perf_site_name(PERF_SITES));
+}
+
+static void* counting_thread(void* arg){
+  gene_map_t gene_map = { 0, NULL, NULL };
+  detecting_genes((long int []){963808024, 42}, 126, &gene_map);
+  free(gene_map.gene_start);
+  free(gene_map.gene_end);
+  return arg;
+}
+
+static int counting_fds(void){
+  int nb = 0;
+  DIR* dir = opendir("/proc/self/fd");
+  if (!dir)
+    return -1;
+  while (readdir(dir))
+    nb++;
+  closedir(dir);
+  return nb;
+}
+
+static void test_perf_counters_threads(void ** state){
+  perf_counters_reset();
+  perf_counters_enable(1);
+
+  // Each thread opens its own group, which must be closed when it exits
+  int before = counting_fds();
+  for (int i = 0; i < 64; i++){
+    pthread_t thread;
+    assert_int_equal(0, pthread_create(&thread, NULL, counting_thread, NULL));
+    assert_int_equal(0, pthread_join(thread, NULL));
+  }
+  assert_int_equal(before, counting_fds());
+
+  perf_counters_t c;
+  perf_counters_get(PERF_DETECTING_GENES, &c);
+  assert_int_equal(64, c.calls);
+  perf_counters_enable(0);
+}
+
+int main(void) {
+  int result = 0;
+  const struct CMUnitTest tests[] = {
+    cmocka_unit_test(test_perf_counters_sites),
+    cmocka_unit_test(test_perf_names),
+    cmocka_unit_test(test_perf_counters_threads),
+  };
+  result |= cmocka_run_group_tests_name("perf_counters", tests, NULL, NULL);
+
+  return result;
+}
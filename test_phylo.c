@@ -0,0 +1,209 @@
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+
+#include "phylo.h"
+#include "phylo.c"
+
+// Parent and branch length of each node of a tree
+typedef struct rooted_s {
+  long* parent;
+  double* length;
+}rooted_t;
+
+static double path(const rooted_t* tree, long a, long b){
+  double da = 0;
+  for (long x = a; x != -1; x = tree->parent[x]) {
+    double db = 0;
+    for (long y = b; y != -1; y = tree->parent[y]) {
+      if (x == y)
+        return da + db;
+      db += tree->length[y];
+    }
+    da += tree->length[x];
+  }
+  return -1;
+}
+
+// Distances of the leaves of a random tree
+static void generating_tree(const unsigned long long n, float* distances){
+  rooted_t tree = { malloc(2 * n * sizeof(long)), malloc(2 * n * sizeof(double)) };
+  long* active = malloc(n * sizeof(long));
+  for (unsigned long long i = 0; i < n; i++)
+    active[i] = i;
+  long next = n;
+  for (unsigned long long r = n; r > 1; r--) {
+    unsigned long long a = rand() % r, b = (a + 1 + rand() % (r - 1)) % r;
+    tree.parent[active[a]] = tree.parent[active[b]] = next;
+    tree.length[active[a]] = 0.01 + (rand() % 100) / 100.0;
+    tree.length[active[b]] = 0.01 + (rand() % 100) / 100.0;
+    active[a < b ? a : b] = next++;
+    active[a < b ? b : a] = active[r - 1];
+  }
+  tree.parent[next - 1] = -1;
+  for (unsigned long long a = 0; a < n; a++)
+    for (unsigned long long b = 0; b < n; b++)
+      distances[a * n + b] = path(&tree, a, b);
+  free(active);
+  free(tree.parent);
+  free(tree.length);
+}
+
+// Distances of the leaves of a joined tree
+static void checking_tree(const phylo_tree_t* joined, const float* distances){
+  unsigned long long n = joined->nb_leaves;
+  rooted_t tree = { malloc(joined->nb_nodes * sizeof(long)), malloc(joined->nb_nodes * sizeof(double)) };
+  for (unsigned long long x = 0; x < joined->nb_nodes; x++)
+    tree.parent[x] = -1;
+  for (unsigned long long i = 0; i + n < joined->nb_nodes; i++)
+    for (int c = 0; c < 3 && joined->children[3 * i + c] != -1; c++) {
+      tree.parent[joined->children[3 * i + c]] = n + i;
+      tree.length[joined->children[3 * i + c]] = joined->lengths[3 * i + c];
+    }
+  assert_int_equal(-1, tree.parent[joined->root]);
+  for (unsigned long long a = 0; a < n; a++)
+    for (unsigned long long b = 0; b < n; b++)
+      assert_true(fabs(path(&tree, a, b) - distances[a * n + b]) < 1e-3);
+  free(tree.parent);
+  free(tree.length);
+}
+
+static void test_computing_distances(void ** state){
+  srand(1);
+  const unsigned long long nb_genomes = 70;
+  char* seqs[70];
+  long int* seqs_bin[70];
+  unsigned long long nb_bases[70];
+  for (unsigned long long g = 0; g < nb_genomes; g++) {
+    nb_bases[g] = 500 + rand() % 100;
+    seqs[g] = malloc(nb_bases[g] + 1);
+    for (unsigned long long i = 0; i < nb_bases[g]; i++)
+      seqs[g][i] = g && rand() % 10 ? seqs[0][i < nb_bases[0] ? i : 0] : "ACGT"[rand() % 4];
+    seqs[g][nb_bases[g]] = '\0';
+    seqs_bin[g] = set_binary_array(seqs[g], nb_bases[g]);
+  }
+
+  float* distances = malloc(nb_genomes * nb_genomes * sizeof(float));
+  float* threaded = malloc(nb_genomes * nb_genomes * sizeof(float));
+  thread_pool_t* pool = thread_pool_create(4);
+  for (int k = 0; k <= 8; k += 8) {
+    assert_int_equal(0, computing_distances(NULL, (const long int* const*)seqs_bin, nb_bases, nb_genomes, k, distances));
+    assert_int_equal(0, computing_distances(pool, (const long int* const*)seqs_bin, nb_bases, nb_genomes, k, threaded));
+    assert_memory_equal(distances, threaded, nb_genomes * nb_genomes * sizeof(float));
+
+    for (unsigned long long a = 0; a < nb_genomes; a++)
+      for (unsigned long long b = 0; b < nb_genomes; b++) {
+        float d = distances[a * nb_genomes + b];
+        assert_true(d == distances[b * nb_genomes + a]);
+        if (a == b)
+          assert_true(d == 0);
+        else if (!k) {
+          // Different bits of the common bases
+          unsigned long long n = nb_bases[a] < nb_bases[b] ? nb_bases[a] : nb_bases[b], mismatches = 0;
+          for (unsigned long long i = 0; i < 2 * n; i++)
+            mismatches += get_binary_value(seqs_bin[a], i) != get_binary_value(seqs_bin[b], i);
+          assert_true(fabs(d - (double)mismatches / (2 * n)) < 1e-6);
+        }
+        else
+          assert_true(d > 0 && d <= 1);
+      }
+  }
+  thread_pool_destroy(pool);
+
+  // The k-mers do not depend on the alignment
+  long int* shifted = set_binary_array(seqs[1] + 1, nb_bases[1] - 1);
+  const long int* pair[2] = { seqs_bin[1], shifted };
+  unsigned long long lengths[2] = { nb_bases[1], nb_bases[1] - 1 };
+  assert_int_equal(0, computing_distances(NULL, pair, lengths, 2, 12, distances));
+  assert_true(distances[1] < 0.001);
+  assert_int_equal(0, computing_distances(NULL, pair, lengths, 2, 0, distances));
+  assert_true(distances[1] > 0.2);
+  assert_int_equal(-1, computing_distances(NULL, pair, lengths, 2, PHYLO_MAX_K + 1, distances));
+
+  free(shifted);
+  free(distances);
+  free(threaded);
+  for (unsigned long long g = 0; g < nb_genomes; g++) {
+    free(seqs[g]);
+    free(seqs_bin[g]);
+  }
+}
+
+static void test_joining_neighbors(void ** state){
+  srand(2);
+  thread_pool_t* pool = thread_pool_create(4);
+  // Trees given back from their distances, the same with the threads
+  for (unsigned long long n = 1; n < 200; n += n < 10 ? 1 : 47) {
+    float* distances = malloc(n * n * sizeof(float));
+    float* copy = malloc(n * n * sizeof(float));
+    generating_tree(n, distances);
+
+    phylo_tree_t tree, threaded;
+    memcpy(copy, distances, n * n * sizeof(float));
+    assert_int_equal(0, joining_neighbors(NULL, copy, n, &tree));
+    assert_int_equal(n > 2 ? 2 * n - 2 : 2 * n - 1, tree.nb_nodes);
+    checking_tree(&tree, distances);
+
+    memcpy(copy, distances, n * n * sizeof(float));
+    assert_int_equal(0, joining_neighbors(pool, copy, n, &threaded));
+    char* newick = writing_newick(&tree, NULL);
+    char* newick_threaded = writing_newick(&threaded, NULL);
+    assert_string_equal(newick, newick_threaded);
+
+    free(newick);
+    free(newick_threaded);
+    phylo_tree_free(&tree);
+    phylo_tree_free(&threaded);
+    free(distances);
+    free(copy);
+  }
+  thread_pool_destroy(pool);
+}
+
+static void test_writing_newick(void ** state){
+  // ((a:1,b:3):1,c:4,d:5)
+  float distances[16] = { 0, 4, 6, 7,
+                          4, 0, 8, 9,
+                          6, 8, 0, 9,
+                          7, 9, 9, 0 };
+  const char* names[4] = { "a", "b c", "it's", "" };
+  phylo_tree_t tree;
+  assert_int_equal(0, joining_neighbors(NULL, distances, 4, &tree));
+  char* newick = writing_newick(&tree, names);
+  assert_string_equal("((a:1,'b c':3):1,'':5,'it''s':4);", newick);
+  free(newick);
+  phylo_tree_free(&tree);
+
+  float one = 0;
+  assert_int_equal(0, joining_neighbors(NULL, &one, 1, &tree));
+  newick = writing_newick(&tree, names);
+  assert_string_equal("a;", newick);
+  free(newick);
+  phylo_tree_free(&tree);
+
+  float two[4] = { 0, 0.5, 0.5, 0 };
+  assert_int_equal(0, joining_neighbors(NULL, two, 2, &tree));
+  newick = writing_newick(&tree, NULL);
+  assert_string_equal("(0:0.25,1:0.25);", newick);
+  free(newick);
+  phylo_tree_free(&tree);
+
+  assert_int_equal(-1, joining_neighbors(NULL, two, 0, &tree));
+  assert_null(writing_newick(&tree, NULL));
+}
+
+int main(void) {
+  int result = 0;
+  const struct CMUnitTest tests[] = {
+    cmocka_unit_test(test_computing_distances),
+    cmocka_unit_test(test_joining_neighbors),
+    cmocka_unit_test(test_writing_newick),
+  };
+  result |= cmocka_run_group_tests_name("phylo", tests, NULL, NULL);
+
+  return result;
+}
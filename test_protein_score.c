@@ -0,0 +1,189 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdint.h>
+#include <string.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+
+#include "protein_score.h"
+#include "protein_score.c"
+
+static char* generating_protein(const uint64_t length){
+  char* chain = malloc(length + 1);
+  for (uint64_t i = 0; i < length; i++)
+    chain[i] = "ACDEFGHIKLMNPQRSTVWY*X"[rand() % 22];
+  chain[length] = '\0';
+  return chain;
+}
+
+// Copy with substitutions, insertions and deletions
+static char* mutating(const char* chain, const uint64_t length){
+  char* copy = malloc(2 * length + 1);
+  uint64_t n = 0;
+  for (uint64_t i = 0; i < length; i++) {
+    int r = rand() % 20;
+    if (r == 0)
+      continue;
+    copy[n++] = r == 1 ? "ACDEFGHIKLMNPQRSTVWY"[rand() % 20] : chain[i];
+    if (r == 2)
+      copy[n++] = "ACDEFGHIKLMNPQRSTVWY"[rand() % 20];
+  }
+  copy[n] = '\0';
+  return copy;
+}
+
+// Smith-Waterman with affine gaps (Gotoh), one cell at a time
+static int64_t aligning(const char* a, const uint64_t n, const char* b, const uint64_t m, const int8_t* matrix,
+                        const int open, const int extend){
+  int64_t* h = calloc(m + 1, sizeof(int64_t));
+  int64_t* e = calloc(m + 1, sizeof(int64_t));
+  int64_t best = 0;
+  for (uint64_t i = 1; i <= n; i++) {
+    int64_t diagonal = 0, f = 0;
+    for (uint64_t j = 1; j <= m; j++) {
+      e[j] = e[j] - extend > h[j] - open - extend ? e[j] - extend : h[j] - open - extend;
+      f = f - extend > h[j - 1] - open - extend ? f - extend : h[j - 1] - open - extend;
+      int64_t x = diagonal + matrix[substitution_code(a[i - 1]) * SUBSTITUTION_SIZE + substitution_code(b[j - 1])];
+      x = x > e[j] ? x : e[j];
+      x = x > f ? x : f;
+      x = x > 0 ? x : 0;
+      diagonal = h[j];
+      h[j] = x;
+      best = x > best ? x : best;
+    }
+  }
+  free(h);
+  free(e);
+  return best;
+}
+
+static void test_substitution_matrices(void ** state){
+  for (int id = 0; substitution_matrix_name(id); id++) {
+    const int8_t* matrix = substitution_matrix(id);
+    assert_non_null(matrix);
+    for (int r = 0; r < SUBSTITUTION_SIZE; r++)
+      for (int c = 0; c < SUBSTITUTION_SIZE; c++)
+        assert_int_equal(matrix[r * SUBSTITUTION_SIZE + c], matrix[c * SUBSTITUTION_SIZE + r]);
+  }
+  assert_string_equal("PAM250", substitution_matrix_name(SUBSTITUTION_PAM250));
+  assert_null(substitution_matrix(-1));
+  assert_int_equal(11, substitution_matrix(SUBSTITUTION_BLOSUM62)[substitution_code('w') * SUBSTITUTION_SIZE
+                                                                 + substitution_code('W')]);
+  assert_int_equal(SUBSTITUTION_X, substitution_code('U'));
+  assert_int_equal(SUBSTITUTION_STOP, substitution_code('*'));
+}
+
+static void test_aligning_protein_profile(void ** state){
+  srand(1);
+  const int gaps[3][2] = { { 11, 1 }, { 0, 4 }, { 5, 2 } };
+  for (uint64_t length = 0; length < 300; length += 1 + rand() % 17)
+    for (int id = 0; id < 2; id++) {
+      char* query = generating_protein(length);
+      char* chain = rand() % 2 ? mutating(query, length) : generating_protein(rand() % 200);
+      uint64_t chain_length = strlen(chain);
+      const int* gap = gaps[rand() % 3];
+
+      protein_profile_t profile;
+      assert_int_equal(0, protein_profile_init(&profile, query, length, id));
+      assert_int_equal(aligning(query, length, chain, chain_length, substitution_matrix(id), gap[0], gap[1]),
+                       aligning_protein_profile(&profile, chain, chain_length, gap[0], gap[1]));
+      // Reused
+      assert_int_equal(aligning(query, length, query, length, substitution_matrix(id), gap[0], gap[1]),
+                       aligning_protein_profile(&profile, query, length, gap[0], gap[1]));
+      assert_int_equal(-1, aligning_protein_profile(&profile, query, length, 1, 0));
+      protein_profile_free(&profile);
+      free(query);
+      free(chain);
+    }
+}
+
+static void test_scoring_proteins(void ** state){
+  protein_scoring_t ungapped = { SUBSTITUTION_BLOSUM62, 0, 0, 0 };
+  protein_scoring_t gapped = { SUBSTITUTION_BLOSUM62, 1, 11, 1 };
+  int64_t score;
+  // The same positions, the shortest chain
+  assert_int_equal(0, scoring_proteins("MKW", 3, "MRWAAA", 6, &ungapped, &score));
+  assert_int_equal(5 + 2 + 11, score);
+  assert_int_equal(0, scoring_proteins("MKW*", 4, "MKW*", 4, &ungapped, &score));
+  assert_int_equal(5 + 5 + 11 + 1, score);
+  // A gap of 2 residues
+  assert_int_equal(0, scoring_proteins("WWWWWCCWWWWW", 12, "WWWWWWWWWW", 10, &gapped, &score));
+  assert_int_equal(110 - 11 - 2, score);
+  assert_int_equal(0, scoring_proteins("", 0, "MK", 2, &gapped, &score));
+  assert_int_equal(0, score);
+
+  protein_scoring_t invalid = { 7, 0, 0, 0 };
+  assert_int_equal(-1, scoring_proteins("MK", 2, "MK", 2, &invalid, &score));
+  invalid = (protein_scoring_t){ SUBSTITUTION_PAM250, 1, -1, 1 };
+  assert_int_equal(-1, scoring_proteins("MK", 2, "MK", 2, &invalid, &score));
+}
+
+static void test_scoring_proteins_collection(void ** state){
+  srand(2);
+  const unsigned long long n = 40;
+  // Chains in a bulk buffer, some of them empty
+  char* data = malloc(n * 400);
+  int64_t offsets[41] = { 0 };
+  char* family = generating_protein(150);
+  for (unsigned long long i = 0; i < n; i++) {
+    char* chain = i % 7 == 6 ? strdup("") : i % 2 ? mutating(family, 150) : generating_protein(rand() % 300);
+    memcpy(data + offsets[i], chain, strlen(chain));
+    offsets[i + 1] = offsets[i] + strlen(chain);
+    free(chain);
+  }
+  protein_chains_t chains = { data, offsets, n };
+  // The chains i and n - 1 - i
+  char* reversed = malloc(offsets[n]);
+  int64_t reversed_offsets[41] = { 0 };
+  for (unsigned long long i = 0; i < n; i++) {
+    int64_t length = offsets[n - i] - offsets[n - 1 - i];
+    memcpy(reversed + reversed_offsets[i], data + offsets[n - 1 - i], length);
+    reversed_offsets[i + 1] = reversed_offsets[i] + length;
+  }
+  protein_chains_t others = { reversed, reversed_offsets, n };
+
+  thread_pool_t* pool = thread_pool_create(4);
+  int64_t* scores = malloc(n * n * sizeof(int64_t));
+  int64_t batch[40];
+  for (int gapped = 0; gapped < 2; gapped++)
+    for (int threaded = 0; threaded < 2; threaded++) {
+      protein_scoring_t scoring = { gapped ? SUBSTITUTION_BLOSUM62 : SUBSTITUTION_PAM250, gapped, 10, 1 };
+      assert_int_equal(0, scoring_proteins_all_pairs(threaded ? pool : NULL, &chains, &scoring, scores));
+      assert_int_equal(0, scoring_proteins_batch(threaded ? pool : NULL, &chains, &others, &scoring, batch));
+      for (unsigned long long i = 0; i < n; i++) {
+        for (unsigned long long j = 0; j < n; j++) {
+          int64_t score;
+          assert_int_equal(0, scoring_proteins(data + offsets[i], offsets[i + 1] - offsets[i], data + offsets[j],
+                                               offsets[j + 1] - offsets[j], &scoring, &score));
+          assert_int_equal(score, scores[i * n + j]);
+        }
+        assert_int_equal(scores[i * n + n - 1 - i], batch[i]);
+      }
+      // The family above the unrelated chains
+      if (gapped)
+        assert_true(scores[1 * n + 3] > 3 * scores[0 * n + 2]);
+    }
+
+  protein_scoring_t scoring = { SUBSTITUTION_BLOSUM62, 0, 0, 0 };
+  others.nb_chains = n - 1;
+  assert_int_equal(-1, scoring_proteins_batch(pool, &chains, &others, &scoring, batch));
+  thread_pool_destroy(pool);
+  free(scores);
+  free(reversed);
+  free(family);
+  free(data);
+}
+
+int main(void) {
+  int result = 0;
+  const struct CMUnitTest tests[] = {
+    cmocka_unit_test(test_substitution_matrices),
+    cmocka_unit_test(test_aligning_protein_profile),
+    cmocka_unit_test(test_scoring_proteins),
+    cmocka_unit_test(test_scoring_proteins_collection),
+  };
+  result |= cmocka_run_group_tests_name("protein_score", tests, NULL, NULL);
+
+  return result;
+}
@@ -0,0 +1,196 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdint.h>
+#include <string.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+
+#include "protein_search.h"
+#include "protein_search.c"
+
+static char* generating_sequence(const uint64_t length){
+  char* seq = malloc(length + 1);
+  for (uint64_t i = 0; i < length; i++)
+    seq[i] = "ACGT"[rand() % 4];
+  seq[length] = '\0';
+  return seq;
+}
+
+static char* reverse_complement(const char* seq, const uint64_t length){
+  char* rc = malloc(length + 1);
+  for (uint64_t i = 0; i < length; i++)
+    rc[i] = "TGCA"[strchr("ACGT", seq[length - 1 - i]) - "ACGT"];
+  rc[length] = '\0';
+  return rc;
+}
+
+// Translation of the bases [start, start + 3 * nb_codons) of a decoded strand
+static char* translating(const char* strand, const uint64_t start, const uint64_t nb_codons){
+  long int* bin = set_binary_array(strand + start, 3 * nb_codons);
+  char* aa = generating_amino_acid_chain_table(bin, 0, 6 * nb_codons, 1);
+  free(bin);
+  return aa;
+}
+
+static void test_indexing_proteins(void ** state){
+  srand(1);
+  for (uint64_t length = 0; length < 2000; length += 1 + rand() % 300)
+    for (int reduced = 0; reduced < 2; reduced++) {
+      char* seq = generating_sequence(length);
+      char* rc = reverse_complement(seq, length);
+      long int* seq_bin = set_binary_array(seq, length);
+      protein_db_t db;
+      assert_int_equal(0, indexing_proteins(seq_bin, length, 11, 3, reduced, &db));
+
+      // Frames
+      for (int f = 0; f < 6; f++) {
+        uint64_t nb_codons = length > (uint64_t)f % 3 ? (length - f % 3) / 3 : 0;
+        char* aa = nb_codons ? translating(f < 3 ? seq : rc, f % 3, nb_codons) : strdup("");
+        assert_string_equal(aa, db.residues + db.frame_start[f]);
+        free(aa);
+      }
+
+      // Every seed under its code
+      uint64_t nb_seeds = 0;
+      for (uint64_t p = 0; p + 3 <= db.frame_start[6]; p++) {
+        uint32_t code = 0;
+        int valid = 1;
+        for (int i = 0; i < 3; i++) {
+          valid &= db.letters[(unsigned char)db.residues[p + i]] >= 0;
+          code = code * (reduced ? 10 : 20) + (valid ? db.letters[(unsigned char)db.residues[p + i]] : 0);
+        }
+        if (!valid)
+          continue;
+        nb_seeds++;
+        int found = 0;
+        for (uint32_t j = db.offsets[code]; j < db.offsets[code + 1]; j++)
+          found |= db.positions[j] == p;
+        assert_true(found);
+      }
+      assert_int_equal(nb_seeds, db.offsets[db.nb_codes]);
+
+      protein_db_free(&db);
+      free(seq_bin);
+      free(rc);
+      free(seq);
+    }
+
+  long int* seq_bin = set_binary_array("ACGTACGT", 8);
+  protein_db_t db;
+  assert_int_equal(-1, indexing_proteins(seq_bin, 8, 0, 3, 0, &db));
+  assert_int_equal(-1, indexing_proteins(seq_bin, 8, 1, 0, 0, &db));
+  assert_int_equal(-1, indexing_proteins(seq_bin, 8, 1, 6, 0, &db));
+  assert_int_equal(0, indexing_proteins(seq_bin, 8, 1, 7, 1, &db));
+  protein_db_free(&db);
+  free(seq_bin);
+}
+
+// Stretch of a frame without stop, with a few substitutions
+static char* sampling_query(const protein_db_t* db, const int f, uint32_t* start, const uint32_t length){
+  const char* frame = db->residues + db->frame_start[f];
+  uint32_t frame_length = db->frame_start[f + 1] - db->frame_start[f] - 1;
+  do
+    *start = rand() % (frame_length - length);
+  while (memchr(frame + *start, '*', length));
+  char* query = strndup(frame + *start, length);
+  for (uint32_t i = 5; i < length; i += 10)
+    query[i] = "ACDEFGHIKLMNPQRSTVWY"[rand() % 20];
+  return query;
+}
+
+static void test_searching_proteins(void ** state){
+  srand(2);
+  const uint64_t length = 30000;
+  char* seq = generating_sequence(length);
+  char* rc = reverse_complement(seq, length);
+  long int* seq_bin = set_binary_array(seq, length);
+  thread_pool_t* pool = thread_pool_create(4);
+
+  for (int reduced = 0; reduced < 2; reduced++) {
+    protein_db_t db;
+    assert_int_equal(0, indexing_proteins(seq_bin, length, 1, reduced ? 4 : 3, reduced, &db));
+    char* queries[24];
+    uint32_t starts[24];
+    for (int i = 0; i < 24; i++)
+      queries[i] = sampling_query(&db, i % 6, &starts[i], 20 + rand() % 30);
+
+    protein_hit_t* hits[2];
+    long nb_hits[2];
+    for (int threaded = 0; threaded < 2; threaded++)
+      nb_hits[threaded] = searching_proteins(threaded ? pool : NULL, &db, (const char* const*)queries, 24, 40, 15,
+                                             &hits[threaded]);
+    assert_true(nb_hits[0] >= 24);
+    assert_int_equal(nb_hits[0], nb_hits[1]);
+    assert_memory_equal(hits[0], hits[1], nb_hits[0] * sizeof(*hits[0]));
+
+    for (int i = 0; i < 24; i++) {
+      // Best hit of the query on its stretch
+      long h = 0;
+      while (h < nb_hits[0] && hits[0][h].query != (uint32_t)i)
+        h++;
+      assert_true(h < nb_hits[0]);
+      const protein_hit_t* hit = &hits[0][h];
+      assert_int_equal(i % 6, hit->frame);
+      assert_int_equal(hit->subject_start - hit->query_start, starts[i]);
+      assert_true(hit->length <= strlen(queries[i]));
+
+      // Score and bases of the hit
+      const int8_t* matrix = substitution_matrix(SUBSTITUTION_BLOSUM62);
+      const char* subject = db.residues + db.frame_start[hit->frame] + hit->subject_start;
+      int score = 0;
+      for (uint32_t r = 0; r < hit->length; r++)
+        score += matrix[substitution_code(queries[i][hit->query_start + r]) * SUBSTITUTION_SIZE
+                        + substitution_code(subject[r])];
+      assert_int_equal(score, hit->score);
+      char* aa = hit->frame < 3 ? translating(seq, hit->nt_start, hit->length)
+                                : translating(rc, length - hit->nt_start - 3 * hit->length, hit->length);
+      assert_memory_equal(subject, aa, hit->length);
+      free(aa);
+      for (; h < nb_hits[0] && hits[0][h].query == (uint32_t)i; h++)
+        assert_true(hits[0][h].score >= 40);
+    }
+
+    for (int i = 0; i < 24; i++)
+      free(queries[i]);
+    free(hits[0]);
+    free(hits[1]);
+    protein_db_free(&db);
+  }
+  thread_pool_destroy(pool);
+  free(seq_bin);
+  free(rc);
+  free(seq);
+}
+
+static void test_searching_proteins_none(void ** state){
+  srand(3);
+  long int* seq_bin = set_binary_array("ATGAAACCCGGGTTTTAA", 18);
+  protein_db_t db;
+  assert_int_equal(0, indexing_proteins(seq_bin, 18, 1, 3, 0, &db));
+  protein_hit_t* hits;
+  const char* queries[] = { "", "MK", "WWWWWWWW", "MKPGF" };
+  assert_int_equal(1, searching_proteins(NULL, &db, queries, 4, 28, 10, &hits));
+  assert_int_equal(3, hits[0].query);
+  assert_int_equal(0, hits[0].frame);
+  assert_int_equal(0, hits[0].nt_start);
+  assert_int_equal(5, hits[0].length);
+  free(hits);
+  assert_int_equal(0, searching_proteins(NULL, &db, queries, 0, 20, 10, &hits));
+  free(hits);
+  assert_int_equal(-1, searching_proteins(NULL, &db, queries, 4, 20, -1, &hits));
+  protein_db_free(&db);
+  free(seq_bin);
+}
+
+int main(void) {
+  int result = 0;
+  const struct CMUnitTest tests[] = {
+    cmocka_unit_test(test_indexing_proteins),
+    cmocka_unit_test(test_searching_proteins),
+    cmocka_unit_test(test_searching_proteins_none),
+  };
+  result |= cmocka_run_group_tests_name("protein_search", tests, NULL, NULL);
+
+  return result;
+}
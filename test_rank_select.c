@@ -0,0 +1,114 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdint.h>
+#include <string.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+
+#include "rank_select.h"
+#include "rank_select.c"
+
+// Random sequence, with long runs of a single base
+static char* generating_sequence(const uint64_t length){
+  char* seq = malloc(length + 1);
+  for (uint64_t i = 0; i < length; i++)
+    seq[i] = i % 5000 < 2000 ? "ACGT"[rand() % 4] : i % 5000 < 3500 ? 'A' : "ACGT"[rand() % 2 * 3];
+  seq[length] = '\0';
+  return seq;
+}
+
+static void test_rank_select_rank(void ** state){
+  srand(1);
+  // Every end of a block and of a superblock
+  for (uint64_t length = 0; length < 20000; length += length < 1000 ? 1 : 1237) {
+    char* seq = generating_sequence(length);
+    long int* seq_bin = set_binary_array(seq, length);
+    rank_select_t index;
+    assert_int_equal(0, rank_select_init(&index, seq_bin, length));
+
+    uint64_t count[4] = { 0 };
+    for (uint64_t pos = 0; pos <= length; pos++) {
+      for (int b = 0; b < 4; b++)
+        assert_int_equal(count[b], rank_select_rank(&index, "ACGT"[b], pos));
+      if (pos < length)
+        count[strchr("ACGT", seq[pos]) - "ACGT"]++;
+    }
+    assert_int_equal(count[3], rank_select_rank(&index, 'u', length + 10));
+    assert_int_equal(0, rank_select_rank(&index, 'N', length));
+
+    free(seq);
+    free(seq_bin);
+    rank_select_free(&index);
+  }
+}
+
+static void test_rank_select_count(void ** state){
+  srand(2);
+  const uint64_t length = 30000;
+  char* seq = generating_sequence(length);
+  long int* seq_bin = set_binary_array(seq, length);
+  rank_select_t index;
+  assert_int_equal(0, rank_select_init(&index, seq_bin, length));
+
+  for (int t = 0; t < 2000; t++) {
+    uint64_t start = rand() % length, end = start + rand() % (length - start + 1);
+    uint64_t count[4] = { 0 };
+    for (uint64_t i = start; i < end; i++)
+      count[strchr("ACGT", seq[i]) - "ACGT"]++;
+    for (int b = 0; b < 4; b++)
+      assert_int_equal(count[b], rank_select_count(&index, "acgt"[b], start, end));
+    assert_int_equal(count[1] + count[2], rank_select_gc(&index, start, end));
+  }
+  assert_int_equal(0, rank_select_gc(&index, 100, 50));
+
+  // Windows
+  float gc[40];
+  assert_int_equal(30, rank_select_gc_windows(&index, 1000, 1000, gc));
+  for (int i = 0; i < 30; i++)
+    assert_float_equal(rank_select_gc(&index, i * 1000, i * 1000 + 1000) / 10.0, gc[i], 1e-4);
+  assert_int_equal(0, rank_select_gc_windows(&index, length + 1, 1, gc));
+  assert_int_equal(-1, rank_select_gc_windows(&index, 0, 1, gc));
+
+  free(seq);
+  free(seq_bin);
+  rank_select_free(&index);
+}
+
+static void test_rank_select_select(void ** state){
+  srand(3);
+  for (uint64_t length = 1; length < 40000; length = length * 3 + 7) {
+    char* seq = generating_sequence(length);
+    long int* seq_bin = set_binary_array(seq, length);
+    rank_select_t index;
+    assert_int_equal(0, rank_select_init(&index, seq_bin, length));
+
+    uint64_t count[4] = { 0 };
+    for (uint64_t pos = 0; pos < length; pos++) {
+      int b = strchr("ACGT", seq[pos]) - "ACGT";
+      assert_int_equal(pos, rank_select_select(&index, "ACGT"[b], count[b]++));
+    }
+    for (int b = 0; b < 4; b++)
+      assert_int_equal(-1, rank_select_select(&index, "ACGT"[b], count[b]));
+    assert_int_equal(-1, rank_select_select(&index, 'N', 0));
+
+    free(seq);
+    free(seq_bin);
+    rank_select_free(&index);
+  }
+
+  rank_select_t index;
+  assert_int_equal(-1, rank_select_init(&index, NULL, 10));
+}
+
+int main(void) {
+  int result = 0;
+  const struct CMUnitTest tests[] = {
+    cmocka_unit_test(test_rank_select_rank),
+    cmocka_unit_test(test_rank_select_count),
+    cmocka_unit_test(test_rank_select_select),
+  };
+  result |= cmocka_run_group_tests_name("rank_select", tests, NULL, NULL);
+
+  return result;
+}
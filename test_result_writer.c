@@ -0,0 +1,214 @@
+#include <stdint.h>
+#include <string.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+
+#include "result_writer.h"
+#include "result_writer.c"
+
+#define NB_THREADS 4
+// More results than a block per thread
+#define NB_GENES 3000
+
+typedef struct producer_s {
+  result_writer_t* writer;
+  unsigned thread_id;
+  int res;
+}producer_t;
+
+// Each gene of a thread: the gene, its protein, one mutation zone and one score
+static void* producing(void* arg){
+  producer_t* p = arg;
+  for (unsigned long long g = 0; g < NB_GENES; g++) {
+    result_t r = { .type = RESULT_GENE, .record = p->thread_id, .gene_start = 10 * g, .gene_end = 10 * g + 5 };
+    p->res |= result_writer_write(p->writer, p->thread_id, &r);
+    r.type = RESULT_PROTEIN;
+    r.protein = g % 2 ? "MKO" : "MA";
+    p->res |= result_writer_write(p->writer, p->thread_id, &r);
+    r.type = RESULT_MUTATION;
+    r.mut_start = 1;
+    r.mut_end = 3;
+    r.mut_size = g;
+    p->res |= result_writer_write(p->writer, p->thread_id, &r);
+    r.type = RESULT_SCORE;
+    r.record2 = 0;
+    r.gene2_start = 2;
+    r.gene2_end = 7;
+    r.score = 50.5;
+    p->res |= result_writer_write(p->writer, p->thread_id, &r);
+  }
+  return NULL;
+}
+
+// Write the results of NB_THREADS threads in a temporary file
+static FILE* writing_results(const result_writer_format_t format){
+  FILE* f = tmpfile();
+  assert_non_null(f);
+  result_writer_t* writer = result_writer_open(f, format, NB_THREADS);
+  assert_non_null(writer);
+
+  pthread_t threads[NB_THREADS];
+  producer_t producers[NB_THREADS];
+  for (unsigned t = 0; t < NB_THREADS; t++) {
+    producers[t].writer = writer;
+    producers[t].thread_id = t;
+    producers[t].res = 0;
+    pthread_create(&threads[t], NULL, producing, &producers[t]);
+  }
+  for (unsigned t = 0; t < NB_THREADS; t++) {
+    pthread_join(threads[t], NULL);
+    assert_int_equal(0, producers[t].res);
+  }
+  assert_int_equal(0, result_writer_close(writer));
+  rewind(f);
+  return f;
+}
+
+static void test_result_writer_tsv(void ** state){
+  FILE* f = writing_results(RESULT_WRITER_TSV);
+
+  char line[256];
+  unsigned long counts[RESULT_TYPES] = { 0 };
+  unsigned long sizes = 0;
+  while (fgets(line, sizeof(line), f)) {
+    unsigned long record, size;
+    unsigned long long start, end, mut_start, mut_end;
+    char protein[16];
+    if (!strncmp(line, "gene\t", 5)) {
+      assert_int_equal(3, sscanf(line, "gene\t%lu\t%llu\t%llu", &record, &start, &end));
+      assert_int_equal(start + 5, end);
+      counts[RESULT_GENE]++;
+    }
+    else if (!strncmp(line, "protein\t", 8)) {
+      assert_int_equal(4, sscanf(line, "protein\t%lu\t%llu\t%llu\t%15s", &record, &start, &end, protein));
+      assert_string_equal(start % 20 ? "MKO" : "MA", protein);
+      counts[RESULT_PROTEIN]++;
+    }
+    else if (!strncmp(line, "mutation\t", 9)) {
+      assert_int_equal(6, sscanf(line, "mutation\t%lu\t%llu\t%llu\t%llu\t%llu\t%lu",
+                                 &record, &start, &end, &mut_start, &mut_end, &size));
+      assert_int_equal(start / 10, size);
+      sizes += size;
+      counts[RESULT_MUTATION]++;
+    }
+    else {
+      // Second gene, then the score
+      assert_non_null(strstr(line, "\t0\t2\t7\t50.5\n"));
+      counts[RESULT_SCORE]++;
+    }
+  }
+  fclose(f);
+
+  for (int t = 0; t < RESULT_TYPES; t++)
+    assert_int_equal(NB_THREADS * NB_GENES, counts[t]);
+  assert_int_equal(NB_THREADS * (unsigned long)NB_GENES * (NB_GENES - 1) / 2, sizes);
+}
+
+static void test_result_writer_jsonl(void ** state){
+  FILE* f = tmpfile();
+  assert_non_null(f);
+  result_writer_t* writer = result_writer_open(f, RESULT_WRITER_JSONL, 1);
+  assert_non_null(writer);
+
+  result_t r = { .type = RESULT_PROTEIN, .record = 1, .gene_start = 4, .gene_end = 33, .protein = "M\"A\\" };
+  assert_int_equal(0, result_writer_write(writer, 0, &r));
+  r.type = RESULT_SCORE;
+  r.score = 0.0f / 0.0f;
+  assert_int_equal(0, result_writer_write(writer, 0, &r));
+  // Invalid thread number
+  assert_int_equal(-1, result_writer_write(writer, 1, &r));
+  assert_int_equal(0, result_writer_close(writer));
+
+  char line[256];
+  rewind(f);
+  assert_non_null(fgets(line, sizeof(line), f));
+  assert_string_equal("{\"type\":\"protein\",\"record\":1,\"gene_start\":4,\"gene_end\":33,"
+                      "\"protein\":\"M\\u0022A\\u005c\"}\n", line);
+  assert_non_null(fgets(line, sizeof(line), f));
+  assert_string_equal("{\"type\":\"score\",\"record\":1,\"gene_start\":4,\"gene_end\":33,"
+                      "\"record2\":0,\"gene2_start\":0,\"gene2_end\":0,\"score\":null}\n", line);
+  assert_null(fgets(line, sizeof(line), f));
+  fclose(f);
+}
+
+static void test_result_writer_binary(void ** state){
+  FILE* f = writing_results(RESULT_WRITER_BINARY);
+
+  char magic[sizeof(RESULT_WRITER_MAGIC)];
+  assert_int_equal(1, fread(magic, sizeof(magic), 1, f));
+  assert_string_equal(RESULT_WRITER_MAGIC, magic);
+
+  // Read the columns block by block
+  unsigned long counts[RESULT_TYPES] = { 0 };
+  unsigned long long sizes = 0, chars = 0;
+  uint32_t block_counts[RESULT_TYPES];
+  uint64_t* columns = malloc(7 * RESULT_WRITER_BLOCK_RECORDS * sizeof(uint64_t));
+  while (fread(block_counts, sizeof(block_counts), 1, f) == 1) {
+    for (int t = 0; t < RESULT_TYPES; t++) {
+      uint32_t n = block_counts[t];
+      counts[t] += n;
+      if (!n)
+        continue;
+      assert_int_equal(3, fread(columns, n * sizeof(uint64_t), 3, f));
+      // gene_end = gene_start + 5
+      for (uint32_t i = 0; i < n; i++)
+        assert_int_equal(columns[n + i] + 5, columns[2 * n + i]);
+
+      if (t == RESULT_PROTEIN) {
+        uint32_t* lengths = (uint32_t*)columns;
+        assert_int_equal(1, fread(lengths, n * sizeof(uint32_t), 1, f));
+        unsigned long total = 0;
+        for (uint32_t i = 0; i < n; i++)
+          total += lengths[i];
+        char* text = malloc(total);
+        assert_int_equal(1, fread(text, total, 1, f));
+        assert_true(text[0] == 'M');
+        chars += total;
+        free(text);
+      }
+      else if (t == RESULT_MUTATION) {
+        assert_int_equal(3, fread(columns, n * sizeof(uint64_t), 3, f));
+        for (uint32_t i = 0; i < n; i++)
+          sizes += columns[2 * n + i];
+      }
+      else if (t == RESULT_SCORE) {
+        assert_int_equal(3, fread(columns, n * sizeof(uint64_t), 3, f));
+        float* scores = (float*)columns;
+        assert_int_equal(1, fread(scores, n * sizeof(float), 1, f));
+        for (uint32_t i = 0; i < n; i++)
+          assert_true(scores[i] == 50.5f);
+      }
+    }
+  }
+  free(columns);
+  fclose(f);
+
+  for (int t = 0; t < RESULT_TYPES; t++)
+    assert_int_equal(NB_THREADS * NB_GENES, counts[t]);
+  assert_int_equal(NB_THREADS * (unsigned long long)NB_GENES * (NB_GENES - 1) / 2, sizes);
+  assert_int_equal(NB_THREADS * (NB_GENES / 2) * 5, chars);
+}
+
+static void test_result_writer_parse_format(void ** state){
+  result_writer_format_t format;
+  assert_int_equal(0, result_writer_parse_format("jsonl", &format));
+  assert_int_equal(RESULT_WRITER_JSONL, format);
+  assert_int_equal(0, result_writer_parse_format("binary", &format));
+  assert_int_equal(RESULT_WRITER_BINARY, format);
+  assert_int_equal(-1, result_writer_parse_format("html", &format));
+}
+
+int main(void) {
+  int result = 0;
+  const struct CMUnitTest tests[] = {
+    cmocka_unit_test(test_result_writer_tsv),
+    cmocka_unit_test(test_result_writer_jsonl),
+    cmocka_unit_test(test_result_writer_binary),
+    cmocka_unit_test(test_result_writer_parse_format),
+  };
+  result |= cmocka_run_group_tests_name("result_writer", tests, NULL, NULL);
+
+  return result;
+}
@@ -0,0 +1,201 @@
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+
+#include "similarity.h"
+#include "similarity.c"
+
+#define NB_GENES 48
+#define MAX_GENE 600
+
+// Genes of A, C and G only (no stop codon inside), every fourth one is a mutated copy of a gene shared by all seeds
+static long int* generating_sequence(const unsigned seed, long int* nb_bits){
+  char* seq = malloc(NB_GENES * (MAX_GENE + 8) + 1);
+  long int length = 0, size;
+  srand(seed);
+  for (int g = 0; g < NB_GENES; g++) {
+    memcpy(seq + length, "CATGC", 5);
+    length += 5;
+    if (g % 4 == 3) {
+      unsigned long shared = g;
+      size = 60 + (shared = shared * 6364136223846793005UL + 1442695040888963407UL) % (MAX_GENE - 60);
+      for (long int i = 0; i < size; i++) {
+        shared = shared * 6364136223846793005UL + 1442695040888963407UL;
+        seq[length + i] = i % 40 ? "ACG"[(shared >> 33) % 3] : "ACG"[rand() % 3];
+      }
+    }
+    else {
+      size = 60 + rand() % (MAX_GENE - 60);
+      for (long int i = 0; i < size; i++)
+        seq[length + i] = "ACG"[rand() % 3];
+    }
+    length += size;
+    memcpy(seq + length, "TAA", 3);
+    length += 3;
+  }
+  seq[length] = '\0';
+  *nb_bits = binary_array_size(2 * length) * int_SIZE;
+  long int* seq_bin = convert_to_binary(seq, length);
+  free(seq);
+  return seq_bin;
+}
+
+typedef struct genome_s {
+  long int* seq;
+  gene_map_t genes;
+  similarity_genes_t set;
+}genome_t;
+
+static void preparing(genome_t* g, const unsigned seed){
+  long int nb_bits;
+  g->seq = generating_sequence(seed, &nb_bits);
+  g->genes.genes_counter = 0;
+  g->genes.gene_start = malloc(sizeof(*g->genes.gene_start) * nb_bits);
+  g->genes.gene_end = malloc(sizeof(*g->genes.gene_end) * nb_bits);
+  detecting_genes(g->seq, nb_bits, &g->genes);
+  assert_true(g->genes.genes_counter > 10);
+  assert_int_equal(0, similarity_prepare(g->seq, &g->genes, &g->set));
+}
+
+static void freeing(genome_t* g){
+  similarity_free(&g->set);
+  free(g->genes.gene_start);
+  free(g->genes.gene_end);
+  free(g->seq);
+}
+
+static float scoring(const genome_t* g1, const unsigned long long j, const genome_t* g2, const unsigned long long k){
+  return calculating_matching_score(g1->seq, g1->genes.gene_start[j], g1->genes.gene_end[j] - g1->genes.gene_start[j] + 1,
+                                    g2->seq, g2->genes.gene_start[k], g2->genes.gene_end[k] - g2->genes.gene_start[k] + 1);
+}
+
+static void test_similarity_all(void ** state){
+  genome_t g1, g2;
+  preparing(&g1, 1);
+  preparing(&g2, 2);
+
+  // Without threshold, every pair gets the score of calculating_matching_score
+  similarity_hit_t* hits = malloc(sizeof(*hits) * g2.set.nb_genes);
+  similarity_stats_t stats = { 0 };
+  for (unsigned long long j = 0; j < g1.set.nb_genes; j++) {
+    assert_int_equal(g2.set.nb_genes, similarity_above(&g1.set, j, &g2.set, -INFINITY, hits, &stats));
+    for (unsigned long long k = 0; k < g2.set.nb_genes; k++) {
+      assert_int_equal(j, hits[k].gene1);
+      assert_int_equal(k, hits[k].gene2);
+      assert_true(hits[k].score == scoring(&g1, j, &g2, k));
+    }
+  }
+  assert_int_equal(g1.set.nb_genes * g2.set.nb_genes, stats.pairs);
+  assert_int_equal(stats.pairs, stats.scored);
+
+  free(hits);
+  freeing(&g1);
+  freeing(&g2);
+}
+
+static void test_similarity_above(void ** state){
+  genome_t g1, g2;
+  preparing(&g1, 3);
+  preparing(&g2, 4);
+
+  similarity_hit_t* hits = malloc(sizeof(*hits) * g2.set.nb_genes);
+  similarity_stats_t stats = { 0 };
+  unsigned long long found = 0;
+  for (unsigned long long j = 0; j < g1.set.nb_genes; j++) {
+    unsigned long long n = similarity_above(&g1.set, j, &g2.set, 80, hits, &stats);
+    unsigned long long h = 0;
+    for (unsigned long long k = 0; k < g2.set.nb_genes; k++) {
+      float score = scoring(&g1, j, &g2, k);
+      if (score < 80)
+        continue;
+      assert_true(h < n);
+      assert_int_equal(k, hits[h].gene2);
+      assert_true(hits[h].score == score);
+      h++;
+    }
+    assert_int_equal(h, n);
+    found += n;
+  }
+  // Most pairs are not scored in full
+  assert_true(found > 0);
+  assert_int_equal(stats.pairs, stats.pruned_pieces + stats.pruned_blocks + stats.pruned_words + stats.scored);
+  assert_true(stats.scored < stats.pairs / 2);
+
+  free(hits);
+  freeing(&g1);
+  freeing(&g2);
+}
+
+static void test_similarity_top_k(void ** state){
+  genome_t g1, g2;
+  preparing(&g1, 5);
+  preparing(&g2, 6);
+
+  unsigned long long n2 = g2.set.nb_genes, k = 5;
+  similarity_hit_t* hits = malloc(sizeof(*hits) * n2);
+  similarity_hit_t* all = malloc(sizeof(*all) * n2);
+  similarity_stats_t stats = { 0 };
+  for (unsigned long long j = 0; j < g1.set.nb_genes; j++) {
+    // Best pairs of all the pairs
+    for (unsigned long long c = 0; c < n2; c++)
+      all[c] = (similarity_hit_t){ j, c, scoring(&g1, j, &g2, c) };
+    qsort(all, n2, sizeof(*all), similarity_comparing);
+
+    assert_int_equal(k, similarity_top_k(&g1.set, j, &g2.set, k, -INFINITY, hits, &stats));
+    for (unsigned long long h = 0; h < k; h++) {
+      assert_int_equal(all[h].gene2, hits[h].gene2);
+      assert_true(all[h].score == hits[h].score);
+    }
+
+    // With a threshold: the best pairs above it
+    unsigned long long above = 0;
+    while (above < k && all[above].score >= all[2].score)
+      above++;
+    assert_int_equal(above, similarity_top_k(&g1.set, j, &g2.set, k, all[2].score, hits, &stats));
+    assert_int_equal(all[0].gene2, hits[0].gene2);
+  }
+  assert_true(stats.scored < stats.pairs);
+  // More pairs than genes
+  assert_int_equal(n2, similarity_top_k(&g1.set, 0, &g2.set, n2 + 3, -INFINITY, hits, &stats));
+  assert_int_equal(0, similarity_top_k(&g1.set, 0, &g2.set, 0, -INFINITY, hits, &stats));
+
+  free(all);
+  free(hits);
+  freeing(&g1);
+  freeing(&g2);
+}
+
+static void test_similarity_same_genome(void ** state){
+  genome_t g;
+  preparing(&g, 7);
+
+  // A gene is not compared with itself
+  unsigned long long n = g.set.nb_genes;
+  similarity_hit_t* hits = malloc(sizeof(*hits) * n);
+  similarity_stats_t stats = { 0 };
+  assert_int_equal(n - 1, similarity_above(&g.set, 1, &g.set, -INFINITY, hits, &stats));
+  for (unsigned long long h = 0; h < n - 1; h++)
+    assert_int_not_equal(1, hits[h].gene2);
+  assert_int_equal(1, similarity_top_k(&g.set, 1, &g.set, 1, -INFINITY, hits, &stats));
+  assert_int_not_equal(1, hits[0].gene2);
+
+  free(hits);
+  freeing(&g);
+}
+
+int main(void) {
+  int result = 0;
+  const struct CMUnitTest tests[] = {
+    cmocka_unit_test(test_similarity_all),
+    cmocka_unit_test(test_similarity_above),
+    cmocka_unit_test(test_similarity_top_k),
+    cmocka_unit_test(test_similarity_same_genome),
+  };
+  result |= cmocka_run_group_tests_name("similarity", tests, NULL, NULL);
+
+  return result;
+}
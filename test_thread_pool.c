@@ -0,0 +1,108 @@
+#include <stdint.h>
+#include <string.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+
+#include "thread_pool.h"
+#include "thread_pool.c"
+
+static void count_task(void* arg, const unsigned long long begin, const unsigned long long end, const unsigned thread_id){
+  unsigned* counts = arg;
+  for (unsigned long long i = begin; i < end; i++)
+    __atomic_fetch_add(&counts[i], 1, __ATOMIC_RELAXED);
+}
+
+static void owner_task(void* arg, const unsigned long long begin, const unsigned long long end, const unsigned thread_id){
+  unsigned* owners = arg;
+  for (unsigned long long i = begin; i < end; i++)
+    owners[i] = thread_id;
+}
+
+static void test_thread_pool_partition(void ** state){
+  // Contiguous parts covering the range, sizes differing by at most one
+  unsigned long long begin, end, prev_end = 0;
+  for (unsigned t = 0; t < 7; t++) {
+    thread_pool_partition(100, 7, t, &begin, &end);
+    assert_int_equal(prev_end, begin);
+    assert_true(end - begin == 14 || end - begin == 15);
+    prev_end = end;
+  }
+  assert_int_equal(100, prev_end);
+
+  // More threads than elements
+  thread_pool_partition(2, 4, 3, &begin, &end);
+  assert_int_equal(begin, end);
+}
+
+static void test_thread_pool_run(void ** state){
+  thread_pool_t* pool = thread_pool_create(4);
+  assert_ptr_not_equal(NULL, pool);
+  assert_int_equal(4, pool->nb_threads);
+
+  unsigned counts[1000];
+  unsigned owners[1000];
+
+  // Each element is processed exactly once, by the thread of its static part
+  for (int job = 0; job < 10; job++) {
+    memset(counts, 0, sizeof(counts));
+    thread_pool_run(pool, 1000, count_task, counts);
+    for (int i = 0; i < 1000; i++)
+      assert_int_equal(1, counts[i]);
+  }
+  thread_pool_run(pool, 1000, owner_task, owners);
+  for (unsigned t = 0; t < 4; t++) {
+    unsigned long long begin, end;
+    thread_pool_partition(1000, 4, t, &begin, &end);
+    for (unsigned long long i = begin; i < end; i++)
+      assert_int_equal(t, owners[i]);
+  }
+
+  // Dynamic scheduling
+  for (int chunk = 1; chunk < 300; chunk += 37) {
+    memset(counts, 0, sizeof(counts));
+    thread_pool_run_dynamic(pool, 1000, chunk, count_task, counts);
+    for (int i = 0; i < 1000; i++)
+      assert_int_equal(1, counts[i]);
+  }
+
+  // Empty job
+  thread_pool_run(pool, 0, count_task, counts);
+
+  thread_pool_destroy(pool);
+
+  // Single thread pool: the calling thread does all the work
+  pool = thread_pool_create(1);
+  memset(counts, 0, sizeof(counts));
+  thread_pool_run_dynamic(pool, 1000, 10, count_task, counts);
+  for (int i = 0; i < 1000; i++)
+    assert_int_equal(1, counts[i]);
+  thread_pool_destroy(pool);
+}
+
+static void test_thread_pool_first_touch(void ** state){
+  thread_pool_t* pool = thread_pool_create(3);
+  unsigned long long values[1001];
+  memset(values, 0xff, sizeof(values));
+
+  // Zeroed by the thread that processes each element
+  thread_pool_first_touch(pool, values, 1000, sizeof(*values));
+  for (int i = 0; i < 1000; i++)
+    assert_int_equal(0, values[i]);
+  assert_true(values[1000] == ~0ULL);
+
+  thread_pool_destroy(pool);
+}
+
+int main(void) {
+  int result = 0;
+  const struct CMUnitTest tests[] = {
+    cmocka_unit_test(test_thread_pool_partition),
+    cmocka_unit_test(test_thread_pool_run),
+    cmocka_unit_test(test_thread_pool_first_touch),
+  };
+  result |= cmocka_run_group_tests_name("thread_pool", tests, NULL, NULL);
+
+  return result;
+}
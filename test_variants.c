@@ -0,0 +1,238 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdint.h>
+#include <string.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+
+#include "variants.h"
+#include "variants.c"
+
+static char* generating_sequence(const unsigned long long length){
+  char* seq = malloc(length + 1);
+  for (unsigned long long i = 0; i < length; i++)
+    seq[i] = "ACGT"[rand() % 4];
+  seq[length] = '\0';
+  return seq;
+}
+
+// Copy with about one substitution every rate bases
+static char* mutating(const char* ref, const unsigned long long length, const int rate){
+  char* seq = strdup(ref);
+  for (unsigned long long i = 0; i < length; i++)
+    if (rand() % rate == 0)
+      seq[i] = "ACGT"[(strchr("ACGT", ref[i]) - "ACGT" + 1 + rand() % 3) % 4];
+  return seq;
+}
+
+// Variants of the decoded strings
+static void checking(const char* ref, const char* seq, const unsigned long long length, const variants_t* variants){
+  unsigned long long v = 0;
+  for (unsigned long long i = 0; i < length; i++) {
+    if (ref[i] == seq[i])
+      continue;
+    assert_true(v < variants->nb_variants);
+    assert_int_equal(i, variants->list[v].pos);
+    assert_int_equal(ref[i], variants->list[v].ref);
+    assert_int_equal(seq[i], variants->list[v].alt);
+    v++;
+  }
+  assert_int_equal(v, variants->nb_variants);
+}
+
+static void test_extracting_variants(void ** state){
+  srand(1);
+  // Every word boundary of the first words, and longer genomes
+  for (unsigned long long length = 1; length < 3000; length += length < 200 ? 1 : 97) {
+    char* ref = generating_sequence(length);
+    char* seq = mutating(ref, length, length < 200 ? 3 : 50);
+    long int* ref_bin = set_binary_array(ref, length);
+    long int* seq_bin = set_binary_array(seq, length);
+
+    variants_t variants;
+    variants_init(&variants);
+    assert_int_equal(0, extracting_variants(ref_bin, seq_bin, length, &variants));
+    checking(ref, seq, length, &variants);
+    variants_free(&variants);
+
+    free(ref);
+    free(seq);
+    free(ref_bin);
+    free(seq_bin);
+  }
+}
+
+static void test_extracting_variants_same(void ** state){
+  srand(2);
+  char* ref = generating_sequence(30000);
+  long int* ref_bin = set_binary_array(ref, 30000);
+  variants_t variants;
+  variants_init(&variants);
+  assert_int_equal(0, extracting_variants(ref_bin, ref_bin, 30000, &variants));
+  assert_int_equal(0, variants.nb_variants);
+
+  // Appended to the list
+  char* seq = mutating(ref, 30000, 1000);
+  long int* seq_bin = set_binary_array(seq, 30000);
+  assert_int_equal(0, extracting_variants(ref_bin, seq_bin, 30000, &variants));
+  assert_int_equal(0, extracting_variants(ref_bin, seq_bin, 30000, &variants));
+  assert_true(variants.nb_variants > 0 && variants.nb_variants % 2 == 0);
+  for (unsigned long long v = 0, half = variants.nb_variants / 2; v < half; v++) {
+    assert_int_equal(variants.list[v].pos, variants.list[half + v].pos);
+    assert_int_equal(variants.list[v].alt, variants.list[half + v].alt);
+  }
+
+  assert_int_equal(-1, extracting_variants(NULL, seq_bin, 30000, &variants));
+  // The positions are in 32 bits, the bits read at int positions
+  assert_int_equal(-1, extracting_variants(ref_bin, seq_bin, VARIANTS_MAX_BASES, &variants));
+  variants_free(&variants);
+  free(ref);
+  free(seq);
+  free(ref_bin);
+  free(seq_bin);
+}
+
+static void test_extracting_variants_collection(void ** state){
+  srand(3);
+  const unsigned long long nb_genomes = 40, length = 20000;
+  char* ref = generating_sequence(length);
+  long int* ref_bin = set_binary_array(ref, length);
+  char* seqs[40];
+  long int* seqs_bin[40];
+  unsigned long long nb_bases[40];
+  for (unsigned long long g = 0; g < nb_genomes; g++) {
+    seqs[g] = mutating(ref, length, 100 + g);
+    seqs_bin[g] = set_binary_array(seqs[g], length);
+    nb_bases[g] = length - g;
+  }
+
+  thread_pool_t* pool = thread_pool_create(4);
+  assert_non_null(pool);
+  variants_t variants[40];
+  for (int threaded = 0; threaded < 2; threaded++) {
+    for (unsigned long long g = 0; g < nb_genomes; g++)
+      variants_init(&variants[g]);
+    assert_int_equal(0, extracting_variants_collection(threaded ? pool : NULL, ref_bin, (const long int* const*)seqs_bin,
+                                                       nb_bases, nb_genomes, variants));
+    for (unsigned long long g = 0; g < nb_genomes; g++) {
+      checking(ref, seqs[g], nb_bases[g], &variants[g]);
+      variants_free(&variants[g]);
+    }
+  }
+  thread_pool_destroy(pool);
+
+  for (unsigned long long g = 0; g < nb_genomes; g++) {
+    free(seqs[g]);
+    free(seqs_bin[g]);
+  }
+  free(ref);
+  free(ref_bin);
+}
+
+// Reference with open reading frames planted every few hundred bases
+static char* generating_orfs(const unsigned long long length){
+  char* ref = generating_sequence(length);
+  for (unsigned long long i = rand() % 300; i + 200 < length; i += 100 + rand() % 400) {
+    memcpy(ref + i, "ATG", 3);
+    unsigned long long end = i + 3 * (10 + rand() % 50);
+    memcpy(ref + end, (const char*[]){ "TAA", "TAG", "TGA" }[rand() % 3], 3);
+  }
+  return ref;
+}
+
+static void assert_genes_equal(const gene_map_t* expected, const gene_map_t* genes){
+  assert_int_equal(expected->genes_counter, genes->genes_counter);
+  for (unsigned long long g = 0; g < genes->genes_counter; g++) {
+    assert_int_equal(expected->gene_start[g], genes->gene_start[g]);
+    assert_int_equal(expected->gene_end[g], genes->gene_end[g]);
+  }
+}
+
+static void test_indexing_genes(void ** state){
+  srand(4);
+  for (unsigned long long length = 0; length < 5000; length += 1 + rand() % 700) {
+    char* ref = generating_orfs(length);
+    long int* ref_bin = set_binary_array(ref, length);
+    gene_map_t expected = { 0 };
+    detecting_genes(ref_bin, 2 * length, &expected);
+
+    gene_index_t index;
+    assert_int_equal(0, indexing_genes(ref_bin, 2 * length, &index));
+    assert_genes_equal(&expected, &index.genes);
+    assert_int_equal(2 * length / (2 * GENE_INDEX_BLOCK) + 1, index.nb_checkpoints);
+    for (unsigned long long c = 1; c < index.nb_checkpoints; c++)
+      assert_true(index.checkpoint_pos[c] >= (long)(c * 2 * GENE_INDEX_BLOCK) || index.checkpoint_pos[c] + 6 > index.nb_bits);
+
+    gene_index_free(&index);
+    free(expected.gene_start);
+    free(expected.gene_end);
+    free(ref_bin);
+    free(ref);
+  }
+}
+
+static void test_detecting_genes_variants(void ** state){
+  srand(5);
+  const unsigned long long length = 20000;
+  char* ref = generating_orfs(length);
+  long int* ref_bin = set_binary_array(ref, length);
+  gene_index_t index;
+  assert_int_equal(0, indexing_genes(ref_bin, 2 * length, &index));
+
+  const int rates[] = { 0, 5000, 500, 50, 5, 1 };
+  for (int r = 0; r < 6; r++)
+    for (int t = 0; t < 10; t++) {
+      char* seq = rates[r] ? mutating(ref, length, rates[r]) : strdup(ref);
+      // Starts and stops made and broken, and the ends of the genome
+      for (int k = 0; k < 3 && r; k++) {
+        unsigned long long i = rand() % (length - 3);
+        memcpy(seq + i, (const char*[]){ "ATG", "TAA", "TAG", "TGA", "CCC" }[rand() % 5], 3);
+      }
+      if (t % 2) {
+        seq[0] = "ACGT"[rand() % 4];
+        seq[length - 1] = "ACGT"[rand() % 4];
+      }
+      long int* seq_bin = set_binary_array(seq, length);
+      variants_t variants;
+      variants_init(&variants);
+      assert_int_equal(0, extracting_variants(ref_bin, seq_bin, length, &variants));
+
+      gene_map_t expected = { 0 }, genes;
+      detecting_genes(seq_bin, 2 * length, &expected);
+      long scanned = detecting_genes_variants(ref_bin, &index, &variants, &genes);
+      assert_true(scanned >= 0 && scanned <= 2 * (long)length);
+      assert_genes_equal(&expected, &genes);
+      // A few blocks around each variant only
+      if (variants.nb_variants == 0)
+        assert_int_equal(0, scanned);
+      else if (rates[r] >= 500)
+        assert_true(8 * scanned < 2 * (long)length);
+
+      free(genes.gene_start);
+      free(genes.gene_end);
+      free(expected.gene_start);
+      free(expected.gene_end);
+      variants_free(&variants);
+      free(seq_bin);
+      free(seq);
+    }
+
+  gene_index_free(&index);
+  free(ref_bin);
+  free(ref);
+}
+
+int main(void) {
+  int result = 0;
+  const struct CMUnitTest tests[] = {
+    cmocka_unit_test(test_extracting_variants),
+    cmocka_unit_test(test_extracting_variants_same),
+    cmocka_unit_test(test_extracting_variants_collection),
+    cmocka_unit_test(test_indexing_genes),
+    cmocka_unit_test(test_detecting_genes_variants),
+  };
+  result |= cmocka_run_group_tests_name("variants", tests, NULL, NULL);
+
+  return result;
+}
@@ -0,0 +1,238 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "thread_pool.h"
+
+
+/**
+ * Number of threads used when none is requested.
+ *
+ * out : unsigned : number of online CPUs (at least 1)
+ */
+unsigned thread_pool_default_size(void){
+    long nb = sysconf(_SC_NPROCESSORS_ONLN);
+    return nb > 0 ? (unsigned)nb : 1;
+}
+
+/**
+ * Static partitioning of a range between the threads.
+ *
+ * in : size : number of elements of the range [0, size)
+ * in : nb_threads : number of threads
+ * in : thread_id : thread number (0 <= thread_id < nb_threads)
+ * out : begin, end : part [begin, end) of the thread
+ *
+ * The parts are contiguous and their sizes differ by at most one element.
+ * The same partitioning must be used to place the memory (first touch) and to process it.
+ */
+void thread_pool_partition(const unsigned long long size, const unsigned nb_threads, const unsigned thread_id,
+                           unsigned long long* begin, unsigned long long* end){
+    unsigned long long part = size / nb_threads;
+    unsigned long long rest = size % nb_threads;
+    *begin = thread_id * part + (thread_id < rest ? thread_id : rest);
+    *end = *begin + part + (thread_id < rest);
+}
+
+/**
+ * Run the part of the current job of one thread.
+ */
+static void thread_pool_work(thread_pool_t* pool, const unsigned thread_id){
+    if (!pool->chunk) {
+        unsigned long long begin, end;
+        thread_pool_partition(pool->size, pool->nb_threads, thread_id, &begin, &end);
+        if (begin < end)
+            pool->task(pool->arg, begin, end, thread_id);
+        return;
+    }
+
+    // Dynamic scheduling: claim chunks until the range is exhausted
+    for (;;) {
+        unsigned long long begin = __atomic_fetch_add(&pool->next, pool->chunk, __ATOMIC_RELAXED);
+        if (begin >= pool->size)
+            break;
+        unsigned long long end = begin + pool->chunk < pool->size ? begin + pool->chunk : pool->size;
+        pool->task(pool->arg, begin, end, thread_id);
+    }
+}
+
+typedef struct thread_pool_worker_s {
+    thread_pool_t* pool;
+    unsigned thread_id;
+}thread_pool_worker_t;
+
+/**
+ * Worker thread: wait for a job, run its part, signal its end.
+ */
+static void* thread_pool_worker(void* arg){
+    thread_pool_worker_t worker = *(thread_pool_worker_t*)arg;
+    free(arg);
+    thread_pool_t* pool = worker.pool;
+    unsigned long long generation = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->stop && pool->generation == generation)
+            pthread_cond_wait(&pool->start, &pool->lock);
+        if (pool->stop)
+            break;
+        generation = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        thread_pool_work(pool, worker.thread_id);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->running == 0)
+            pthread_cond_signal(&pool->done);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+/**
+ * Create a pool of threads.
+ *
+ * in : nb_threads : number of threads, the calling thread included (0 = thread_pool_default_size)
+ * out : pool : the thread pool, NULL on error
+ */
+thread_pool_t* thread_pool_create(const unsigned nb_threads){
+    // Allocate memory and verify it has been allocated
+    thread_pool_t* pool = calloc(1, sizeof(*pool));
+    if (!pool)
+        return printf("ERROR: thread_pool_create: cannot allocate memory\n"), NULL;
+
+    pool->nb_threads = nb_threads ? nb_threads : thread_pool_default_size();
+    pool->workers = calloc(pool->nb_threads, sizeof(*pool->workers));
+    if (!pool->workers)
+        return printf("ERROR: thread_pool_create: cannot allocate memory\n"), free(pool), NULL;
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    for (unsigned t = 1; t < pool->nb_threads; t++) {
+        thread_pool_worker_t* worker = malloc(sizeof(*worker));
+        if (worker) {
+            worker->pool = pool;
+            worker->thread_id = t;
+        }
+        if (!worker || pthread_create(&pool->workers[t], NULL, thread_pool_worker, worker)) {
+            printf("ERROR: thread_pool_create: cannot create thread %u\n", t);
+            free(worker);
+            pool->nb_threads = t;
+            thread_pool_destroy(pool);
+            return NULL;
+        }
+    }
+    return pool;
+}
+
+/**
+ * Stop the threads and free the pool.
+ */
+void thread_pool_destroy(thread_pool_t* pool){
+    if (!pool)
+        return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = 1;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (unsigned t = 1; t < pool->nb_threads; t++)
+        pthread_join(pool->workers[t], NULL);
+
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->start);
+    pthread_cond_destroy(&pool->done);
+    free(pool->workers);
+    free(pool);
+}
+
+/**
+ * Run a job and wait for its end.
+ */
+static void thread_pool_job(thread_pool_t* pool, const unsigned long long size, const unsigned long long chunk,
+                            thread_pool_task_t task, void* arg){
+    if (pool->nb_threads == 1) {
+        if (size)
+            task(arg, 0, size, 0);
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->task = task;
+    pool->arg = arg;
+    pool->size = size;
+    pool->chunk = chunk;
+    pool->next = 0;
+    pool->running = pool->nb_threads - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    // The calling thread is the thread 0
+    thread_pool_work(pool, 0);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->running)
+        pthread_cond_wait(&pool->done, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/**
+ * Run a task on the range [0, size), statically partitioned between the threads.
+ *
+ * in : pool : thread pool
+ * in : size : number of elements
+ * in : task : function called once per thread with its part (see thread_pool_partition)
+ * in : arg : argument of the task
+ */
+void thread_pool_run(thread_pool_t* pool, const unsigned long long size, thread_pool_task_t task, void* arg){
+    thread_pool_job(pool, size, 0, task, arg);
+}
+
+/**
+ * Run a task on the range [0, size), claimed by chunks by the threads.
+ *
+ * in : pool : thread pool
+ * in : size : number of elements
+ * in : chunk : number of elements claimed at once (at least 1)
+ * in : task : function called for each claimed chunk
+ * in : arg : argument of the task
+ *
+ * For irregular work (genomes or genes of different sizes).
+ */
+void thread_pool_run_dynamic(thread_pool_t* pool, const unsigned long long size, const unsigned long long chunk,
+                             thread_pool_task_t task, void* arg){
+    thread_pool_job(pool, size, chunk ? chunk : 1, task, arg);
+}
+
+typedef struct thread_pool_touch_s {
+    char* ptr;
+    size_t item_size;
+}thread_pool_touch_t;
+
+static void thread_pool_touching(void* arg, const unsigned long long begin, const unsigned long long end,
+                                 const unsigned thread_id){
+    thread_pool_touch_t* touch = arg;
+    memset(touch->ptr + begin * touch->item_size, 0, (end - begin) * touch->item_size);
+}
+
+/**
+ * Place an array on the NUMA nodes of the threads that process it (first-touch policy).
+ *
+ * in : pool : thread pool
+ * in : ptr : array whose pages are not touched yet (arena_pages_alloc, or an arena with the ARENA_PAGES policy)
+ * in : nb_items, item_size : number and size of the elements of the array
+ * out : ptr : array filled with 0
+ *
+ * Each thread zeroes its part of thread_pool_partition, so that thread_pool_run over the same
+ * nb_items elements finds them in the memory of its node.
+ */
+void thread_pool_first_touch(thread_pool_t* pool, void* ptr, const unsigned long long nb_items, const size_t item_size){
+    thread_pool_touch_t touch = { ptr, item_size };
+    thread_pool_run(pool, nb_items, thread_pool_touching, &touch);
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stddef.h>
+#include <pthread.h>
+
+// Function run by the pool on the range [begin, end) of a job, by the thread number thread_id
+typedef void (*thread_pool_task_t)(void* arg, const unsigned long long begin, const unsigned long long end,
+                                   const unsigned thread_id);
+
+typedef struct thread_pool_s {
+
+    //Number of threads, the calling thread included (thread 0)
+    unsigned nb_threads;
+
+    //Worker threads (nb_threads - 1)
+    pthread_t* workers;
+
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t done;
+
+    //Current job
+    thread_pool_task_t task;
+    void* arg;
+    unsigned long long size;
+    //Chunk size of the dynamic scheduling, 0 for the static partitioning
+    unsigned long long chunk;
+    //Next index to claim (dynamic scheduling)
+    unsigned long long next;
+
+    //Job counter, incremented at each job
+    unsigned long long generation;
+    //Workers that have not finished the current job
+    unsigned running;
+    int stop;
+
+}thread_pool_t;
+
+
+/******** THREAD POOL FUNCTION *********/
+
+unsigned thread_pool_default_size(void);
+thread_pool_t* thread_pool_create(const unsigned nb_threads);
+void thread_pool_destroy(thread_pool_t* pool);
+void thread_pool_partition(const unsigned long long size, const unsigned nb_threads, const unsigned thread_id,
+                           unsigned long long* begin, unsigned long long* end);
+void thread_pool_run(thread_pool_t* pool, const unsigned long long size, thread_pool_task_t task, void* arg);
+void thread_pool_run_dynamic(thread_pool_t* pool, const unsigned long long size, const unsigned long long chunk,
+                             thread_pool_task_t task, void* arg);
+void thread_pool_first_touch(thread_pool_t* pool, void* ptr, const unsigned long long nb_items, const size_t item_size);
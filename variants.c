@@ -0,0 +1,388 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "variants.h"
+
+
+/***************************************/
+/*************** LISTS *****************/
+/***************************************/
+
+void variants_init(variants_t* variants){
+    memset(variants, 0, sizeof(*variants));
+}
+
+void variants_free(variants_t* variants){
+    free(variants->list);
+    memset(variants, 0, sizeof(*variants));
+}
+
+// Append a variant, the list grows by doubling
+static inline int variants_push(variants_t* variants, const uint32_t pos, const char ref, const char alt){
+    if (variants->nb_variants == variants->capacity) {
+        unsigned long long capacity = variants->capacity ? 2 * variants->capacity : 64;
+        variant_t* list = realloc(variants->list, capacity * sizeof(*list));
+        if (!list)
+            return -1;
+        variants->list = list;
+        variants->capacity = capacity;
+    }
+    variants->list[variants->nb_variants++] = (variant_t){ pos, ref, alt };
+    return 0;
+}
+
+// Base at a position of a binary array
+static inline char variants_base(const long int* seq_bin, const uint64_t pos){
+    return "AGCT"[2 * get_binary_value(seq_bin, 2 * pos) + get_binary_value(seq_bin, 2 * pos + 1)];
+}
+
+
+
+/***************************************/
+/************* EXTRACTION **************/
+/***************************************/
+
+/**
+ * Single base differences between a genome and a reference.
+ *
+ * in : ref_bin : reference in binary array format
+ * in : seq_bin : genome in binary array format, aligned on the reference (same positions)
+ * in : nb_bases : bases compared, less than VARIANTS_MAX_BASES
+ * out : variants : (position, reference base, genome base) of each different base appended, by position
+ * out : int : 0, -1 on error (or a longer genome)
+ *
+ * The arrays are xored word by word, and most words of near-identical sequences are equal.
+ * The bits of a different word are put in the order of their positions (get_binary_value keeps
+ * the bit of position pos of word w at (pos - w) % 64), then each pair of bits is folded into a
+ * flag on the first bit of its base, and the flags are read with ctz. A base across two words
+ * is flagged in both and kept once. N and the other letters are packed as A, C or G
+ * (set_binary_array): their positions give variants as the base they are packed as.
+ */
+GENE_KERNEL
+int extracting_variants(const long int* ref_bin, const long int* seq_bin, const unsigned long long nb_bases,
+                        variants_t* variants){
+    if (!ref_bin || !seq_bin || !variants)
+        return printf("ERROR: extracting_variants: undefined sequence\n"), -1;
+    if (nb_bases >= VARIANTS_MAX_BASES)
+        return printf("ERROR: extracting_variants: sequence too long\n"), -1;
+
+    long nb_words = binary_array_size(2 * nb_bases);
+    uint64_t last = UINT64_MAX;
+    for (long w = 0; w < nb_words; w++) {
+        uint64_t x = (uint64_t)(ref_bin[w] ^ seq_bin[w]);
+        if (!x)
+            continue;
+
+        // Positions of the word: 0 to 63, then 64 to 125, then 63 per word
+        uint64_t start = w < 2 ? 64 * w : 63 * w;
+        int n = w ? (w == 1 ? 62 : 63) : 64;
+        int rot = (start - w) & 63;
+        if (rot)
+            x = x >> rot | x << (64 - rot);
+        if (n < 64)
+            x &= (1ULL << n) - 1;
+
+        // First bits of the bases at the even positions, the first bit of an odd word ends a base
+        uint64_t flags = (x | x >> 1) & (start & 1 ? 0xAAAAAAAAAAAAAAAAULL : 0x5555555555555555ULL);
+        if (start & 1)
+            flags |= x & 1;
+
+        while (flags) {
+            uint64_t base = (start + __builtin_ctzll(flags)) / 2;
+            flags &= flags - 1;
+            if (base == last || base >= nb_bases)
+                continue;
+            last = base;
+            if (variants_push(variants, base, variants_base(ref_bin, base), variants_base(seq_bin, base)))
+                return printf("ERROR: extracting_variants: cannot allocate memory\n"), -1;
+        }
+    }
+    return 0;
+}
+
+typedef struct variants_collection_s {
+    const long int* ref_bin;
+    const long int* const* seqs_bin;
+    const unsigned long long* nb_bases;
+    variants_t* variants;
+    int error;
+}variants_collection_t;
+
+// Variants of a range of genomes (thread pool task)
+static void extracting_variants_task(void* arg, const unsigned long long begin, const unsigned long long end,
+                                     const unsigned thread_id){
+    variants_collection_t* c = arg;
+    for (unsigned long long g = begin; g < end; g++)
+        if (extracting_variants(c->ref_bin, c->seqs_bin[g], c->nb_bases[g], &c->variants[g]))
+            c->error = 1;
+}
+
+/**
+ * Single base differences between each genome of a collection and a reference.
+ *
+ * in : pool : threads sharing the genomes, NULL for the calling thread only
+ * in : ref_bin : reference in binary array format
+ * in : seqs_bin, nb_bases, nb_genomes : genomes in binary array format, and their bases compared
+ * out : variants : variants of each genome appended to its list, as extracting_variants
+ * out : int : 0, -1 on error
+ */
+int extracting_variants_collection(thread_pool_t* pool, const long int* ref_bin, const long int* const* seqs_bin,
+                                   const unsigned long long* nb_bases, const unsigned long long nb_genomes,
+                                   variants_t* variants){
+    if (!seqs_bin || !nb_bases || !variants)
+        return printf("ERROR: extracting_variants_collection: undefined collection\n"), -1;
+
+    variants_collection_t c = { ref_bin, seqs_bin, nb_bases, variants, 0 };
+    // Genomes one by one: their variants are not known in advance
+    if (pool)
+        thread_pool_run_dynamic(pool, nb_genomes, 1, extracting_variants_task, &c);
+    else
+        extracting_variants_task(&c, 0, nb_genomes, 0);
+    return c.error ? -1 : 0;
+}
+
+
+
+/***************************************/
+/********** INCREMENTAL GENES **********/
+/***************************************/
+
+// Codons read by detecting_genes, 2 bits per base (A = 0, G = 1, C = 2, T = 3)
+#define CODON_AUG 13
+#define CODON_UAA 48
+#define CODON_UAG 49
+#define CODON_UGA 52
+
+typedef struct gene_scan_s {
+
+    //Next position read (in bits), and start of the open gene (-1 for none)
+    long int i;
+    long int start;
+
+}gene_scan_t;
+
+static inline int gene_base(const long int* seq_bin, const long int base){
+    return 2 * get_binary_value(seq_bin, 2 * base) + get_binary_value(seq_bin, 2 * base + 1);
+}
+
+static inline int gene_ref_codon(const long int* ref_bin, const long int i){
+    return 16 * gene_base(ref_bin, i / 2) + 4 * gene_base(ref_bin, i / 2 + 1) + gene_base(ref_bin, i / 2 + 2);
+}
+
+/**
+ * Codon of a genome given as a reference and its variants.
+ *
+ * in : ref_bin, variants : genome
+ * in : next : first variant that can be at or after position i, moved forward
+ * in : i : position of the codon (in bits)
+ * out : int : codon, 2 bits per base
+ */
+static inline int gene_genome_codon(const long int* ref_bin, const variants_t* variants, unsigned long long* next,
+                                    const long int i){
+    long int base = i / 2;
+    while (*next < variants->nb_variants && variants->list[*next].pos < base)
+        (*next)++;
+
+    int codon = 0;
+    unsigned long long k = *next;
+    for (int b = 0; b < 3; b++) {
+        int code;
+        if (k < variants->nb_variants && variants->list[k].pos == base + b) {
+            char alt = variants->list[k++].alt;
+            code = alt == 'G' ? 1 : alt == 'C' ? 2 : alt == 'T' ? 3 : 0;
+        }
+        else
+            code = gene_base(ref_bin, base + b);
+        codon = 4 * codon + code;
+    }
+    return codon;
+}
+
+/**
+ * One step of the scan of detecting_genes.
+ *
+ * in : scan : position and open gene, updated
+ * in : codon : codon at the position
+ * out : int : 1 if a gene ends, from scan->start (before the step) to the end of the codon
+ */
+static inline int gene_stepping(gene_scan_t* scan, const int codon){
+    if (codon == CODON_AUG) {
+        scan->start = scan->i;
+        scan->i += 6;
+        return 0;
+    }
+    if (scan->start != -1 && (codon == CODON_UAA || codon == CODON_UAG || codon == CODON_UGA)) {
+        scan->start = -1;
+        scan->i += 6;
+        return 1;
+    }
+    scan->i += 2;
+    return 0;
+}
+
+// Append a gene to a map, its arrays grow by doubling
+static inline int gene_map_push(gene_map_t* genes, unsigned long long* capacity, const unsigned long long start,
+                                const unsigned long long end){
+    if (genes->genes_counter == *capacity) {
+        unsigned long long size = *capacity ? 2 * *capacity : 64;
+        unsigned long long* starts = realloc(genes->gene_start, size * sizeof(*starts));
+        if (starts)
+            genes->gene_start = starts;
+        unsigned long long* ends = realloc(genes->gene_end, size * sizeof(*ends));
+        if (ends)
+            genes->gene_end = ends;
+        if (!starts || !ends)
+            return -1;
+        *capacity = size;
+    }
+    genes->gene_start[genes->genes_counter] = start;
+    genes->gene_end[genes->genes_counter++] = end;
+    return 0;
+}
+
+/**
+ * Genes of a reference, with the checkpoints of their scan.
+ *
+ * in : ref_bin : reference in binary array format
+ * in : nb_bits : bits scanned, as given to detecting_genes
+ * out : index : genes and checkpoints, to free with gene_index_free
+ * out : int : 0, -1 on error
+ *
+ * The genes are those of detecting_genes. At the beginning of each block of GENE_INDEX_BLOCK bases,
+ * the position and the open gene of the scan are kept, detecting_genes_variants starts again from them.
+ */
+int indexing_genes(const long int* ref_bin, const long int nb_bits, gene_index_t* index){
+    memset(index, 0, sizeof(*index));
+    if (!ref_bin)
+        return printf("ERROR: indexing_genes: undefined sequence\n"), -1;
+    if (nb_bits < 0 || nb_bits >= INT_MAX - 6)
+        return printf("ERROR: indexing_genes: invalid sequence size\n"), -1;
+
+    const long int block = 2 * GENE_INDEX_BLOCK;
+    index->nb_bits = nb_bits;
+    index->nb_checkpoints = nb_bits / block + 1;
+    index->checkpoint_pos = malloc(index->nb_checkpoints * sizeof(*index->checkpoint_pos));
+    index->checkpoint_start = malloc(index->nb_checkpoints * sizeof(*index->checkpoint_start));
+    if (!index->checkpoint_pos || !index->checkpoint_start)
+        return gene_index_free(index), printf("ERROR: indexing_genes: cannot allocate memory\n"), -1;
+
+    gene_scan_t scan = { 0, -1 };
+    unsigned long long capacity = 0, c = 0;
+    while (scan.i + 6 <= nb_bits) {
+        for (; c < index->nb_checkpoints && (long)c * block <= scan.i; c++) {
+            index->checkpoint_pos[c] = scan.i;
+            index->checkpoint_start[c] = scan.start;
+        }
+        long int start = scan.start;
+        if (gene_stepping(&scan, gene_ref_codon(ref_bin, scan.i))
+            && gene_map_push(&index->genes, &capacity, start, scan.i - 1))
+            return gene_index_free(index), printf("ERROR: indexing_genes: cannot allocate memory\n"), -1;
+    }
+    for (; c < index->nb_checkpoints; c++) {
+        index->checkpoint_pos[c] = scan.i;
+        index->checkpoint_start[c] = scan.start;
+    }
+    return 0;
+}
+
+void gene_index_free(gene_index_t* index){
+    free(index->genes.gene_start);
+    free(index->genes.gene_end);
+    free(index->checkpoint_pos);
+    free(index->checkpoint_start);
+    memset(index, 0, sizeof(*index));
+}
+
+/**
+ * Genes of a genome differing from a reference by single base variants.
+ *
+ * in : ref_bin : reference in binary array format
+ * in : index : genes and checkpoints of the reference (indexing_genes)
+ * in : variants : variants of the genome, sorted by position (extracting_variants)
+ * out : genes : genes of the genome, as detecting_genes gives them for the same number of bits,
+ *               in new arrays to free
+ * out : long : bits scanned again, -1 on error
+ *
+ * Only the regions around the variants are scanned again. A region starts at the last checkpoint
+ * before the first codon reading a variant, and the reference and the genome are scanned side by
+ * side until they read the same position with the same open gene past the last variant met: from
+ * there, the genes are those of the reference again. The genes of the reference ended in the
+ * region are replaced by those of the genome.
+ */
+long detecting_genes_variants(const long int* ref_bin, const gene_index_t* index, const variants_t* variants,
+                              gene_map_t* genes){
+    memset(genes, 0, sizeof(*genes));
+    if (!ref_bin || !index || !variants)
+        return printf("ERROR: detecting_genes_variants: undefined sequence\n"), -1;
+
+    const gene_map_t* ref = &index->genes;
+    const long int nb_bits = index->nb_bits, block = 2 * GENE_INDEX_BLOCK;
+    unsigned long long capacity = 0, r = 0, k = 0, next = 0;
+    gene_scan_t synced = { 0, -1 };
+    long scanned = 0;
+    int res = 0;
+
+    while (!res && k < variants->nb_variants && synced.i + 6 <= nb_bits) {
+        // Region start: the last checkpoint before the first codon reading the variant, unless the last region ends after it
+        long int v = variants->list[k++].pos;
+        long int first = v >= 2 ? 2 * (v - 2) : 0;
+        unsigned long long c = first / block;
+        if (c >= index->nb_checkpoints)
+            c = index->nb_checkpoints - 1;
+        while (c > 0 && index->checkpoint_pos[c] > first)
+            c--;
+        gene_scan_t ref_scan = synced;
+        if (index->checkpoint_pos[c] > synced.i)
+            ref_scan = (gene_scan_t){ index->checkpoint_pos[c], index->checkpoint_start[c] };
+        gene_scan_t seq_scan = ref_scan;
+        long int region = ref_scan.i, dirty = 2 * (v + 1);
+
+        // Genes of the reference before the region
+        for (; !res && r < ref->genes_counter && (long)ref->gene_end[r] - 5 < region; r++)
+            res = gene_map_push(genes, &capacity, ref->gene_start[r], ref->gene_end[r]);
+
+        while (!res) {
+            int seq_done = seq_scan.i + 6 > nb_bits, ref_done = ref_scan.i + 6 > nb_bits;
+            if (seq_done && ref_done) {
+                seq_scan.i = nb_bits;
+                break;
+            }
+            int seq_step = !seq_done && (ref_done || seq_scan.i <= ref_scan.i);
+            int ref_step = !ref_done && (seq_done || ref_scan.i <= seq_scan.i);
+            if (seq_step && ref_step) {
+                // Same position: variants read from there, then the end of the region
+                for (; k < variants->nb_variants && 2 * ((long)variants->list[k].pos - 2) <= seq_scan.i; k++)
+                    if (2 * ((long)variants->list[k].pos + 1) > dirty)
+                        dirty = 2 * ((long)variants->list[k].pos + 1);
+                if (seq_scan.i >= dirty && seq_scan.start == ref_scan.start)
+                    break;
+            }
+            if (seq_step) {
+                long int start = seq_scan.start;
+                if (gene_stepping(&seq_scan, gene_genome_codon(ref_bin, variants, &next, seq_scan.i)))
+                    res = gene_map_push(genes, &capacity, start, seq_scan.i - 1);
+            }
+            if (ref_step)
+                gene_stepping(&ref_scan, gene_ref_codon(ref_bin, ref_scan.i));
+        }
+
+        // Genes of the reference ended in the region
+        while (r < ref->genes_counter && (long)ref->gene_end[r] - 5 < seq_scan.i)
+            r++;
+        scanned += seq_scan.i - region;
+        synced = seq_scan;
+    }
+
+    // Genes of the reference after the last region
+    for (; !res && r < ref->genes_counter; r++)
+        res = gene_map_push(genes, &capacity, ref->gene_start[r], ref->gene_end[r]);
+    if (res) {
+        free(genes->gene_start);
+        free(genes->gene_end);
+        memset(genes, 0, sizeof(*genes));
+        return printf("ERROR: detecting_genes_variants: cannot allocate memory\n"), -1;
+    }
+    return scanned;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stdint.h>
+#include <limits.h>
+
+#include "gene_bin.h"
+#include "thread_pool.h"
+
+// Longest genomes compared, below 1.07 Gb: the binary library reads the bits at int positions (2 per base),
+// which also bounds the 32 bits positions of the variants
+#define VARIANTS_MAX_BASES (INT_MAX / 2)
+
+typedef struct variant_s {
+
+    //Position of the base, in the reference and in the genome (below VARIANTS_MAX_BASES)
+    uint32_t pos;
+
+    //Base of the reference, and of the genome (A, C, G or T)
+    char ref;
+    char alt;
+
+}variant_t;
+
+typedef struct variants_s {
+
+    //Variants sorted by position
+    variant_t* list;
+    unsigned long long nb_variants;
+
+    //Allocated variants
+    unsigned long long capacity;
+
+}variants_t;
+
+// Bases between two checkpoints of the scan of detecting_genes over a reference
+#define GENE_INDEX_BLOCK 64
+
+typedef struct gene_index_s {
+
+    //Genes of the reference, as detecting_genes
+    gene_map_t genes;
+
+    //Number of bits of the reference
+    long int nb_bits;
+
+    //First position scanned from each block of GENE_INDEX_BLOCK bases (in bits), and the start
+    //of the gene open there (-1 for none)
+    unsigned long long nb_checkpoints;
+    long int* checkpoint_pos;
+    long int* checkpoint_start;
+
+}gene_index_t;
+
+
+/******** VARIANTS FUNCTION *********/
+
+void variants_init(variants_t* variants);
+void variants_free(variants_t* variants);
+int extracting_variants(const long int* ref_bin, const long int* seq_bin, const unsigned long long nb_bases,
+                        variants_t* variants);
+int extracting_variants_collection(thread_pool_t* pool, const long int* ref_bin, const long int* const* seqs_bin,
+                                   const unsigned long long* nb_bases, const unsigned long long nb_genomes,
+                                   variants_t* variants);
+int indexing_genes(const long int* ref_bin, const long int nb_bits, gene_index_t* index);
+void gene_index_free(gene_index_t* index);
+long detecting_genes_variants(const long int* ref_bin, const gene_index_t* index, const variants_t* variants,
+                              gene_map_t* genes);